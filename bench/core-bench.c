@@ -0,0 +1,1329 @@
+/*
+ * bench/core-bench.c
+ * CPU unit tests and microbenchmarks for the effect core, linked against
+ * the libobs stand-in in bench/mock-obs. Runs the tests; with --bench also
+ * times settings updates, parameter uploads, create/destroy churn and
+ * shader path validation over every registered effect and prints JSON.
+ */
+
+#include "effect-registry.h"
+#include "cpu-kernels.h"
+#include "utils/style-net.h"
+#include "utils/task-pool.h"
+#include "utils/tileable-noise.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_FRAME_SECONDS 0.016f
+#define SHADER_WAIT_NS 10000000000ull  // Loader thread's time to compile one shader
+#define SMOKE_FRAMES 8
+#define CHURN_LEAK_CYCLES 20
+#define PATH_ROUNDS_PER_ITERATION 100
+#define SYNC_RACE_NS 300000000ull      // How long test_sync_race races updates
+#define NOISE_SIZE 64
+#define ESN_MAX_BYTES 65536
+#define ESN_TEST_PATH "core-bench-test.esn"
+
+#ifndef EMULENS_CORE_BENCH_DATA
+#define EMULENS_CORE_BENCH_DATA "data"
+#endif
+
+// --- Checks ---
+
+static unsigned long checks_run = 0;
+static unsigned long checks_failed = 0;
+
+static bool check(bool ok, const char *expr, const char *file, int line) {
+    checks_run++;
+    if (!ok) {
+        checks_failed++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+#define CHECK(expr) check((expr), #expr, __FILE__, __LINE__)
+
+static bool near(double a, double b) {
+    return fabs(a - b) < 1e-6;
+}
+
+// Effect the checks that follow are about, for failure messages
+static void check_context(const char *what, const effect_info_t *info) {
+    if (getenv("CORE_BENCH_TRACE")) fprintf(stderr, "-- %s: %s\n", what, info ? info->id : "");
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+// --- Instances ---
+// A filter as libobs drives it: defaults, create, the update create asked
+// for, then ticks and renders on the "graphics thread" (this one).
+
+typedef struct {
+    const effect_info_t *info;
+    obs_source_t *source;
+    effect_data_t *ed;
+} instance_t;
+
+static obs_data_t *default_settings(const effect_info_t *info) {
+    obs_data_t *settings = obs_data_create();
+    if (info->get_defaults) info->get_defaults(settings);
+    return settings;
+}
+
+// Sets every parameter of `info` to a value in range other than its default
+static void perturb_settings(const effect_info_t *info, obs_data_t *settings) {
+    for (size_t i = 0; i < info->num_params; i++) {
+        const param_def_t *def = &info->params[i];
+        switch (def->type) {
+            case PARAM_FLOAT: {
+                double val = def->min + (def->max - def->min) * 0.375;
+                if (fabs(val - def->default_val.f_val) < 1e-3) val = def->min + (def->max - def->min) * 0.625;
+                obs_data_set_double(settings, def->name, val);
+                break;
+            }
+            case PARAM_INT: {
+                long long val = (long long)def->min + (long long)(def->max - def->min) / 2;
+                if (val == def->default_val.i_val) val = val < (long long)def->max ? val + 1 : val - 1;
+                obs_data_set_int(settings, def->name, val);
+                break;
+            }
+            case PARAM_BOOL:
+                obs_data_set_bool(settings, def->name, !def->default_val.b_val);
+                break;
+            case PARAM_COLOR:
+                obs_data_set_int(settings, def->name, def->default_val.i_val ^ 0x00FF00FFll);
+                break;
+        }
+    }
+}
+
+static bool instance_create(instance_t *inst, const effect_info_t *info, obs_data_t *settings) {
+    inst->info = info;
+    inst->source = mock_filter_create(info->name, (void *)info, info->update, BENCH_WIDTH, BENCH_HEIGHT);
+    inst->ed = info->create(settings, inst->source);
+    mock_filter_set_data(inst->source, inst->ed);
+    return inst->ed != NULL;
+}
+
+static void instance_destroy(instance_t *inst) {
+    if (inst->ed) inst->info->destroy(inst->ed);
+    mock_filter_destroy(inst->source);
+    memset(inst, 0, sizeof(*inst));
+}
+
+static void instance_tick(instance_t *inst) {
+    if (inst->info->video_tick) inst->info->video_tick(inst->ed, BENCH_FRAME_SECONDS);
+}
+
+static void instance_frame(instance_t *inst) {
+    instance_tick(inst);
+    obs_enter_graphics();
+    effect_video_render(inst->ed, NULL);
+    obs_leave_graphics();
+}
+
+// Waits for the loader thread to compile the instance's shader, then binds it
+static bool instance_bind(instance_t *inst) {
+    uint64_t deadline = os_gettime_ns() + SHADER_WAIT_NS;
+    for (;;) {
+        obs_enter_graphics();
+        bool ready = generic_ensure_effect(inst->ed);
+        obs_leave_graphics();
+
+        if (ready) return true;
+        if (inst->ed->effect_failed || os_gettime_ns() > deadline) return false;
+        sleep_ms(1);
+    }
+}
+
+// Index of the first parameter of `info` with all of `flags` and none of
+// `without`, of type `type` (or any type if < 0), or -1
+static int find_param(const effect_info_t *info, int type, uint32_t flags, uint32_t without) {
+    for (size_t i = 0; i < info->num_params; i++) {
+        const param_def_t *def = &info->params[i];
+        if (type >= 0 && def->type != (param_type_t)type) continue;
+        if ((def->flags & flags) != flags || (def->flags & without)) continue;
+        return (int)i;
+    }
+    return -1;
+}
+
+// --- Tests ---
+
+static void test_shader_paths(void) {
+    static const char *const valid[] = {"shaders/bokeh.shader", "shaders/x.shader", "shaders/a-b_c.shader"};
+    static const char *const invalid[] = {
+        "",
+        "bokeh.shader",
+        "shader/bokeh.shader",
+        "shaders/../bokeh.shader",
+        "shaders/..shader",
+        "shaders\\bokeh.shader",
+        "shaders/sub/bokeh.shader",
+        "/shaders/bokeh.shader",
+        "shaders/bokeh.effect",
+        "shaders/bokeh.shader.txt",
+        "shaders/bokeh",
+    };
+
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) CHECK(is_valid_shader_path(valid[i]));
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) CHECK(!is_valid_shader_path(invalid[i]));
+    CHECK(!is_valid_shader_path(NULL));
+
+    char long_path[300];
+    memcpy(long_path, "shaders/", 8);
+    memset(long_path + 8, 'a', sizeof(long_path) - 8);
+    memcpy(long_path + sizeof(long_path) - 8, ".shader", 8);
+    CHECK(!is_valid_shader_path(long_path));
+
+    // Every shader the effects load is valid and shipped
+    obs_module_t *module = obs_get_module("obs-emulens");
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("shader paths", info);
+        CHECK(is_valid_shader_path(info->shader_path));
+
+        char *path = obs_find_module_file(module, info->shader_path);
+        CHECK(path != NULL);
+        bfree(path);
+
+        for (const char *const *extra = info->extra_shaders; extra && *extra; extra++) {
+            CHECK(is_valid_shader_path(*extra));
+            path = obs_find_module_file(module, *extra);
+            CHECK(path != NULL);
+            bfree(path);
+        }
+    }
+}
+
+static void test_param_store(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("param store", info);
+
+        param_store_t store = {0};
+        void *block = bzalloc(param_store_size(info));
+        param_store_init(&store, info, block);
+
+        size_t total = 0;
+        for (int t = 0; t < 4; t++) total += store.counts[t];
+        CHECK(total == info->num_params);
+
+        for (size_t i = 0; i < info->num_params; i++) {
+            const param_def_t *def = &info->params[i];
+            CHECK(param_store_find(&store, info, def->name) == (int)i);
+            CHECK(store.slots[i] < store.counts[def->type]);
+            CHECK(def->min <= def->max);
+
+            // Slots of one type don't overlap
+            for (size_t j = 0; j < i; j++) {
+                if (info->params[j].type == def->type) CHECK(store.slots[j] != store.slots[i]);
+            }
+        }
+        CHECK(param_store_find(&store, info, "no_such_parameter") == -1);
+        CHECK(param_store_find(&store, info, "") == -1);
+
+        bfree(block);
+    }
+}
+
+// After create and one tick the synced values, host-side settings included,
+// are the defaults, clamped
+static void test_defaults(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("defaults", info);
+
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings))) {
+            obs_data_release(settings);
+            continue;
+        }
+        instance_tick(&inst);
+
+        for (size_t i = 0; i < info->num_params; i++) {
+            const param_def_t *def = &info->params[i];
+            switch (def->type) {
+                case PARAM_FLOAT: {
+                    double want = fmin(fmax(obs_data_get_double(settings, def->name), def->min), def->max);
+                    CHECK(fabs(param_get_float(inst.ed, def->name) - want) < 1e-3);
+                    break;
+                }
+                case PARAM_INT: {
+                    long long want = obs_data_get_int(settings, def->name);
+                    if (want < (long long)def->min) want = (long long)def->min;
+                    if (want > (long long)def->max) want = (long long)def->max;
+                    CHECK(param_get_int(inst.ed, def->name) == want);
+                    break;
+                }
+                case PARAM_BOOL:
+                    CHECK(param_get_bool(inst.ed, def->name) == obs_data_get_bool(settings, def->name));
+                    break;
+                case PARAM_COLOR:
+                    CHECK(param_get_color(inst.ed, def->name) == (uint32_t)obs_data_get_int(settings, def->name));
+                    break;
+            }
+        }
+        CHECK(near(param_get_float(inst.ed, "no_such_parameter"), 0.0));
+
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+// Updates land in the drawn values at the next tick, not before, clamped
+// to the parameter's range
+static void test_update_sync(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        int index = find_param(info, PARAM_FLOAT, 0, PARAM_FLAG_NO_UNIFORM | PARAM_FLAG_QUALITY);
+        if (index < 0) continue;
+        check_context("update/sync", info);
+
+        const param_def_t *def = &info->params[index];
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings))) {
+            obs_data_release(settings);
+            continue;
+        }
+        instance_tick(&inst);
+
+        float before = param_get_float(inst.ed, def->name);
+        double mid = def->min + (def->max - def->min) * 0.5;
+        double changed = fabs(mid - before) > 1e-3 ? mid : def->min;
+        obs_data_set_double(settings, def->name, changed);
+        info->update(inst.ed, settings);
+        CHECK(fabsf(param_get_float(inst.ed, def->name) - before) < 1e-6f);
+
+        instance_tick(&inst);
+        CHECK(fabs(param_get_float(inst.ed, def->name) - changed) < 1e-3);
+
+        obs_data_set_double(settings, def->name, def->max + 1000.0);
+        info->update(inst.ed, settings);
+        instance_tick(&inst);
+        CHECK(fabs(param_get_float(inst.ed, def->name) - def->max) < 1e-3);
+
+        obs_data_set_double(settings, def->name, def->min - 1000.0);
+        info->update(inst.ed, settings);
+        instance_tick(&inst);
+        CHECK(fabs(param_get_float(inst.ed, def->name) - def->min) < 1e-3);
+
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+typedef struct {
+    effect_data_t *ed;
+    obs_data_t *settings[2];
+    volatile bool stop;
+    volatile long written;      // Updates finished
+} update_storm_t;
+
+static void *update_storm_main(void *data) {
+    update_storm_t *storm = data;
+    for (long n = 0; !os_atomic_load_bool(&storm->stop); n++) {
+        generic_update(storm->ed, storm->settings[n & 1]);
+        os_atomic_set_long(&storm->written, n + 1);
+    }
+    return NULL;
+}
+
+// Syncs racing a thread that keeps updating only ever see whole updates,
+// and once it stops the last one arrives
+static void test_sync_race(void) {
+    const effect_info_t *info = effects[0];
+    int first = find_param(info, PARAM_FLOAT, 0, PARAM_FLAG_NO_UNIFORM | PARAM_FLAG_QUALITY);
+    int last = -1;
+    for (size_t i = info->num_params; i-- > 0 && last < 0;) {
+        const param_def_t *def = &info->params[i];
+        if (def->type == PARAM_FLOAT && !(def->flags & (PARAM_FLAG_NO_UNIFORM | PARAM_FLAG_QUALITY))) last = (int)i;
+    }
+    if (first < 0 || last <= first) return;
+    check_context("sync race", info);
+
+    update_storm_t storm = {.settings = {default_settings(info), default_settings(info)}};
+    perturb_settings(info, storm.settings[1]);
+    const char *names[2] = {info->params[first].name, info->params[last].name};
+    float values[2][2];
+    for (int b = 0; b < 2; b++) {
+        for (int p = 0; p < 2; p++) values[b][p] = (float)obs_data_get_double(storm.settings[b], names[p]);
+    }
+
+    instance_t inst;
+    if (!CHECK(instance_create(&inst, info, storm.settings[0]))) {
+        obs_data_release(storm.settings[0]);
+        obs_data_release(storm.settings[1]);
+        return;
+    }
+    storm.ed = inst.ed;
+    instance_tick(&inst);
+
+    pthread_t writer;
+    if (!CHECK(pthread_create(&writer, NULL, update_storm_main, &storm) == 0)) {
+        instance_destroy(&inst);
+        obs_data_release(storm.settings[0]);
+        obs_data_release(storm.settings[1]);
+        return;
+    }
+
+    unsigned long torn = 0;
+    uint64_t until = os_gettime_ns() + SYNC_RACE_NS;
+    while (os_gettime_ns() < until || os_atomic_load_long(&storm.written) < 100) {
+        sync_effect_parameters(inst.ed);
+        float a = param_get_float(inst.ed, names[0]);
+        float b = param_get_float(inst.ed, names[1]);
+        bool whole = (near(a, values[0][0]) && near(b, values[0][1])) || (near(a, values[1][0]) && near(b, values[1][1]));
+        if (!whole) torn++;
+    }
+    os_atomic_set_bool(&storm.stop, true);
+    pthread_join(writer, NULL);
+    CHECK(torn == 0);
+
+    const float *final = values[(os_atomic_load_long(&storm.written) - 1) & 1];
+    sync_effect_parameters(inst.ed);
+    CHECK(near(param_get_float(inst.ed, names[0]), final[0]));
+    CHECK(near(param_get_float(inst.ed, names[1]), final[1]));
+
+    instance_destroy(&inst);
+    obs_data_release(storm.settings[0]);
+    obs_data_release(storm.settings[1]);
+}
+
+// A bound effect gets every uniform once, then only what changed
+static void test_apply(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("apply", info);
+
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings)) || !CHECK(instance_bind(&inst))) {
+            if (inst.ed) instance_destroy(&inst);
+            obs_data_release(settings);
+            continue;
+        }
+        instance_tick(&inst);
+
+        size_t bound = 0;
+        int changed_index = -1;
+        for (size_t i = 0; i < info->num_params; i++) {
+            gs_eparam_t *handle = inst.ed->params.handles[i];
+            if (!handle) continue;
+            bound++;
+            if (changed_index < 0 && info->params[i].type == PARAM_FLOAT && handle->type == GS_SHADER_PARAM_FLOAT &&
+                !(info->params[i].flags & (PARAM_FLAG_QUALITY | PARAM_FLAG_SPECIALIZE))) {
+                changed_index = (int)i;
+            }
+        }
+
+        obs_enter_graphics();
+        unsigned long sets = mock_gs_param_sets();
+        apply_effect_parameters(inst.ed);
+        CHECK(mock_gs_param_sets() - sets <= bound);
+        sets = mock_gs_param_sets();
+        apply_effect_parameters(inst.ed);
+        CHECK(mock_gs_param_sets() == sets);
+        obs_leave_graphics();
+
+        if (changed_index >= 0) {
+            const param_def_t *def = &info->params[changed_index];
+            gs_eparam_t *handle = inst.ed->params.handles[changed_index];
+            float value = (float)(def->min + (def->max - def->min) * 0.25);
+            if (fabsf(value - param_get_float(inst.ed, def->name)) < 1e-3f) value = (float)def->max;
+
+            obs_data_set_double(settings, def->name, value);
+            info->update(inst.ed, settings);
+            instance_tick(&inst);
+
+            obs_enter_graphics();
+            sets = mock_gs_param_sets();
+            unsigned long handle_sets = handle->sets;
+            apply_effect_parameters(inst.ed);
+            CHECK(mock_gs_param_sets() - sets == 1);
+            CHECK(handle->sets == handle_sets + 1);
+
+            float uploaded;
+            memcpy(&uploaded, handle->value, sizeof(uploaded));
+            CHECK(fabsf(uploaded - value) < 1e-3f);
+            obs_leave_graphics();
+        }
+
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+static void test_quality_scale(void) {
+    const param_def_t taps = {"taps", "Taps", NULL, PARAM_INT, {.i_val = 16}, 1, 16, 1, PARAM_FLAG_QUALITY};
+    const param_def_t radius = {"radius", "Radius", NULL, PARAM_FLOAT, {.f_val = 1.0}, 0.0, 1.0, 0.0,
+                                PARAM_FLAG_QUALITY};
+    const param_def_t feature = {"feature", "Feature", NULL, PARAM_BOOL, {.b_val = true}, 0, 1, 0,
+                                 PARAM_FLAG_QUALITY};
+    const param_def_t plain = {"plain", "Plain", NULL, PARAM_INT, {.i_val = 16}, 1, 16, 1, 0};
+
+    CHECK(near(quality_scale_value(&taps, 16.0, 0), 16.0));
+    CHECK(near(quality_scale_value(&taps, 16.0, 1), 11.0));  // 1 + 15 * 0.7, rounded down
+    CHECK(near(quality_scale_value(&taps, 16.0, 3), 4.0));   // 1 + 15 * 0.25
+    CHECK(near(quality_scale_value(&taps, 16.0, 99), 4.0));  // Clamped to the last level
+    CHECK(near(quality_scale_value(&taps, 1.0, 3), 1.0));    // Already at the minimum
+    CHECK(near(quality_scale_value(&radius, 1.0, 2), 0.45)); // Levels are floats
+    CHECK(near(quality_scale_value(&feature, 1.0, 1), 1.0));
+    CHECK(near(quality_scale_value(&feature, 1.0, 2), 0.0));
+    CHECK(near(quality_scale_value(&plain, 16.0, 3), 16.0));
+    CHECK(near(quality_scale_value(NULL, 5.0, 3), 5.0));
+
+    // A governor level lowers what draws, and stepping back restores it
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        int index = find_param(info, -1, PARAM_FLAG_QUALITY, PARAM_FLAG_NO_UNIFORM);
+        if (index < 0) continue;
+        const param_def_t *def = &info->params[index];
+        if (def->type != PARAM_INT && def->type != PARAM_FLOAT) continue;
+        check_context("quality levels", info);
+
+        obs_data_t *settings = default_settings(info);
+        if (def->type == PARAM_INT) {
+            obs_data_set_int(settings, def->name, (long long)def->max);
+        } else {
+            obs_data_set_double(settings, def->name, def->max);
+        }
+
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings))) {
+            obs_data_release(settings);
+            continue;
+        }
+        instance_tick(&inst);
+        float full = param_get_float(inst.ed, def->name);
+
+        inst.ed->quality_level = QUALITY_LEVELS - 1;
+        instance_tick(&inst);
+        CHECK(param_get_float(inst.ed, def->name) < full);
+        CHECK(fabs(param_get_float(inst.ed, def->name) - quality_scale_value(def, full, QUALITY_LEVELS - 1)) < 1e-3);
+
+        inst.ed->quality_level = 0;
+        instance_tick(&inst);
+        CHECK(fabsf(param_get_float(inst.ed, def->name) - full) < 1e-6f);
+
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+// A governed render scale only ever lowers the layer's resolution
+static void test_quality_render_scale(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        if (!(info->flags & EFFECT_FLAG_SPLIT_OVERLAY)) continue;
+        check_context("render scale levels", info);
+
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings))) {
+            obs_data_release(settings);
+            continue;
+        }
+        int index = param_store_find(&inst.ed->params, info, RENDER_SCALE_SETTING);
+        bool governed = index >= 0 && (info->params[index].flags & PARAM_FLAG_QUALITY);
+        instance_tick(&inst);
+        CHECK(quality_render_scale_shift(inst.ed) == 0);
+
+        inst.ed->quality_level = QUALITY_LEVELS - 1;
+        instance_tick(&inst);
+        CHECK(quality_render_scale_shift(inst.ed) == (governed ? RENDER_SCALE_MAX_SHIFT : 0));
+
+        inst.ed->quality_level = 1;
+        obs_data_set_int(settings, RENDER_SCALE_SETTING, RENDER_SCALE_MAX_SHIFT);
+        info->update(inst.ed, settings);
+        instance_tick(&inst);
+        CHECK(quality_render_scale_shift(inst.ed) == RENDER_SCALE_MAX_SHIFT); // Never above the setting
+
+        inst.ed->quality_level = 0;
+        obs_data_set_int(settings, RENDER_SCALE_SETTING, 0);
+        info->update(inst.ed, settings);
+        instance_tick(&inst);
+        CHECK(quality_render_scale_shift(inst.ed) == 0);
+
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+// Variants define every PARAM_FLAG_SPECIALIZE parameter, and nothing else
+static void test_variant_defines(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("variant defines", info);
+
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings))) {
+            obs_data_release(settings);
+            continue;
+        }
+        instance_tick(&inst);
+
+        struct dstr defines = {0};
+        param_store_variant_defines(&inst.ed->params, info, &defines);
+        const char *text = defines.array ? defines.array : "";
+
+        size_t lines = 0;
+        for (const char *p = text; (p = strchr(p, '\n')) != NULL; p++) lines++;
+
+        size_t specialized = 0;
+        struct dstr name = {0};
+        for (size_t i = 0; i < info->num_params; i++) {
+            if (!(info->params[i].flags & PARAM_FLAG_SPECIALIZE)) continue;
+            if (info->params[i].type != PARAM_BOOL && info->params[i].type != PARAM_INT) continue;
+            specialized++;
+            dstr_printf(&name, "#define SPEC_%s ", info->params[i].name);
+            CHECK(strstr(text, name.array) != NULL);
+        }
+        CHECK(lines == specialized);
+
+        dstr_free(&name);
+        dstr_free(&defines);
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+// While a budget is set, a new quality level never waits on a variant: the
+// specialised parameters the governor may lower are left to their uniforms
+static void test_governed_variants(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        int index = find_param(info, -1, PARAM_FLAG_SPECIALIZE | PARAM_FLAG_QUALITY, 0);
+        if (index < 0) continue;
+        check_context("governed variants", info);
+
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        if (!CHECK(instance_create(&inst, info, settings))) {
+            obs_data_release(settings);
+            continue;
+        }
+        instance_tick(&inst);
+        CHECK(param_store_find(&inst.ed->params, info, QUALITY_BUDGET_SETTING) >= 0);
+
+        struct dstr name = {0};
+        struct dstr defines = {0};
+        dstr_printf(&name, "#define SPEC_%s ", info->params[index].name);
+
+        obs_data_set_double(settings, QUALITY_BUDGET_SETTING, 1.0);
+        info->update(inst.ed, settings);
+        os_atomic_set_bool(&inst.ed->variant_stale, false);
+        instance_tick(&inst);
+        CHECK(os_atomic_load_bool(&inst.ed->variant_stale));
+        param_store_variant_defines(&inst.ed->params, info, &defines);
+        CHECK(!defines.array || strstr(defines.array, name.array) == NULL);
+
+        os_atomic_set_bool(&inst.ed->variant_stale, false);
+        inst.ed->quality_level = QUALITY_LEVELS - 1;
+        instance_tick(&inst);
+        CHECK(!os_atomic_load_bool(&inst.ed->variant_stale));
+
+        // governed_render drops the level once the budget is off
+        obs_data_set_double(settings, QUALITY_BUDGET_SETTING, 0.0);
+        info->update(inst.ed, settings);
+        inst.ed->quality_level = 0;
+        instance_tick(&inst);
+        CHECK(os_atomic_load_bool(&inst.ed->variant_stale));
+        param_store_variant_defines(&inst.ed->params, info, &defines);
+        CHECK(defines.array && strstr(defines.array, name.array) != NULL);
+
+        dstr_free(&name);
+        dstr_free(&defines);
+        instance_destroy(&inst);
+        obs_data_release(settings);
+    }
+}
+
+// --- CPU kernels ---
+
+static uint32_t test_rng = 0x2545F491u;
+
+static uint32_t test_random(void) {
+    // xorshift32
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 17;
+    test_rng ^= test_rng << 5;
+    return test_rng;
+}
+
+static int channel_diff(uint32_t a, uint32_t b) {
+    int worst = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int d = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+        if (d > worst) worst = d;
+    }
+    return worst;
+}
+
+static int unorm16_step(uint16_t a, uint16_t b) {
+    return abs((int)a - (int)b);
+}
+
+// Same seed, same texels however the rows are split; the scalar reference
+// agrees with the SIMD rows; and across the wrap the noise steps no further
+// than between any two neighbours inside the texture
+static void test_tileable_noise(void) {
+    check_context("tileable noise", NULL);
+    tileable_fbm_desc_t desc = {NOISE_SIZE, NOISE_SIZE, 4, 3, 4, 0.5f, 1234};
+    size_t count = (size_t)NOISE_SIZE * NOISE_SIZE;
+    uint16_t *a = bmalloc(sizeof(uint16_t) * count);
+    uint16_t *b = bzalloc(sizeof(uint16_t) * count);
+
+    tileable_fbm_bake(&desc, a);
+    tileable_fbm_rows(&desc, b, NOISE_SIZE / 3, NOISE_SIZE);
+    tileable_fbm_rows(&desc, b, 0, NOISE_SIZE / 3);
+    CHECK(memcmp(a, b, sizeof(uint16_t) * count) == 0);
+
+    int reference_diff = 0;
+    for (uint32_t y = 0; y < NOISE_SIZE; y++) {
+        for (uint32_t x = 0; x < NOISE_SIZE; x++) {
+            float v = tileable_fbm_sample(&desc, x, y);
+            uint16_t expected = v <= 0.0f ? 0 : v >= 1.0f ? 65535 : (uint16_t)(v * 65535.0f + 0.5f);
+            int d = unorm16_step(expected, a[y * NOISE_SIZE + x]);
+            if (d > reference_diff) reference_diff = d;
+        }
+    }
+    CHECK(reference_diff <= 1);
+
+    int inner_x = 0, inner_y = 0, seam_x = 0, seam_y = 0;
+    for (uint32_t y = 0; y < NOISE_SIZE; y++) {
+        const uint16_t *row = a + y * NOISE_SIZE;
+        const uint16_t *next = a + ((y + 1) % NOISE_SIZE) * NOISE_SIZE;
+        for (uint32_t x = 0; x < NOISE_SIZE; x++) {
+            int dx = unorm16_step(row[x], row[(x + 1) % NOISE_SIZE]);
+            int dy = unorm16_step(row[x], next[x]);
+            if (x + 1 < NOISE_SIZE) inner_x = dx > inner_x ? dx : inner_x;
+            else seam_x = dx > seam_x ? dx : seam_x;
+            if (y + 1 < NOISE_SIZE) inner_y = dy > inner_y ? dy : inner_y;
+            else seam_y = dy > seam_y ? dy : seam_y;
+        }
+    }
+    CHECK(seam_x > 0 && seam_x <= inner_x);
+    CHECK(seam_y > 0 && seam_y <= inner_y);
+
+    desc.seed++;
+    tileable_fbm_bake(&desc, b);
+    CHECK(memcmp(a, b, sizeof(uint16_t) * count) != 0);
+
+    bfree(a);
+    bfree(b);
+}
+
+static int compare_u16(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+// Same seed, same map, holding every rank once
+static void test_blue_noise(void) {
+    check_context("blue noise", NULL);
+    enum { SIZE_LOG2 = 4, COUNT = 1 << (SIZE_LOG2 * 2) };
+    uint16_t a[COUNT], b[COUNT];
+
+    CHECK(blue_noise_bake(a, SIZE_LOG2, 99));
+    CHECK(blue_noise_bake(b, SIZE_LOG2, 99));
+    CHECK(memcmp(a, b, sizeof(a)) == 0);
+
+    qsort(b, COUNT, sizeof(uint16_t), compare_u16);
+    size_t misplaced = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        if (b[i] != (uint16_t)((i * 65535u) / (COUNT - 1))) misplaced++;
+    }
+    CHECK(misplaced == 0);
+
+    CHECK(blue_noise_bake(b, SIZE_LOG2, 100));
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+    CHECK(!blue_noise_bake(a, 1, 99));
+    CHECK(!blue_noise_bake(a, 9, 99));
+}
+
+// Points the planes of a width x height frame of its format into `buffer`
+// and returns the bytes they take; with NULL only counts them
+static size_t frame_planes(struct obs_source_frame *frame, uint8_t *buffer) {
+    uint32_t w = frame->width, h = frame->height;
+    uint32_t linesize[3] = {w, 0, 0};
+    uint32_t rows[3] = {h, 0, 0};
+
+    switch (frame->format) {
+        case VIDEO_FORMAT_I420: linesize[1] = linesize[2] = w / 2; rows[1] = rows[2] = h / 2; break;
+        case VIDEO_FORMAT_I444: linesize[1] = linesize[2] = w; rows[1] = rows[2] = h; break;
+        case VIDEO_FORMAT_NV12: linesize[1] = w; rows[1] = h / 2; break;
+        default: linesize[0] = w * 2; break; // Packed 4:2:2
+    }
+
+    size_t size = 0;
+    for (int p = 0; p < 3; p++) {
+        frame->linesize[p] = linesize[p];
+        frame->data[p] = buffer && rows[p] ? buffer + size : NULL;
+        size += (size_t)linesize[p] * rows[p];
+    }
+    return size;
+}
+
+// The vector kernels match the EMULENS_NO_SIMD reference within 1 LSB:
+// bilinear sampling anywhere around the image, and the YUV -> RGBA -> YUV
+// round trip filter_video makes, in both directions
+static void test_simd_agreement(void) {
+    check_context("SIMD agreement", NULL);
+    enum { WIDTH = 38, HEIGHT = 22, SAMPLES = 1024 };
+
+    cpu_image_t image = {bmalloc(sizeof(uint32_t) * ((WIDTH + 7) & ~7) * HEIGHT), WIDTH, HEIGHT, (WIDTH + 7) & ~7};
+    for (size_t i = 0; i < (size_t)image.stride * HEIGHT; i++) image.pixels[i] = test_random();
+
+    float u[SAMPLES], v[SAMPLES];
+    uint32_t sampled[2][SAMPLES];
+    for (size_t i = 0; i < SAMPLES; i++) {
+        u[i] = (float)(test_random() % 1200) / 1000.0f - 0.1f; // Past the edges too
+        v[i] = (float)(test_random() % 1200) / 1000.0f - 0.1f;
+    }
+    cpu_kernels_sample_simd(&image, u, v, SAMPLES, sampled[0]);
+    cpu_kernels_sample_scalar(&image, u, v, SAMPLES, sampled[1]);
+
+    int sample_diff = 0;
+    for (size_t i = 0; i < SAMPLES; i++) {
+        int d = channel_diff(sampled[0][i], sampled[1][i]);
+        if (d > sample_diff) sample_diff = d;
+    }
+    CHECK(sample_diff <= 1);
+    bfree(image.pixels);
+
+    // BT.709, limited range
+    static const float bt709[16] = {1.164384f, 0.0f,      1.792741f,  -0.972945f, 1.164384f, -0.213249f,
+                                    -0.532909f, 0.301483f, 1.164384f, 2.112402f,  0.0f,      -1.133402f,
+                                    0.0f,       0.0f,      0.0f,      1.0f};
+    static const enum video_format formats[] = {VIDEO_FORMAT_I420, VIDEO_FORMAT_NV12, VIDEO_FORMAT_I444,
+                                                VIDEO_FORMAT_YUY2, VIDEO_FORMAT_UYVY};
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        struct obs_source_frame frames[2];
+        cpu_image_t images[2] = {{0}};
+        uint8_t *buffers[2];
+
+        memset(frames, 0, sizeof(frames));
+        frames[0].width = WIDTH;
+        frames[0].height = HEIGHT;
+        frames[0].format = formats[f];
+        memcpy(frames[0].color_matrix, bt709, sizeof(bt709));
+        for (int k = 0; k < 3; k++) {
+            frames[0].color_range_min[k] = 16.0f / 255.0f;
+            frames[0].color_range_max[k] = (k == 0 ? 235.0f : 240.0f) / 255.0f;
+        }
+        frames[1] = frames[0];
+
+        size_t size = frame_planes(&frames[0], NULL);
+        buffers[0] = bmalloc(size);
+        buffers[1] = bmalloc(size);
+        for (size_t i = 0; i < size; i++) buffers[0][i] = (uint8_t)test_random();
+        memcpy(buffers[1], buffers[0], size);
+        frame_planes(&frames[0], buffers[0]);
+        frame_planes(&frames[1], buffers[1]);
+
+        CHECK(cpu_kernels_round_trip_simd(&frames[0], &images[0]));
+        CHECK(cpu_kernels_round_trip_scalar(&frames[1], &images[1]));
+
+        int rgb_diff = images[0].pixels && images[1].pixels ? 0 : 256;
+        for (uint32_t y = 0; rgb_diff < 256 && y < HEIGHT; y++) {
+            for (uint32_t x = 0; x < WIDTH; x++) {
+                size_t i = (size_t)y * images[0].stride + x;
+                int d = channel_diff(images[0].pixels[i], images[1].pixels[i]);
+                if (d > rgb_diff) rgb_diff = d;
+            }
+        }
+        CHECK(rgb_diff <= 1);
+
+        int yuv_diff = 0;
+        for (size_t i = 0; i < size; i++) {
+            int d = abs((int)buffers[0][i] - (int)buffers[1][i]);
+            if (d > yuv_diff) yuv_diff = d;
+        }
+        CHECK(yuv_diff <= 1);
+
+        for (int i = 0; i < 2; i++) {
+            bfree(images[i].pixels);
+            bfree(buffers[i]);
+        }
+    }
+}
+
+// The CPU path measures frames for the auto modes in place of the render
+static void test_luma_frame(void) {
+    const effect_info_t *info = effects[0];
+    check_context("luma from frames", info);
+    enum { WIDTH = 21, HEIGHT = 9, STRIDE = 24 };
+
+    obs_data_t *settings = default_settings(info);
+    instance_t inst;
+    if (CHECK(instance_create(&inst, info, settings))) {
+        uint32_t pixels[STRIDE * HEIGHT];
+        for (size_t i = 0; i < STRIDE * HEIGHT; i++) pixels[i] = 0xFF808080u;
+        pixels[4 * STRIDE + 8] = 0xFFFFFFFFu;
+        cpu_image_t image = {pixels, WIDTH, HEIGHT, STRIDE};
+
+        luma_stats_measure_frame(inst.ed, &image);
+        const luma_stats_t *luma = &inst.ed->luma;
+        CHECK(luma->valid);
+        CHECK(fabsf(luma->peak - 1.0f) < 1e-4f);
+        CHECK(fabsf(luma->mean - (17.0f * 128.0f / 255.0f + 1.0f) / 18.0f) < 1e-4f); // Every 4th texel of every 4th row
+        CHECK(luma_stats_exposure(luma) > 1.0f);
+        instance_destroy(&inst);
+    }
+    obs_data_release(settings);
+}
+
+// Style network files as style-net.h lays them out, built in memory
+
+typedef struct {
+    uint8_t bytes[ESN_MAX_BYTES];
+    size_t size;
+} esn_file_t;
+
+static void esn_put(esn_file_t *file, const void *data, size_t size) {
+    if (file->size + size > sizeof(file->bytes)) return;
+    memcpy(file->bytes + file->size, data, size);
+    file->size += size;
+}
+
+static void esn_put_u16(esn_file_t *file, uint32_t value) {
+    uint8_t b[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+    esn_put(file, b, sizeof(b));
+}
+
+static void esn_put_u32(esn_file_t *file, uint32_t value) {
+    uint8_t b[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    esn_put(file, b, sizeof(b));
+}
+
+static void esn_put_f32(esn_file_t *file, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    esn_put_u32(file, bits);
+}
+
+static void esn_begin(esn_file_t *file, uint32_t layers) {
+    file->size = 0;
+    esn_put(file, "ESN1", 4);
+    esn_put_u32(file, layers);
+}
+
+static void esn_layer(esn_file_t *file, uint8_t op, uint32_t kernel, uint32_t in, uint32_t out) {
+    uint8_t head[4] = {op, STYLE_ACT_NONE, 0, STYLE_WEIGHTS_FP32};
+    esn_put(file, head, sizeof(head));
+    esn_put_u16(file, kernel);
+    esn_put_u16(file, 1);
+    esn_put_u16(file, in);
+    esn_put_u16(file, out);
+}
+
+// fp32 convolution passing channel c through to channel c, zero bias
+static void esn_identity_conv(esn_file_t *file, uint32_t kernel, uint32_t in, uint32_t out) {
+    esn_layer(file, STYLE_OP_CONV, kernel, in, out);
+    for (uint32_t ky = 0; ky < kernel; ky++) {
+        for (uint32_t kx = 0; kx < kernel; kx++) {
+            for (uint32_t i = 0; i < in; i++) {
+                for (uint32_t o = 0; o < out; o++) {
+                    bool centre = ky == kernel / 2 && kx == kernel / 2;
+                    esn_put_f32(file, centre && i == o ? 1.0f : 0.0f);
+                }
+            }
+        }
+    }
+    for (uint32_t o = 0; o < out; o++) esn_put_f32(file, 0.0f);
+}
+
+// Loads the first `size` bytes of `file`
+static style_net_t *esn_load(const esn_file_t *file, size_t size, char *error, size_t error_size) {
+    error[0] = '\0';
+    FILE *out = fopen(ESN_TEST_PATH, "wb");
+    if (!out) return NULL;
+    bool written = fwrite(file->bytes, 1, size, out) == size;
+    fclose(out);
+
+    style_net_t *net = written ? style_net_load(ESN_TEST_PATH, error, error_size) : NULL;
+    remove(ESN_TEST_PATH);
+    return net;
+}
+
+static bool esn_rejects(const esn_file_t *file, size_t size) {
+    char error[256];
+    style_net_t *net = esn_load(file, size, error, sizeof(error));
+    style_net_destroy(net);
+    return !net && error[0] != '\0';
+}
+
+// Runs `net` over random texels; true if it gives them back unchanged
+static bool esn_passes_through(style_net_t *net, uint32_t width, uint32_t height) {
+    uint32_t stride = width + 3; // Padding the network must not touch
+    size_t count = (size_t)stride * height;
+    uint32_t *src = bmalloc(sizeof(uint32_t) * count);
+    uint32_t *dst = bmalloc(sizeof(uint32_t) * count);
+    for (size_t i = 0; i < count; i++) src[i] = test_random();
+    memcpy(dst, src, sizeof(uint32_t) * count);
+
+    bool same = style_net_run(net, task_pool_shared(), src, dst, width, height, stride) &&
+                memcmp(src, dst, sizeof(uint32_t) * count) == 0;
+    bfree(src);
+    bfree(dst);
+    return same;
+}
+
+// Identity networks give back their input, a kernel wider than the image
+// included; truncated files and ones whose layers don't fit together are
+// refused with a reason
+static void test_style_net(void) {
+    check_context("style network", NULL);
+    esn_file_t *file = bzalloc(sizeof(esn_file_t));
+    char error[256];
+
+    esn_begin(file, 1);
+    esn_identity_conv(file, 1, 3, 3);
+    style_net_t *net = esn_load(file, file->size, error, sizeof(error));
+    if (CHECK(net)) {
+        CHECK(strcmp(style_net_precision(net), "fp32") == 0);
+        CHECK(style_net_alignment(net) == 1);
+        CHECK(esn_passes_through(net, 13, 7));
+        style_net_destroy(net);
+    }
+
+    // Reflection padding 4 texels into a 3 x 2 image
+    esn_begin(file, 2);
+    esn_identity_conv(file, 9, 3, 8);
+    esn_identity_conv(file, 9, 8, 3);
+    net = esn_load(file, file->size, error, sizeof(error));
+    if (CHECK(net)) {
+        CHECK(esn_passes_through(net, 3, 2));
+        CHECK(esn_passes_through(net, 1, 1));
+        style_net_destroy(net);
+    }
+
+    size_t full = file->size;
+    static const size_t cuts[] = {0, 3, 7, 12, 20, 100};
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) CHECK(esn_rejects(file, cuts[i]));
+    CHECK(esn_rejects(file, full - 1)); // Last bias
+    CHECK(esn_rejects(file, full / 2)); // Second layer's weights
+
+    esn_begin(file, 1);
+    esn_identity_conv(file, 1, 4, 3); // Four channels in, three arrive
+    CHECK(esn_rejects(file, file->size));
+
+    esn_begin(file, 1);
+    esn_identity_conv(file, 1, 3, 1); // Doesn't end in RGB
+    CHECK(esn_rejects(file, file->size));
+
+    esn_begin(file, 3);
+    esn_layer(file, STYLE_OP_RESIDUAL_BEGIN, 0, 0, 0);
+    esn_identity_conv(file, 3, 3, 8); // The block's output has another shape
+    esn_layer(file, STYLE_OP_RESIDUAL_ADD, 0, 0, 0);
+    CHECK(esn_rejects(file, file->size));
+
+    esn_begin(file, 2);
+    esn_identity_conv(file, 1, 3, 3);
+    esn_layer(file, STYLE_OP_UPSAMPLE, 0, 0, 0); // Past the input size
+    CHECK(esn_rejects(file, file->size));
+
+    bfree(file);
+}
+
+// Every effect renders a few frames with its defaults and with everything
+// changed, without errors
+static void test_render_smoke(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("render", info);
+
+        for (int perturbed = 0; perturbed < 2; perturbed++) {
+            obs_data_t *settings = default_settings(info);
+            if (perturbed) perturb_settings(info, settings);
+
+            unsigned long errors = mock_obs_log_count(LOG_ERROR);
+            instance_t inst;
+            if (CHECK(instance_create(&inst, info, settings))) {
+                CHECK(instance_bind(&inst));
+                for (int f = 0; f < SMOKE_FRAMES; f++) instance_frame(&inst);
+                instance_destroy(&inst);
+            }
+            CHECK(mock_obs_log_count(LOG_ERROR) == errors);
+            obs_data_release(settings);
+        }
+    }
+}
+
+// Creating and destroying an instance gives back everything it allocated.
+// Shared edge maps are keyed by source and age out on their own, so they
+// are dropped before counting.
+static void test_churn_leaks(void) {
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        check_context("churn", info);
+
+        obs_data_t *settings = default_settings(info);
+        instance_t inst;
+        instance_create(&inst, info, settings);
+        instance_bind(&inst);
+        instance_destroy(&inst);
+        edge_map_shutdown();
+
+        long allocs = bnum_allocs();
+        for (int i = 0; i < CHURN_LEAK_CYCLES; i++) {
+            if (!CHECK(instance_create(&inst, info, settings))) break;
+            instance_bind(&inst);
+            instance_frame(&inst);
+            instance_destroy(&inst);
+        }
+        edge_map_shutdown();
+        CHECK(bnum_allocs() == allocs);
+        obs_data_release(settings);
+    }
+}
+
+// --- Benchmarks ---
+
+typedef struct {
+    uint32_t iterations;
+    uint32_t instances;
+    const char *only_effect;
+    struct dstr json;
+    size_t results;
+} bench_t;
+
+static void add_result(bench_t *bench, const char *benchmark, const char *effect_id, const char *variant,
+                       uint64_t elapsed_ns, uint64_t ops) {
+    double ns_per_op = ops ? (double)elapsed_ns / (double)ops : 0.0;
+    fprintf(stderr, "%-20s %-24s %-10s %10.1f ns/op\n", benchmark, effect_id, variant, ns_per_op);
+    dstr_catf(&bench->json, "%s\n    {\"benchmark\": \"%s\", \"effect\": \"%s\", \"case\": \"%s\", \"ns_per_op\": %.1f}",
+              bench->results++ ? "," : "", benchmark, effect_id, variant, ns_per_op);
+}
+
+static instance_t *create_instances(const effect_info_t *info, obs_data_t *settings, uint32_t count, bool bind) {
+    instance_t *insts = bzalloc(sizeof(instance_t) * count);
+    for (uint32_t i = 0; i < count; i++) {
+        instance_create(&insts[i], info, settings);
+        if (bind) instance_bind(&insts[i]);
+        instance_tick(&insts[i]);
+    }
+    return insts;
+}
+
+static void destroy_instances(instance_t *insts, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) instance_destroy(&insts[i]);
+    bfree(insts);
+}
+
+// generic_update over many instances: settings as they were (the common
+// case, e.g. a scene collection reload) and every value changed; then the
+// effect's own update, which wraps it. That may start real work on a change
+// (the light leak's worker rebakes its noise, competing for the CPU), so it
+// runs once per iteration only.
+static void bench_update(bench_t *bench, const effect_info_t *info) {
+    obs_data_t *settings[2] = {default_settings(info), default_settings(info)};
+    perturb_settings(info, settings[1]);
+    instance_t *insts = create_instances(info, settings[0], bench->instances, false);
+    uint64_t ops = (uint64_t)bench->iterations * bench->instances;
+
+    uint64_t start = os_gettime_ns();
+    for (uint32_t n = 0; n < bench->iterations; n++) {
+        for (uint32_t i = 0; i < bench->instances; i++) generic_update(insts[i].ed, settings[0]);
+    }
+    add_result(bench, "generic_update", info->id, "unchanged", os_gettime_ns() - start, ops);
+
+    start = os_gettime_ns();
+    for (uint32_t n = 0; n < bench->iterations; n++) {
+        for (uint32_t i = 0; i < bench->instances; i++) generic_update(insts[i].ed, settings[(n + 1) & 1]);
+    }
+    add_result(bench, "generic_update", info->id, "changed", os_gettime_ns() - start, ops);
+
+    start = os_gettime_ns();
+    for (uint32_t n = 0; n < bench->iterations; n++) {
+        info->update(insts[n % bench->instances].ed, settings[(n / bench->instances + 1) & 1]);
+    }
+    add_result(bench, "effect_update", info->id, "changed", os_gettime_ns() - start, bench->iterations);
+
+    destroy_instances(insts, bench->instances);
+    obs_data_release(settings[0]);
+    obs_data_release(settings[1]);
+}
+
+// Per-frame cost of picking up an update: sync on tick, upload on draw.
+// Instances share the effect, so each apply after another instance
+// re-uploads everything, as in a scene with many copies of a filter.
+static void bench_sync_apply(bench_t *bench, const effect_info_t *info) {
+    obs_data_t *settings[2] = {default_settings(info), default_settings(info)};
+    perturb_settings(info, settings[1]);
+    instance_t *insts = create_instances(info, settings[0], bench->instances, true);
+    uint64_t ops = (uint64_t)bench->iterations * bench->instances;
+
+    uint64_t elapsed = 0;
+    for (uint32_t n = 0; n < bench->iterations; n++) {
+        for (uint32_t i = 0; i < bench->instances; i++) generic_update(insts[i].ed, settings[n & 1]);
+
+        uint64_t start = os_gettime_ns();
+        obs_enter_graphics();
+        for (uint32_t i = 0; i < bench->instances; i++) {
+            sync_effect_parameters(insts[i].ed);
+            apply_effect_parameters(insts[i].ed);
+        }
+        obs_leave_graphics();
+        elapsed += os_gettime_ns() - start;
+    }
+    add_result(bench, "sync_apply", info->id, "changed", elapsed, ops);
+
+    destroy_instances(insts, bench->instances);
+    obs_data_release(settings[0]);
+    obs_data_release(settings[1]);
+}
+
+// Create and destroy with the shader already compiled, as when scenes
+// switch or a collection loads; "bound" also takes the cached effect
+static void bench_churn(bench_t *bench, const effect_info_t *info) {
+    obs_data_t *settings = default_settings(info);
+    instance_t inst;
+
+    uint64_t start = os_gettime_ns();
+    for (uint32_t n = 0; n < bench->iterations; n++) {
+        instance_create(&inst, info, settings);
+        instance_destroy(&inst);
+    }
+    add_result(bench, "create_destroy", info->id, "unbound", os_gettime_ns() - start, bench->iterations);
+
+    start = os_gettime_ns();
+    for (uint32_t n = 0; n < bench->iterations; n++) {
+        instance_create(&inst, info, settings);
+        instance_bind(&inst);
+        instance_destroy(&inst);
+    }
+    add_result(bench, "create_destroy", info->id, "bound", os_gettime_ns() - start, bench->iterations);
+
+    obs_data_release(settings);
+}
+
+static void bench_shader_paths(bench_t *bench) {
+    static const char *const valid[] = {"shaders/bokeh.shader", "shaders/star-burst-multipass.shader",
+                                        "shaders/emulens-stack.shader", "shaders/light-leak.shader"};
+    static const char *const invalid[] = {"shaders/../bokeh.shader", "shaders/sub/bokeh.shader",
+                                          "effects/bokeh.shader", "shaders/bokeh.effect"};
+    const size_t count = sizeof(valid) / sizeof(valid[0]);
+    uint64_t rounds = (uint64_t)bench->iterations * PATH_ROUNDS_PER_ITERATION;
+    size_t accepted = 0;
+
+    uint64_t start = os_gettime_ns();
+    for (uint64_t n = 0; n < rounds; n++) {
+        for (size_t i = 0; i < count; i++) accepted += is_valid_shader_path(valid[i]);
+    }
+    add_result(bench, "is_valid_shader_path", "all", "valid", os_gettime_ns() - start, rounds * count);
+
+    start = os_gettime_ns();
+    for (uint64_t n = 0; n < rounds; n++) {
+        for (size_t i = 0; i < count; i++) accepted += is_valid_shader_path(invalid[i]);
+    }
+    add_result(bench, "is_valid_shader_path", "all", "invalid", os_gettime_ns() - start, rounds * count);
+
+    CHECK(accepted == rounds * count);
+}
+
+static void run_benchmarks(bench_t *bench) {
+    dstr_printf(&bench->json, "{\n  \"iterations\": %u,\n  \"instances\": %u,\n  \"results\": [",
+                bench->iterations, bench->instances);
+
+    for (size_t e = 0; e < num_effects; e++) {
+        const effect_info_t *info = effects[e];
+        if (bench->only_effect && strcmp(bench->only_effect, info->id) != 0) continue;
+
+        bench_update(bench, info);
+        bench_sync_apply(bench, info);
+        bench_churn(bench, info);
+    }
+    bench_shader_paths(bench);
+
+    dstr_cat(&bench->json, "\n  ]\n}\n");
+    printf("%s", bench->json.array);
+    dstr_free(&bench->json);
+}
+
+// --- Main ---
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: core-bench [--bench] [--iterations N] [--instances N] [--effect ID] [--data DIR] [--verbose]\n"
+            "Runs the core's unit tests; --bench also prints CPU timings as JSON.\n");
+}
+
+int main(int argc, char **argv) {
+    bench_t bench = {.iterations = 200, .instances = 64};
+    const char *data_path = EMULENS_CORE_BENCH_DATA;
+    bool run_bench = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--bench") == 0) {
+            run_bench = true;
+        } else if (strcmp(argv[i], "--iterations") == 0 && has_value) {
+            bench.iterations = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--instances") == 0 && has_value) {
+            bench.instances = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--effect") == 0 && has_value) {
+            bench.only_effect = argv[++i];
+        } else if (strcmp(argv[i], "--data") == 0 && has_value) {
+            data_path = argv[++i];
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            mock_obs_set_log_level(LOG_DEBUG);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (bench.iterations == 0) bench.iterations = 1;
+    if (bench.instances == 0) bench.instances = 1;
+    mock_obs_set_data_path(data_path);
+
+    // As obs_module_load: compile every shader in the background up front
+    for (size_t e = 0; e < num_effects; e++) {
+        effect_cache_prefetch(effects[e]->shader_path);
+        for (const char *const *extra = effects[e]->extra_shaders; extra && *extra; extra++) {
+            effect_cache_prefetch(*extra);
+        }
+    }
+
+    test_shader_paths();
+    test_param_store();
+    test_defaults();
+    test_update_sync();
+    test_sync_race();
+    test_apply();
+    test_quality_scale();
+    test_quality_render_scale();
+    test_variant_defines();
+    test_governed_variants();
+    test_tileable_noise();
+    test_blue_noise();
+    test_simd_agreement();
+    test_luma_frame();
+    test_style_net();
+    test_render_smoke();
+    test_churn_leaks();
+    fprintf(stderr, "core-bench: %lu checks, %lu failed\n", checks_run, checks_failed);
+
+    if (run_bench && checks_failed == 0) run_benchmarks(&bench);
+
+    // As obs_module_unload
+    task_pool_shared_release();
+    edge_map_shutdown();
+    luma_stats_shutdown();
+    effect_cache_shutdown();
+
+    return checks_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+/*
+ * bench/cpu-kernels.c
+ * Builds cpu-filter.c's conversions under the names in cpu-kernels.h.
+ * CMake compiles this file once per CPU_KERNELS_SUFFIX, the scalar one
+ * with EMULENS_NO_SIMD.
+ */
+
+#define CPU_KERNELS_PASTE(name, suffix) name##_##suffix
+#define CPU_KERNELS_NAME(name, suffix) CPU_KERNELS_PASTE(name, suffix)
+#define CPU_KERNEL(name) CPU_KERNELS_NAME(name, CPU_KERNELS_SUFFIX)
+
+// The plugin's own copy is linked too
+#define cpu_filter_video CPU_KERNEL(cpu_filter_video)
+#define cpu_filter_skip_render CPU_KERNEL(cpu_filter_skip_render)
+#define cpu_filter_free CPU_KERNEL(cpu_filter_free)
+
+#include "core/cpu-filter.c"
+#include "cpu-kernels.h"
+
+void CPU_KERNEL(cpu_kernels_sample)(const cpu_image_t *image, const float *u, const float *v, size_t count,
+                                    uint32_t *out) {
+    for (size_t i = 0; i + SIMD_LANES <= count; i += SIMD_LANES) {
+        cpu_store_rgba(out, (uint32_t)i, cpu_sample_rgba(image, simd_load(u + i), simd_load(v + i)));
+    }
+}
+
+bool CPU_KERNEL(cpu_kernels_round_trip)(struct obs_source_frame *frame, cpu_image_t *image) {
+    frame_desc_t desc;
+    frame_job_t job;
+    if (!frame_describe(frame->format, &desc) || !frame_job_init(&job, frame, &desc, image) ||
+        !cpu_image_reserve(image, frame->width, frame->height)) {
+        return false;
+    }
+
+    bool rgb = desc.layout == LAYOUT_RGBA || desc.layout == LAYOUT_BGRA || desc.layout == LAYOUT_BGRX;
+    (rgb ? unpack_rgb_rows : unpack_yuv_rows)(&job, 0, frame->height);
+    (rgb ? pack_rgb_rows : pack_yuv_rows)(&job, 0, frame->height);
+    return true;
+}
@@ -0,0 +1,22 @@
+/*
+ * bench/cpu-kernels.h
+ * The CPU path's sampling and YUV conversion kernels, built twice: with
+ * the SIMD lanes the plugin uses (*_simd) and with EMULENS_NO_SIMD
+ * (*_scalar), so core-bench can hold one against the other
+ */
+
+#pragma once
+
+#include "effect-core.h"
+
+// Samples `image` at `count` UV pairs, a multiple of 8, into RGBA8 texels
+// with cpu_sample_rgba. Converts `frame` to RGBA8 in `image` and back in
+// place, as cpu_filter_video does around filter_frame; false for formats
+// the CPU path doesn't handle. The caller bfrees image->pixels.
+#define CPU_KERNELS_DECLARE(suffix)                                                                              \
+    void cpu_kernels_sample_##suffix(const cpu_image_t *image, const float *u, const float *v, size_t count,   \
+                                     uint32_t *out);                                                          \
+    bool cpu_kernels_round_trip_##suffix(struct obs_source_frame *frame, cpu_image_t *image);
+
+CPU_KERNELS_DECLARE(simd)
+CPU_KERNELS_DECLARE(scalar)
@@ -0,0 +1,344 @@
+/*
+ * bench/emulens-bench.c
+ * Headless render benchmark: loads the built plugin into libobs on a
+ * software OpenGL context and reports ms/frame per effect as JSON
+ */
+
+#include <obs.h>
+#include <obs-nix-platform.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SOURCE_ID "emulens_bench_pattern"
+#define BENCH_PATTERN_SIZE 256
+#define BENCH_FPS 1000          // Far above what's reachable, so frames run back to back
+#define BENCH_WARMUP_FRAMES 30  // Lets the loader compile shaders before measuring
+#define BENCH_MAX_FILTER_TYPES 64
+
+#ifndef EMULENS_BENCH_PLUGIN
+#define EMULENS_BENCH_PLUGIN "obs-emulens.so"
+#endif
+#ifndef EMULENS_BENCH_DATA
+#define EMULENS_BENCH_DATA "data"
+#endif
+
+typedef struct {
+    uint32_t width, height;
+    const char *name;
+} bench_resolution_t;
+
+static const bench_resolution_t resolutions[] = {
+    {1280, 720, "720p"},
+    {1920, 1080, "1080p"},
+    {3840, 2160, "4k"},
+};
+
+// Settings applied over an effect's defaults. Every effect also runs with
+// plain defaults; these push the expensive paths.
+typedef struct {
+    const char *effect_id;
+    const char *name;
+    const char *json;
+} bench_preset_t;
+
+static const bench_preset_t presets[] = {
+    {"handheld_effect", "quake_motion_blur",
+     "{\"preset\": 4, \"blurMode\": 1, \"maxBlurTaps\": 32, \"blurDownsample\": false}"},
+    {"handheld_effect", "quake_downsampled", "{\"preset\": 4, \"blurMode\": 1, \"blurDownsample\": true}"},
+    {"liteleke_effect", "complex_screen", "{\"noiseComplexity\": 8.0, \"blendMode\": 2, \"grainAmount\": 0.5}"},
+    {"liteleke_effect", "quarter_scale", "{\"noiseComplexity\": 8.0, \"render_scale\": 2}"},
+    {"star_burst_effect", "max_quality", "{\"ray_sample_count\": 12, \"StarPoints\": 16, \"RayLength\": 0.5}"},
+    {"star_burst_effect", "multi_pass", "{\"StarPoints\": 16, \"RayLength\": 0.5, \"multi_pass\": true}"},
+    {"star_burst_effect", "auto_threshold",
+     "{\"StarPoints\": 16, \"RayLength\": 0.5, \"multi_pass\": true, \"auto_threshold\": true}"},
+    {"bokeh_effect", "dense_cells",
+     "{\"particle_density\": 100.0, \"use_polygons\": true, \"enable_chromatic_aberration\": true}"},
+    {"bokeh_effect", "sprites", "{\"bokeh_mode\": 1, \"sprite_count\": 5000}"},
+    {"bokeh_effect", "brightness_cells", "{\"particle_density\": 100.0, \"enable_source_brightness_affect\": true}"},
+    {"canny_edge_effect", "max_linking", "{\"hysteresis_passes\": 16, \"overlay_source\": true}"},
+    {"canny_edge_effect", "quarter_res", "{\"edge_resolution\": 2}"},
+};
+
+// --- Test pattern source ---
+// Gradient with a grid of bright dots, so threshold-driven effects (star
+// burst, bokeh brightness) have highlights to work on.
+
+typedef struct {
+    gs_texture_t *texture;
+} pattern_t;
+
+static uint32_t bench_width = 1280;
+static uint32_t bench_height = 720;
+
+static const char *pattern_get_name(void *type_data) {
+    (void)type_data;
+    return "EmuLens Bench Pattern";
+}
+
+static void *pattern_create(obs_data_t *settings, obs_source_t *source) {
+    (void)settings;
+    (void)source;
+    pattern_t *pattern = bzalloc(sizeof(pattern_t));
+
+    uint32_t *pixels = bmalloc(BENCH_PATTERN_SIZE * BENCH_PATTERN_SIZE * sizeof(uint32_t));
+    for (uint32_t y = 0; y < BENCH_PATTERN_SIZE; y++) {
+        for (uint32_t x = 0; x < BENCH_PATTERN_SIZE; x++) {
+            bool dot = (x % 32) < 3 && (y % 32) < 3;
+            uint32_t r = dot ? 255 : x * 200 / BENCH_PATTERN_SIZE;
+            uint32_t g = dot ? 255 : y * 200 / BENCH_PATTERN_SIZE;
+            uint32_t b = dot ? 255 : 96;
+            pixels[y * BENCH_PATTERN_SIZE + x] = 0xFF000000u | (b << 16) | (g << 8) | r;
+        }
+    }
+
+    const uint8_t *levels[1] = {(const uint8_t *)pixels};
+    obs_enter_graphics();
+    pattern->texture = gs_texture_create(BENCH_PATTERN_SIZE, BENCH_PATTERN_SIZE, GS_RGBA, 1, levels, 0);
+    obs_leave_graphics();
+
+    bfree(pixels);
+    return pattern;
+}
+
+static void pattern_destroy(void *data) {
+    pattern_t *pattern = data;
+    obs_enter_graphics();
+    gs_texture_destroy(pattern->texture);
+    obs_leave_graphics();
+    bfree(pattern);
+}
+
+static uint32_t pattern_get_width(void *data) {
+    (void)data;
+    return bench_width;
+}
+
+static uint32_t pattern_get_height(void *data) {
+    (void)data;
+    return bench_height;
+}
+
+static void pattern_render(void *data, gs_effect_t *effect) {
+    (void)effect;
+    pattern_t *pattern = data;
+    gs_effect_t *draw = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_effect_set_texture(gs_effect_get_param_by_name(draw, "image"), pattern->texture);
+    while (gs_effect_loop(draw, "Draw")) {
+        gs_draw_sprite(pattern->texture, 0, bench_width, bench_height);
+    }
+}
+
+static struct obs_source_info pattern_info = {
+    .id = BENCH_SOURCE_ID,
+    .type = OBS_SOURCE_TYPE_INPUT,
+    .output_flags = OBS_SOURCE_VIDEO,
+    .get_name = pattern_get_name,
+    .create = pattern_create,
+    .destroy = pattern_destroy,
+    .get_width = pattern_get_width,
+    .get_height = pattern_get_height,
+    .video_render = pattern_render,
+};
+
+// --- Measurement ---
+
+static bool reset_video(uint32_t width, uint32_t height) {
+    bench_width = width;
+    bench_height = height;
+
+    struct obs_video_info ovi = {
+        .graphics_module = "libobs-opengl",
+        .fps_num = BENCH_FPS,
+        .fps_den = 1,
+        .base_width = width,
+        .base_height = height,
+        .output_width = width,
+        .output_height = height,
+        .output_format = VIDEO_FORMAT_RGBA,
+        .adapter = 0,
+        .gpu_conversion = true,
+        .colorspace = VIDEO_CS_709,
+        .range = VIDEO_RANGE_FULL,
+        .scale_type = OBS_SCALE_BILINEAR,
+    };
+    return obs_reset_video(&ovi) == OBS_VIDEO_SUCCESS;
+}
+
+static void wait_frames(uint32_t frames) {
+    uint32_t target = obs_get_total_frames() + frames;
+    while (obs_get_total_frames() < target) os_sleep_ms(1);
+}
+
+// Wall time per frame with `source` as the output, once warmed up. The
+// graphics thread renders back to back at BENCH_FPS, so this is frame cost.
+static double measure_ms(obs_source_t *source, uint32_t frames) {
+    obs_set_output_source(0, source);
+    wait_frames(BENCH_WARMUP_FRAMES);
+
+    uint32_t start_frame = obs_get_total_frames();
+    uint64_t start_ns = os_gettime_ns();
+    wait_frames(frames);
+    uint64_t elapsed_ns = os_gettime_ns() - start_ns;
+    uint32_t rendered = obs_get_total_frames() - start_frame;
+
+    obs_set_output_source(0, NULL);
+    return rendered ? (double)elapsed_ns / 1000000.0 / rendered : 0.0;
+}
+
+static void add_result(obs_data_array_t *results, const char *effect_id, const char *preset,
+                       const bench_resolution_t *res, double ms, double baseline_ms) {
+    obs_data_t *item = obs_data_create();
+    obs_data_set_string(item, "effect", effect_id);
+    obs_data_set_string(item, "preset", preset);
+    obs_data_set_string(item, "resolution", res->name);
+    obs_data_set_int(item, "width", res->width);
+    obs_data_set_int(item, "height", res->height);
+    obs_data_set_double(item, "ms_per_frame", ms);
+    obs_data_set_double(item, "effect_ms", ms - baseline_ms);
+    obs_data_array_push_back(results, item);
+    obs_data_release(item);
+}
+
+static void run_case(obs_data_array_t *results, obs_source_t *pattern, const char *effect_id,
+                     const char *preset, const char *json, const bench_resolution_t *res,
+                     double baseline_ms, uint32_t frames) {
+    obs_data_t *settings = json ? obs_data_create_from_json(json) : obs_data_create();
+    obs_source_t *filter = obs_source_create(effect_id, "bench filter", settings, NULL);
+    obs_data_release(settings);
+    if (!filter) {
+        fprintf(stderr, "emulens-bench: failed to create %s\n", effect_id);
+        return;
+    }
+
+    obs_source_filter_add(pattern, filter);
+    double ms = measure_ms(pattern, frames);
+    obs_source_filter_remove(pattern, filter);
+    obs_source_release(filter);
+
+    fprintf(stderr, "%-24s %-20s %-6s %8.3f ms/frame\n", effect_id, preset, res->name, ms - baseline_ms);
+    add_result(results, effect_id, preset, res, ms, baseline_ms);
+}
+
+// Filter types registered by the plugin: those that appear after loading it
+static size_t plugin_filter_ids(const char **before, size_t num_before, const char **out) {
+    size_t count = 0;
+    const char *id;
+    for (size_t i = 0; obs_enum_filter_types(i, &id) && count < BENCH_MAX_FILTER_TYPES; i++) {
+        bool known = false;
+        for (size_t j = 0; j < num_before && !known; j++) known = strcmp(before[j], id) == 0;
+        if (!known) out[count++] = id;
+    }
+    return count;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: emulens-bench [--plugin PATH] [--data DIR] [--frames N] [--effect ID]\n"
+            "Runs under an X server (e.g. xvfb-run) with Mesa's llvmpipe; needs no GPU.\n");
+}
+
+int main(int argc, char **argv) {
+    const char *plugin_path = EMULENS_BENCH_PLUGIN;
+    const char *data_path = EMULENS_BENCH_DATA;
+    const char *only_effect = NULL;
+    uint32_t frames = 120;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--plugin") == 0 && has_value) {
+            plugin_path = argv[++i];
+        } else if (strcmp(argv[i], "--data") == 0 && has_value) {
+            data_path = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            frames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--effect") == 0 && has_value) {
+            only_effect = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (frames == 0) frames = 1;
+
+    // libobs' EGL backend needs a native display; under Xvfb with
+    // LIBGL_ALWAYS_SOFTWARE Mesa renders on llvmpipe
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    Display *display = XOpenDisplay(NULL);
+    if (!display) {
+        fprintf(stderr, "emulens-bench: no X display, run under xvfb-run\n");
+        return 1;
+    }
+    obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+    obs_set_nix_platform_display(display);
+
+    int rc = 1;
+    if (!obs_startup("en-US", NULL, NULL)) {
+        fprintf(stderr, "emulens-bench: obs_startup failed\n");
+        goto close_display;
+    }
+    if (!reset_video(resolutions[0].width, resolutions[0].height)) {
+        fprintf(stderr, "emulens-bench: failed to start the OpenGL backend\n");
+        goto shutdown;
+    }
+    obs_register_source(&pattern_info);
+
+    const char *before[BENCH_MAX_FILTER_TYPES];
+    size_t num_before = 0;
+    const char *id;
+    while (num_before < BENCH_MAX_FILTER_TYPES && obs_enum_filter_types(num_before, &id)) {
+        before[num_before++] = id;
+    }
+
+    obs_module_t *module = NULL;
+    if (obs_open_module(&module, plugin_path, data_path) != MODULE_SUCCESS || !obs_init_module(module)) {
+        fprintf(stderr, "emulens-bench: failed to load %s\n", plugin_path);
+        goto shutdown;
+    }
+
+    const char *effect_ids[BENCH_MAX_FILTER_TYPES];
+    size_t num_effects = plugin_filter_ids(before, num_before, effect_ids);
+
+    obs_data_t *report = obs_data_create();
+    obs_data_array_t *results = obs_data_array_create();
+    obs_data_set_string(report, "renderer", "libobs-opengl");
+    obs_data_set_int(report, "frames", frames);
+
+    for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++) {
+        const bench_resolution_t *res = &resolutions[r];
+        if (!reset_video(res->width, res->height)) {
+            fprintf(stderr, "emulens-bench: failed to reset video to %s\n", res->name);
+            continue;
+        }
+
+        obs_source_t *pattern = obs_source_create(BENCH_SOURCE_ID, "bench pattern", NULL, NULL);
+        double baseline_ms = measure_ms(pattern, frames);
+        add_result(results, "none", "baseline", res, baseline_ms, baseline_ms);
+
+        for (size_t e = 0; e < num_effects; e++) {
+            if (only_effect && strcmp(only_effect, effect_ids[e]) != 0) continue;
+
+            run_case(results, pattern, effect_ids[e], "defaults", NULL, res, baseline_ms, frames);
+            for (size_t p = 0; p < sizeof(presets) / sizeof(presets[0]); p++) {
+                if (strcmp(presets[p].effect_id, effect_ids[e]) != 0) continue;
+                run_case(results, pattern, effect_ids[e], presets[p].name, presets[p].json, res, baseline_ms, frames);
+            }
+        }
+        obs_source_release(pattern);
+    }
+
+    obs_data_set_array(report, "results", results);
+    printf("%s\n", obs_data_get_json(report));
+    obs_data_array_release(results);
+    obs_data_release(report);
+    rc = 0;
+
+shutdown:
+    obs_shutdown();
+close_display:
+    XCloseDisplay(display);
+    return rc;
+}
@@ -0,0 +1,1371 @@
+/*
+ * bench/mock-obs/mock-obs.c
+ * libobs stand-in for bench/core-bench.c, see mock-obs.h
+ */
+
+#include "mock-obs.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <time.h>
+
+// --- Logging ---
+
+static int print_level = LOG_ERROR;
+static unsigned long log_counts[4]; // Per level: error, warning, info, debug
+
+void mock_obs_set_log_level(int level) {
+    print_level = level;
+}
+
+unsigned long mock_obs_log_count(int level) {
+    unsigned long total = 0;
+    for (int i = 0; i < 4 && (i + 1) * 100 <= level; i++) {
+        total += __atomic_load_n(&log_counts[i], __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+// Formats every message, as libobs' log handler does, so logging costs
+// what it would in OBS whether or not it is printed
+void blogva(int log_level, const char *format, va_list args) {
+    char message[4096];
+    vsnprintf(message, sizeof(message), format, args);
+
+    int index = log_level / 100 - 1;
+    if (index >= 0 && index < 4) __atomic_add_fetch(&log_counts[index], 1, __ATOMIC_RELAXED);
+    if (log_level > print_level) return;
+
+    static const char *const names[] = {"error", "warning", "info", "debug"};
+    fprintf(stderr, "%s: %s\n", index >= 0 && index < 4 ? names[index] : "log", message);
+}
+
+void blog(int log_level, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    blogva(log_level, format, args);
+    va_end(args);
+}
+
+// --- Memory ---
+
+static long num_allocs = 0;
+
+void *bmalloc(size_t size) {
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        fprintf(stderr, "Out of memory allocating %zu bytes\n", size);
+        abort();
+    }
+    __atomic_add_fetch(&num_allocs, 1, __ATOMIC_RELAXED);
+    return ptr;
+}
+
+void *brealloc(void *ptr, size_t size) {
+    if (!ptr) return bmalloc(size);
+    void *grown = realloc(ptr, size ? size : 1);
+    if (!grown) {
+        fprintf(stderr, "Out of memory reallocating %zu bytes\n", size);
+        abort();
+    }
+    return grown;
+}
+
+void *bzalloc(size_t size) {
+    void *ptr = bmalloc(size);
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void bfree(void *ptr) {
+    if (!ptr) return;
+    __atomic_sub_fetch(&num_allocs, 1, __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+char *bstrdup(const char *str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char *copy = bmalloc(len + 1);
+    memcpy(copy, str, len + 1);
+    return copy;
+}
+
+long bnum_allocs(void) {
+    return __atomic_load_n(&num_allocs, __ATOMIC_RELAXED);
+}
+
+// --- Strings ---
+
+static void dstr_ensure_capacity(struct dstr *dst, size_t capacity) {
+    if (capacity <= dst->capacity) return;
+    size_t grown = dst->capacity ? dst->capacity * 2 : 16;
+    if (grown < capacity) grown = capacity;
+    dst->array = brealloc(dst->array, grown);
+    dst->capacity = grown;
+}
+
+void dstr_free(struct dstr *dst) {
+    bfree(dst->array);
+    dst->array = NULL;
+    dst->len = 0;
+    dst->capacity = 0;
+}
+
+void dstr_copy(struct dstr *dst, const char *array) {
+    if (!array || !*array) {
+        dstr_free(dst);
+        return;
+    }
+    size_t len = strlen(array);
+    dstr_ensure_capacity(dst, len + 1);
+    memcpy(dst->array, array, len + 1);
+    dst->len = len;
+}
+
+static void dstr_ncat(struct dstr *dst, const char *array, size_t len) {
+    if (!len) return;
+    dstr_ensure_capacity(dst, dst->len + len + 1);
+    memcpy(dst->array + dst->len, array, len);
+    dst->len += len;
+    dst->array[dst->len] = '\0';
+}
+
+void dstr_cat(struct dstr *dst, const char *array) {
+    if (array) dstr_ncat(dst, array, strlen(array));
+}
+
+static void dstr_vcatf(struct dstr *dst, const char *format, va_list args) {
+    va_list measure;
+    va_copy(measure, args);
+    int len = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+    if (len <= 0) return;
+
+    dstr_ensure_capacity(dst, dst->len + (size_t)len + 1);
+    vsnprintf(dst->array + dst->len, (size_t)len + 1, format, args);
+    dst->len += (size_t)len;
+}
+
+void dstr_catf(struct dstr *dst, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    dstr_vcatf(dst, format, args);
+    va_end(args);
+}
+
+void dstr_printf(struct dstr *dst, const char *format, ...) {
+    if (dst->array) dst->array[0] = '\0';
+    dst->len = 0;
+
+    va_list args;
+    va_start(args, format);
+    dstr_vcatf(dst, format, args);
+    va_end(args);
+
+    if (!dst->len) dstr_free(dst);
+}
+
+void dstr_replace(struct dstr *str, const char *find, const char *replace) {
+    if (!str->array || !find || !*find) return;
+
+    size_t find_len = strlen(find);
+    struct dstr out = {0};
+    const char *pos = str->array;
+    for (const char *hit; (hit = strstr(pos, find)) != NULL; pos = hit + find_len) {
+        dstr_ncat(&out, pos, (size_t)(hit - pos));
+        dstr_cat(&out, replace);
+    }
+    dstr_cat(&out, pos);
+
+    dstr_free(str);
+    *str = out;
+}
+
+void dstr_depad(struct dstr *dst) {
+    if (!dst->array) return;
+
+    size_t start = 0;
+    while (start < dst->len && isspace((unsigned char)dst->array[start])) start++;
+    size_t end = dst->len;
+    while (end > start && isspace((unsigned char)dst->array[end - 1])) end--;
+
+    memmove(dst->array, dst->array + start, end - start);
+    dst->len = end - start;
+    dst->array[dst->len] = '\0';
+    if (!dst->len) dstr_free(dst);
+}
+
+// --- Platform ---
+
+uint64_t os_gettime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+char *os_quick_read_utf8_file(const char *path) {
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    char *text = bmalloc((size_t)size + 1);
+    size_t read = fread(text, 1, (size_t)size, file);
+    fclose(file);
+    text[read] = '\0';
+
+    // Skip a byte order mark
+    if (read >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0) memmove(text, text + 3, read - 2);
+    return text;
+}
+
+// --- Threading ---
+
+struct os_sem_data {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+};
+
+int os_sem_init(os_sem_t **sem, int value) {
+    os_sem_t *s = bzalloc(sizeof(os_sem_t));
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->count = value;
+    *sem = s;
+    return 0;
+}
+
+void os_sem_destroy(os_sem_t *sem) {
+    if (!sem) return;
+    pthread_mutex_destroy(&sem->mutex);
+    pthread_cond_destroy(&sem->cond);
+    bfree(sem);
+}
+
+int os_sem_post(os_sem_t *sem) {
+    if (!sem) return -1;
+    pthread_mutex_lock(&sem->mutex);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+    return 0;
+}
+
+int os_sem_wait(os_sem_t *sem) {
+    if (!sem) return -1;
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count <= 0) pthread_cond_wait(&sem->cond, &sem->mutex);
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+    return 0;
+}
+
+void os_set_thread_name(const char *name) {
+    (void)name;
+}
+
+// --- Graphics: resources ---
+
+struct gs_texture {
+    uint32_t width;
+    uint32_t height;
+    enum gs_color_format format;
+};
+
+struct gs_texture_render {
+    enum gs_color_format format;
+    gs_texture_t *texture;
+    bool rendered;              // Like libobs, begin fails again until reset
+};
+
+struct gs_stage_surface {
+    uint32_t width;
+    uint32_t height;
+    uint32_t linesize;
+    uint8_t *data;
+};
+
+struct gs_vertex_buffer {
+    struct gs_vb_data *data;
+};
+
+struct gs_timer {
+    int unused;
+};
+
+struct gs_timer_range {
+    int unused;
+};
+
+static uint32_t format_bytes(enum gs_color_format format) {
+    switch (format) {
+        case GS_A8:
+        case GS_R8: return 1;
+        case GS_R16:
+        case GS_R16F: return 2;
+        case GS_RGBA16:
+        case GS_RGBA16F:
+        case GS_RG32F: return 8;
+        case GS_RGBA32F: return 16;
+        default: return 4;
+    }
+}
+
+gs_texture_t *gs_texture_create(uint32_t width, uint32_t height, enum gs_color_format color_format,
+                                uint32_t levels, const uint8_t **data, uint32_t flags) {
+    (void)levels;
+    (void)data;
+    (void)flags;
+    gs_texture_t *tex = bzalloc(sizeof(gs_texture_t));
+    tex->width = width;
+    tex->height = height;
+    tex->format = color_format;
+    return tex;
+}
+
+void gs_texture_destroy(gs_texture_t *tex) {
+    bfree(tex);
+}
+
+void gs_texture_set_image(gs_texture_t *tex, const uint8_t *data, uint32_t linesize, bool invert) {
+    (void)tex;
+    (void)data;
+    (void)linesize;
+    (void)invert;
+}
+
+gs_texrender_t *gs_texrender_create(enum gs_color_format format, enum gs_zstencil_format zsformat) {
+    (void)zsformat;
+    gs_texrender_t *texrender = bzalloc(sizeof(gs_texrender_t));
+    texrender->format = format;
+    return texrender;
+}
+
+void gs_texrender_destroy(gs_texrender_t *texrender) {
+    if (!texrender) return;
+    gs_texture_destroy(texrender->texture);
+    bfree(texrender);
+}
+
+bool gs_texrender_begin(gs_texrender_t *texrender, uint32_t cx, uint32_t cy) {
+    if (!texrender || texrender->rendered || !cx || !cy) return false;
+
+    gs_texture_t *tex = texrender->texture;
+    if (!tex || tex->width != cx || tex->height != cy) {
+        gs_texture_destroy(tex);
+        texrender->texture = gs_texture_create(cx, cy, texrender->format, 1, NULL, GS_RENDER_TARGET);
+    }
+    return true;
+}
+
+bool gs_texrender_begin_with_color_space(gs_texrender_t *texrender, uint32_t cx, uint32_t cy,
+                                         enum gs_color_space space) {
+    (void)space;
+    return gs_texrender_begin(texrender, cx, cy);
+}
+
+void gs_texrender_end(gs_texrender_t *texrender) {
+    if (texrender) texrender->rendered = true;
+}
+
+void gs_texrender_reset(gs_texrender_t *texrender) {
+    if (texrender) texrender->rendered = false;
+}
+
+gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender) {
+    return texrender ? texrender->texture : NULL;
+}
+
+enum gs_color_format gs_texrender_get_format(const gs_texrender_t *texrender) {
+    return texrender ? texrender->format : GS_UNKNOWN;
+}
+
+gs_stagesurf_t *gs_stagesurface_create(uint32_t width, uint32_t height, enum gs_color_format color_format) {
+    gs_stagesurf_t *surf = bzalloc(sizeof(gs_stagesurf_t));
+    surf->width = width;
+    surf->height = height;
+    surf->linesize = width * format_bytes(color_format);
+    surf->data = bzalloc((size_t)surf->linesize * height);
+    return surf;
+}
+
+void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf) {
+    if (!stagesurf) return;
+    bfree(stagesurf->data);
+    bfree(stagesurf);
+}
+
+uint32_t gs_stagesurface_get_width(const gs_stagesurf_t *stagesurf) {
+    return stagesurf ? stagesurf->width : 0;
+}
+
+uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf) {
+    return stagesurf ? stagesurf->height : 0;
+}
+
+bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data, uint32_t *linesize) {
+    if (!stagesurf) return false;
+    *data = stagesurf->data;
+    *linesize = stagesurf->linesize;
+    return true;
+}
+
+void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf) {
+    (void)stagesurf;
+}
+
+void gs_stage_texture(gs_stagesurf_t *dst, gs_texture_t *src) {
+    (void)dst;
+    (void)src;
+}
+
+struct gs_vb_data *gs_vbdata_create(void) {
+    return bzalloc(sizeof(struct gs_vb_data));
+}
+
+void gs_vbdata_destroy(struct gs_vb_data *data) {
+    if (!data) return;
+    bfree(data->points);
+    bfree(data->normals);
+    bfree(data->tangents);
+    bfree(data->colors);
+    for (size_t i = 0; data->tvarray && i < data->num_tex; i++) bfree(data->tvarray[i].array);
+    bfree(data->tvarray);
+    bfree(data);
+}
+
+gs_vertbuffer_t *gs_vertexbuffer_create(struct gs_vb_data *data, uint32_t flags) {
+    (void)flags;
+    gs_vertbuffer_t *vb = bzalloc(sizeof(gs_vertbuffer_t));
+    vb->data = data;
+    return vb;
+}
+
+void gs_vertexbuffer_destroy(gs_vertbuffer_t *vertbuffer) {
+    if (!vertbuffer) return;
+    gs_vbdata_destroy(vertbuffer->data);
+    bfree(vertbuffer);
+}
+
+void gs_vertexbuffer_flush(gs_vertbuffer_t *vertbuffer) {
+    (void)vertbuffer;
+}
+
+struct gs_vb_data *gs_vertexbuffer_get_data(const gs_vertbuffer_t *vertbuffer) {
+    return vertbuffer ? vertbuffer->data : NULL;
+}
+
+void gs_load_vertexbuffer(gs_vertbuffer_t *vertbuffer) {
+    (void)vertbuffer;
+}
+
+void gs_load_indexbuffer(gs_indexbuffer_t *indexbuffer) {
+    (void)indexbuffer;
+}
+
+// Queries never complete, as on a GPU that's always a few frames behind
+gs_timer_t *gs_timer_create(void) {
+    return bzalloc(sizeof(gs_timer_t));
+}
+
+void gs_timer_destroy(gs_timer_t *timer) {
+    bfree(timer);
+}
+
+void gs_timer_begin(gs_timer_t *timer) {
+    (void)timer;
+}
+
+void gs_timer_end(gs_timer_t *timer) {
+    (void)timer;
+}
+
+bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks) {
+    (void)timer;
+    *ticks = 0;
+    return false;
+}
+
+gs_timer_range_t *gs_timer_range_create(void) {
+    return bzalloc(sizeof(gs_timer_range_t));
+}
+
+void gs_timer_range_destroy(gs_timer_range_t *range) {
+    bfree(range);
+}
+
+void gs_timer_range_begin(gs_timer_range_t *range) {
+    (void)range;
+}
+
+void gs_timer_range_end(gs_timer_range_t *range) {
+    (void)range;
+}
+
+bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint, uint64_t *frequency) {
+    (void)range;
+    *disjoint = false;
+    *frequency = 0;
+    return false;
+}
+
+// --- Graphics: state and drawing ---
+
+static bool framebuffer_srgb = false;
+static bool linear_srgb = false;
+
+void gs_draw(enum gs_draw_mode draw_mode, uint32_t start_vert, uint32_t num_verts) {
+    (void)draw_mode;
+    (void)start_vert;
+    (void)num_verts;
+}
+
+void gs_draw_sprite(gs_texture_t *tex, uint32_t flip, uint32_t width, uint32_t height) {
+    (void)tex;
+    (void)flip;
+    (void)width;
+    (void)height;
+}
+
+void gs_clear(uint32_t clear_flags, const struct vec4 *color, float depth, uint8_t stencil) {
+    (void)clear_flags;
+    (void)color;
+    (void)depth;
+    (void)stencil;
+}
+
+void gs_ortho(float left, float right, float top, float bottom, float znear, float zfar) {
+    (void)left;
+    (void)right;
+    (void)top;
+    (void)bottom;
+    (void)znear;
+    (void)zfar;
+}
+
+void gs_blend_state_push(void) {}
+void gs_blend_state_pop(void) {}
+
+void gs_blend_function(enum gs_blend_type src, enum gs_blend_type dest) {
+    (void)src;
+    (void)dest;
+}
+
+enum gs_color_space gs_get_color_space(void) {
+    return GS_CS_SRGB;
+}
+
+enum gs_color_format gs_get_format_from_space(enum gs_color_space space) {
+    return space == GS_CS_SRGB ? GS_RGBA : GS_RGBA16F;
+}
+
+bool gs_framebuffer_srgb_enabled(void) {
+    return framebuffer_srgb;
+}
+
+void gs_enable_framebuffer_srgb(bool enable) {
+    framebuffer_srgb = enable;
+}
+
+bool gs_set_linear_srgb(bool linear) {
+    bool previous = linear_srgb;
+    linear_srgb = linear;
+    return previous;
+}
+
+// --- Graphics: effects ---
+
+#define EFFECT_INCLUDE_DEPTH 8
+
+struct gs_effect_technique {
+    char *name;
+};
+
+struct gs_effect {
+    gs_eparam_t *params;
+    size_t num_params;
+    size_t params_capacity;
+    gs_technique_t *techniques;
+    size_t num_techniques;
+    size_t techniques_capacity;
+    bool looping;               // Inside the single pass of a gs_effect_loop
+};
+
+static unsigned long param_sets = 0;
+
+unsigned long mock_gs_param_sets(void) {
+    return __atomic_load_n(&param_sets, __ATOMIC_RELAXED);
+}
+
+static enum gs_shader_param_type param_type_from_name(const char *type) {
+    static const struct {
+        const char *name;
+        enum gs_shader_param_type type;
+    } types[] = {
+        {"bool", GS_SHADER_PARAM_BOOL},       {"float", GS_SHADER_PARAM_FLOAT},
+        {"int", GS_SHADER_PARAM_INT},         {"float2", GS_SHADER_PARAM_VEC2},
+        {"float3", GS_SHADER_PARAM_VEC3},     {"float4", GS_SHADER_PARAM_VEC4},
+        {"int2", GS_SHADER_PARAM_INT2},       {"int3", GS_SHADER_PARAM_INT3},
+        {"int4", GS_SHADER_PARAM_INT4},       {"float4x4", GS_SHADER_PARAM_MATRIX4X4},
+        {"texture2d", GS_SHADER_PARAM_TEXTURE}, {"texture_rect", GS_SHADER_PARAM_TEXTURE},
+        {"texture3d", GS_SHADER_PARAM_TEXTURE},
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcmp(types[i].name, type) == 0) return types[i].type;
+    }
+    return GS_SHADER_PARAM_UNKNOWN;
+}
+
+// Copies the identifier at `*pos` into `out` and skips past it
+static bool read_word(const char **pos, char *out, size_t size) {
+    const char *p = *pos;
+    while (*p == ' ' || *p == '\t') p++;
+    size_t len = 0;
+    while (isalnum((unsigned char)p[len]) || p[len] == '_') len++;
+    if (!len || len >= size) return false;
+
+    memcpy(out, p, len);
+    out[len] = '\0';
+    *pos = p + len;
+    return true;
+}
+
+static void effect_add_param(gs_effect_t *effect, const char *name, enum gs_shader_param_type type) {
+    if (gs_effect_get_param_by_name(effect, name)) return; // Declared in several #if branches
+
+    if (effect->num_params == effect->params_capacity) {
+        effect->params_capacity = effect->params_capacity ? effect->params_capacity * 2 : 16;
+        effect->params = brealloc(effect->params, sizeof(gs_eparam_t) * effect->params_capacity);
+    }
+    gs_eparam_t *param = &effect->params[effect->num_params++];
+    memset(param, 0, sizeof(*param));
+    param->name = bstrdup(name);
+    param->type = type;
+}
+
+static void effect_add_technique(gs_effect_t *effect, const char *name) {
+    if (gs_effect_get_technique(effect, name)) return;
+
+    if (effect->num_techniques == effect->techniques_capacity) {
+        effect->techniques_capacity = effect->techniques_capacity ? effect->techniques_capacity * 2 : 4;
+        effect->techniques = brealloc(effect->techniques, sizeof(gs_technique_t) * effect->techniques_capacity);
+    }
+    effect->techniques[effect->num_techniques++].name = bstrdup(name);
+}
+
+// Collects the `uniform` and `technique` declarations of `text`, following
+// #include "file" next to `filename` as libobs' effect parser does
+static bool effect_parse(gs_effect_t *effect, const char *text, const char *filename, int depth,
+                         char **error_string) {
+    for (const char *line = text; line && *line;) {
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        char word[128];
+        const char *after = p;
+
+        if (strncmp(p, "#include", 8) == 0) {
+            const char *open = strchr(p, '"');
+            const char *close = open ? strchr(open + 1, '"') : NULL;
+            const char *slash = strrchr(filename, '/');
+            if (!close || depth >= EFFECT_INCLUDE_DEPTH) {
+                if (error_string) *error_string = bstrdup("bad #include");
+                return false;
+            }
+
+            struct dstr path = {0};
+            if (slash) {
+                dstr_ncat(&path, filename, (size_t)(slash - filename) + 1);
+            }
+            dstr_ncat(&path, open + 1, (size_t)(close - open - 1));
+            char *included = os_quick_read_utf8_file(path.array);
+            bool ok = included && effect_parse(effect, included, path.array, depth + 1, error_string);
+            if (!included && error_string) *error_string = bstrdup("included file not found");
+            bfree(included);
+            dstr_free(&path);
+            if (!ok) return false;
+        } else if (read_word(&after, word, sizeof(word)) && strcmp(word, "uniform") == 0) {
+            char type[32];
+            char name[128];
+            if (read_word(&after, type, sizeof(type)) && read_word(&after, name, sizeof(name))) {
+                effect_add_param(effect, name, param_type_from_name(type));
+            }
+        } else if (strcmp(word, "technique") == 0 && read_word(&after, word, sizeof(word))) {
+            effect_add_technique(effect, word);
+        }
+
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+    return true;
+}
+
+gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, char **error_string) {
+    if (error_string) *error_string = NULL;
+    if (!effect_string) return NULL;
+
+    gs_effect_t *effect = bzalloc(sizeof(gs_effect_t));
+    if (!effect_parse(effect, effect_string, filename ? filename : "", 0, error_string) ||
+        !effect->num_techniques) {
+        if (error_string && !*error_string) *error_string = bstrdup("no techniques");
+        gs_effect_destroy(effect);
+        return NULL;
+    }
+    return effect;
+}
+
+gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string) {
+    if (error_string) *error_string = NULL;
+    char *text = os_quick_read_utf8_file(file);
+    if (!text) return NULL;
+
+    gs_effect_t *effect = gs_effect_create(text, file, error_string);
+    bfree(text);
+    return effect;
+}
+
+void gs_effect_destroy(gs_effect_t *effect) {
+    if (!effect) return;
+    for (size_t i = 0; i < effect->num_params; i++) bfree(effect->params[i].name);
+    for (size_t i = 0; i < effect->num_techniques; i++) bfree(effect->techniques[i].name);
+    bfree(effect->params);
+    bfree(effect->techniques);
+    bfree(effect);
+}
+
+gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *name) {
+    if (!effect || !name) return NULL;
+    for (size_t i = 0; i < effect->num_params; i++) {
+        if (strcmp(effect->params[i].name, name) == 0) return &effect->params[i];
+    }
+    return NULL;
+}
+
+gs_technique_t *gs_effect_get_technique(const gs_effect_t *effect, const char *name) {
+    if (!effect || !name) return NULL;
+    for (size_t i = 0; i < effect->num_techniques; i++) {
+        if (strcmp(effect->techniques[i].name, name) == 0) return &effect->techniques[i];
+    }
+    return NULL;
+}
+
+// One pass per technique
+bool gs_effect_loop(gs_effect_t *effect, const char *name) {
+    if (!effect) return false;
+    if (effect->looping) {
+        effect->looping = false;
+        return false;
+    }
+    effect->looping = gs_effect_get_technique(effect, name) != NULL;
+    return effect->looping;
+}
+
+static void param_store(gs_eparam_t *param, const void *val, size_t size) {
+    if (!param) return;
+    if (size > sizeof(param->value)) size = sizeof(param->value);
+    memcpy(param->value, val, size);
+    param->size = size;
+    param->sets++;
+    __atomic_add_fetch(&param_sets, 1, __ATOMIC_RELAXED);
+}
+
+void gs_effect_set_bool(gs_eparam_t *param, bool val) {
+    int b = val;
+    param_store(param, &b, sizeof(b));
+}
+
+void gs_effect_set_float(gs_eparam_t *param, float val) {
+    param_store(param, &val, sizeof(val));
+}
+
+void gs_effect_set_int(gs_eparam_t *param, int val) {
+    param_store(param, &val, sizeof(val));
+}
+
+void gs_effect_set_matrix4(gs_eparam_t *param, const struct matrix4 *val) {
+    param_store(param, val, sizeof(*val));
+}
+
+void gs_effect_set_vec2(gs_eparam_t *param, const struct vec2 *val) {
+    param_store(param, val, sizeof(*val));
+}
+
+void gs_effect_set_vec4(gs_eparam_t *param, const struct vec4 *val) {
+    param_store(param, val, sizeof(*val));
+}
+
+void gs_effect_set_texture(gs_eparam_t *param, gs_texture_t *val) {
+    if (param) param->texture = val;
+    param_store(param, &val, sizeof(val));
+}
+
+void gs_effect_set_val(gs_eparam_t *param, const void *val, size_t size) {
+    param_store(param, val, size);
+}
+
+// --- Settings ---
+
+typedef enum {
+    ITEM_NULL,
+    ITEM_STRING,
+    ITEM_INT,
+    ITEM_DOUBLE,
+    ITEM_BOOL
+} item_type_t;
+
+typedef struct {
+    item_type_t type;
+    union {
+        long long i;
+        double d;
+        bool b;
+        char *s;
+    };
+} item_value_t;
+
+struct obs_data_item {
+    struct obs_data_item *next;
+    char *name;
+    item_value_t value;         // User value, ITEM_NULL if unset
+    item_value_t default_value; // ITEM_NULL if none
+};
+
+struct obs_data {
+    long refs;
+    obs_data_item_t *first;
+    obs_data_item_t *last;
+    struct dstr json;
+};
+
+static void value_clear(item_value_t *value) {
+    if (value->type == ITEM_STRING) bfree(value->s);
+    value->type = ITEM_NULL;
+}
+
+obs_data_t *obs_data_create(void) {
+    obs_data_t *data = bzalloc(sizeof(obs_data_t));
+    data->refs = 1;
+    return data;
+}
+
+void obs_data_addref(obs_data_t *data) {
+    if (data) os_atomic_inc_long(&data->refs);
+}
+
+void obs_data_release(obs_data_t *data) {
+    if (!data || os_atomic_dec_long(&data->refs) > 0) return;
+
+    for (obs_data_item_t *item = data->first, *next; item; item = next) {
+        next = item->next;
+        value_clear(&item->value);
+        value_clear(&item->default_value);
+        bfree(item->name);
+        bfree(item);
+    }
+    dstr_free(&data->json);
+    bfree(data);
+}
+
+// Linear search in insertion order, as libobs does
+obs_data_item_t *obs_data_item_byname(obs_data_t *data, const char *name) {
+    if (!data || !name) return NULL;
+    for (obs_data_item_t *item = data->first; item; item = item->next) {
+        if (strcmp(item->name, name) == 0) return item;
+    }
+    return NULL;
+}
+
+static obs_data_item_t *get_or_add_item(obs_data_t *data, const char *name) {
+    obs_data_item_t *item = obs_data_item_byname(data, name);
+    if (item) return item;
+
+    item = bzalloc(sizeof(obs_data_item_t));
+    item->name = bstrdup(name);
+    if (data->last) {
+        data->last->next = item;
+    } else {
+        data->first = item;
+    }
+    data->last = item;
+    return item;
+}
+
+static item_value_t *item_current(obs_data_item_t *item) {
+    if (!item) return NULL;
+    if (item->value.type != ITEM_NULL) return &item->value;
+    if (item->default_value.type != ITEM_NULL) return &item->default_value;
+    return NULL;
+}
+
+static void set_value(obs_data_t *data, const char *name, item_value_t value, bool as_default) {
+    if (!data || !name) {
+        if (value.type == ITEM_STRING) bfree(value.s);
+        return;
+    }
+    obs_data_item_t *item = get_or_add_item(data, name);
+    item_value_t *slot = as_default ? &item->default_value : &item->value;
+    value_clear(slot);
+    *slot = value;
+}
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val) {
+    set_value(data, name, (item_value_t){.type = ITEM_STRING, .s = bstrdup(val ? val : "")}, false);
+}
+
+void obs_data_set_int(obs_data_t *data, const char *name, long long val) {
+    set_value(data, name, (item_value_t){.type = ITEM_INT, .i = val}, false);
+}
+
+void obs_data_set_double(obs_data_t *data, const char *name, double val) {
+    set_value(data, name, (item_value_t){.type = ITEM_DOUBLE, .d = val}, false);
+}
+
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val) {
+    set_value(data, name, (item_value_t){.type = ITEM_BOOL, .b = val}, false);
+}
+
+void obs_data_set_default_string(obs_data_t *data, const char *name, const char *val) {
+    set_value(data, name, (item_value_t){.type = ITEM_STRING, .s = bstrdup(val ? val : "")}, true);
+}
+
+void obs_data_set_default_int(obs_data_t *data, const char *name, long long val) {
+    set_value(data, name, (item_value_t){.type = ITEM_INT, .i = val}, true);
+}
+
+void obs_data_set_default_double(obs_data_t *data, const char *name, double val) {
+    set_value(data, name, (item_value_t){.type = ITEM_DOUBLE, .d = val}, true);
+}
+
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val) {
+    set_value(data, name, (item_value_t){.type = ITEM_BOOL, .b = val}, true);
+}
+
+const char *obs_data_item_get_name(obs_data_item_t *item) {
+    return item ? item->name : NULL;
+}
+
+long long obs_data_item_get_int(obs_data_item_t *item) {
+    const item_value_t *value = item_current(item);
+    if (!value) return 0;
+    if (value->type == ITEM_INT) return value->i;
+    if (value->type == ITEM_DOUBLE) return (long long)value->d;
+    return 0;
+}
+
+double obs_data_item_get_double(obs_data_item_t *item) {
+    const item_value_t *value = item_current(item);
+    if (!value) return 0.0;
+    if (value->type == ITEM_DOUBLE) return value->d;
+    if (value->type == ITEM_INT) return (double)value->i;
+    return 0.0;
+}
+
+bool obs_data_item_get_bool(obs_data_item_t *item) {
+    const item_value_t *value = item_current(item);
+    return value && value->type == ITEM_BOOL && value->b;
+}
+
+const char *obs_data_get_string(obs_data_t *data, const char *name) {
+    const item_value_t *value = item_current(obs_data_item_byname(data, name));
+    return value && value->type == ITEM_STRING ? value->s : "";
+}
+
+long long obs_data_get_int(obs_data_t *data, const char *name) {
+    return obs_data_item_get_int(obs_data_item_byname(data, name));
+}
+
+double obs_data_get_double(obs_data_t *data, const char *name) {
+    return obs_data_item_get_double(obs_data_item_byname(data, name));
+}
+
+bool obs_data_get_bool(obs_data_t *data, const char *name) {
+    return obs_data_item_get_bool(obs_data_item_byname(data, name));
+}
+
+// Items come in insertion order, defaults-only ones included
+obs_data_item_t *obs_data_first(obs_data_t *data) {
+    return data ? data->first : NULL;
+}
+
+bool obs_data_item_next(obs_data_item_t **item) {
+    if (!item || !*item) return false;
+    *item = (*item)->next;
+    return *item != NULL;
+}
+
+void obs_data_item_release(obs_data_item_t **item) {
+    if (item) *item = NULL;
+}
+
+// User values only, like libobs
+const char *obs_data_get_json(obs_data_t *data) {
+    if (!data) return NULL;
+
+    dstr_copy(&data->json, "{");
+    bool first = true;
+    for (obs_data_item_t *item = data->first; item; item = item->next) {
+        const item_value_t *value = &item->value;
+        if (value->type == ITEM_NULL) continue;
+
+        dstr_catf(&data->json, "%s\"%s\": ", first ? "" : ", ", item->name);
+        switch (value->type) {
+            case ITEM_STRING: dstr_catf(&data->json, "\"%s\"", value->s); break;
+            case ITEM_INT: dstr_catf(&data->json, "%lld", value->i); break;
+            case ITEM_DOUBLE: dstr_catf(&data->json, "%g", value->d); break;
+            case ITEM_BOOL: dstr_cat(&data->json, value->b ? "true" : "false"); break;
+            case ITEM_NULL: break;
+        }
+        first = false;
+    }
+    dstr_cat(&data->json, "}");
+    return data->json.array;
+}
+
+// --- Properties ---
+
+struct obs_property {
+    struct obs_property *next;
+    char *name;
+    bool visible;
+    obs_property_modified_t modified;
+    obs_properties_t *group;    // Owned, OBS_GROUP_* properties
+};
+
+struct obs_properties {
+    obs_property_t *first;
+    obs_property_t *last;
+};
+
+obs_properties_t *obs_properties_create(void) {
+    return bzalloc(sizeof(obs_properties_t));
+}
+
+void obs_properties_destroy(obs_properties_t *props) {
+    if (!props) return;
+    for (obs_property_t *p = props->first, *next; p; p = next) {
+        next = p->next;
+        obs_properties_destroy(p->group);
+        bfree(p->name);
+        bfree(p);
+    }
+    bfree(props);
+}
+
+obs_property_t *obs_properties_get(obs_properties_t *props, const char *property) {
+    if (!props || !property) return NULL;
+    for (obs_property_t *p = props->first; p; p = p->next) {
+        if (strcmp(p->name, property) == 0) return p;
+        obs_property_t *nested = obs_properties_get(p->group, property);
+        if (nested) return nested;
+    }
+    return NULL;
+}
+
+static obs_property_t *property_add(obs_properties_t *props, const char *name) {
+    if (!props || !name || obs_properties_get(props, name)) return NULL;
+
+    obs_property_t *p = bzalloc(sizeof(obs_property_t));
+    p->name = bstrdup(name);
+    p->visible = true;
+    if (props->last) {
+        props->last->next = p;
+    } else {
+        props->first = p;
+    }
+    props->last = p;
+    return p;
+}
+
+obs_property_t *obs_properties_add_bool(obs_properties_t *props, const char *name, const char *description) {
+    (void)description;
+    return property_add(props, name);
+}
+
+obs_property_t *obs_properties_add_int_slider(obs_properties_t *props, const char *name, const char *description,
+                                              int min, int max, int step) {
+    (void)description;
+    (void)min;
+    (void)max;
+    (void)step;
+    return property_add(props, name);
+}
+
+obs_property_t *obs_properties_add_float_slider(obs_properties_t *props, const char *name,
+                                                const char *description, double min, double max, double step) {
+    (void)description;
+    (void)min;
+    (void)max;
+    (void)step;
+    return property_add(props, name);
+}
+
+obs_property_t *obs_properties_add_color(obs_properties_t *props, const char *name, const char *description) {
+    (void)description;
+    return property_add(props, name);
+}
+
+obs_property_t *obs_properties_add_path(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_path_type type, const char *filter, const char *default_path) {
+    (void)description;
+    (void)type;
+    (void)filter;
+    (void)default_path;
+    return property_add(props, name);
+}
+
+obs_property_t *obs_properties_add_list(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_combo_type type, enum obs_combo_format format) {
+    (void)description;
+    (void)type;
+    (void)format;
+    return property_add(props, name);
+}
+
+obs_property_t *obs_properties_add_group(obs_properties_t *props, const char *name, const char *description,
+                                         enum obs_group_type type, obs_properties_t *group) {
+    (void)description;
+    (void)type;
+    obs_property_t *p = property_add(props, name);
+    if (p) {
+        p->group = group;
+    } else {
+        obs_properties_destroy(group);
+    }
+    return p;
+}
+
+size_t obs_property_list_add_string(obs_property_t *p, const char *name, const char *val) {
+    (void)p;
+    (void)name;
+    (void)val;
+    return 0;
+}
+
+void obs_property_set_modified_callback(obs_property_t *p, obs_property_modified_t modified) {
+    if (p) p->modified = modified;
+}
+
+void obs_property_set_visible(obs_property_t *p, bool visible) {
+    if (p) p->visible = visible;
+}
+
+// --- Sources ---
+
+const char *get_video_format_name(enum video_format format) {
+    static const char *const names[] = {"None", "I420", "NV12", "YVYU", "YUY2", "UYVY", "RGBA",
+                                        "BGRA", "BGRX", "Y800", "I444", "BGR3", "I422"};
+    return (size_t)format < sizeof(names) / sizeof(names[0]) ? names[format] : "Unknown";
+}
+
+struct obs_source {
+    char *name;
+    void *type_data;
+    mock_update_t update;
+    void *data;
+    uint32_t width;
+    uint32_t height;
+    obs_data_t *deferred;       // Settings of an update before `data` was set
+    struct obs_source *parent;  // Filters only, owned
+};
+
+obs_source_t *mock_filter_create(const char *name, void *type_data, mock_update_t update, uint32_t width,
+                                 uint32_t height) {
+    obs_source_t *parent = bzalloc(sizeof(obs_source_t));
+    parent->name = bstrdup("parent");
+    parent->width = width;
+    parent->height = height;
+
+    obs_source_t *filter = bzalloc(sizeof(obs_source_t));
+    filter->name = bstrdup(name);
+    filter->type_data = type_data;
+    filter->update = update;
+    filter->parent = parent;
+    return filter;
+}
+
+void mock_filter_set_data(obs_source_t *filter, void *data) {
+    if (!filter) return;
+    filter->data = data;
+
+    obs_data_t *deferred = filter->deferred;
+    filter->deferred = NULL;
+    if (deferred && data && filter->update) filter->update(data, deferred);
+    obs_data_release(deferred);
+}
+
+void mock_filter_destroy(obs_source_t *filter) {
+    if (!filter) return;
+    obs_data_release(filter->deferred);
+    if (filter->parent) {
+        bfree(filter->parent->name);
+        bfree(filter->parent);
+    }
+    bfree(filter->name);
+    bfree(filter);
+}
+
+void *obs_source_get_type_data(obs_source_t *source) {
+    return source ? source->type_data : NULL;
+}
+
+const char *obs_source_get_name(const obs_source_t *source) {
+    return source ? source->name : NULL;
+}
+
+// A filter is the size of its target
+uint32_t obs_source_get_width(obs_source_t *source) {
+    if (!source) return 0;
+    return source->parent ? source->parent->width : source->width;
+}
+
+uint32_t obs_source_get_height(obs_source_t *source) {
+    if (!source) return 0;
+    return source->parent ? source->parent->height : source->height;
+}
+
+uint32_t obs_source_get_output_flags(const obs_source_t *source) {
+    return source ? OBS_SOURCE_VIDEO : 0;
+}
+
+enum gs_color_space obs_source_get_color_space(obs_source_t *source, size_t count,
+                                               const enum gs_color_space *preferred_spaces) {
+    (void)source;
+    (void)count;
+    (void)preferred_spaces;
+    return GS_CS_SRGB;
+}
+
+enum obs_deinterlace_mode obs_source_get_deinterlace_mode(const obs_source_t *source) {
+    (void)source;
+    return OBS_DEINTERLACE_MODE_DISABLE;
+}
+
+bool obs_source_showing(const obs_source_t *source) {
+    return source != NULL;
+}
+
+// An update from inside the create callback runs once its data is set
+void obs_source_update(obs_source_t *source, obs_data_t *settings) {
+    if (!source || !settings) return;
+    if (source->data) {
+        if (source->update) source->update(source->data, settings);
+        return;
+    }
+    obs_data_addref(settings);
+    obs_data_release(source->deferred);
+    source->deferred = settings;
+}
+
+void obs_source_skip_video_filter(obs_source_t *filter) {
+    (void)filter;
+}
+
+bool obs_source_process_filter_begin(obs_source_t *filter, enum gs_color_format format,
+                                     enum obs_allow_direct_render allow_direct) {
+    (void)format;
+    (void)allow_direct;
+    return filter != NULL;
+}
+
+bool obs_source_process_filter_begin_with_color_space(obs_source_t *filter, enum gs_color_format format,
+                                                      enum gs_color_space space,
+                                                      enum obs_allow_direct_render allow_direct) {
+    (void)space;
+    return obs_source_process_filter_begin(filter, format, allow_direct);
+}
+
+void obs_source_process_filter_end(obs_source_t *filter, gs_effect_t *effect, uint32_t width, uint32_t height) {
+    (void)filter;
+    while (gs_effect_loop(effect, "Draw")) gs_draw_sprite(NULL, 0, width, height);
+}
+
+void obs_source_default_render(obs_source_t *source) {
+    (void)source;
+}
+
+void obs_source_video_render(obs_source_t *source) {
+    (void)source;
+}
+
+obs_source_t *obs_filter_get_parent(const obs_source_t *filter) {
+    return filter ? filter->parent : NULL;
+}
+
+obs_source_t *obs_filter_get_target(const obs_source_t *filter) {
+    return filter ? filter->parent : NULL;
+}
+
+// --- Core ---
+
+static pthread_mutex_t graphics_mutex;
+static pthread_once_t graphics_once = PTHREAD_ONCE_INIT;
+static char *data_path = NULL;
+
+static void graphics_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&graphics_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// The graphics context is held by one thread at a time, re-entrantly
+void obs_enter_graphics(void) {
+    pthread_once(&graphics_once, graphics_init);
+    pthread_mutex_lock(&graphics_mutex);
+}
+
+void obs_leave_graphics(void) {
+    pthread_mutex_unlock(&graphics_mutex);
+}
+
+uint64_t obs_get_video_frame_time(void) {
+    return os_gettime_ns();
+}
+
+gs_effect_t *obs_get_base_effect(enum obs_base_effect effect) {
+    static gs_effect_t *default_effect = NULL;
+    if (effect != OBS_EFFECT_DEFAULT) return NULL;
+
+    if (!default_effect) {
+        default_effect = gs_effect_create("uniform float4x4 ViewProj;\n"
+                                          "uniform texture2d image;\n"
+                                          "uniform float multiplier;\n"
+                                          "technique Draw\n"
+                                          "technique DrawNonlinearAlpha\n",
+                                          "default.effect", NULL);
+    }
+    return default_effect;
+}
+
+obs_module_t *obs_get_module(const char *name) {
+    static int module;
+    (void)name;
+    return (obs_module_t *)(void *)&module;
+}
+
+void mock_obs_set_data_path(const char *path) {
+    free(data_path);
+    data_path = path ? strdup(path) : NULL;
+}
+
+// NULL unless the file exists, like libobs
+char *obs_find_module_file(obs_module_t *module, const char *file) {
+    if (!module || !file || !data_path) return NULL;
+
+    struct dstr path = {0};
+    dstr_printf(&path, "%s/%s", data_path, file);
+    FILE *f = fopen(path.array, "rb");
+    if (!f) {
+        dstr_free(&path);
+        return NULL;
+    }
+    fclose(f);
+    return path.array;
+}
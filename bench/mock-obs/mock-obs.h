@@ -0,0 +1,576 @@
+/*
+ * bench/mock-obs/mock-obs.h
+ * Stand-in for the parts of libobs the plugin core uses, so it links into
+ * plain executables (bench/core-bench.c). Signatures match libobs; the
+ * headers under bench/mock-obs mirror its include layout and all land here.
+ *
+ * Settings (obs_data_*), bmem, dstr, atomics and semaphores behave like
+ * libobs. Graphics calls do no GPU work: effects are built from the
+ * `uniform` and `technique` declarations of the shader text, setters store
+ * into the parameter, and render targets and stage surfaces are zeroed CPU
+ * buffers.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MOCK_PRINTF(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define MOCK_PRINTF(fmt, args)
+#endif
+
+// --- util/base.h, util/bmem.h ---
+
+enum {
+    LOG_ERROR = 100,
+    LOG_WARNING = 200,
+    LOG_INFO = 300,
+    LOG_DEBUG = 400
+};
+
+void blog(int log_level, const char *format, ...) MOCK_PRINTF(2, 3);
+void blogva(int log_level, const char *format, va_list args);
+
+void *bmalloc(size_t size);
+void *brealloc(void *ptr, size_t size);
+void *bzalloc(size_t size);
+void bfree(void *ptr);
+char *bstrdup(const char *str);
+long bnum_allocs(void);
+
+// --- util/dstr.h ---
+
+struct dstr {
+    char *array;
+    size_t len;
+    size_t capacity;
+};
+
+void dstr_free(struct dstr *dst);
+void dstr_copy(struct dstr *dst, const char *array);
+void dstr_cat(struct dstr *dst, const char *array);
+void dstr_catf(struct dstr *dst, const char *format, ...) MOCK_PRINTF(2, 3);
+void dstr_printf(struct dstr *dst, const char *format, ...) MOCK_PRINTF(2, 3);
+void dstr_replace(struct dstr *str, const char *find, const char *replace);
+void dstr_depad(struct dstr *dst);
+
+// --- util/platform.h ---
+
+uint64_t os_gettime_ns(void);
+char *os_quick_read_utf8_file(const char *path);
+
+// --- util/threading.h ---
+
+static inline long os_atomic_inc_long(volatile long *val) {
+    return __atomic_add_fetch(val, 1, __ATOMIC_SEQ_CST);
+}
+static inline long os_atomic_dec_long(volatile long *val) {
+    return __atomic_sub_fetch(val, 1, __ATOMIC_SEQ_CST);
+}
+static inline void os_atomic_set_long(volatile long *ptr, long val) {
+    __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+static inline long os_atomic_load_long(const volatile long *ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+static inline long os_atomic_exchange_long(volatile long *ptr, long val) {
+    return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+static inline bool os_atomic_compare_swap_long(volatile long *val, long old_val, long new_val) {
+    return __atomic_compare_exchange_n(val, &old_val, new_val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static inline void os_atomic_set_bool(volatile bool *ptr, bool val) {
+    __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+static inline bool os_atomic_load_bool(const volatile bool *ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+struct os_sem_data;
+typedef struct os_sem_data os_sem_t;
+
+int os_sem_init(os_sem_t **sem, int value);
+void os_sem_destroy(os_sem_t *sem);
+int os_sem_post(os_sem_t *sem);
+int os_sem_wait(os_sem_t *sem);
+void os_set_thread_name(const char *name);
+
+// --- graphics/vec2.h ... graphics/matrix4.h ---
+
+struct vec2 {
+    float x, y;
+};
+
+struct vec3 {
+    float x, y, z, w; // Padded to 16 bytes like libobs' SSE vec3
+};
+
+struct vec4 {
+    float x, y, z, w;
+};
+
+struct matrix4 {
+    struct vec4 x, y, z, t;
+};
+
+static inline void vec2_set(struct vec2 *dst, float x, float y) {
+    dst->x = x;
+    dst->y = y;
+}
+static inline void vec3_set(struct vec3 *dst, float x, float y, float z) {
+    dst->x = x;
+    dst->y = y;
+    dst->z = z;
+    dst->w = 0.0f;
+}
+static inline void vec4_set(struct vec4 *dst, float x, float y, float z, float w) {
+    dst->x = x;
+    dst->y = y;
+    dst->z = z;
+    dst->w = w;
+}
+static inline void vec4_zero(struct vec4 *dst) {
+    vec4_set(dst, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+static inline void vec4_mulf(struct vec4 *dst, const struct vec4 *v, float f) {
+    vec4_set(dst, v->x * f, v->y * f, v->z * f, v->w * f);
+}
+static inline void vec4_from_rgba(struct vec4 *dst, uint32_t rgba) {
+    dst->x = (float)(rgba & 0xFF) / 255.0f;
+    dst->y = (float)((rgba >> 8) & 0xFF) / 255.0f;
+    dst->z = (float)((rgba >> 16) & 0xFF) / 255.0f;
+    dst->w = (float)((rgba >> 24) & 0xFF) / 255.0f;
+}
+static inline void matrix4_identity(struct matrix4 *dst) {
+    memset(dst, 0, sizeof(*dst));
+    dst->x.x = dst->y.y = dst->z.z = dst->t.w = 1.0f;
+}
+
+// --- graphics/graphics.h ---
+
+enum gs_color_format {
+    GS_UNKNOWN,
+    GS_A8,
+    GS_R8,
+    GS_RGBA,
+    GS_BGRX,
+    GS_BGRA,
+    GS_R10G10B10A2,
+    GS_RGBA16,
+    GS_R16,
+    GS_RGBA16F,
+    GS_RGBA32F,
+    GS_RG16F,
+    GS_RG32F,
+    GS_R16F,
+    GS_R32F
+};
+
+enum gs_color_space {
+    GS_CS_SRGB,
+    GS_CS_SRGB_16F,
+    GS_CS_709_EXTENDED,
+    GS_CS_709_SCRGB
+};
+
+enum gs_zstencil_format {
+    GS_ZS_NONE,
+    GS_Z16,
+    GS_Z24_S8,
+    GS_Z32F,
+    GS_Z32F_S8X24
+};
+
+enum gs_draw_mode {
+    GS_POINTS,
+    GS_LINES,
+    GS_LINESTRIP,
+    GS_TRIS,
+    GS_TRISTRIP
+};
+
+enum gs_blend_type {
+    GS_BLEND_ZERO,
+    GS_BLEND_ONE,
+    GS_BLEND_SRCCOLOR,
+    GS_BLEND_INVSRCCOLOR,
+    GS_BLEND_SRCALPHA,
+    GS_BLEND_INVSRCALPHA,
+    GS_BLEND_DSTCOLOR,
+    GS_BLEND_INVDSTCOLOR,
+    GS_BLEND_DSTALPHA,
+    GS_BLEND_INVDSTALPHA,
+    GS_BLEND_SRCALPHASAT
+};
+
+enum gs_shader_param_type {
+    GS_SHADER_PARAM_UNKNOWN,
+    GS_SHADER_PARAM_BOOL,
+    GS_SHADER_PARAM_FLOAT,
+    GS_SHADER_PARAM_INT,
+    GS_SHADER_PARAM_STRING,
+    GS_SHADER_PARAM_VEC2,
+    GS_SHADER_PARAM_VEC3,
+    GS_SHADER_PARAM_VEC4,
+    GS_SHADER_PARAM_INT2,
+    GS_SHADER_PARAM_INT3,
+    GS_SHADER_PARAM_INT4,
+    GS_SHADER_PARAM_MATRIX4X4,
+    GS_SHADER_PARAM_TEXTURE
+};
+
+#define GS_CLEAR_COLOR (1 << 0)
+#define GS_CLEAR_DEPTH (1 << 1)
+#define GS_CLEAR_STENCIL (1 << 2)
+
+#define GS_BUILD_MIPMAPS (1 << 0)
+#define GS_DYNAMIC (1 << 1)
+#define GS_RENDER_TARGET (1 << 2)
+
+struct gs_texture;
+struct gs_texture_render;
+struct gs_stage_surface;
+struct gs_vertex_buffer;
+struct gs_index_buffer;
+struct gs_timer;
+struct gs_timer_range;
+struct gs_effect;
+struct gs_effect_technique;
+typedef struct gs_texture gs_texture_t;
+typedef struct gs_texture_render gs_texrender_t;
+typedef struct gs_stage_surface gs_stagesurf_t;
+typedef struct gs_vertex_buffer gs_vertbuffer_t;
+typedef struct gs_index_buffer gs_indexbuffer_t;
+typedef struct gs_timer gs_timer_t;
+typedef struct gs_timer_range gs_timer_range_t;
+typedef struct gs_effect gs_effect_t;
+typedef struct gs_effect_technique gs_technique_t;
+
+struct gs_tvertarray {
+    size_t width;
+    void *array;
+};
+
+struct gs_vb_data {
+    size_t num;
+    struct vec3 *points;
+    struct vec3 *normals;
+    struct vec3 *tangents;
+    uint32_t *colors;
+    size_t num_tex;
+    struct gs_tvertarray *tvarray;
+};
+
+struct gs_vb_data *gs_vbdata_create(void);
+void gs_vbdata_destroy(struct gs_vb_data *data);
+
+gs_texture_t *gs_texture_create(uint32_t width, uint32_t height, enum gs_color_format color_format,
+                                uint32_t levels, const uint8_t **data, uint32_t flags);
+void gs_texture_destroy(gs_texture_t *tex);
+void gs_texture_set_image(gs_texture_t *tex, const uint8_t *data, uint32_t linesize, bool invert);
+
+gs_texrender_t *gs_texrender_create(enum gs_color_format format, enum gs_zstencil_format zsformat);
+void gs_texrender_destroy(gs_texrender_t *texrender);
+bool gs_texrender_begin(gs_texrender_t *texrender, uint32_t cx, uint32_t cy);
+bool gs_texrender_begin_with_color_space(gs_texrender_t *texrender, uint32_t cx, uint32_t cy,
+                                         enum gs_color_space space);
+void gs_texrender_end(gs_texrender_t *texrender);
+void gs_texrender_reset(gs_texrender_t *texrender);
+gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender);
+enum gs_color_format gs_texrender_get_format(const gs_texrender_t *texrender);
+
+gs_stagesurf_t *gs_stagesurface_create(uint32_t width, uint32_t height, enum gs_color_format color_format);
+void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf);
+uint32_t gs_stagesurface_get_width(const gs_stagesurf_t *stagesurf);
+uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf);
+bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data, uint32_t *linesize);
+void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf);
+void gs_stage_texture(gs_stagesurf_t *dst, gs_texture_t *src);
+
+gs_vertbuffer_t *gs_vertexbuffer_create(struct gs_vb_data *data, uint32_t flags);
+void gs_vertexbuffer_destroy(gs_vertbuffer_t *vertbuffer);
+void gs_vertexbuffer_flush(gs_vertbuffer_t *vertbuffer);
+struct gs_vb_data *gs_vertexbuffer_get_data(const gs_vertbuffer_t *vertbuffer);
+void gs_load_vertexbuffer(gs_vertbuffer_t *vertbuffer);
+void gs_load_indexbuffer(gs_indexbuffer_t *indexbuffer);
+
+gs_timer_t *gs_timer_create(void);
+void gs_timer_destroy(gs_timer_t *timer);
+void gs_timer_begin(gs_timer_t *timer);
+void gs_timer_end(gs_timer_t *timer);
+bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks);
+gs_timer_range_t *gs_timer_range_create(void);
+void gs_timer_range_destroy(gs_timer_range_t *range);
+void gs_timer_range_begin(gs_timer_range_t *range);
+void gs_timer_range_end(gs_timer_range_t *range);
+bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint, uint64_t *frequency);
+
+void gs_draw(enum gs_draw_mode draw_mode, uint32_t start_vert, uint32_t num_verts);
+void gs_draw_sprite(gs_texture_t *tex, uint32_t flip, uint32_t width, uint32_t height);
+void gs_clear(uint32_t clear_flags, const struct vec4 *color, float depth, uint8_t stencil);
+void gs_ortho(float left, float right, float top, float bottom, float znear, float zfar);
+void gs_blend_state_push(void);
+void gs_blend_state_pop(void);
+void gs_blend_function(enum gs_blend_type src, enum gs_blend_type dest);
+
+enum gs_color_space gs_get_color_space(void);
+enum gs_color_format gs_get_format_from_space(enum gs_color_space space);
+bool gs_framebuffer_srgb_enabled(void);
+void gs_enable_framebuffer_srgb(bool enable);
+bool gs_set_linear_srgb(bool linear_srgb);
+
+// --- graphics/effect.h ---
+
+// Field names follow libobs' struct gs_effect_param; param-system.c reads `type`
+struct gs_effect_param {
+    char *name;
+    enum gs_shader_param_type type;
+    size_t size;                 // Bytes the last setter stored in `value`
+    uint8_t value[64];           // Up to a float4x4
+    gs_texture_t *texture;       // GS_SHADER_PARAM_TEXTURE
+    unsigned long sets;          // Setter calls, for tests
+};
+typedef struct gs_effect_param gs_eparam_t;
+
+gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, char **error_string);
+gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string);
+void gs_effect_destroy(gs_effect_t *effect);
+gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *name);
+gs_technique_t *gs_effect_get_technique(const gs_effect_t *effect, const char *name);
+bool gs_effect_loop(gs_effect_t *effect, const char *name);
+
+void gs_effect_set_bool(gs_eparam_t *param, bool val);
+void gs_effect_set_float(gs_eparam_t *param, float val);
+void gs_effect_set_int(gs_eparam_t *param, int val);
+void gs_effect_set_matrix4(gs_eparam_t *param, const struct matrix4 *val);
+void gs_effect_set_vec2(gs_eparam_t *param, const struct vec2 *val);
+void gs_effect_set_vec4(gs_eparam_t *param, const struct vec4 *val);
+void gs_effect_set_texture(gs_eparam_t *param, gs_texture_t *val);
+void gs_effect_set_val(gs_eparam_t *param, const void *val, size_t size);
+
+// --- obs.h ---
+
+enum video_format {
+    VIDEO_FORMAT_NONE,
+    VIDEO_FORMAT_I420,
+    VIDEO_FORMAT_NV12,
+    VIDEO_FORMAT_YVYU,
+    VIDEO_FORMAT_YUY2,
+    VIDEO_FORMAT_UYVY,
+    VIDEO_FORMAT_RGBA,
+    VIDEO_FORMAT_BGRA,
+    VIDEO_FORMAT_BGRX,
+    VIDEO_FORMAT_Y800,
+    VIDEO_FORMAT_I444,
+    VIDEO_FORMAT_BGR3,
+    VIDEO_FORMAT_I422
+};
+
+const char *get_video_format_name(enum video_format format);
+
+#define MAX_AV_PLANES 8
+
+struct obs_source_frame {
+    uint8_t *data[MAX_AV_PLANES];
+    uint32_t linesize[MAX_AV_PLANES];
+    uint32_t width;
+    uint32_t height;
+    uint64_t timestamp;
+    enum video_format format;
+    float color_matrix[16];
+    bool full_range;
+    uint16_t max_luminance;
+    float color_range_min[3];
+    float color_range_max[3];
+    bool flip;
+};
+
+enum obs_source_type {
+    OBS_SOURCE_TYPE_INPUT,
+    OBS_SOURCE_TYPE_FILTER,
+    OBS_SOURCE_TYPE_TRANSITION,
+    OBS_SOURCE_TYPE_SCENE
+};
+
+#define OBS_SOURCE_VIDEO (1 << 0)
+#define OBS_SOURCE_AUDIO (1 << 1)
+#define OBS_SOURCE_ASYNC (1 << 2)
+#define OBS_SOURCE_CUSTOM_DRAW (1 << 3)
+
+enum obs_allow_direct_render {
+    OBS_NO_DIRECT_RENDERING,
+    OBS_ALLOW_DIRECT_RENDERING
+};
+
+enum obs_deinterlace_mode {
+    OBS_DEINTERLACE_MODE_DISABLE,
+    OBS_DEINTERLACE_MODE_DISCARD
+};
+
+enum obs_base_effect {
+    OBS_EFFECT_DEFAULT,
+    OBS_EFFECT_DEFAULT_RECT,
+    OBS_EFFECT_OPAQUE,
+    OBS_EFFECT_SOLID
+};
+
+enum obs_combo_type {
+    OBS_COMBO_TYPE_INVALID,
+    OBS_COMBO_TYPE_EDITABLE,
+    OBS_COMBO_TYPE_LIST,
+    OBS_COMBO_TYPE_RADIO
+};
+
+enum obs_combo_format {
+    OBS_COMBO_FORMAT_INVALID,
+    OBS_COMBO_FORMAT_INT,
+    OBS_COMBO_FORMAT_FLOAT,
+    OBS_COMBO_FORMAT_STRING,
+    OBS_COMBO_FORMAT_BOOL
+};
+
+enum obs_path_type {
+    OBS_PATH_FILE,
+    OBS_PATH_FILE_SAVE,
+    OBS_PATH_DIRECTORY
+};
+
+enum obs_group_type {
+    OBS_COMBO_INVALID,
+    OBS_GROUP_NORMAL,
+    OBS_GROUP_CHECKABLE
+};
+
+struct obs_source;
+struct obs_data;
+struct obs_data_item;
+struct obs_module;
+struct obs_properties;
+struct obs_property;
+typedef struct obs_source obs_source_t;
+typedef struct obs_data obs_data_t;
+typedef struct obs_data_item obs_data_item_t;
+typedef struct obs_module obs_module_t;
+typedef struct obs_properties obs_properties_t;
+typedef struct obs_property obs_property_t;
+
+typedef bool (*obs_property_modified_t)(obs_properties_t *props, obs_property_t *property, obs_data_t *settings);
+
+// Settings
+obs_data_t *obs_data_create(void);
+void obs_data_addref(obs_data_t *data);
+void obs_data_release(obs_data_t *data);
+const char *obs_data_get_json(obs_data_t *data);
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val);
+void obs_data_set_int(obs_data_t *data, const char *name, long long val);
+void obs_data_set_double(obs_data_t *data, const char *name, double val);
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val);
+void obs_data_set_default_string(obs_data_t *data, const char *name, const char *val);
+void obs_data_set_default_int(obs_data_t *data, const char *name, long long val);
+void obs_data_set_default_double(obs_data_t *data, const char *name, double val);
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val);
+
+const char *obs_data_get_string(obs_data_t *data, const char *name);
+long long obs_data_get_int(obs_data_t *data, const char *name);
+double obs_data_get_double(obs_data_t *data, const char *name);
+bool obs_data_get_bool(obs_data_t *data, const char *name);
+
+obs_data_item_t *obs_data_first(obs_data_t *data);
+obs_data_item_t *obs_data_item_byname(obs_data_t *data, const char *name);
+bool obs_data_item_next(obs_data_item_t **item);
+void obs_data_item_release(obs_data_item_t **item);
+const char *obs_data_item_get_name(obs_data_item_t *item);
+long long obs_data_item_get_int(obs_data_item_t *item);
+double obs_data_item_get_double(obs_data_item_t *item);
+bool obs_data_item_get_bool(obs_data_item_t *item);
+
+// Properties
+obs_properties_t *obs_properties_create(void);
+void obs_properties_destroy(obs_properties_t *props);
+obs_property_t *obs_properties_get(obs_properties_t *props, const char *property);
+obs_property_t *obs_properties_add_bool(obs_properties_t *props, const char *name, const char *description);
+obs_property_t *obs_properties_add_int_slider(obs_properties_t *props, const char *name, const char *description,
+                                              int min, int max, int step);
+obs_property_t *obs_properties_add_float_slider(obs_properties_t *props, const char *name,
+                                                const char *description, double min, double max, double step);
+obs_property_t *obs_properties_add_color(obs_properties_t *props, const char *name, const char *description);
+obs_property_t *obs_properties_add_path(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_path_type type, const char *filter, const char *default_path);
+obs_property_t *obs_properties_add_list(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_combo_type type, enum obs_combo_format format);
+obs_property_t *obs_properties_add_group(obs_properties_t *props, const char *name, const char *description,
+                                         enum obs_group_type type, obs_properties_t *group);
+size_t obs_property_list_add_string(obs_property_t *p, const char *name, const char *val);
+void obs_property_set_modified_callback(obs_property_t *p, obs_property_modified_t modified);
+void obs_property_set_visible(obs_property_t *p, bool visible);
+
+// Sources
+void *obs_source_get_type_data(obs_source_t *source);
+const char *obs_source_get_name(const obs_source_t *source);
+uint32_t obs_source_get_width(obs_source_t *source);
+uint32_t obs_source_get_height(obs_source_t *source);
+uint32_t obs_source_get_output_flags(const obs_source_t *source);
+enum gs_color_space obs_source_get_color_space(obs_source_t *source, size_t count,
+                                               const enum gs_color_space *preferred_spaces);
+enum obs_deinterlace_mode obs_source_get_deinterlace_mode(const obs_source_t *source);
+bool obs_source_showing(const obs_source_t *source);
+void obs_source_update(obs_source_t *source, obs_data_t *settings);
+void obs_source_skip_video_filter(obs_source_t *filter);
+bool obs_source_process_filter_begin(obs_source_t *filter, enum gs_color_format format,
+                                     enum obs_allow_direct_render allow_direct);
+bool obs_source_process_filter_begin_with_color_space(obs_source_t *filter, enum gs_color_format format,
+                                                      enum gs_color_space space,
+                                                      enum obs_allow_direct_render allow_direct);
+void obs_source_process_filter_end(obs_source_t *filter, gs_effect_t *effect, uint32_t width, uint32_t height);
+void obs_source_default_render(obs_source_t *source);
+void obs_source_video_render(obs_source_t *source);
+obs_source_t *obs_filter_get_parent(const obs_source_t *filter);
+obs_source_t *obs_filter_get_target(const obs_source_t *filter);
+
+// Core
+void obs_enter_graphics(void);
+void obs_leave_graphics(void);
+uint64_t obs_get_video_frame_time(void);
+gs_effect_t *obs_get_base_effect(enum obs_base_effect effect);
+obs_module_t *obs_get_module(const char *name);
+char *obs_find_module_file(obs_module_t *module, const char *file);
+
+// --- Mock controls (not libobs) ---
+
+// Directory obs_find_module_file() resolves "shaders/..." against, the
+// plugin's data directory
+void mock_obs_set_data_path(const char *path);
+
+// Messages at or below `level` are printed (default LOG_ERROR);
+// mock_obs_log_count() counts all messages at or below `level`
+void mock_obs_set_log_level(int level);
+unsigned long mock_obs_log_count(int level);
+
+// A filter of `type_data` (an effect_info_t) on a width x height parent
+// source. obs_source_update() on it calls `update`; one made before
+// mock_filter_set_data() (from the create callback) runs when it is called.
+typedef void (*mock_update_t)(void *data, obs_data_t *settings);
+obs_source_t *mock_filter_create(const char *name, void *type_data, mock_update_t update, uint32_t width,
+                                 uint32_t height);
+void mock_filter_set_data(obs_source_t *filter, void *data);
+void mock_filter_destroy(obs_source_t *filter);
+
+// Setter calls on every effect's parameters since start
+unsigned long mock_gs_param_sets(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,3 @@
+/* Forwards to the libobs stand-in, see bench/mock-obs/mock-obs.h */
+#pragma once
+#include <mock-obs.h>
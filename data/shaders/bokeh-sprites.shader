@@ -0,0 +1,169 @@
+// --- Bokeh Sprites ---
+// Sprite and highlights modes for bokeh.shader. Particles are simulated once
+// per frame on the CPU (bokeh.c), or placed on the source's bright spots
+// found by the HighlightPass technique, and drawn as one quad each, so only
+// the pixels a particle covers run the shape / chromatic aberration / onion
+// ring shading. Uniform names match bokeh.shader so both share the same
+// settings.
+
+// --- Constants ---
+#define PI 3.14159265359
+
+// --- Uniforms ---
+uniform bool enable_source_brightness_affect = false;
+uniform float source_brightness_strength = 0.75;
+uniform float source_brightness_threshold = 0.2;
+
+uniform bool use_polygons = false;
+uniform int poly_sides = 6;
+
+uniform bool enable_chromatic_aberration = false;
+uniform float ca_strength = 2.0;
+
+uniform bool enable_onion_rings = false;
+uniform float onion_ring_frequency = 5.0;
+uniform float onion_ring_strength = 0.4;
+uniform float onion_ring_animation_speed = 0.0;
+
+// --- Per-frame values (set by bokeh.c) ---
+uniform float2 sprite_rotation = {1.0, 0.0}; // (cos, sin) of the polygon rotation, animation applied
+uniform float sprite_opacity = 1.0;   // 1 - motion_blur_amount
+uniform bool use_luma_image = false;  // Read brightness from luma_image instead of image
+uniform texture2d luma_image;         // Low-res mean luminance in r (luma-stats.c)
+uniform float2 highlight_block;       // Input UV covered by one HighlightPass texel
+
+// --- Standard Uniforms & Structs ---
+uniform float4x4 ViewProj;
+uniform texture2d image;
+uniform float elapsed_time;
+uniform float2 uv_pixel_interval;
+
+sampler_state textureSampler {
+    Filter   = Linear;
+    AddressU = Clamp;
+    AddressV = Clamp;
+};
+
+struct VertData {
+    float4 pos : POSITION;
+    float2 uv  : TEXCOORD0;
+};
+
+struct SpriteData {
+    float4 pos    : POSITION;
+    float4 shape  : TEXCOORD0;  // xy: offset from particle centre (aspect units), z: radius, w: edge blur width
+    float4 color  : TEXCOORD1;  // Life-cycle colour, alpha already faded
+    float2 center : TEXCOORD2;  // Particle centre in source UV
+};
+
+#include "bokeh-shape.inc"
+
+// --- Vertex Shaders ---
+VertData VSDefault(VertData v_in)
+{
+    VertData v_out;
+    v_out.pos = mul(float4(v_in.pos.xyz, 1.0), ViewProj);
+    v_out.uv = v_in.uv;
+    return v_out;
+}
+
+SpriteData VSSprite(SpriteData v_in)
+{
+    SpriteData v_out;
+    v_out.pos = mul(float4(v_in.pos.xyz, 1.0), ViewProj);
+    v_out.shape = v_in.shape;
+    v_out.color = v_in.color;
+    v_out.center = v_in.center;
+    return v_out;
+}
+
+// --- Pixel Shaders ---
+
+// Highlights mode bright pass, one texel per block of the input: the colour
+// of the block's brightest tap in rgb, its luminance in a. The 4x4 linear
+// taps each average 2x2 texels, so small lights still register; bokeh.c
+// reads the result back and places a sprite on each local maximum.
+float4 PSHighlightPass(VertData v_in) : TARGET
+{
+    float4 brightest = float4(0.0, 0.0, 0.0, 0.0);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            float2 uv = v_in.uv + highlight_block * ((float2(x, y) - 1.5) / 4.0);
+            float3 rgb = image.Sample(textureSampler, uv).rgb;
+            float luminance = dot(rgb, float3(0.299, 0.587, 0.114));
+            if (luminance > brightest.a) brightest = float4(rgb, luminance);
+        }
+    }
+    return brightest;
+}
+
+float4 PSSprite(SpriteData v_in) : TARGET
+{
+    float2 p_local = v_in.shape.xy;
+    float radius = v_in.shape.z;
+    float blur_width = v_in.shape.w;
+    float4 particle_color = v_in.color;
+
+    // --- Source Brightness Interaction (same rule as bokeh.shader) ---
+    // Every pixel of a sprite reads the same texel, so this stays in cache.
+    if (enable_source_brightness_affect) {
+        float source_luminance;
+        if (use_luma_image) {
+            source_luminance = luma_image.Sample(textureSampler, saturate(v_in.center)).r;
+        } else {
+            float4 source_color_at_particle = image.Sample(textureSampler, saturate(v_in.center));
+            source_luminance = dot(source_color_at_particle.rgb, float3(0.299, 0.587, 0.114));
+        }
+
+        float luma_modulation_factor = 1.0;
+        if (source_luminance < source_brightness_threshold) {
+            luma_modulation_factor = saturate(source_luminance / source_brightness_threshold);
+        }
+        particle_color.a *= lerp(1.0, luma_modulation_factor, source_brightness_strength);
+    }
+
+    float4 contribution;
+
+    if (SPEC_enable_chromatic_aberration && ca_strength > 0.01) {
+        float dist_to_pixel_from_center = length(p_local);
+        float2 radial_offset_dir = (dist_to_pixel_from_center > 0.0001) ? p_local / dist_to_pixel_from_center : float2(0.0, 0.0);
+        float2 offset_uv_amount = radial_offset_dir * ca_strength * uv_pixel_interval.y;
+
+        float mask_r = get_shape_mask(p_local + offset_uv_amount, float2(0.0, 0.0),
+                                      SPEC_use_polygons, poly_sides, sprite_rotation, radius, blur_width);
+        float mask_g = get_shape_mask(p_local, float2(0.0, 0.0),
+                                      SPEC_use_polygons, poly_sides, sprite_rotation, radius, blur_width);
+        float mask_b = get_shape_mask(p_local - offset_uv_amount, float2(0.0, 0.0),
+                                      SPEC_use_polygons, poly_sides, sprite_rotation, radius, blur_width);
+
+        contribution = float4(particle_color.r * mask_r,
+                              particle_color.g * mask_g,
+                              particle_color.b * mask_b,
+                              particle_color.a * mask_g);
+    } else {
+        float mask = get_shape_mask(p_local, float2(0.0, 0.0),
+                                    SPEC_use_polygons, poly_sides, sprite_rotation, radius, blur_width);
+        contribution = particle_color * mask;
+    }
+
+    // Blended with ONE / INVSRCALPHA: out = particle + source * (1 - particle.a)
+    return contribution * sprite_opacity;
+}
+
+technique HighlightPass
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSHighlightPass(v_in);
+    }
+}
+
+technique DrawSprites
+{
+    pass
+    {
+        vertex_shader = VSSprite(v_in);
+        pixel_shader  = PSSprite(v_in);
+    }
+}
@@ -202,6 +202,27 @@ uniform float onion_ring_animation_speed <
     string group = "Artifact Settings";
 > = 0.0;
 
+uniform int search_radius <
+    string label = "Search Radius";
+    string description = "Neighbouring cells each pixel checks for particles. Lower is faster but clips bokeh that reach further.";
+    string widget_type = "slider";
+    int minimum = 0;
+    int maximum = 2;
+    int step = 1;
+> = 1;
+
+// --- Per-frame values (set by bokeh.c) ---
+uniform float2 shape_rotation = {1.0, 0.0}; // (cos, sin) of poly_rotation, animation applied
+
+// --- Brightness Lookup (set by bokeh.c) ---
+// With use_particle_luma the ParticleLuma prepass has stored the brightness
+// factor of every particle a pixel can reach, one texel per grid cell, read
+// from the low-res luminance in luma_image.
+uniform bool use_particle_luma = false;
+uniform texture2d particle_luma;
+uniform texture2d luma_image;
+uniform float2 particle_luma_layout; // Texels per side, cells left of/above the grid
+
 // --- Standard Uniforms & Structs ---
 uniform float4x4 ViewProj;
 uniform texture2d image;
@@ -215,6 +236,12 @@ sampler_state textureSampler {
     AddressV = Clamp;
 };
 
+sampler_state pointSampler {
+    Filter   = Point;
+    AddressU = Clamp;
+    AddressV = Clamp;
+};
+
 struct VertData {
     float4 pos : POSITION;
     float2 uv  : TEXCOORD0;
@@ -226,87 +253,38 @@ float2 rand2(float2 p) {
     return frac(sin(float2(dot(p, float2(127.1, 311.7)), dot(p, float2(269.5, 183.3)))) * 43758.5453);
 }
 
-// Original circle function (still used by get_shape_mask as a fallback or if use_polygons is false)
-float circle(float2 uv, float2 pos, float radius, float softness) {
-    // Ensure softness doesn't make radius completely disappear or become negative
-    softness = min(softness, radius * 0.999); 
-    softness = max(0.0, softness); // Ensure non-negative softness
-    float d = length(uv - pos);
-    return smoothstep(radius, radius - softness, d);
-}
+// Shape mask helpers (circle/polygon, onion rings), shared with bokeh-sprites.shader
+#include "bokeh-shape.inc"
 
-// Helper to rotate a 2D vector
-float2 rotate(float2 v, float angle_rad) {
-    float s = sin(angle_rad);
-    float c = cos(angle_rad);
-    return float2(v.x * c - v.y * s, v.x * s + v.y * c);
+// Cells per side of the particle grid
+float particle_cells()
+{
+    return clamp(max(particle_density, 1.0) / 5.0, 3.0, 10.0);
 }
 
-// Calculates a value representing distance from polygon edge (negative inside)
-float nGonDist(float2 p_local, float N_float, float r_circum) {
-    if (N_float < 2.5) return length(p_local) - r_circum; // Fallback for safety
-
-    float ang = atan2(p_local.x, p_local.y); 
-    float segment_angle = 2.0 * PI / N_float; 
-    float t = floor(0.5 + ang / segment_angle) * segment_angle;
-    float dist_to_segment_bisector_projection = cos(t - ang) * length(p_local);
-    float apothem = r_circum * cos(PI / N_float);
-    return dist_to_segment_bisector_projection - apothem; 
+// Centre (uv) of the particle of a cell at `time`, with its random values
+// and life phase
+float2 particle_center(float2 cell_id, float cells, float time, out float2 particle_rand, out float particle_phase)
+{
+    particle_rand = rand2(cell_id);
+    float particle_life = particle_rand.x * 5.0 + 2.0;
+    particle_phase = frac(time / particle_life + particle_rand.y);
+
+    float2 particle_pos_in_cell = rand2(cell_id + particle_rand.y);
+    particle_pos_in_cell.y += particle_phase * 2.0 - 1.0;
+    particle_pos_in_cell.x += sin(particle_phase * PI * 2.0 + particle_rand.x * PI) * 0.5;
+    return (cell_id + particle_pos_in_cell) / cells;
 }
 
-// Unified function to generate the shape mask (circle or polygon)
-// Includes onion ring effect if enabled.
-float get_shape_mask(float2 uv_pixel_centered_aspect, float2 particle_center_aspect, 
-                     bool use_polygons_flag, int N_sides_int, float rotation_rad, 
-                     float particle_radius_circum, float desired_edge_blur_width)
+// Alpha factor of a particle over source luminance `luma`: fades out below
+// the threshold, blended in by source_brightness_strength
+float brightness_factor(float luma)
 {
-    // Calculate p_local_unrotated: coordinates of the current pixel relative to the particle center,
-    // without the polygon's specific orientation rotation. This is used for distance from center (for rings).
-    float2 p_local_unrotated = uv_pixel_centered_aspect - particle_center_aspect;
-    float dist_from_center_for_rings = length(p_local_unrotated);
-
-    float base_shape_alpha; // This will be the mask from the primary shape (circle/polygon)
-
-    if (!use_polygons_flag || N_sides_int < 3) { 
-        // --- Circle Drawing Logic ---
-        float actual_circle_softness = min(desired_edge_blur_width, particle_radius_circum * 0.999);
-        actual_circle_softness = max(0.0, actual_circle_softness); 
-
-        // Use dist_from_center_for_rings (which is 'd' in the original circle function)
-        base_shape_alpha = smoothstep(particle_radius_circum, particle_radius_circum - actual_circle_softness, dist_from_center_for_rings);
-    } else {
-        // --- Polygon Drawing Logic (N_sides >= 3) ---
-        // For the polygon SDF, we need p_local rotated by the particle's orientation
-        float2 p_local_rotated_for_sdf = rotate(p_local_unrotated, -rotation_rad); 
-
-        float N_float = float(N_sides_int); 
-        float dist_from_sdf_edge = nGonDist(p_local_rotated_for_sdf, N_float, particle_radius_circum); // dist is negative inside
-
-        float half_actual_blur_width = max(desired_edge_blur_width, uv_pixel_interval.y) * 0.5; 
-        base_shape_alpha = smoothstep(half_actual_blur_width, -half_actual_blur_width, dist_from_sdf_edge);
-    }
-
-    // --- Apply Onion Ring Effect (modulates base_shape_alpha) ---
-    if (enable_onion_rings && base_shape_alpha > 0.001) { // Only apply if pixel is significantly part of the bokeh
-        // Normalized distance from center (0 at center, ~1 at edge of particle_radius_circum)
-        float normalized_dist = saturate(dist_from_center_for_rings / particle_radius_circum);
-        
-        float ring_phase_offset = elapsed_time * onion_ring_animation_speed;
-
-        // Sinusoidal wave based on normalized distance and frequency, animated by phase
-        // (Multiplying by 2.0*PI makes one full cycle of sin per unit of frequency)
-        float ring_sine_wave = sin(normalized_dist * onion_ring_frequency * 2.0 * PI - ring_phase_offset);
-        
-        // Remap sine wave from [-1, 1] to [0, 1] range
-        float ring_modulation_factor = (ring_sine_wave * 0.5 + 0.5); 
-        
-        // Apply strength: lerp from 1.0 (no effect) towards the ring_modulation_factor
-        ring_modulation_factor = lerp(1.0, ring_modulation_factor, onion_ring_strength);
-        
-        base_shape_alpha *= ring_modulation_factor; // Modulate the existing alpha
+    float modulation = 1.0;
+    if (luma < source_brightness_threshold) {
+        modulation = saturate(luma / source_brightness_threshold);
     }
-    
-    return saturate(base_shape_alpha); // Ensure final mask is clamped
+    return lerp(1.0, modulation, source_brightness_strength);
 }
 
 // --- Vertex Shader ---
@@ -318,12 +296,11 @@ VertData VSDefault(VertData v_in)
     return v_out;
 }
 
-// --- Pixel Shader ---
-float4 mainImage(VertData v_in) : TARGET
+// --- Particle Layer ---
+// Premultiplied sum of every particle covering this pixel. The DrawOverlay
+// technique renders this at reduced resolution.
+float4 particle_layer(float2 texcoord)
 {
-    float2 texcoord = v_in.uv; 
-    float4 original_color = image.Sample(textureSampler, texcoord); 
-    
     float4 final_particle_color = float4(0.0, 0.0, 0.0, 0.0); 
 
     float aspect_ratio = uv_size.x / uv_size.y;
@@ -331,42 +308,24 @@ float4 mainImage(VertData v_in) : TARGET
 
     float time = elapsed_time * animation_speed;
 
-    float cells_raw = max(particle_density, 1.0) / 5.0; // Ensure minimum 1.0
-    float cells = clamp(cells_raw, 3.0, 10.0); 
+    float cells = particle_cells();
 
     float2 cell_uv = texcoord * cells; 
     float2 cell_id = floor(cell_uv); 
 
     // Reduce search area based on particle density
-    float search_radius = min(2.0, cells / 5.0);
-    int search_int = int(ceil(search_radius));
+    float search_cells = min(float(search_radius), cells / 5.0);
+    int search_int = int(ceil(search_cells));
 
-    // Calculate animated rotation outside the loop for efficiency
-    float static_rotation_rad = poly_rotation * (PI / 180.0);
-    float animated_rotation_rad = elapsed_time * poly_rotation_speed * (PI / 180.0);
-    float final_rotation_radians = static_rotation_rad + animated_rotation_rad;
-
-    int max_iterations = min(search_int * search_int, 16); // Limit max iterations
-    int current_iteration = 0;
-
-    for (int iy = -search_int; iy <= search_int && current_iteration < max_iterations; ++iy) {
-        for (int ix = -search_int; ix <= search_int && current_iteration < max_iterations; ++ix) {
-            current_iteration++;
+    for (int iy = -search_int; iy <= search_int; ++iy) {
+        for (int ix = -search_int; ix <= search_int; ++ix) {
             if (abs(ix) + abs(iy) > search_int) continue; // Skip corners
 
             float2 neighbor_cell_id = cell_id + float2(ix, iy);
             
-            float2 particle_rand_seed = neighbor_cell_id; 
-            float2 particle_rand = rand2(particle_rand_seed);
-
-            float particle_life = particle_rand.x * 5.0 + 2.0; 
-            float particle_phase = frac(time / particle_life + particle_rand.y); 
-
-            float2 particle_pos_in_cell = rand2(particle_rand_seed + particle_rand.y); 
-            particle_pos_in_cell.y += particle_phase * 2.0 - 1.0; 
-            particle_pos_in_cell.x += sin(particle_phase * PI * 2.0 + particle_rand.x * PI) * 0.5; 
-            
-            float2 particle_center_uv_raw = (neighbor_cell_id + particle_pos_in_cell) / cells;
+            float2 particle_rand;
+            float particle_phase;
+            float2 particle_center_uv_raw = particle_center(neighbor_cell_id, cells, time, particle_rand, particle_phase);
 
             float2 focus_uv_raw = float2(focus_point_x, focus_point_y);
             float dist_to_focus = length(particle_center_uv_raw - focus_uv_raw);
@@ -381,39 +340,18 @@ float4 mainImage(VertData v_in) : TARGET
             current_particle_color_sample.a *= life_alpha;
 
 // --- Source Brightness Interaction ---
+            // Looked up from the prepass when bokeh.c ran it, otherwise
+            // sampled from the source at the particle's centre
             if (enable_source_brightness_affect) {
-                // Sample the original source color at the particle's conceptual center.
-                // particle_center_uv_raw is in [0,1] UV space.
-                float2 source_sample_uv = saturate(particle_center_uv_raw); // Clamp to avoid edge issues
-                float4 source_color_at_particle = image.Sample(textureSampler, source_sample_uv);
-                
-                // Calculate luminance (brightness) of the sampled source color
-                float source_luminance = dot(source_color_at_particle.rgb, float3(0.299, 0.587, 0.114));
-                
-                // Determine modulation factor based on luminance, threshold, and strength
-                float luma_modulation_factor = 1.0; // Default: no change to alpha
-
-                if (source_luminance < source_brightness_threshold) {
-                    // If source is darker than threshold, the modulation aims towards 0 (transparent)
-                    // How quickly it goes to 0 depends on how far below threshold it is.
-                    // For simplicity, let's make it a sharper falloff if below threshold:
-                    luma_modulation_factor = source_luminance / source_brightness_threshold; // Scales 0-1 below threshold
-                    luma_modulation_factor = saturate(luma_modulation_factor); // Ensure it's 0-1
+                if (use_particle_luma) {
+                    float2 luma_uv = (neighbor_cell_id + particle_luma_layout.y + 0.5) / particle_luma_layout.x;
+                    current_particle_color_sample.a *= particle_luma.Sample(pointSampler, luma_uv).r;
                 } else {
-                    // If source is brighter than or at threshold, scale factor from a base (e.g., 0 if at threshold) to 1 (at max brightness)
-                    // This makes particles "pop" more over bright areas if not already at full alpha.
-                    // For this implementation, let's make sure particles are fully visible if source is bright enough.
-                    // (The previous logic was scaling between 0 and 1, let's simplify)
-                    luma_modulation_factor = 1.0; // Fully visible if above threshold (can be refined later if needed)
+                    float4 source_color_at_particle = image.Sample(textureSampler, saturate(particle_center_uv_raw));
+                    float source_luminance = dot(source_color_at_particle.rgb, float3(0.299, 0.587, 0.114));
+                    current_particle_color_sample.a *= brightness_factor(source_luminance);
                 }
-                
-                // The 'source_brightness_strength' (0 to 1) blends between original alpha and luma-modulated alpha.
-                // If strength = 0, final_factor = 1 (no change from original life_alpha).
-                // If strength = 1, final_factor = luma_modulation_factor.
-                float final_luma_effect_on_alpha = lerp(1.0, luma_modulation_factor, source_brightness_strength); 
-                current_particle_color_sample.a *= final_luma_effect_on_alpha;
             }
-            // --- End of Source Brightness Interaction ---
 
             float2 particle_pos_aspect = float2((particle_center_uv_raw.x - 0.5) * aspect_ratio, particle_center_uv_raw.y - 0.5);
             
@@ -422,7 +360,7 @@ float4 mainImage(VertData v_in) : TARGET
 
             float4 particle_contribution_this_iteration = float4(0.0, 0.0, 0.0, 0.0);
 
-            if (enable_chromatic_aberration && ca_strength > 0.01) {
+            if (SPEC_enable_chromatic_aberration && ca_strength > 0.01) {
                 // Calculate radial offset direction (from particle center to current pixel)
                 // This makes the aberration spread out from the particle's center.
                 float2 vector_to_pixel = centered_aspect_uv - particle_pos_aspect;
@@ -437,17 +375,17 @@ float4 mainImage(VertData v_in) : TARGET
 
                 // Get mask for Red channel: evaluate shape at UV shifted by +offset_uv_amount
                 float mask_r = get_shape_mask(centered_aspect_uv + offset_uv_amount, particle_pos_aspect, 
-                                              use_polygons, poly_sides, final_rotation_radians, 
+                                              SPEC_use_polygons, poly_sides, shape_rotation, 
                                               current_particle_size, calculated_blur_width);
                 
                 // Get mask for Green channel: evaluate shape at normal UV (no offset)
                 float mask_g = get_shape_mask(centered_aspect_uv, particle_pos_aspect, 
-                                              use_polygons, poly_sides, final_rotation_radians, 
+                                              SPEC_use_polygons, poly_sides, shape_rotation, 
                                               current_particle_size, calculated_blur_width);
                 
                 // Get mask for Blue channel: evaluate shape at UV shifted by -offset_uv_amount
                 float mask_b = get_shape_mask(centered_aspect_uv - offset_uv_amount, particle_pos_aspect, 
-                                              use_polygons, poly_sides, final_rotation_radians, 
+                                              SPEC_use_polygons, poly_sides, shape_rotation, 
                                               current_particle_size, calculated_blur_width);
 
                 particle_contribution_this_iteration.r = current_particle_color_sample.r * mask_r;
@@ -459,7 +397,7 @@ float4 mainImage(VertData v_in) : TARGET
 
             } else { // No chromatic aberration, or strength is effectively zero
                 float particle_mask_no_ca = get_shape_mask(centered_aspect_uv, particle_pos_aspect, 
-                                                           use_polygons, poly_sides, final_rotation_radians, 
+                                                           SPEC_use_polygons, poly_sides, shape_rotation, 
                                                            current_particle_size, calculated_blur_width);
                 particle_contribution_this_iteration = particle_mask_no_ca * current_particle_color_sample;
             }
@@ -467,7 +405,12 @@ float4 mainImage(VertData v_in) : TARGET
             final_particle_color += particle_contribution_this_iteration;
         }
     }
-    
+
+    return final_particle_color;
+}
+
+float4 composite_particles(float4 original_color, float4 final_particle_color)
+{
     float4 blended_output_color;
     blended_output_color.rgb = final_particle_color.rgb + original_color.rgb * (1.0 - final_particle_color.a);
     blended_output_color.a = saturate(final_particle_color.a + original_color.a * (1.0 - final_particle_color.a));
@@ -479,6 +422,40 @@ float4 mainImage(VertData v_in) : TARGET
     return saturate(blended_output_color);
 }
 
+// Edge-aware upsample of the reduced-resolution particle layer
+#include "overlay-upsample.inc"
+
+// --- Pixel Shaders ---
+float4 mainImage(VertData v_in) : TARGET
+{
+    float4 original_color = image.Sample(textureSampler, v_in.uv);
+    return composite_particles(original_color, particle_layer(v_in.uv));
+}
+
+// Brightness factor of the particle of every cell the particle loop can
+// reach, one texel each, evaluated once per frame instead of per pixel
+float4 PSParticleLuma(VertData v_in) : TARGET
+{
+    float2 cell_id = floor(v_in.uv * particle_luma_layout.x) - particle_luma_layout.y;
+    float2 particle_rand;
+    float particle_phase;
+    float2 center = particle_center(cell_id, particle_cells(), elapsed_time * animation_speed, particle_rand, particle_phase);
+    float luma = luma_image.Sample(textureSampler, saturate(center)).r;
+    return float4(brightness_factor(luma), 0.0, 0.0, 1.0);
+}
+
+float4 PSOverlay(VertData v_in) : TARGET
+{
+    return particle_layer(v_in.uv);
+}
+
+float4 PSComposite(VertData v_in) : TARGET
+{
+    float4 original_color = image.Sample(textureSampler, v_in.uv);
+    float guide_luma = dot(original_color.rgb, OVERLAY_LUMA);
+    return composite_particles(original_color, upsample_overlay(v_in.uv, guide_luma));
+}
+
 technique Draw
 {
     pass
@@ -486,4 +463,30 @@ technique Draw
         vertex_shader = VSDefault(v_in);
         pixel_shader  = mainImage(v_in);
     }
-}
\ No newline at end of file
+}
+technique DrawOverlay
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSOverlay(v_in);
+    }
+}
+
+technique Composite
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSComposite(v_in);
+    }
+}
+
+technique ParticleLuma
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSParticleLuma(v_in);
+    }
+}
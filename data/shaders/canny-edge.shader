@@ -1,75 +1,240 @@
+// --- Canny Edge Detection ---
+// Passes run by edge-map.c at the selected resolution:
+//   1. BlurLuma / Blur - separable Gaussian of the input's luminance
+//   2. Gradient        - Sobel magnitude and gradient direction (4 sectors)
+//   3. Suppress        - non-maximum suppression along the gradient, then
+//                        double threshold: 1 strong, 0.5 weak, 0 none
+//   4. Hysteresis      - weak texels touching a strong one become strong,
+//                        a bounded number of times; the final pass drops
+//                        the weak texels left over
+// Draw is the filter's own output (canny.c), reading the finished edge map.
+
+// --- Constants ---
+#define PI 3.14159265359
+#define BLUR_RADIUS 4
+
+// --- User-defined parameters (uniforms) ---
+uniform bool overlay_source = false;
+uniform float4 edge_color = { 1.0, 1.0, 1.0, 1.0 };
+uniform float edge_opacity = 1.0;
+
+// --- Pass uniforms (set by edge-map.c) ---
+uniform float2 texel;          // UV size of one texel of the pass target
+uniform float2 blur_dir;       // (1, 0) or (0, 1)
+uniform float blur_sigma = 1.4;
+uniform float low_threshold = 0.1;
+uniform float high_threshold = 0.3;
+uniform bool hysteresis_final = false;
+uniform texture2d edge_image;  // Finished edge map (Draw)
+
+// --- Standard Uniforms & Structs ---
 uniform float4x4 ViewProj;
-uniform texture2D image;
-uniform float2 uv_size; // width and height of the texture
+uniform texture2d image;
 
-// Canny edge detection parameters
-uniform float threshold1 = 100.0 / 255.0; // Lower threshold (normalized)
-uniform float threshold2 = 200.0 / 255.0; // Upper threshold (normalized)
+sampler_state textureSampler {
+    Filter   = Linear;
+    AddressU = Clamp;
+    AddressV = Clamp;
+};
 
-struct VertData {
-	float4 pos : POSITION;
-	float2 uv  : TEXCOORD0;
+sampler_state pointSampler {
+    Filter   = Point;
+    AddressU = Clamp;
+    AddressV = Clamp;
 };
 
-struct VertToFrag {
-	float4 pos : POSITION;
-	float2 uv  : TEXCOORD0;
+struct VertData {
+    float4 pos : POSITION;
+    float2 uv  : TEXCOORD0;
 };
 
-VertToFrag main_vertex(VertData v_in)
+// --- Vertex Shader ---
+VertData VSDefault(VertData v_in)
 {
-	VertToFrag v_out;
-	v_out.pos = mul(v_in.pos, ViewProj);
-	v_out.uv = v_in.uv;
-	return v_out;
+    VertData v_out;
+    v_out.pos = mul(v_in.pos, ViewProj);
+    v_out.uv = v_in.uv;
+    return v_out;
 }
 
-// Helper to convert to grayscale
-float grayscale(float4 color)
+// --- Helpers ---
+float luma(float3 rgb)
 {
-	return dot(color.rgb, float3(0.299, 0.587, 0.114));
+    return dot(rgb, float3(0.299, 0.587, 0.114));
 }
 
-// Sobel edge detection
-float sobel(texture2D tex, float2 uv, float2 pixel_size)
+float gauss_weight(int i)
 {
-	// Get grayscale values of 3x3 neighborhood
-	float tl = grayscale(tex2D(tex, uv + float2(-pixel_size.x, -pixel_size.y)));
-	float t  = grayscale(tex2D(tex, uv + float2(0.0, -pixel_size.y)));
-	float tr = grayscale(tex2D(tex, uv + float2(pixel_size.x, -pixel_size.y)));
-	float l  = grayscale(tex2D(tex, uv + float2(-pixel_size.x, 0.0)));
-	float r  = grayscale(tex2D(tex, uv + float2(pixel_size.x, 0.0)));
-	float bl = grayscale(tex2D(tex, uv + float2(-pixel_size.x, pixel_size.y)));
-	float b  = grayscale(tex2D(tex, uv + float2(0.0, pixel_size.y)));
-	float br = grayscale(tex2D(tex, uv + float2(pixel_size.x, pixel_size.y)));
+    return exp(-float(i * i) / (2.0 * blur_sigma * blur_sigma));
+}
 
-	// Sobel operators
-	float Gx = -tl - 2.0 * l - bl + tr + 2.0 * r + br;
-	float Gy = -tl - 2.0 * t - tr + bl + 2.0 * b + br;
+float edge_at(float2 uv, float2 offset)
+{
+    return image.Sample(pointSampler, uv + offset * texel).r;
+}
 
-	// Gradient magnitude
-	return length(float2(Gx, Gy));
+// --- Pixel Shaders ---
+// Horizontal pass, reading the colour input (linear: the pass target may be
+// smaller than the input)
+float4 PSBlurLuma(VertData v_in) : TARGET
+{
+    float sum = 0.0;
+    float total = 0.0;
+    for (int i = -BLUR_RADIUS; i <= BLUR_RADIUS; i++) {
+        float w = gauss_weight(i);
+        sum += luma(image.Sample(textureSampler, v_in.uv + blur_dir * texel * float(i)).rgb) * w;
+        total += w;
+    }
+    sum /= total;
+    return float4(sum, sum, sum, 1.0);
 }
 
+// Vertical pass, reading the horizontal one
+float4 PSBlur(VertData v_in) : TARGET
+{
+    float sum = 0.0;
+    float total = 0.0;
+    for (int i = -BLUR_RADIUS; i <= BLUR_RADIUS; i++) {
+        float w = gauss_weight(i);
+        sum += image.Sample(pointSampler, v_in.uv + blur_dir * texel * float(i)).r * w;
+        total += w;
+    }
+    sum /= total;
+    return float4(sum, sum, sum, 1.0);
+}
 
-float4 main_fragment(VertToFrag v_in) : TARGET
+// r: gradient magnitude, g: direction sector 0..3 (0 horizontal gradient,
+// 1 down-right, 2 vertical, 3 down-left, in UV space)
+float4 PSGradient(VertData v_in) : TARGET
 {
-	float2 pixel_size = 1.0 / uv_size;
-	float magnitude = sobel(image, v_in.uv, pixel_size);
+    float tl = edge_at(v_in.uv, float2(-1.0, -1.0));
+    float t  = edge_at(v_in.uv, float2( 0.0, -1.0));
+    float tr = edge_at(v_in.uv, float2( 1.0, -1.0));
+    float l  = edge_at(v_in.uv, float2(-1.0,  0.0));
+    float r  = edge_at(v_in.uv, float2( 1.0,  0.0));
+    float bl = edge_at(v_in.uv, float2(-1.0,  1.0));
+    float b  = edge_at(v_in.uv, float2( 0.0,  1.0));
+    float br = edge_at(v_in.uv, float2( 1.0,  1.0));
+
+    float gx = -tl - 2.0 * l - bl + tr + 2.0 * r + br;
+    float gy = -tl - 2.0 * t - tr + bl + 2.0 * b + br;
+
+    // Fold the angle to [0, PI) and round to the nearest of four directions
+    float angle = atan2(gy, gx);
+    if (angle < 0.0) angle += PI;
+    float sector = fmod(floor(angle / (PI / 4.0) + 0.5), 4.0);
+
+    return float4(length(float2(gx, gy)), sector, 0.0, 1.0);
+}
+
+float4 PSSuppress(VertData v_in) : TARGET
+{
+    float2 gradient = image.Sample(pointSampler, v_in.uv).rg;
+    float magnitude = gradient.r;
+
+    float2 offset;
+    if (gradient.g < 0.5) {
+        offset = float2(1.0, 0.0);
+    } else if (gradient.g < 1.5) {
+        offset = float2(1.0, 1.0);
+    } else if (gradient.g < 2.5) {
+        offset = float2(0.0, 1.0);
+    } else {
+        offset = float2(-1.0, 1.0);
+    }
+
+    // Keep only the ridge across the gradient
+    float ahead = edge_at(v_in.uv, offset);
+    float behind = edge_at(v_in.uv, -offset);
+    if (magnitude < ahead || magnitude < behind) magnitude = 0.0;
+
+    float edge = magnitude >= high_threshold ? 1.0 : (magnitude >= low_threshold ? 0.5 : 0.0);
+    return float4(edge, edge, edge, 1.0);
+}
 
-	// Simple thresholding - this is a simplified Canny
-	if (magnitude > threshold1) {
-		return float4(1.0, 1.0, 1.0, 1.0); // Edge is white
-	} else {
-		return float4(0.0, 0.0, 0.0, 1.0); // No edge is black
-	}
+float4 PSHysteresis(VertData v_in) : TARGET
+{
+    float edge = edge_at(v_in.uv, float2(0.0, 0.0));
+
+    if (edge > 0.25 && edge < 0.75) {
+        float strongest = 0.0;
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                strongest = max(strongest, edge_at(v_in.uv, float2(float(x), float(y))));
+            }
+        }
+        if (strongest > 0.75) {
+            edge = 1.0;
+        } else if (hysteresis_final) {
+            edge = 0.0;
+        }
+    }
+
+    return float4(edge, edge, edge, 1.0);
+}
+
+float4 PSDraw(VertData v_in) : TARGET
+{
+    float4 color = image.Sample(textureSampler, v_in.uv);
+    float edge = edge_image.Sample(textureSampler, v_in.uv).r * edge_opacity;
+
+    if (overlay_source) {
+        color.rgb = lerp(color.rgb, edge_color.rgb, edge);
+        return color;
+    }
+    return float4(edge_color.rgb * edge, 1.0);
+}
+
+technique BlurLuma
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSBlurLuma(v_in);
+    }
+}
+
+technique Blur
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSBlur(v_in);
+    }
+}
+
+technique Gradient
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSGradient(v_in);
+    }
+}
+
+technique Suppress
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSSuppress(v_in);
+    }
+}
+
+technique Hysteresis
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSHysteresis(v_in);
+    }
 }
 
 technique Draw
 {
-	pass
-	{
-		vertex_shader = main_vertex;
-		pixel_shader  = main_fragment;
-	}
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSDraw(v_in);
+    }
 }
@@ -0,0 +1,77 @@
+// --- EmuLens Stack ---
+// Template for fused passes of the EmuLens Stack filter (src/effects/stack).
+// stack.c compiles a variant per combination of members, prepending:
+//   STACK_WITH_<EFFECT>        includes that effect's stage file
+//   STACK_SAMPLE(uv)           reads the input, optionally through a stage
+//                              that resamples it (e.g. the handheld camera)
+//   STACK_STAGE_<n>(c, uv)     per-pixel stages applied in order, n = 0..3
+// plus the members' SPEC_ defines. Each member binds its own uniforms, so
+// two members of the same effect never share a fused pass.
+
+// --- Standard Uniforms & Structs ---
+uniform float4x4 ViewProj;
+uniform texture2d image;
+uniform float elapsed_time;
+uniform float2 uv_size;
+uniform float2 uv_pixel_interval;
+
+sampler_state textureSampler {
+    Filter   = Linear;
+    AddressU = Clamp;
+    AddressV = Clamp;
+};
+
+struct VertData {
+    float4 pos : POSITION;
+    float2 uv  : TEXCOORD0;
+};
+
+// --- Stages ---
+#ifdef STACK_WITH_HANDHELD
+#include "handheld-stage.inc"
+#endif
+
+#ifdef STACK_WITH_LIGHT_LEAK
+#include "light-leak-stage.inc"
+#endif
+
+#ifndef STACK_SAMPLE
+#define STACK_SAMPLE(uv) image.Sample(textureSampler, uv)
+#endif
+
+// --- Vertex Shader ---
+VertData VSDefault(VertData v_in)
+{
+    VertData v_out;
+    v_out.pos = mul(v_in.pos, ViewProj);
+    v_out.uv = v_in.uv;
+    return v_out;
+}
+
+// --- Pixel Shader ---
+float4 PSStack(VertData v_in) : TARGET
+{
+    float4 color = STACK_SAMPLE(v_in.uv);
+#ifdef STACK_STAGE_0
+    color = STACK_STAGE_0(color, v_in.uv);
+#endif
+#ifdef STACK_STAGE_1
+    color = STACK_STAGE_1(color, v_in.uv);
+#endif
+#ifdef STACK_STAGE_2
+    color = STACK_STAGE_2(color, v_in.uv);
+#endif
+#ifdef STACK_STAGE_3
+    color = STACK_STAGE_3(color, v_in.uv);
+#endif
+    return color;
+}
+
+technique Draw
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSStack(v_in);
+    }
+}
@@ -0,0 +1,95 @@
+// --- Luminance Reduction ---
+// Passes of luma-stats.c. Each pass shrinks its input 4x per axis; every
+// output texel holds the mean (r) and maximum (g) luminance of its 4x4
+// block. The first pass reads RGBA, the others the previous r/g level.
+
+// --- Per-pass values (set by luma-stats.c) ---
+uniform float2 texel; // One texel of `image`
+
+// --- Standard Uniforms & Structs ---
+uniform float4x4 ViewProj;
+uniform texture2d image;
+
+sampler_state pointSampler {
+    Filter   = Point;
+    AddressU = Clamp;
+    AddressV = Clamp;
+};
+
+struct VertData {
+    float4 pos : POSITION;
+    float2 uv  : TEXCOORD0;
+};
+
+// --- Vertex Shader ---
+VertData VSDefault(VertData v_in)
+{
+    VertData v_out;
+    v_out.pos = mul(v_in.pos, ViewProj);
+    v_out.uv = v_in.uv;
+    return v_out;
+}
+
+// --- Helpers ---
+float luma(float3 rgb)
+{
+    return dot(rgb, float3(0.299, 0.587, 0.114));
+}
+
+// Centre of the first texel of the 4x4 block under `uv`
+float2 block_origin(float2 uv)
+{
+    return uv - texel * 1.5;
+}
+
+// --- Pixel Shaders ---
+float4 PSReduceLuma(VertData v_in) : TARGET
+{
+    float2 origin = block_origin(v_in.uv);
+    float sum = 0.0;
+    float peak = 0.0;
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            float l = luma(image.Sample(pointSampler, origin + float2(x, y) * texel).rgb);
+            sum += l;
+            peak = max(peak, l);
+        }
+    }
+    return float4(sum / 16.0, peak, 0.0, 1.0);
+}
+
+float4 PSReduce(VertData v_in) : TARGET
+{
+    float2 origin = block_origin(v_in.uv);
+    float sum = 0.0;
+    float peak = 0.0;
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            float2 s = image.Sample(pointSampler, origin + float2(x, y) * texel).rg;
+            sum += s.r;
+            peak = max(peak, s.g);
+        }
+    }
+    return float4(sum / 16.0, peak, 0.0, 1.0);
+}
+
+// --- Techniques ---
+technique ReduceLuma
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSReduceLuma(v_in);
+    }
+}
+
+technique Reduce
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSReduce(v_in);
+    }
+}
@@ -0,0 +1,144 @@
+// --- Multi-pass Star Burst ---
+// Fast mode for star-burst.shader. Instead of marching every ray from every
+// pixel, the renderer runs:
+//   1. BrightPass - half resolution mask of pixels that can cast rays
+//   2. Streak     - per ray direction, 4 taps whose spacing grows 4x per pass
+//                   (cost ~ log4 of the ray length in pixels)
+//   3. Composite  - core glow plus the accumulated streaks over the source
+// Uniform names match star-burst.shader so both share the same settings.
+
+// --- User-defined parameters (uniforms) ---
+uniform float Threshold = 0.7;
+uniform float Intensity = 3.0;
+uniform bool ColorizeRays = false;
+uniform float4 RayColor = { 1.0, 0.8, 0.4, 1.0 };
+uniform float CoreGlowIntensity = 0.3;
+uniform bool CoreGlowUsesRayColor = false;
+
+// --- Pass uniforms (set by starburst.c) ---
+uniform texture2d streak_image;
+uniform float2 streak_step;   // UV offset between taps of the current pass
+uniform float streak_decay;   // Falloff applied per tap of the current pass
+uniform float streak_gain;    // Normalisation per pass (1 / tap count)
+uniform float ray_gain;       // Ray thickness compensation / StarPoints normalisation
+
+// --- Standard Uniforms & Structs ---
+uniform float4x4 ViewProj;
+uniform texture2d image;
+
+sampler_state textureSampler {
+    Filter   = Linear;
+    AddressU = Clamp;
+    AddressV = Clamp;
+};
+
+// Rays starting outside the frame contribute nothing, like the bounds
+// checks in the single-pass shader.
+sampler_state streakSampler {
+    Filter      = Linear;
+    AddressU    = Border;
+    AddressV    = Border;
+    BorderColor = 00000000;
+};
+
+struct VertData {
+    float4 pos : POSITION;
+    float2 uv  : TEXCOORD0;
+};
+
+#define STREAK_TAPS 4
+
+// --- Vertex Shader ---
+VertData VSDefault(VertData v_in)
+{
+    VertData v_out;
+    v_out.pos = mul(v_in.pos, ViewProj);
+    v_out.uv = v_in.uv;
+    return v_out;
+}
+
+// --- Pixel Shaders ---
+float4 PSBrightPass(VertData v_in) : TARGET
+{
+    // Rendered at half size, so one bilinear fetch averages a 2x2 block
+    float3 rgb = image.Sample(textureSampler, v_in.uv).rgb;
+    float brightness = dot(rgb, float3(0.299, 0.587, 0.114));
+
+    // The single-pass shader accepts samples above 0.8*Threshold next to the
+    // source, relaxing to 0.4*Threshold at the ray tip; ramp across that band.
+    float mask = smoothstep(Threshold * 0.4, Threshold * 0.8, brightness);
+    return float4(mask, mask, mask, 1.0);
+}
+
+float4 PSStreak(VertData v_in) : TARGET
+{
+    float sum = 0.0;
+    float weight = 1.0;
+
+    // Sample *towards* the potential ray sources, as the single-pass shader does
+    for (int i = 0; i < STREAK_TAPS; i++) {
+        sum += image.Sample(streakSampler, v_in.uv - streak_step * float(i)).r * weight;
+        weight *= streak_decay;
+    }
+
+    sum *= streak_gain;
+    return float4(sum, sum, sum, 1.0);
+}
+
+float4 PSComposite(VertData v_in) : TARGET
+{
+    float4 color = image.Sample(textureSampler, v_in.uv);
+    float brightness = dot(color.rgb, float3(0.299, 0.587, 0.114));
+
+    // --- Apply Core Glow (identical to star-burst.shader) ---
+    if (CoreGlowIntensity > 0.0 && brightness > Threshold) {
+        float glowAmountNormalized = pow(saturate((brightness - Threshold) / (1.0 - Threshold + 0.001)), 1.5);
+        float actualGlow = glowAmountNormalized * CoreGlowIntensity;
+
+        float3 glowTint;
+        if (CoreGlowUsesRayColor) {
+            glowTint = RayColor.rgb;
+        } else {
+            glowTint = lerp(float3(1.0, 1.0, 1.0), color.rgb, 0.5);
+        }
+        color.rgb = saturate(color.rgb + glowTint * actualGlow);
+    }
+
+    // --- Add accumulated rays ---
+    float totalRayStrength = saturate(streak_image.Sample(textureSampler, v_in.uv).r * ray_gain);
+    float finalRayMixFactor = totalRayStrength * Intensity * 0.5;
+
+    if (finalRayMixFactor > 0.001) {
+        float3 appliedRayColor = ColorizeRays ? RayColor.rgb : float3(1.0, 1.0, 1.0);
+        color.rgb = saturate(color.rgb + appliedRayColor * finalRayMixFactor);
+    }
+
+    return color;
+}
+
+technique BrightPass
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSBrightPass(v_in);
+    }
+}
+
+technique Streak
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSStreak(v_in);
+    }
+}
+
+technique Composite
+{
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSComposite(v_in);
+    }
+}
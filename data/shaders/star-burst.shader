@@ -98,6 +98,17 @@ uniform bool AnamorphicRays<
     string group = "Advanced";
 > = false;
 
+// --- Specialisation ---
+// For a shader variant (PARAM_FLAG_SPECIALIZE) the loader defines SPEC_<name>
+// to a literal so the compiler drops the unused branch; otherwise these
+// read the uniforms.
+#ifndef SPEC_ExtendRays
+#define SPEC_ExtendRays ExtendRays
+#endif
+#ifndef SPEC_ColorizeRays
+#define SPEC_ColorizeRays ColorizeRays
+#endif
+
 #define MAX_RAY_SAMPLES 12
 #define DEFAULT_RAY_SAMPLES 8
 #define MIN_RAY_SAMPLES 4
@@ -134,6 +145,12 @@ uniform float RayEdgeSoftness <
     float minimum = 0.5; float maximum = 5.0; float step = 0.1;
 > = 1.5;
 
+// --- Per-frame values (set by starburst.c) ---
+// Rotation, rotation speed and AnamorphicRays only reach the shader through
+// this table: xy is the direction of ray i, zw one thickness step across it.
+#define MAX_STAR_POINTS 16
+uniform float4 ray_dirs[MAX_STAR_POINTS];
+
 // --- Standard Uniforms & Structs ---
 uniform float4x4 ViewProj;
 uniform texture2d image;
@@ -183,12 +200,6 @@ float4 mainImage(VertData v_in) : TARGET {
     
     float4 baseOutputColor = currentPixelColor; // This color now includes the core glow
 
-    // Handle rotation
-    float finalRotation = Rotation;
-    if (EnableRotation) {
-        finalRotation += elapsed_time * RotationSpeed;
-    }
-    
     float totalRayStrength = 0.0; // Accumulator for all rays' strength affecting this pixel
 
     // The main logic for ray generation starts here
@@ -205,13 +216,8 @@ float4 mainImage(VertData v_in) : TARGET {
     // totalRayStrength will be the sum of light gathered along each ray direction *for the current pixel v_in.uv*.
 
     for (int i = 0; i < StarPoints; i++) { // Loop only up to StarPoints
-        float angle = (6.2831853 / float(StarPoints)) * float(i) + finalRotation;
-        
-        float2 dir = float2(cos(angle), sin(angle));
-        if (AnamorphicRays) {
-            dir.y *= 0.5; // Compress vertical for horizontal streaks
-            dir = normalize(dir);
-        }
+        float2 dir = ray_dirs[i].xy;
+        float2 perpStep = ray_dirs[i].zw;
         
         float raySamplesAccumulator = 0.0;
         int sampleCount = ray_sample_count;
@@ -225,7 +231,7 @@ float4 mainImage(VertData v_in) : TARGET {
 
             // Check bounds for this primary sample
             if (samplePos.x < 0.0 || samplePos.x > 1.0 || samplePos.y < 0.0 || samplePos.y > 1.0) {
-                if (!ExtendRays) continue; // If not extending, stop if primary sample is out of bounds
+                if (!SPEC_ExtendRays) continue; // If not extending, stop if primary sample is out of bounds
                 // If extending, we might still count thickness samples that are in bounds.
             }
 
@@ -244,9 +250,7 @@ float4 mainImage(VertData v_in) : TARGET {
 
             // --- Ray Thickness with new RayEdgeSoftness ---
             if (currentRayContribution > 0.0 && RayThickness > 0.01) {
-                float perpDistanceBase = RayThickness * 0.005 * uv_pixel_interval.y / RayLength; // Smaller base for thickness
-                float2 perpDir = float2(-dir.y, dir.x);
-                
+
                 // Check 2 perpendicular samples on each side (4 total extra points for thickness)
                 for (int p_side = -1; p_side <= 1; p_side +=2) { // -1 and 1 (sides)
                     for (int p_step = 1; p_step <= 2; p_step++) { // Two steps outwards for thickness
@@ -255,7 +259,7 @@ float4 mainImage(VertData v_in) : TARGET {
                         float actual_thickness_falloff = pow(thickness_falloff_normalized, RayEdgeSoftness);
 
                         float2 perpSamplePos = v_in.uv - dir * RayLength * scale + // Point on central ray
-                                               (perpDir * float(p_side) * perpDistanceBase * float(p_step)); // Offset perpendicularly
+                                               (perpStep * float(p_side) * float(p_step)); // Offset perpendicularly
 
                         if (perpSamplePos.x >= 0.0 && perpSamplePos.x <= 1.0 && perpSamplePos.y >= 0.0 && perpSamplePos.y <= 1.0) {
                             float perpBright = dot(image.Sample(textureSampler, perpSamplePos).rgb, float3(0.299, 0.587, 0.114));
@@ -280,7 +284,7 @@ float4 mainImage(VertData v_in) : TARGET {
                                                                   // The 0.5 is an adjustment factor, tune as needed
 
     if (finalRayMixFactor > 0.001) {
-        float3 appliedRayColor = ColorizeRays ? RayColor.rgb : float3(1.0, 1.0, 1.0); // White if not colorized
+        float3 appliedRayColor = SPEC_ColorizeRays ? RayColor.rgb : float3(1.0, 1.0, 1.0); // White if not colorized
         // Additive blending for rays
         baseOutputColor.rgb += appliedRayColor * finalRayMixFactor;
         baseOutputColor.rgb = saturate(baseOutputColor.rgb);
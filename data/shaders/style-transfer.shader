@@ -1,37 +1,61 @@
+// --- Style Transfer ---
+// Blends the network output (styled_image, computed on the CPU by
+// style_transfer.c one or two frames behind) over the source. Along edges
+// from the shared Canny map (condition_image) the source's own detail can
+// be kept.
+
+// --- User-defined parameters (uniforms) ---
+uniform float style_strength = 1.0;
+uniform float edge_preserve = 0.0;
+
+// --- Per-frame values (set by style_transfer.c) ---
+uniform texture2d styled_image;    // Network output at network resolution
+uniform texture2d condition_image; // The canny-edge output (edge_preserve > 0 only)
+
+// --- Standard Uniforms & Structs ---
 uniform float4x4 ViewProj;
-uniform texture2D image;
-uniform texture2D condition_image; // The canny-edge output
+uniform texture2d image;
 
-struct VertData {
-	float4 pos : POSITION;
-	float2 uv  : TEXCOORD0;
+sampler_state textureSampler {
+    Filter   = Linear;
+    AddressU = Clamp;
+    AddressV = Clamp;
 };
 
-struct VertToFrag {
-	float4 pos : POSITION;
-	float2 uv  : TEXCOORD0;
+struct VertData {
+    float4 pos : POSITION;
+    float2 uv  : TEXCOORD0;
 };
 
-VertToFrag main_vertex(VertData v_in)
+// --- Vertex Shader ---
+VertData VSDefault(VertData v_in)
 {
-	VertToFrag v_out;
-	v_out.pos = mul(v_in.pos, ViewProj);
-	v_out.uv = v_in.uv;
-	return v_out;
+    VertData v_out;
+    v_out.pos = mul(v_in.pos, ViewProj);
+    v_out.uv = v_in.uv;
+    return v_out;
 }
 
-// Pass-through fragment shader
-float4 main_fragment(VertToFrag v_in) : TARGET
+// --- Pixel Shader ---
+float4 PSStyle(VertData v_in) : TARGET
 {
-	// For now, just pass through the original image
-	return tex2D(image, v_in.uv);
+    float4 color = image.Sample(textureSampler, v_in.uv);
+    float3 styled = styled_image.Sample(textureSampler, v_in.uv).rgb;
+
+    float amount = style_strength;
+    if (edge_preserve > 0.0) {
+        amount *= 1.0 - condition_image.Sample(textureSampler, v_in.uv).r * edge_preserve;
+    }
+
+    color.rgb = lerp(color.rgb, styled, amount);
+    return color;
 }
 
 technique Draw
 {
-	pass
-	{
-		vertex_shader = main_vertex;
-		pixel_shader  = main_fragment;
-	}
+    pass
+    {
+        vertex_shader = VSDefault(v_in);
+        pixel_shader  = PSStyle(v_in);
+    }
 }
@@ -0,0 +1,415 @@
+/*
+ * src/core/cpu-filter.c
+ * CPU path for async sources: filter_video converts the frame to RGBA8, runs
+ * the effect's filter_frame and writes the result back in the frame's own
+ * format, before OBS uploads it
+ */
+
+#include "cpu-image.h"
+#include "../utils/logging.h"
+#include "../utils/task-pool.h"
+
+struct cpu_filter {
+    cpu_image_t images[2];        // The frame as RGBA8, and filter_frame's output
+    enum video_format unsupported; // Last format reported as unsupported
+};
+
+// --- Frame formats ---
+
+typedef enum {
+    LAYOUT_RGBA,
+    LAYOUT_BGRA,
+    LAYOUT_BGRX,
+    LAYOUT_PLANAR,      // Y, U and V planes
+    LAYOUT_NV12,        // Y plane, interleaved UV plane
+    LAYOUT_PACKED_422   // Y0 U Y1 V in some order
+} frame_layout_t;
+
+typedef struct {
+    frame_layout_t layout;
+    uint32_t shift_x;           // Chroma subsampling, log2
+    uint32_t shift_y;
+    uint32_t y_offset;          // LAYOUT_PACKED_422: bytes of Y0, U and V in each group of 4
+    uint32_t u_offset;
+    uint32_t v_offset;
+} frame_desc_t;
+
+static bool frame_describe(enum video_format format, frame_desc_t *desc) {
+    frame_desc_t d = {LAYOUT_PLANAR, 0, 0, 0, 0, 0};
+
+    switch (format) {
+        case VIDEO_FORMAT_RGBA: d.layout = LAYOUT_RGBA; break;
+        case VIDEO_FORMAT_BGRA: d.layout = LAYOUT_BGRA; break;
+        case VIDEO_FORMAT_BGRX: d.layout = LAYOUT_BGRX; break;
+        case VIDEO_FORMAT_I420: d.shift_x = 1; d.shift_y = 1; break;
+        case VIDEO_FORMAT_I422: d.shift_x = 1; break;
+        case VIDEO_FORMAT_I444: break;
+        case VIDEO_FORMAT_NV12: d.layout = LAYOUT_NV12; d.shift_x = 1; d.shift_y = 1; break;
+        case VIDEO_FORMAT_YUY2: d = (frame_desc_t){LAYOUT_PACKED_422, 1, 0, 0, 1, 3}; break;
+        case VIDEO_FORMAT_YVYU: d = (frame_desc_t){LAYOUT_PACKED_422, 1, 0, 0, 3, 1}; break;
+        case VIDEO_FORMAT_UYVY: d = (frame_desc_t){LAYOUT_PACKED_422, 1, 0, 1, 0, 2}; break;
+        default: return false; // High bit depth, alpha planes, packed RGB
+    }
+
+    *desc = d;
+    return true;
+}
+
+// --- Conversion ---
+
+typedef struct {
+    struct obs_source_frame *frame;
+    frame_desc_t desc;
+    cpu_image_t *image;
+    float to_rgb[3][4];         // rgb = M * yuv + t, rows of the frame's color_matrix
+    float to_yuv[3][4];         // Its inverse
+    float range_min[3];         // Valid YUV range, limited or full
+    float range_max[3];
+} frame_job_t;
+
+// Inverts the affine YUV->RGB transform. Returns false if it is singular.
+static bool invert_color_matrix(float m[3][4], float out[3][4]) {
+    float det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    if (fabsf(det) < 1e-8f) return false;
+
+    float inv = 1.0f / det;
+    out[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv;
+    out[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv;
+    out[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv;
+    out[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv;
+    out[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv;
+    out[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv;
+    out[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv;
+    out[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv;
+    out[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv;
+
+    for (int r = 0; r < 3; r++) {
+        out[r][3] = -(out[r][0] * m[0][3] + out[r][1] * m[1][3] + out[r][2] * m[2][3]);
+    }
+    return true;
+}
+
+// Image row shown at frame row `y`
+static inline uint32_t image_row_index(const frame_job_t *job, uint32_t y) {
+    return job->frame->flip ? job->frame->height - 1 - y : y;
+}
+
+// One frame row as Y, U and V bytes per pixel (chroma repeated), padded to
+// whole lanes so the conversion never reads past the frame's planes
+static void read_yuv_row(const frame_job_t *job, uint32_t y, uint8_t *ys, uint8_t *us, uint8_t *vs) {
+    const struct obs_source_frame *frame = job->frame;
+    const frame_desc_t *d = &job->desc;
+    uint32_t width = frame->width;
+    uint32_t cy = y >> d->shift_y;
+
+    if (d->layout == LAYOUT_PACKED_422) {
+        const uint8_t *src = frame->data[0] + (size_t)y * frame->linesize[0];
+        for (uint32_t x = 0; x < width; x++) {
+            const uint8_t *group = src + (x >> 1) * 4;
+            ys[x] = group[d->y_offset + (x & 1) * 2];
+            us[x] = group[d->u_offset];
+            vs[x] = group[d->v_offset];
+        }
+        return;
+    }
+
+    memcpy(ys, frame->data[0] + (size_t)y * frame->linesize[0], width);
+    if (d->layout == LAYOUT_NV12) {
+        const uint8_t *uv = frame->data[1] + (size_t)cy * frame->linesize[1];
+        for (uint32_t x = 0; x < width; x++) {
+            us[x] = uv[(x >> 1) * 2];
+            vs[x] = uv[(x >> 1) * 2 + 1];
+        }
+        return;
+    }
+
+    const uint8_t *u = frame->data[1] + (size_t)cy * frame->linesize[1];
+    const uint8_t *v = frame->data[2] + (size_t)cy * frame->linesize[2];
+    for (uint32_t x = 0; x < width; x++) {
+        us[x] = u[x >> d->shift_x];
+        vs[x] = v[x >> d->shift_x];
+    }
+}
+
+static void unpack_yuv_rows(void *ctx, size_t begin, size_t end) {
+    const frame_job_t *job = ctx;
+    const struct obs_source_frame *frame = job->frame;
+    uint32_t padded = job->image->stride;
+
+    uint8_t *scratch = bmalloc((size_t)padded * 3 + SIMD_LANES);
+    uint8_t *ys = scratch;
+    uint8_t *us = ys + padded;
+    uint8_t *vs = us + padded;
+
+    const simd_f unit = simd_set1(1.0f / 255.0f);
+    const simd_f lo[3] = {simd_set1(job->range_min[0]), simd_set1(job->range_min[1]), simd_set1(job->range_min[2])};
+    const simd_f hi[3] = {simd_set1(job->range_max[0]), simd_set1(job->range_max[1]), simd_set1(job->range_max[2])};
+    const simd_f one = simd_set1(1.0f);
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        read_yuv_row(job, y, ys, us, vs);
+        uint32_t *row = cpu_image_row(job->image, image_row_index(job, y));
+
+        for (uint32_t x = 0; x < frame->width; x += SIMD_LANES) {
+            simd_f c[3] = {simd_mul(simd_load_u8(ys + x), unit), simd_mul(simd_load_u8(us + x), unit),
+                           simd_mul(simd_load_u8(vs + x), unit)};
+            for (int k = 0; k < 3; k++) c[k] = simd_min(simd_max(c[k], lo[k]), hi[k]);
+
+            simd_f rgb[3];
+            for (int k = 0; k < 3; k++) {
+                const float *m = job->to_rgb[k];
+                simd_f sum = simd_madd(c[0], simd_set1(m[0]), simd_set1(m[3]));
+                sum = simd_madd(c[1], simd_set1(m[1]), sum);
+                rgb[k] = simd_madd(c[2], simd_set1(m[2]), sum);
+            }
+
+            simd_rgba_t px = {rgb[0], rgb[1], rgb[2], one};
+            cpu_store_rgba(row, x, px);
+        }
+    }
+
+    bfree(scratch);
+}
+
+// Writes image rows [begin, end) back. With vertical subsampling each chroma
+// row averages the two image rows it covers; begin is always even then.
+static void pack_yuv_rows(void *ctx, size_t begin, size_t end) {
+    const frame_job_t *job = ctx;
+    struct obs_source_frame *frame = job->frame;
+    const frame_desc_t *d = &job->desc;
+    uint32_t width = frame->width;
+    uint32_t padded = job->image->stride;
+    uint32_t rows_per_chroma = 1u << d->shift_y;
+
+    uint8_t *ys = bmalloc((size_t)padded * 2 + SIMD_LANES);
+    float *chroma = bmalloc(sizeof(float) * padded * 4); // U and V for up to two rows
+
+    const simd_f lo[3] = {simd_set1(job->range_min[0]), simd_set1(job->range_min[1]), simd_set1(job->range_min[2])};
+    const simd_f hi[3] = {simd_set1(job->range_max[0]), simd_set1(job->range_max[1]), simd_set1(job->range_max[2])};
+    const simd_f scale = simd_set1(255.0f);
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y += rows_per_chroma) {
+        uint32_t rows = (y + 1 < frame->height) ? rows_per_chroma : 1;
+
+        for (uint32_t r = 0; r < rows; r++) {
+            const uint32_t *row = cpu_image_row(job->image, image_row_index(job, y + r));
+            uint8_t *y_out = ys + (size_t)r * padded;
+            float *u_out = chroma + (size_t)r * 2 * padded;
+            float *v_out = u_out + padded;
+
+            for (uint32_t x = 0; x < width; x += SIMD_LANES) {
+                simd_rgba_t px = cpu_load_rgba(row, x);
+                simd_f yuv[3];
+                for (int k = 0; k < 3; k++) {
+                    const float *m = job->to_yuv[k];
+                    simd_f sum = simd_madd(px.r, simd_set1(m[0]), simd_set1(m[3]));
+                    sum = simd_madd(px.g, simd_set1(m[1]), sum);
+                    sum = simd_madd(px.b, simd_set1(m[2]), sum);
+                    yuv[k] = simd_mul(simd_min(simd_max(sum, lo[k]), hi[k]), scale);
+                }
+                simd_store_u8(y_out + x, yuv[0]);
+                simd_store(u_out + x, yuv[1]);
+                simd_store(v_out + x, yuv[2]);
+            }
+        }
+
+        // Chroma samples average the pixels they cover
+        uint32_t cx_count = (width + (1u << d->shift_x) - 1) >> d->shift_x;
+        float inv_count = 1.0f / (float)(rows << d->shift_x);
+        uint8_t *y_plane0 = frame->data[0] + (size_t)y * frame->linesize[0];
+        uint32_t cy = y >> d->shift_y;
+
+        for (uint32_t cx = 0; cx < cx_count; cx++) {
+            float u = 0.0f, v = 0.0f;
+            for (uint32_t r = 0; r < rows; r++) {
+                const float *u_row = chroma + (size_t)r * 2 * padded;
+                const float *v_row = u_row + padded;
+                for (uint32_t s = 0; s < (1u << d->shift_x); s++) {
+                    uint32_t x = (cx << d->shift_x) + s;
+                    if (x >= width) x = width - 1; // Odd width: repeat the last pixel
+                    u += u_row[x];
+                    v += v_row[x];
+                }
+            }
+            uint8_t u8 = (uint8_t)(u * inv_count + 0.5f);
+            uint8_t v8 = (uint8_t)(v * inv_count + 0.5f);
+
+            if (d->layout == LAYOUT_PACKED_422) {
+                uint8_t *group = y_plane0 + (size_t)cx * 4;
+                group[d->u_offset] = u8;
+                group[d->v_offset] = v8;
+            } else if (d->layout == LAYOUT_NV12) {
+                uint8_t *uv = frame->data[1] + (size_t)cy * frame->linesize[1];
+                uv[cx * 2] = u8;
+                uv[cx * 2 + 1] = v8;
+            } else {
+                frame->data[1][(size_t)cy * frame->linesize[1] + cx] = u8;
+                frame->data[2][(size_t)cy * frame->linesize[2] + cx] = v8;
+            }
+        }
+
+        for (uint32_t r = 0; r < rows; r++) {
+            const uint8_t *y_in = ys + (size_t)r * padded;
+            uint8_t *dst = frame->data[0] + (size_t)(y + r) * frame->linesize[0];
+
+            if (d->layout == LAYOUT_PACKED_422) {
+                for (uint32_t x = 0; x < width; x++) dst[(x >> 1) * 4 + d->y_offset + (x & 1) * 2] = y_in[x];
+            } else {
+                memcpy(dst, y_in, width);
+            }
+        }
+    }
+
+    bfree(chroma);
+    bfree(ys);
+}
+
+static void unpack_rgb_rows(void *ctx, size_t begin, size_t end) {
+    const frame_job_t *job = ctx;
+    const struct obs_source_frame *frame = job->frame;
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        const uint8_t *src = frame->data[0] + (size_t)y * frame->linesize[0];
+        uint32_t *row = cpu_image_row(job->image, image_row_index(job, y));
+
+        if (job->desc.layout == LAYOUT_RGBA) {
+            memcpy(row, src, (size_t)frame->width * 4);
+            continue;
+        }
+
+        uint32_t alpha_mask = job->desc.layout == LAYOUT_BGRX ? 0xFF000000u : 0;
+        for (uint32_t x = 0; x < frame->width; x++) {
+            const uint8_t *px = src + (size_t)x * 4;
+            row[x] = ((uint32_t)px[2] | (uint32_t)px[1] << 8 | (uint32_t)px[0] << 16 | (uint32_t)px[3] << 24) |
+                     alpha_mask;
+        }
+    }
+}
+
+static void pack_rgb_rows(void *ctx, size_t begin, size_t end) {
+    const frame_job_t *job = ctx;
+    struct obs_source_frame *frame = job->frame;
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        uint8_t *dst = frame->data[0] + (size_t)y * frame->linesize[0];
+        const uint32_t *row = cpu_image_row(job->image, image_row_index(job, y));
+
+        if (job->desc.layout == LAYOUT_RGBA) {
+            memcpy(dst, row, (size_t)frame->width * 4);
+            continue;
+        }
+
+        for (uint32_t x = 0; x < frame->width; x++) {
+            uint8_t *px = dst + (size_t)x * 4;
+            px[0] = (uint8_t)(row[x] >> 16);
+            px[1] = (uint8_t)(row[x] >> 8);
+            px[2] = (uint8_t)row[x];
+            px[3] = (uint8_t)(row[x] >> 24);
+        }
+    }
+}
+
+// --- Filter ---
+
+static bool cpu_image_reserve(cpu_image_t *image, uint32_t width, uint32_t height) {
+    if (image->pixels && image->width == width && image->height == height) return true;
+
+    bfree(image->pixels);
+    image->width = width;
+    image->height = height;
+    image->stride = (width + 7) & ~7u;
+    image->pixels = bmalloc(sizeof(uint32_t) * image->stride * height);
+    return image->pixels != NULL;
+}
+
+static bool frame_job_init(frame_job_t *job, struct obs_source_frame *frame, const frame_desc_t *desc,
+                           cpu_image_t *image) {
+    job->frame = frame;
+    job->desc = *desc;
+    job->image = image;
+
+    if (desc->layout == LAYOUT_RGBA || desc->layout == LAYOUT_BGRA || desc->layout == LAYOUT_BGRX) return true;
+
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) job->to_rgb[r][c] = frame->color_matrix[r * 4 + c];
+    }
+
+    // Sources that leave the range unset get full range
+    for (int k = 0; k < 3; k++) {
+        bool valid = frame->color_range_max[k] > frame->color_range_min[k];
+        job->range_min[k] = valid ? frame->color_range_min[k] : 0.0f;
+        job->range_max[k] = valid ? frame->color_range_max[k] : 1.0f;
+    }
+    return invert_color_matrix(job->to_rgb, job->to_yuv);
+}
+
+// filter_video for effects with a filter_frame callback. Runs on the
+// graphics thread as OBS picks the next async frame, so the effect's render
+// in the same frame knows whether the frame was filtered already. OBS calls
+// it before any filter renders, so only the first filter on the source may
+// change the frame. Further up the chain that would apply the effect before
+// the filters below it, so there it renders on the GPU instead.
+struct obs_source_frame *cpu_filter_video(void *data, struct obs_source_frame *frame) {
+    effect_data_t *ed = data;
+    if (!ed || !frame) return frame;
+
+    ed->cpu_active = false;
+    if (!ed->info->filter_frame || !param_get_bool(ed, CPU_PATH_SETTING)) return frame;
+    if (frame->width == 0 || frame->height == 0) return frame;
+    if (obs_filter_get_target(ed->context) != obs_filter_get_parent(ed->context)) return frame;
+
+    if (!ed->cpu) ed->cpu = bzalloc(sizeof(struct cpu_filter));
+    struct cpu_filter *cpu = ed->cpu;
+
+    frame_desc_t desc;
+    frame_job_t job;
+    if (!frame_describe(frame->format, &desc) || !frame_job_init(&job, frame, &desc, &cpu->images[0])) {
+        if (cpu->unsupported != frame->format) {
+            cpu->unsupported = frame->format;
+            EFFECT_LOG_WARNING(ed, "CPU path doesn't handle %s frames, rendering on the GPU",
+                               get_video_format_name(frame->format));
+        }
+        return frame;
+    }
+    cpu->unsupported = VIDEO_FORMAT_NONE;
+
+    if (!cpu_image_reserve(&cpu->images[0], frame->width, frame->height) ||
+        !cpu_image_reserve(&cpu->images[1], frame->width, frame->height)) {
+        return frame;
+    }
+
+    bool rgb = desc.layout == LAYOUT_RGBA || desc.layout == LAYOUT_BGRA || desc.layout == LAYOUT_BGRX;
+    task_pool_t *pool = task_pool_shared();
+
+    task_pool_parallel_for(pool, frame->height, CPU_ROWS_PER_TASK, rgb ? unpack_rgb_rows : unpack_yuv_rows, &job);
+
+    // The skipped render would have measured the input for the auto modes
+    if (ed->luma_wanted) luma_stats_measure_frame(ed, &cpu->images[0]);
+    ed->info->filter_frame(ed, &cpu->images[0], &cpu->images[1]);
+
+    job.image = &cpu->images[1];
+    task_pool_parallel_for(pool, frame->height, CPU_ROWS_PER_TASK, rgb ? pack_rgb_rows : pack_yuv_rows, &job);
+
+    ed->cpu_active = true;
+    return frame;
+}
+
+// For video_render: true (and the input passed through) when the frame
+// being drawn was filtered on the CPU already
+bool cpu_filter_skip_render(effect_data_t *ed) {
+    if (!ed || !ed->cpu_active) return false;
+
+    obs_source_skip_video_filter(ed->context);
+    return true;
+}
+
+void cpu_filter_free(effect_data_t *ed) {
+    if (!ed || !ed->cpu) return;
+
+    bfree(ed->cpu->images[0].pixels);
+    bfree(ed->cpu->images[1].pixels);
+    bfree(ed->cpu);
+    ed->cpu = NULL;
+}
@@ -0,0 +1,165 @@
+/*
+ * src/core/cpu-image.h
+ * SIMD_LANES-wide helpers for filter_frame kernels: texel loads and stores,
+ * and bilinear sampling that matches the shaders' Linear samplers
+ */
+
+#pragma once
+
+#include "effect-core.h"
+#include "../utils/simd.h"
+
+#define CPU_ROWS_PER_TASK 16  // Even, so 4:2:0 row pairs stay in one task
+
+// SIMD_LANES pixels, channels in 0..1
+typedef struct {
+    simd_f r, g, b, a;
+} simd_rgba_t;
+
+// Single-channel float image for intermediate passes
+typedef struct {
+    float *data;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;            // Floats per row, multiple of 8
+} cpu_plane_t;
+
+static inline uint32_t *cpu_image_row(const cpu_image_t *image, uint32_t y) {
+    return image->pixels + (size_t)y * image->stride;
+}
+
+static inline float *cpu_plane_row(const cpu_plane_t *plane, uint32_t y) {
+    return plane->data + (size_t)y * plane->stride;
+}
+
+// Keeps `plane` at width x height; contents are undefined after a resize
+static inline bool cpu_plane_reserve(cpu_plane_t *plane, uint32_t width, uint32_t height) {
+    if (plane->data && plane->width == width && plane->height == height) return true;
+
+    bfree(plane->data);
+    plane->width = width;
+    plane->height = height;
+    plane->stride = (width + 7) & ~7u;
+    plane->data = bmalloc(sizeof(float) * plane->stride * height);
+    return plane->data != NULL;
+}
+
+static inline void cpu_plane_free(cpu_plane_t *plane) {
+    bfree(plane->data);
+    plane->data = NULL;
+}
+
+static inline simd_rgba_t cpu_unpack_rgba(simd_i texels) {
+    simd_rgba_t c;
+    simd_unpack_rgba8(texels, &c.r, &c.g, &c.b, &c.a);
+    const simd_f scale = simd_set1(1.0f / 255.0f);
+    c.r = simd_mul(c.r, scale);
+    c.g = simd_mul(c.g, scale);
+    c.b = simd_mul(c.b, scale);
+    c.a = simd_mul(c.a, scale);
+    return c;
+}
+
+static inline simd_rgba_t cpu_load_rgba(const uint32_t *row, uint32_t x) {
+    return cpu_unpack_rgba(simd_load_u32(row + x));
+}
+
+// Saturates and rounds to RGBA8
+static inline void cpu_store_rgba(uint32_t *row, uint32_t x, simd_rgba_t c) {
+    const simd_f scale = simd_set1(255.0f);
+    simd_store_u32(row + x, simd_pack_rgba8(simd_mul(simd_saturate(c.r), scale), simd_mul(simd_saturate(c.g), scale),
+                                            simd_mul(simd_saturate(c.b), scale), simd_mul(simd_saturate(c.a), scale)));
+}
+
+// Texel centres of the pixels at x..x + SIMD_LANES - 1 in UV
+static inline simd_f cpu_pixel_u(uint32_t x, float inv_width) {
+    return simd_mul(simd_iota((float)x + 0.5f), simd_set1(inv_width));
+}
+
+// --- Bilinear sampling ---
+
+typedef struct {
+    simd_i x0, x1, y0, y1;     // Texel indices, clamped to the image
+    simd_f fx, fy;             // Weights of x1 and y1
+    simd_m valid_x0, valid_x1, valid_y0, valid_y1; // Unclamped index inside the image
+} cpu_bilinear_t;
+
+static inline cpu_bilinear_t cpu_bilinear_setup(simd_f u, simd_f v, uint32_t width, uint32_t height) {
+    cpu_bilinear_t t;
+    simd_f px = simd_sub(simd_mul(u, simd_set1((float)width)), simd_set1(0.5f));
+    simd_f py = simd_sub(simd_mul(v, simd_set1((float)height)), simd_set1(0.5f));
+
+    // Far outside the image the float->int conversion would overflow
+    px = simd_min(simd_max(px, simd_set1(-2.0f)), simd_set1((float)width + 1.0f));
+    py = simd_min(simd_max(py, simd_set1(-2.0f)), simd_set1((float)height + 1.0f));
+
+    simd_f fx0 = simd_floor(px);
+    simd_f fy0 = simd_floor(py);
+    t.fx = simd_sub(px, fx0);
+    t.fy = simd_sub(py, fy0);
+
+    t.valid_x0 = simd_gt(fx0, simd_set1(-0.5f));
+    t.valid_x1 = simd_lt(fx0, simd_set1((float)width - 1.5f));
+    t.valid_y0 = simd_gt(fy0, simd_set1(-0.5f));
+    t.valid_y1 = simd_lt(fy0, simd_set1((float)height - 1.5f));
+
+    const simd_i zero = simd_i_set1(0);
+    const simd_i max_x = simd_i_set1((int)width - 1);
+    const simd_i max_y = simd_i_set1((int)height - 1);
+    simd_i ix = simd_i_from_f(fx0);
+    simd_i iy = simd_i_from_f(fy0);
+    t.x0 = simd_i_min(simd_i_max(ix, zero), max_x);
+    t.x1 = simd_i_min(simd_i_max(simd_i_add(ix, simd_i_set1(1)), zero), max_x);
+    t.y0 = simd_i_min(simd_i_max(iy, zero), max_y);
+    t.y1 = simd_i_min(simd_i_max(simd_i_add(iy, simd_i_set1(1)), zero), max_y);
+    return t;
+}
+
+static inline simd_rgba_t cpu_rgba_lerp(simd_rgba_t a, simd_rgba_t b, simd_f t) {
+    simd_rgba_t c = {simd_lerp(a.r, b.r, t), simd_lerp(a.g, b.g, t), simd_lerp(a.b, b.b, t), simd_lerp(a.a, b.a, t)};
+    return c;
+}
+
+// Linear filter, Clamp addressing
+static inline simd_rgba_t cpu_sample_rgba(const cpu_image_t *image, simd_f u, simd_f v) {
+    cpu_bilinear_t t = cpu_bilinear_setup(u, v, image->width, image->height);
+    const simd_i stride = simd_i_set1((int)image->stride);
+    simd_i row0 = simd_i_mul(t.y0, stride);
+    simd_i row1 = simd_i_mul(t.y1, stride);
+
+    simd_rgba_t c00 = cpu_unpack_rgba(simd_gather_u32(image->pixels, simd_i_add(row0, t.x0)));
+    simd_rgba_t c10 = cpu_unpack_rgba(simd_gather_u32(image->pixels, simd_i_add(row0, t.x1)));
+    simd_rgba_t c01 = cpu_unpack_rgba(simd_gather_u32(image->pixels, simd_i_add(row1, t.x0)));
+    simd_rgba_t c11 = cpu_unpack_rgba(simd_gather_u32(image->pixels, simd_i_add(row1, t.x1)));
+
+    return cpu_rgba_lerp(cpu_rgba_lerp(c00, c10, t.fx), cpu_rgba_lerp(c01, c11, t.fx), t.fy);
+}
+
+// Linear filter, Clamp addressing
+static inline simd_f cpu_sample_plane(const cpu_plane_t *plane, simd_f u, simd_f v) {
+    cpu_bilinear_t t = cpu_bilinear_setup(u, v, plane->width, plane->height);
+    const simd_i stride = simd_i_set1((int)plane->stride);
+    simd_i row0 = simd_i_mul(t.y0, stride);
+    simd_i row1 = simd_i_mul(t.y1, stride);
+
+    simd_f top = simd_lerp(simd_gather(plane->data, simd_i_add(row0, t.x0)),
+                           simd_gather(plane->data, simd_i_add(row0, t.x1)), t.fx);
+    simd_f bottom = simd_lerp(simd_gather(plane->data, simd_i_add(row1, t.x0)),
+                              simd_gather(plane->data, simd_i_add(row1, t.x1)), t.fx);
+    return simd_lerp(top, bottom, t.fy);
+}
+
+// Linear filter, Border addressing with a zero border colour
+static inline simd_f cpu_sample_plane_border(const cpu_plane_t *plane, simd_f u, simd_f v) {
+    cpu_bilinear_t t = cpu_bilinear_setup(u, v, plane->width, plane->height);
+    const simd_i stride = simd_i_set1((int)plane->stride);
+    const simd_f zero = simd_set1(0.0f);
+    simd_i row0 = simd_i_mul(t.y0, stride);
+    simd_i row1 = simd_i_mul(t.y1, stride);
+
+    simd_f v00 = simd_select(simd_m_and(t.valid_x0, t.valid_y0), simd_gather(plane->data, simd_i_add(row0, t.x0)), zero);
+    simd_f v10 = simd_select(simd_m_and(t.valid_x1, t.valid_y0), simd_gather(plane->data, simd_i_add(row0, t.x1)), zero);
+    simd_f v01 = simd_select(simd_m_and(t.valid_x0, t.valid_y1), simd_gather(plane->data, simd_i_add(row1, t.x0)), zero);
+    simd_f v11 = simd_select(simd_m_and(t.valid_x1, t.valid_y1), simd_gather(plane->data, simd_i_add(row1, t.x1)), zero);
+    return simd_lerp(simd_lerp(v00, v10, t.fx), simd_lerp(v01, v11, t.fx), t.fy);
+}
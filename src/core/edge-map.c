@@ -0,0 +1,222 @@
+/*
+ * src/core/edge-map.c
+ * Canny edge maps (data/shaders/canny-edge.shader), computed at most once
+ * per source, settings and frame, so every effect that wants the edges of
+ * the same image shares one set of passes
+ */
+
+#include "effect-core.h"
+#include "../utils/logging.h"
+#include <math.h>
+
+#define EDGE_MAP_MAX_AGE_NS 1000000000ull // Unused entries are freed after this
+
+typedef struct edge_map_entry {
+    struct edge_map_entry *next;
+    const obs_source_t *source;  // Key only, never dereferenced
+    edge_map_params_t params;
+    uint32_t cx, cy;             // Size of the input it was computed from
+    uint64_t frame_time;         // obs_get_video_frame_time() it was computed on
+    bool valid;
+
+    gs_texrender_t *blur[2];     // R16F: horizontal, vertical
+    gs_texrender_t *gradient;    // RG16F: magnitude, direction sector
+    gs_texrender_t *edges[2];    // R8 ping-pong: suppression, then hysteresis
+    gs_texture_t *result;        // Texture of whichever edges[] was written last
+} edge_map_entry_t;
+
+// Graphics thread only
+static edge_map_entry_t *edge_maps = NULL;
+static gs_effect_t *edge_effect = NULL;
+static bool edge_effect_failed = false;
+
+static gs_eparam_t *param_image;
+static gs_eparam_t *param_texel;
+static gs_eparam_t *param_blur_dir;
+static gs_eparam_t *param_blur_sigma;
+static gs_eparam_t *param_low_threshold;
+static gs_eparam_t *param_high_threshold;
+static gs_eparam_t *param_hysteresis_final;
+
+static void free_entry(edge_map_entry_t *entry) {
+    gs_texrender_destroy(entry->blur[0]);
+    gs_texrender_destroy(entry->blur[1]);
+    gs_texrender_destroy(entry->gradient);
+    gs_texrender_destroy(entry->edges[0]);
+    gs_texrender_destroy(entry->edges[1]);
+    bfree(entry);
+}
+
+static bool edge_map_ensure_effect(void) {
+    if (edge_effect) return true;
+    if (edge_effect_failed) return false;
+
+    bool failed = false;
+    edge_effect = effect_cache_try_acquire(EDGE_MAP_SHADER, &failed);
+
+    // load_shader_effect may hand back the passthrough fallback
+    if (edge_effect && !gs_effect_get_technique(edge_effect, "Hysteresis")) {
+        effect_cache_release(edge_effect);
+        edge_effect = NULL;
+        failed = true;
+    }
+
+    if (failed) {
+        edge_effect_failed = true;
+        PLUGIN_LOG_WARNING("edge-map", "Canny shader unavailable, edge maps disabled");
+    }
+    if (!edge_effect) return false;
+
+    param_image = gs_effect_get_param_by_name(edge_effect, "image");
+    param_texel = gs_effect_get_param_by_name(edge_effect, "texel");
+    param_blur_dir = gs_effect_get_param_by_name(edge_effect, "blur_dir");
+    param_blur_sigma = gs_effect_get_param_by_name(edge_effect, "blur_sigma");
+    param_low_threshold = gs_effect_get_param_by_name(edge_effect, "low_threshold");
+    param_high_threshold = gs_effect_get_param_by_name(edge_effect, "high_threshold");
+    param_hysteresis_final = gs_effect_get_param_by_name(edge_effect, "hysteresis_final");
+    return true;
+}
+
+static bool same_params(const edge_map_params_t *a, const edge_map_params_t *b) {
+    return a->scale_shift == b->scale_shift && a->hysteresis_passes == b->hysteresis_passes &&
+           fabsf(a->blur_sigma - b->blur_sigma) <= 0.0001f &&
+           fabsf(a->low_threshold - b->low_threshold) <= 0.0001f &&
+           fabsf(a->high_threshold - b->high_threshold) <= 0.0001f;
+}
+
+// Finds or creates the entry for `source` + `params`. Frees entries nobody
+// asked for in the last EDGE_MAP_MAX_AGE_NS on the way.
+static edge_map_entry_t *find_entry(const obs_source_t *source, const edge_map_params_t *params,
+                                    uint64_t frame_time) {
+    edge_map_entry_t *found = NULL;
+    edge_map_entry_t **link = &edge_maps;
+
+    while (*link) {
+        edge_map_entry_t *entry = *link;
+        if (!found && entry->source == source && same_params(&entry->params, params)) {
+            found = entry;
+        } else if (frame_time - entry->frame_time > EDGE_MAP_MAX_AGE_NS) {
+            *link = entry->next;
+            free_entry(entry);
+            continue;
+        }
+        link = &entry->next;
+    }
+
+    if (!found) {
+        found = bzalloc(sizeof(edge_map_entry_t));
+        found->source = source;
+        found->params = *params;
+        found->next = edge_maps;
+        edge_maps = found;
+    }
+    return found;
+}
+
+static bool ensure_targets(edge_map_entry_t *entry) {
+    if (!entry->blur[0]) entry->blur[0] = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+    if (!entry->blur[1]) entry->blur[1] = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+    if (!entry->gradient) entry->gradient = gs_texrender_create(GS_RG16F, GS_ZS_NONE);
+    if (!entry->edges[0]) entry->edges[0] = gs_texrender_create(GS_R8, GS_ZS_NONE);
+    if (!entry->edges[1]) entry->edges[1] = gs_texrender_create(GS_R8, GS_ZS_NONE);
+
+    return entry->blur[0] && entry->blur[1] && entry->gradient && entry->edges[0] && entry->edges[1];
+}
+
+static bool run_pass(gs_texrender_t *dst, gs_texture_t *src, const char *technique, uint32_t cx, uint32_t cy) {
+    if (!src || !render_pass_begin(dst, cx, cy, false)) return false;
+
+    gs_effect_set_texture(param_image, src);
+    render_pass_draw(edge_effect, technique, cx, cy);
+    gs_texrender_end(dst);
+    return true;
+}
+
+static bool compute_edges(edge_map_entry_t *entry, gs_texture_t *input, uint32_t cx, uint32_t cy) {
+    const edge_map_params_t *p = &entry->params;
+    struct vec2 texel, horizontal, vertical;
+    vec2_set(&texel, 1.0f / (float)cx, 1.0f / (float)cy);
+    vec2_set(&horizontal, 1.0f, 0.0f);
+    vec2_set(&vertical, 0.0f, 1.0f);
+
+    gs_effect_set_vec2(param_texel, &texel);
+    gs_effect_set_float(param_blur_sigma, p->blur_sigma);
+    gs_effect_set_float(param_low_threshold, p->low_threshold);
+    gs_effect_set_float(param_high_threshold, p->high_threshold);
+
+    // 1. Separable Gaussian of the luminance
+    gs_effect_set_vec2(param_blur_dir, &horizontal);
+    if (!run_pass(entry->blur[0], input, "BlurLuma", cx, cy)) return false;
+    gs_effect_set_vec2(param_blur_dir, &vertical);
+    if (!run_pass(entry->blur[1], gs_texrender_get_texture(entry->blur[0]), "Blur", cx, cy)) return false;
+
+    // 2. Sobel gradient, 3. suppression and double threshold
+    if (!run_pass(entry->gradient, gs_texrender_get_texture(entry->blur[1]), "Gradient", cx, cy)) return false;
+    if (!run_pass(entry->edges[0], gs_texrender_get_texture(entry->gradient), "Suppress", cx, cy)) return false;
+
+    // 4. Hysteresis: each pass grows strong edges by one texel along weak ones
+    int current = 0;
+    for (int i = 0; i < p->hysteresis_passes; i++) {
+        gs_effect_set_bool(param_hysteresis_final, i == p->hysteresis_passes - 1);
+        gs_texture_t *src = gs_texrender_get_texture(entry->edges[current]);
+        if (!run_pass(entry->edges[current ^ 1], src, "Hysteresis", cx, cy)) return false;
+        current ^= 1;
+    }
+
+    entry->result = gs_texrender_get_texture(entry->edges[current]);
+    return entry->result != NULL;
+}
+
+// Returns the Canny edge map of `source`'s output for this frame, at
+// width x height >> params->scale_shift: 1 on edges, 0 elsewhere. `input`
+// is that output at width x height; it is only read if no effect has asked
+// for the same map this frame yet. NULL while the shader compiles or if a
+// pass fails. The texture stays valid until the next frame's passes; sample
+// it with linear filtering to scale it up. Graphics thread, inside
+// video_render.
+gs_texture_t *edge_map_get(const obs_source_t *source, gs_texture_t *input, uint32_t width, uint32_t height,
+                           const edge_map_params_t *params) {
+    if (!source || !input || !params || width == 0 || height == 0) return NULL;
+    if (!edge_map_ensure_effect()) return NULL;
+
+    uint64_t frame_time = obs_get_video_frame_time();
+    edge_map_entry_t *entry = find_entry(source, params, frame_time);
+    if (entry->valid && entry->frame_time == frame_time && entry->cx == width && entry->cy == height) {
+        return entry->result;
+    }
+
+    uint32_t round_up = (1u << params->scale_shift) - 1;
+    uint32_t cx = (width + round_up) >> params->scale_shift;
+    uint32_t cy = (height + round_up) >> params->scale_shift;
+
+    entry->valid = false;
+    entry->frame_time = frame_time;
+    entry->cx = width;
+    entry->cy = height;
+    if (!ensure_targets(entry)) return NULL;
+
+    // The passes overwrite the shared effect's uniforms
+    effect_cache_claim(edge_effect, &edge_maps);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    entry->valid = compute_edges(entry, input, cx, cy);
+    gs_blend_state_pop();
+
+    if (!entry->valid) PLUGIN_LOG_WARNING("edge-map", "Failed to render edge map (%ux%u)", cx, cy);
+    return entry->valid ? entry->result : NULL;
+}
+
+// Frees every edge map and the shader reference. Call from
+// obs_module_unload, before effect_cache_shutdown().
+void edge_map_shutdown(void) {
+    obs_enter_graphics();
+    while (edge_maps) {
+        edge_map_entry_t *entry = edge_maps;
+        edge_maps = entry->next;
+        free_entry(entry);
+    }
+    effect_cache_release(edge_effect);
+    edge_effect = NULL;
+    obs_leave_graphics();
+}
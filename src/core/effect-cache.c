@@ -0,0 +1,272 @@
+/*
+ * src/core/effect-cache.c
+ * Process-wide cache of compiled effects, shared by every filter instance,
+ * with a background loader so compiles stay off the graphics thread's frames
+ */
+
+#include "effect-core.h"
+#include "../utils/logging.h"
+#include <util/threading.h>
+
+typedef enum {
+    ENTRY_QUEUED,   // Waiting for the loader thread
+    ENTRY_LOADING,  // Being compiled by the loader thread
+    ENTRY_READY,
+    ENTRY_FAILED    // No effect, not even the passthrough fallback
+} entry_state_t;
+
+typedef struct effect_cache_entry {
+    struct effect_cache_entry *next;
+    char *shader_path;
+    char *defines;           // Variant's SPEC_ defines, NULL for the plain effect
+    gs_effect_t *effect;
+    entry_state_t state;
+    long refs;
+    bool pinned;             // Warmed up or a variant: kept until effect_cache_shutdown()
+    const void *last_owner;  // Instance whose uniform values the effect holds
+} effect_cache_entry_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static effect_cache_entry_t *cache_entries = NULL;
+static unsigned long cache_hits = 0;
+static unsigned long cache_misses = 0;
+
+// Loader thread, started on the first queued compile
+static pthread_cond_t loader_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t loader_thread;
+static bool loader_running = false;
+static bool loader_shutdown = false;
+
+static effect_cache_entry_t *find_by_key(const char *shader_path, const char *defines) {
+    for (effect_cache_entry_t *e = cache_entries; e; e = e->next) {
+        bool same_defines = (!e->defines && !defines) ||
+                            (e->defines && defines && strcmp(e->defines, defines) == 0);
+        if (same_defines && strcmp(e->shader_path, shader_path) == 0) return e;
+    }
+    return NULL;
+}
+
+static effect_cache_entry_t **find_link_by_effect(const gs_effect_t *effect) {
+    for (effect_cache_entry_t **link = &cache_entries; *link; link = &(*link)->next) {
+        if ((*link)->effect == effect) return link;
+    }
+    return NULL;
+}
+
+static effect_cache_entry_t *find_queued(void) {
+    for (effect_cache_entry_t *e = cache_entries; e; e = e->next) {
+        if (e->state == ENTRY_QUEUED) return e;
+    }
+    return NULL;
+}
+
+// Drops the entry. libobs keeps every effect created with a file name
+// (gs_effect_create_from_file, and load_shader_variant's "path#hash") in
+// its own list until gs_destroy, and gs_effect_destroy leaves those alone,
+// so this releases no GPU memory; creating the plain effect again finds
+// libobs' copy instead of compiling.
+static void free_entry(effect_cache_entry_t *entry) {
+    gs_effect_destroy(entry->effect);
+    bfree(entry->shader_path);
+    bfree(entry->defines);
+    bfree(entry);
+}
+
+// Compiles queued entries one at a time. Each compile takes the graphics
+// context on its own, so the graphics thread waits at most one shader
+// between frames rather than a whole scene's worth inside one.
+static void *loader_main(void *arg) {
+    (void)arg;
+    os_set_thread_name("emulens: shader loader");
+
+    pthread_mutex_lock(&cache_mutex);
+    while (!loader_shutdown) {
+        effect_cache_entry_t *entry = find_queued();
+        if (!entry) {
+            pthread_cond_wait(&loader_cond, &cache_mutex);
+            continue;
+        }
+
+        // Entries are freed by release (needs a compiled effect) or after
+        // the loader has stopped, so `entry` outlives the unlocked compile
+        entry->state = ENTRY_LOADING;
+        const char *shader_path = entry->shader_path;
+        const char *defines = entry->defines;
+        pthread_mutex_unlock(&cache_mutex);
+
+        uint64_t start_ns = os_gettime_ns();
+        obs_enter_graphics();
+        gs_effect_t *effect = load_shader_variant(shader_path, defines);
+        obs_leave_graphics();
+        PLUGIN_LOG_DEBUG("effect-cache", "Compiled %s in %.1f ms", shader_path,
+                         (double)(os_gettime_ns() - start_ns) / 1000000.0);
+
+        pthread_mutex_lock(&cache_mutex);
+        entry->effect = effect;
+        entry->state = effect ? ENTRY_READY : ENTRY_FAILED;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    return NULL;
+}
+
+// Returns the entry for `shader_path` + `defines` (NULL for the plain
+// effect), creating and queueing it if missing. Called with cache_mutex held.
+static effect_cache_entry_t *queue_entry(const char *shader_path, const char *defines) {
+    effect_cache_entry_t *entry = find_by_key(shader_path, defines);
+    if (entry) return entry;
+
+    entry = bzalloc(sizeof(effect_cache_entry_t));
+    entry->shader_path = bstrdup(shader_path);
+    entry->defines = defines ? bstrdup(defines) : NULL;
+    entry->pinned = defines != NULL; // Toggling a setting back shouldn't recompile
+    entry->state = ENTRY_QUEUED;
+    entry->next = cache_entries;
+    cache_entries = entry;
+
+    if (!loader_running && !loader_shutdown) {
+        loader_running = pthread_create(&loader_thread, NULL, loader_main, NULL) == 0;
+        if (!loader_running) {
+            PLUGIN_LOG_ERROR("effect-cache", "Failed to start the shader loader thread");
+        }
+    }
+    pthread_cond_signal(&loader_cond);
+    return entry;
+}
+
+// Queues `shader_path` for compiling on the loader thread and keeps the
+// result until effect_cache_shutdown(). Used to warm the cache at load.
+void effect_cache_prefetch(const char *shader_path) {
+    VALIDATE_POINTER_RETURN_VOID(shader_path, "effect-cache");
+
+    pthread_mutex_lock(&cache_mutex);
+    queue_entry(shader_path, NULL)->pinned = true;
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+// Returns the shared effect for `shader_path` without ever compiling on the
+// calling thread. If it isn't compiled yet it is queued and NULL returned;
+// poll again on a later frame. *failed is set once the shader is known not
+// to load at all. Like load_shader_effect(), a ready effect may be the
+// passthrough fallback. Pair successful calls with effect_cache_release().
+gs_effect_t *effect_cache_try_acquire(const char *shader_path, bool *failed) {
+    return effect_cache_try_acquire_variant(shader_path, NULL, failed);
+}
+
+// As effect_cache_try_acquire(), for the variant compiled with `defines`
+// prepended (see load_shader_variant). NULL or "" selects the plain effect.
+gs_effect_t *effect_cache_try_acquire_variant(const char *shader_path, const char *defines, bool *failed) {
+    if (failed) *failed = false;
+    VALIDATE_POINTER_RETURN(shader_path, "effect-cache", NULL);
+    if (defines && !*defines) defines = NULL;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    effect_cache_entry_t *entry = find_by_key(shader_path, defines);
+    if (!entry) {
+        cache_misses++;
+        entry = queue_entry(shader_path, defines);
+        PLUGIN_LOG_DEBUG("effect-cache", "Miss: %s queued", shader_path);
+    }
+
+    gs_effect_t *effect = NULL;
+    if (entry->state == ENTRY_READY) {
+        // A miss is counted once; polling while it compiles isn't a hit
+        if (entry->refs > 0 || entry->pinned) cache_hits++;
+        entry->refs++;
+        effect = entry->effect;
+        PLUGIN_LOG_DEBUG("effect-cache", "Acquired: %s (%ld users)", shader_path, entry->refs);
+    } else if (entry->state == ENTRY_FAILED && failed) {
+        *failed = true;
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+    return effect;
+}
+
+// Drops one reference; unless the effect is pinned its cache entry goes
+// with its last user (see free_entry for what that frees). Must be called
+// inside obs_enter_graphics().
+void effect_cache_release(gs_effect_t *effect) {
+    if (!effect) return;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    effect_cache_entry_t **link = find_link_by_effect(effect);
+    if (!link) {
+        pthread_mutex_unlock(&cache_mutex);
+        PLUGIN_LOG_WARNING("effect-cache", "Releasing an effect the cache doesn't own");
+        gs_effect_destroy(effect);
+        return;
+    }
+
+    effect_cache_entry_t *entry = *link;
+    if (--entry->refs > 0 || entry->pinned) {
+        pthread_mutex_unlock(&cache_mutex);
+        return;
+    }
+
+    *link = entry->next;
+    PLUGIN_LOG_INFO("effect-cache", "Dropped unused %s (cache hits %lu, misses %lu)",
+                    entry->shader_path, cache_hits, cache_misses);
+    pthread_mutex_unlock(&cache_mutex);
+
+    free_entry(entry);
+}
+
+// Records `owner` as the instance whose uniform values are loaded into the
+// shared effect. Returns true if a different instance (or nobody) applied
+// its values last, meaning the caller must set all of its uniforms again.
+bool effect_cache_claim(gs_effect_t *effect, const void *owner) {
+    if (!effect) return false;
+
+    pthread_mutex_lock(&cache_mutex);
+    effect_cache_entry_t **link = find_link_by_effect(effect);
+    bool changed = true;
+    if (link) {
+        changed = (*link)->last_owner != owner;
+        (*link)->last_owner = owner;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    return changed;
+}
+
+void effect_cache_log_stats(void) {
+    pthread_mutex_lock(&cache_mutex);
+    size_t live = 0;
+    for (effect_cache_entry_t *e = cache_entries; e; e = e->next) live++;
+    PLUGIN_LOG_INFO("effect-cache", "%lu hits, %lu misses, %zu effects still cached",
+                    cache_hits, cache_misses, live);
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+// Stops the loader thread and frees every entry nobody holds. Call from
+// obs_module_unload, after all filter instances are gone.
+void effect_cache_shutdown(void) {
+    pthread_mutex_lock(&cache_mutex);
+    loader_shutdown = true;
+    pthread_cond_signal(&loader_cond);
+    bool joining = loader_running;
+    loader_running = false;
+    pthread_mutex_unlock(&cache_mutex);
+
+    if (joining) pthread_join(loader_thread, NULL);
+
+    obs_enter_graphics();
+    pthread_mutex_lock(&cache_mutex);
+    effect_cache_entry_t **link = &cache_entries;
+    while (*link) {
+        effect_cache_entry_t *entry = *link;
+        if (entry->refs > 0) {
+            PLUGIN_LOG_WARNING("effect-cache", "%s still has %ld users at shutdown",
+                               entry->shader_path, entry->refs);
+            link = &entry->next;
+            continue;
+        }
+        *link = entry->next;
+        free_entry(entry);
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    obs_leave_graphics();
+}
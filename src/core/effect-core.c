@@ -5,42 +5,54 @@
 
 #include "effect-core.h"
 #include "../utils/logging.h"
+#include <util/threading.h>
 #include <math.h>
 
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+// Effect being created by effect_create_member() on this thread. Its create
+// callback reaches generic_create() with the owning filter's source, whose
+// type data is the owner's effect_info_t, not the member's.
+static THREAD_LOCAL const effect_info_t *creating_member = NULL;
+
 void *generic_create(obs_data_t *settings, obs_source_t *source) {
-    const effect_info_t *info = obs_source_get_type_data(source);
+    const effect_info_t *info = creating_member ? creating_member : obs_source_get_type_data(source);
     
-    effect_data_t *ed = bzalloc(sizeof(effect_data_t));
+    // Parameter store shares the allocation; effect_data_t keeps it aligned
+    effect_data_t *ed = bzalloc(sizeof(effect_data_t) + param_store_size(info));
     ed->context = source;
     ed->info = info;
+    param_store_init(&ed->params, info, ed + 1);
+    ed->variant_stale = true; // Selects the first variant too
+    ed->is_member = creating_member != NULL;
 
     PLUGIN_LOG_DEBUG("effect-core", "Creating effect: %s", info->name);
 
-    obs_enter_graphics();
-    ed->effect = load_shader_effect(info->shader_path);
-    
-    if (!ed->effect) {
-        obs_leave_graphics();
-        PLUGIN_LOG_ERROR("effect-core", "Failed to create effect: %s", info->name);
-        bfree(ed);
-        return NULL;
-    }
+    // No graphics work here: the shader was queued by the warm-up in
+    // obs_module_load and generic_ensure_effect() binds it on the graphics
+    // thread. Until then the filter passes its input through.
 
-    // Allocate cache arrays if we have parameters
-    if (info->num_params > 0) {
-        ed->cached_float_values = bzalloc(sizeof(float) * info->num_params);
-        ed->cached_int_values = bzalloc(sizeof(int) * info->num_params);
-        ed->cached_bool_values = bzalloc(sizeof(bool) * info->num_params);
-        ed->cached_color_values = bzalloc(sizeof(uint32_t) * info->num_params);
-    }
+    // The owner of a member passes it settings itself, see effect_create_member()
+    if (!ed->is_member) obs_source_update(source, settings);
+    return ed;
+}
 
-    // Use the central binding helper
-    bind_effect_parameters(ed);
-    
-    obs_leave_graphics();
+// Creates an instance of `info` hosted by another filter (the EmuLens Stack)
+// and applies `settings` to it. The instance renders through `owner`'s
+// context; its callbacks are called by the owner, never by OBS.
+void *effect_create_member(const effect_info_t *info, obs_data_t *settings, obs_source_t *owner) {
+    if (!info || !info->create || !owner) return NULL;
 
-    obs_source_update(source, settings);
-    return ed;
+    creating_member = info;
+    void *data = info->create(settings, owner);
+    creating_member = NULL;
+
+    if (data && info->update) info->update(data, settings);
+    return data;
 }
 
 void generic_destroy(void *data) {
@@ -51,40 +63,123 @@ void generic_destroy(void *data) {
 
     obs_enter_graphics();
     
-    // Properly cleanup effect
+    // Drop our reference to the shared effect
     if (ed->effect) {
-        gs_effect_destroy(ed->effect);
+        effect_cache_release(ed->effect);
         ed->effect = NULL;
     }
+
+    gs_texrender_destroy(ed->split_input);
+    gs_texrender_destroy(ed->split_overlay);
+    render_cache_free(ed);
+    luma_probe_free(ed);
+    quality_governor_free(ed);
     
     obs_leave_graphics();
+
+    cpu_filter_free(ed);
     
-    // Cleanup parameter handles array with verification
-    if (ed->param_handles) {
-        // Nullify handles before freeing container to catch use-after-free
-        if (ed->info && ed->info->num_params > 0) {
-            for (size_t i = 0; i < ed->info->num_params; i++) {
-                ed->param_handles[i] = NULL;
-            }
+    // The parameter store lives in the same block
+    dstr_free(&ed->variant);
+    bfree(ed);
+}
+
+// Sets uv_size, uv_pixel_interval and elapsed_time for an image of
+// width x height. Effects drawing from their own textures call this with
+// the size of the texture bound to `image`.
+void generic_set_standard_uniforms(effect_data_t *ed, float width, float height) {
+    if (!ed || width <= 0.0f || height <= 0.0f) return;
+
+    if (ed->param_uv_size) {
+        struct vec2 uv;
+        vec2_set(&uv, width, height);
+        gs_effect_set_vec2(ed->param_uv_size, &uv);
+    }
+
+    if (ed->param_uv_pixel_interval) {
+        struct vec2 interval;
+        vec2_set(&interval, 1.0f / width, 1.0f / height);
+        gs_effect_set_vec2(ed->param_uv_pixel_interval, &interval);
+    }
+
+    if (ed->param_elapsed_time) {
+        gs_effect_set_float(ed->param_elapsed_time, ed->elapsed_time);
+    }
+}
+
+// Loads this instance's state into the shared effect: parameter values,
+// standard uniforms for a width x height image and the effect's own
+// prepare_draw hook. Call after the input is rendered, right before drawing.
+void generic_prepare_draw(effect_data_t *ed, float width, float height) {
+    if (!ed || !ed->effect) return;
+
+    apply_effect_parameters(ed);
+    generic_set_standard_uniforms(ed, width, height);
+    if (ed->info && ed->info->prepare_draw) ed->info->prepare_draw(ed, width, height);
+}
+
+// Binds `effect`, a reference taken from the effect cache, in place of the
+// current one. `variant` is the defines it was compiled with ("" = plain).
+void generic_bind_effect(effect_data_t *ed, gs_effect_t *effect, const char *variant) {
+    if (ed->effect) effect_cache_release(ed->effect);
+    ed->effect = effect;
+    dstr_copy(&ed->variant, variant);
+
+    bind_effect_parameters(ed);
+    param_store_mark_all_dirty(&ed->params, ed->info->num_params); // Upload the synced values
+    if (ed->info->bind_effect) ed->info->bind_effect(ed);
+}
+
+// Binds the shared effect once the loader has compiled it, and switches to
+// the variant matching the PARAM_FLAG_SPECIALIZE values when they change.
+// While a variant compiles the plain effect draws, reading the same values
+// from uniforms. Returns false while nothing is compiled yet or if the
+// shader failed; the caller should pass the input through. Graphics thread.
+bool generic_ensure_effect(effect_data_t *ed) {
+    if (!ed || !ed->info || ed->effect_failed) return false;
+    if (ed->effect && !os_atomic_load_bool(&ed->variant_stale)) return true;
+
+    // Cleared before reading the values; the next sync re-flags it if they change
+    os_atomic_set_bool(&ed->variant_stale, false);
+
+    struct dstr wanted = {0};
+    param_store_variant_defines(&ed->params, ed->info, &wanted);
+    const char *defines = wanted.array ? wanted.array : "";
+    const char *current = ed->variant.array ? ed->variant.array : "";
+
+    if (!ed->effect || strcmp(defines, current) != 0) {
+        bool failed = false;
+        gs_effect_t *effect = effect_cache_try_acquire_variant(ed->info->shader_path, defines, &failed);
+
+        if (effect) {
+            generic_bind_effect(ed, effect, defines);
+        } else if (!failed) {
+            os_atomic_set_bool(&ed->variant_stale, true); // Poll again next frame
+        } else if (*defines) {
+            EFFECT_LOG_WARNING(ed, "Shader variant failed to compile, using the plain effect");
+        } else {
+            ed->effect_failed = true;
+            EFFECT_LOG_ERROR(ed, "Shader failed to load, filter disabled");
+        }
+
+        // A bound variant has the old values baked in, so until the wanted
+        // one is ready draw with the plain effect
+        if (!effect && *defines && (!ed->effect || *current != '\0')) {
+            effect = effect_cache_try_acquire_variant(ed->info->shader_path, NULL, &failed);
+            if (effect) generic_bind_effect(ed, effect, "");
         }
-        bfree(ed->param_handles);
-        ed->param_handles = NULL;
     }
-    
-    // Cleanup cached values
-    if (ed->cached_float_values) bfree(ed->cached_float_values);
-    if (ed->cached_int_values) bfree(ed->cached_int_values);
-    if (ed->cached_bool_values) bfree(ed->cached_bool_values);
-    if (ed->cached_color_values) bfree(ed->cached_color_values);
-    
-    bfree(ed);
+
+    dstr_free(&wanted);
+    return ed->effect != NULL && !ed->effect_failed;
 }
 
 void generic_render(void *data, gs_effect_t *effect) {
     (void)effect; // Use internal effect
     effect_data_t *ed = data;
+    if (!ed || render_elide(ed)) return;
     
-    if (!ed || !ed->effect) {
+    if (!generic_ensure_effect(ed)) {
         obs_source_skip_video_filter(ed->context);
         return;
     }
@@ -95,37 +190,50 @@ void generic_render(void *data, gs_effect_t *effect) {
         return;
     }
 
-    if (obs_source_process_filter_begin(ed->context, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
-        float width = (float)obs_source_get_width(target);
-        float height = (float)obs_source_get_height(target);
+    if (ed->split_supported && quality_render_scale_shift(ed) > 0) {
+        uint32_t width = obs_source_get_width(target);
+        uint32_t height = obs_source_get_height(target);
+        if (render_split_overlay(ed, width, height)) return;
+    }
 
-        // Update Standard Uniforms
-        if (ed->param_uv_size) {
-            struct vec2 uv;
-            vec2_set(&uv, width, height);
-            gs_effect_set_vec2(ed->param_uv_size, &uv);
-        }
-        
-        if (ed->param_uv_pixel_interval) {
-            struct vec2 interval;
-            vec2_set(&interval, 1.0f / width, 1.0f / height);
-            gs_effect_set_vec2(ed->param_uv_pixel_interval, &interval);
+    // An auto mode measures the input, so it has to be a texture
+    if (ed->luma_wanted) {
+        uint32_t width = obs_source_get_width(target);
+        uint32_t height = obs_source_get_height(target);
+        gs_texture_t *input = luma_probe_capture(ed, width, height);
+        if (input) {
+            generic_prepare_draw(ed, (float)width, (float)height);
+            gs_effect_set_texture(ed->param_image, input);
+            while (gs_effect_loop(ed->effect, "Draw")) {
+                gs_draw_sprite(input, 0, width, height);
+            }
+            return;
         }
+    }
 
-        if (ed->param_elapsed_time) {
-            gs_effect_set_float(ed->param_elapsed_time, ed->elapsed_time);
-        }
-        
-        // Use standard end function which handles techniques automatically
+    // In the input's own colour space, so OBS converts nothing around us
+    enum gs_color_space space = effect_color_space(ed);
+    if (obs_source_process_filter_begin_with_color_space(ed->context, gs_get_format_from_space(space), space,
+                                                         OBS_ALLOW_DIRECT_RENDERING)) {
+        effect_input_ready(ed);
+        generic_prepare_draw(ed, (float)obs_source_get_width(target), (float)obs_source_get_height(target));
+
+        // Use standard end function which handles techniques automatically.
+        // Without linear sRGB it binds the input as stored, no decode.
+        bool previous_linear = gs_set_linear_srgb(false);
         obs_source_process_filter_end(ed->context, ed->effect, 0, 0);
+        gs_set_linear_srgb(previous_linear);
     }
 }
 
+// Graphics thread, once a frame before anything renders
 void generic_tick(void *data, float seconds) {
     effect_data_t *ed = data;
     if (ed) {
+        sync_effect_parameters(ed); // Picks up updates for this frame
         ed->elapsed_time += seconds;
         // Basic overflow protection
         if (ed->elapsed_time > 86400.0f) ed->elapsed_time = fmodf(ed->elapsed_time, 86400.0f);
+        if (ed->info->frame_constants) ed->info->frame_constants(ed);
     }
 }
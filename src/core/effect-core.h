@@ -29,6 +29,15 @@ typedef enum {
     PARAM_BOOL
 } param_type_t;
 
+// Parameter flags
+#define PARAM_FLAG_NO_UNIFORM (1u << 0) // Host-side setting only, no matching shader uniform
+#define PARAM_FLAG_SPECIALIZE (1u << 1) // Bool/int baked into a shader variant as SPEC_<name>
+#define PARAM_FLAG_QUALITY    (1u << 2) // Cost knob the quality governor may lower, see quality-governor.c
+
+// Effect flags
+#define EFFECT_FLAG_SPLIT_OVERLAY (1u << 0) // Shader provides DrawOverlay/Composite for render_scale
+#define EFFECT_FLAG_NO_STACK      (1u << 1) // Only draws through its own video_render, not in an EmuLens Stack
+
 // Schema definition for a single parameter
 typedef struct {
     const char *name;           // Shader uniform name AND OBS property name
@@ -47,8 +56,61 @@ typedef struct {
     double min;
     double max;
     double step;
+
+    uint32_t flags;             // PARAM_FLAG_* (Optional)
 } param_def_t;
 
+// Shared "render_scale" setting for effects with EFFECT_FLAG_SPLIT_OVERLAY.
+// Value is a shift: the generated layer renders at 1 / (1 << value) size.
+// With PARAM_FLAG_QUALITY the governor raises it at lower levels, see
+// quality_render_scale_shift.
+#define RENDER_SCALE_SETTING "render_scale"
+#define RENDER_SCALE_MAX_SHIFT 2
+#define PARAM_RENDER_SCALE_FLAGS(flags) \
+    {RENDER_SCALE_SETTING, "Render Scale", "Resolution of the generated layer 0:Full 1:Half 2:Quarter", \
+     PARAM_INT, {.i_val=0}, 0, RENDER_SCALE_MAX_SHIFT, 1, PARAM_FLAG_NO_UNIFORM | (flags)}
+#define PARAM_RENDER_SCALE PARAM_RENDER_SCALE_FLAGS(0)
+
+// Shared "cpu_path" setting for effects with a filter_frame callback. When
+// on, frames of async sources (media, capture) are filtered in CPU memory
+// before OBS uploads them, and video_render passes them through. Only for
+// the first filter on the source; elsewhere in the chain it renders on the GPU.
+#define CPU_PATH_SETTING "cpu_path"
+#define PARAM_CPU_PATH \
+    {CPU_PATH_SETTING, "Process on CPU", "Filter frames of media and capture sources on the CPU before upload", \
+     PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM}
+
+// Shared "quality_budget" setting. With a budget, the quality governor
+// times the filter on the GPU and steps PARAM_FLAG_QUALITY parameters down
+// while it runs over, and back up once there is room again.
+#define QUALITY_BUDGET_SETTING "quality_budget"
+#define QUALITY_LEVELS 4        // Level 0 is the settings as given
+#define PARAM_QUALITY_BUDGET \
+    {QUALITY_BUDGET_SETTING, "GPU Budget (ms)", "Lower quality while the filter takes longer than this on the GPU, 0 = off", \
+     PARAM_FLOAT, {.f_val=0.0}, 0.0, 16.0, 0.25, PARAM_FLAG_NO_UNIFORM}
+
+// Settings of a Canny edge map, see edge-map.c. Effects asking for the same
+// values on the same source in one frame share the result.
+#define EDGE_MAP_SHADER "shaders/canny-edge.shader"
+
+typedef struct {
+    float blur_sigma;           // Gaussian standard deviation, in edge map texels
+    float low_threshold;        // Gradient magnitude that can continue an edge
+    float high_threshold;       // Gradient magnitude that starts an edge
+    int hysteresis_passes;      // Weak edge propagation steps, at least 1
+    int scale_shift;            // Map is 1 / (1 << scale_shift) of the input size
+} edge_map_params_t;
+
+// Scene luminance measured by luma-stats.c for "auto" thresholds, a couple
+// of frames late and smoothed over time
+#define LUMA_REDUCE_SHADER "shaders/luma-reduce.shader"
+
+typedef struct {
+    float mean;                 // Average luminance
+    float peak;                 // Brightest 4x4 block's brightest texel
+    bool valid;                 // False until the first readback
+} luma_stats_t;
+
 // --- Effect Structures ---
 
 // Forward declarations
@@ -63,11 +125,68 @@ typedef struct gs_effect_param gs_eparam_t;
 struct obs_properties;
 typedef struct obs_properties obs_properties_t;
 
+// --- Parameter Store ---
+
+// Per-instance parameter values, packed by type into one block allocated
+// with effect_data_t (see param_store_init). Every array lives in that
+// block; nothing here is freed separately.
+//
+// Values are double-buffered. generic_update writes `back` inside the `seq`
+// seqlock; once a frame sync_effect_parameters copies it to `scratch` on the
+// graphics thread and swaps that in as `front` if no update raced the copy,
+// so a frame never sees half an update. Everything that draws reads `front`.
+#define PARAM_DIRTY_WORD_BITS 32
+
+typedef struct {
+    float *floats;
+    int *ints;
+    bool *bools;
+    uint32_t *colors;
+} param_values_t;
+
+typedef struct {
+    gs_eparam_t **handles;      // Param index -> shader uniform (NULL if none)
+    uint16_t *slots;            // Param index -> slot in its type's array
+    uint16_t *name_table;       // Open-addressed name hash -> param index + 1
+    uint32_t name_mask;         // name_table size - 1
+    uint16_t counts[4];         // Params per param_type_t
+    param_values_t front;       // Graphics thread's snapshot
+    param_values_t back;        // Written by update
+    param_values_t scratch;     // Next `front` while sync copies it
+    volatile long seq;          // Odd while update writes `back`
+    long synced_seq;            // seq when `front` was last copied
+    int quality_level;          // Level PARAM_FLAG_QUALITY values in `front` are lowered to
+    volatile long *dirty;       // Bit per param index: set by update, taken by sync
+    unsigned long *taken;       // Bits the sync in progress took from `dirty`
+    unsigned long *unapplied;   // Bits taken by sync, cleared by apply
+    size_t num_dirty_words;
+} param_store_t;
+
+// RGBA8 frame for the CPU path, straight alpha, the values a shader would
+// sample. Rows are padded to a multiple of 8 texels so kernels can run
+// whole SIMD_LANES groups up to `stride`.
+typedef struct {
+    uint32_t *pixels;           // Texel (x, y) at pixels[y * stride + x], R in the low byte
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;            // Texels per row
+} cpu_image_t;
+
+// Per-pixel form of an effect for the EmuLens Stack's fused passes
+// (data/shaders/emulens-stack.shader). `define` makes the stack shader
+// include the effect's stage file, which provides `function`.
+typedef struct {
+    const char *define;         // e.g. "STACK_WITH_LIGHT_LEAK"
+    const char *function;       // float4 f(float4 color, float2 uv), or float4 f(float2 uv) if samples_input
+    bool samples_input;         // Reads the input itself (resamples it), so it must start a pass
+} effect_stage_t;
+
 typedef struct {
     const char *id;
     const char *name;
     const char *description;
     const char *shader_path;
+    const char *const *extra_shaders; // Other shaders it acquires, NULL-terminated, warmed up at load (Optional)
     
     // Parameter Metadata (The Contract)
     const param_def_t *params;
@@ -81,13 +200,57 @@ typedef struct {
     void (*video_tick)(void *data, float seconds);
     obs_properties_t *(*get_properties)(void *data);
     void (*get_defaults)(obs_data_t *settings);
+
+    // Derives the values that depend only on elapsed_time and the settings,
+    // once a frame from generic_tick after both are current (Optional).
+    // Results go in effect_state for prepare_draw to upload and the CPU path
+    // to share, instead of every pixel recomputing them. Graphics thread.
+    void (*frame_constants)(void *data);
+
+    // Refreshes the settings effect_state keeps outside the param store from
+    // the front values (param_get_*), whenever sync_effect_parameters took
+    // new ones (Optional). Tick, render and the CPU path read those copies,
+    // never obs_data. Graphics thread.
+    void (*params_synced)(void *data);
+
+    // Sets per-frame uniforms right before the effect draws, after the input
+    // has been rendered (Optional). The effect is shared between instances,
+    // so values set any earlier may be overwritten by a nested instance.
+    void (*prepare_draw)(void *data, float width, float height);
+
+    // Looks up effect-specific handles once ed->effect is bound (Optional).
+    // Runs on the graphics thread, possibly some frames after create, since
+    // the shader compiles in the background.
+    void (*bind_effect)(void *data);
+
+    // Lets the EmuLens Stack fuse this effect with others (Optional)
+    const effect_stage_t *stage;
+
+    // Applies the effect to `src`, writing `dst` (same size), for frames of
+    // async sources while CPU_PATH_SETTING is on (Optional, see
+    // cpu-filter.c). Graphics thread; split rows over task_pool_shared().
+    void (*filter_frame)(void *data, const cpu_image_t *src, cpu_image_t *dst);
+
+    // Render elision (Optional, see render-cache.c). Both read the synced
+    // values; graphics thread.
+    // True when the output equals the input, so the filter skips itself
+    bool (*is_identity)(void *data);
+    // True when the output depends only on the input and the settings, not
+    // on time, so an unchanged input can reuse the last output
+    bool (*is_static)(void *data);
+
+    uint32_t flags;             // EFFECT_FLAG_* (Optional)
 } effect_info_t;
 
 // Runtime data for an active effect instance
 typedef struct {
     obs_source_t *context;
     const effect_info_t *info;
-    gs_effect_t *effect;
+    gs_effect_t *effect;        // NULL until the shader finishes compiling
+    bool effect_failed;         // Shader didn't load; the filter passes through
+    struct dstr variant;        // SPEC_ defines `effect` was built with, empty = plain
+    volatile bool variant_stale; // A PARAM_FLAG_SPECIALIZE value changed since selection
+    bool is_member;             // Owned by an EmuLens Stack, see effect_create_member
     
     // Standard Uniforms
     gs_eparam_t *param_image;
@@ -95,16 +258,48 @@ typedef struct {
     gs_eparam_t *param_uv_pixel_interval;
     gs_eparam_t *param_elapsed_time;
 
-    // Dynamic Parameter Handles (index matches info->params index)
-    gs_eparam_t **param_handles;
-    
-    // Caching for dirty checks
-    float *cached_float_values;
-    int *cached_int_values;
-    bool *cached_bool_values;
-    uint32_t *cached_color_values;
+    // Current values and uniform handles, applied to the (shared) effect at
+    // render time
+    param_store_t params;
     
     float elapsed_time;
+
+    // Reduced-resolution overlay (EFFECT_FLAG_SPLIT_OVERLAY)
+    gs_eparam_t *param_overlay_image;
+    gs_eparam_t *param_overlay_size;
+    bool split_supported;       // Flag set and the shader has both techniques
+    gs_texrender_t *split_input;
+    gs_texrender_t *split_overlay;
+
+    // CPU path for async sources (effect_info_t.filter_frame and
+    // CPU_PATH_SETTING)
+    bool cpu_active;            // The current async frame was filtered on the CPU
+    struct cpu_filter *cpu;     // Frame buffers, see cpu-filter.c
+
+    // Render elision, see render-cache.c
+    volatile long settings_serial; // Bumped by every update and by the sync that picks it up
+    uint64_t frame_serial;      // Async frames seen by filter_video
+    struct render_cache *cache; // Last output of an is_static effect
+
+    // Luminance analysis, see luma-stats.c. params_synced sets luma_wanted
+    // while an auto mode or a brightness lookup needs it; video_render (or
+    // the CPU path) then measures the input into `luma` and
+    // luma_probe_texture.
+    bool luma_wanted;
+    luma_stats_t luma;
+    struct luma_probe *luma_probe;
+
+    // Quality governor, see quality-governor.c. video_render moves the level
+    // against QUALITY_BUDGET_SETTING, which the next sync applies.
+    int quality_level;          // 0 (as set) to QUALITY_LEVELS - 1 (cheapest)
+    struct quality_governor *governor;
+
+    // Effect-specific state owned by specialised callbacks (Optional)
+    void *effect_state;
+
+#ifdef EMULENS_PROFILING
+    struct effect_profile *profile; // Timings, see profiler.c (NULL for stack members)
+#endif
 } effect_data_t;
 
 // --- Function Prototypes ---
@@ -114,15 +309,85 @@ void *generic_create(obs_data_t *settings, obs_source_t *source);
 void generic_destroy(void *data);
 void generic_render(void *data, gs_effect_t *effect);
 void generic_tick(void *data, float seconds);
+void generic_set_standard_uniforms(effect_data_t *ed, float width, float height);
+void generic_prepare_draw(effect_data_t *ed, float width, float height);
+bool generic_ensure_effect(effect_data_t *ed);
+void generic_bind_effect(effect_data_t *ed, gs_effect_t *effect, const char *variant);
+void *effect_create_member(const effect_info_t *info, obs_data_t *settings, obs_source_t *owner);
 
 // Shader Loading
 gs_effect_t *load_shader_effect(const char *shader_path);
+gs_effect_t *load_shader_variant(const char *shader_path, const char *defines);
 bool is_valid_shader_path(const char *path);
 
+// Shared Effect Cache (one compiled effect per shader path)
+void effect_cache_prefetch(const char *shader_path);
+gs_effect_t *effect_cache_try_acquire(const char *shader_path, bool *failed);
+gs_effect_t *effect_cache_try_acquire_variant(const char *shader_path, const char *defines, bool *failed);
+void effect_cache_release(gs_effect_t *effect);
+bool effect_cache_claim(gs_effect_t *effect, const void *owner);
+void effect_cache_log_stats(void);
+void effect_cache_shutdown(void);
+
 // Parameter System
+size_t param_store_size(const effect_info_t *info);
+void param_store_init(param_store_t *store, const effect_info_t *info, void *block);
+int param_store_find(const param_store_t *store, const effect_info_t *info, const char *name);
+void param_store_mark_all_dirty(param_store_t *store, size_t num_params);
+void param_store_variant_defines(const param_store_t *store, const effect_info_t *info, struct dstr *defines);
 void bind_effect_parameters(effect_data_t *ed);
 void generic_update(void *data, obs_data_t *settings);
+void sync_effect_parameters(effect_data_t *ed);
+void apply_effect_parameters(effect_data_t *ed);
 obs_properties_t *generic_properties(void *data);
+void add_param_properties(obs_properties_t *props, const effect_info_t *info, const char *prefix);
+float param_get_float(const effect_data_t *ed, const char *name);
+int param_get_int(const effect_data_t *ed, const char *name);
+bool param_get_bool(const effect_data_t *ed, const char *name);
+uint32_t param_get_color(const effect_data_t *ed, const char *name);
+
+// Multi-pass Rendering Helpers
+bool render_filter_input(effect_data_t *ed, gs_texrender_t *target, uint32_t cx, uint32_t cy);
+bool render_pass_begin(gs_texrender_t *target, uint32_t cx, uint32_t cy, bool clear);
+void render_pass_draw(gs_effect_t *effect, const char *technique, uint32_t cx, uint32_t cy);
+bool render_split_overlay(effect_data_t *ed, uint32_t cx, uint32_t cy);
+enum gs_color_space effect_color_space(const effect_data_t *ed);
+enum gs_color_space effect_get_color_space(void *data, size_t count, const enum gs_color_space *preferred_spaces);
+gs_texrender_t *ensure_render_target(effect_data_t *ed, gs_texrender_t **target);
+
+// CPU Path (async sources)
+struct obs_source_frame *cpu_filter_video(void *data, struct obs_source_frame *frame);
+bool cpu_filter_skip_render(effect_data_t *ed);
+void cpu_filter_free(effect_data_t *ed);
+
+// Edge Maps (Canny, shared per source per frame)
+gs_texture_t *edge_map_get(const obs_source_t *source, gs_texture_t *input, uint32_t width, uint32_t height,
+                           const edge_map_params_t *params);
+void edge_map_shutdown(void);
+
+// Luminance Analysis (per instance, read back asynchronously)
+void luma_probe_analyze(effect_data_t *ed, gs_texture_t *input, uint32_t width, uint32_t height);
+gs_texture_t *luma_probe_capture(effect_data_t *ed, uint32_t width, uint32_t height);
+gs_texture_t *luma_probe_texture(const effect_data_t *ed, uint32_t max_size);
+void luma_stats_measure_frame(effect_data_t *ed, const cpu_image_t *image);
+void luma_probe_free(effect_data_t *ed);
+void luma_stats_shutdown(void);
+float luma_stats_threshold(const luma_stats_t *stats, float fraction, float fallback);
+float luma_stats_exposure(const luma_stats_t *stats);
+
+// Render Elision
+struct obs_source_frame *effect_filter_video(void *data, struct obs_source_frame *frame);
+bool render_elide(effect_data_t *ed);
+bool effect_is_showing(const effect_data_t *ed);
+void render_cache_free(effect_data_t *ed);
+
+// Quality Governor
+void effect_video_render(void *data, gs_effect_t *effect);
+void effect_input_ready(effect_data_t *ed);
+double quality_scale_value(const param_def_t *def, double value, int level);
+double quality_setting(const effect_data_t *ed, const char *name, double value);
+int quality_render_scale_shift(const effect_data_t *ed);
+void quality_governor_free(effect_data_t *ed);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,322 @@
+/*
+ * src/core/luma-stats.c
+ * Scene luminance for "auto" thresholds: a reduction pyramid
+ * (data/shaders/luma-reduce.shader) shrinks the input to a few texels of
+ * mean and peak luminance, which are read back through stage surfaces a
+ * couple of frames later, so measuring never stalls the GPU. The lower
+ * levels double as small luminance textures for brightness lookups.
+ */
+
+#include "effect-core.h"
+#include "../utils/logging.h"
+#include <math.h>
+
+#define LUMA_REDUCE_FACTOR 4      // Per axis and pass, must match luma-reduce.shader
+#define LUMA_MAX_LEVELS 8         // 4^8 covers any texture size OBS allows
+#define LUMA_TOP_SIZE 8           // Reduce until both sides are at most this
+#define LUMA_READBACK_SLOTS 3     // Staged on frame n, mapped on frame n + 2
+#define LUMA_SMOOTHING_NS 400000000.0f // Time constant of the temporal smoothing
+#define LUMA_MID_GREY 0.46f       // 18% grey, sRGB encoded
+#define LUMA_FRAME_STEP 4         // luma_stats_measure_frame reads every 4th texel of every 4th row
+
+struct luma_probe {
+    gs_texrender_t *input;        // luma_probe_capture's copy of the input
+    gs_texrender_t *levels[LUMA_MAX_LEVELS]; // RG16F, the last one RG32F
+    uint32_t level_cx[LUMA_MAX_LEVELS];
+    uint32_t level_cy[LUMA_MAX_LEVELS];
+    int num_levels;
+    bool reduced;                 // The levels hold the last analysed input
+
+    gs_stagesurf_t *stage[LUMA_READBACK_SLOTS];
+    uint64_t staged_frame[LUMA_READBACK_SLOTS]; // 0 = nothing staged
+    uint64_t frame_count;
+    uint64_t sample_time;         // obs_get_video_frame_time() of the last readback
+};
+
+// Graphics thread only
+static gs_effect_t *luma_effect = NULL;
+static bool luma_effect_failed = false;
+static gs_eparam_t *param_image;
+static gs_eparam_t *param_texel;
+
+static bool luma_ensure_effect(void) {
+    if (luma_effect) return true;
+    if (luma_effect_failed) return false;
+
+    bool failed = false;
+    luma_effect = effect_cache_try_acquire(LUMA_REDUCE_SHADER, &failed);
+
+    // load_shader_effect may hand back the passthrough fallback
+    if (luma_effect && !gs_effect_get_technique(luma_effect, "ReduceLuma")) {
+        effect_cache_release(luma_effect);
+        luma_effect = NULL;
+        failed = true;
+    }
+
+    if (failed) {
+        luma_effect_failed = true;
+        PLUGIN_LOG_WARNING("luma-stats", "Reduction shader unavailable, auto modes use fixed values");
+    }
+    if (!luma_effect) return false;
+
+    param_image = gs_effect_get_param_by_name(luma_effect, "image");
+    param_texel = gs_effect_get_param_by_name(luma_effect, "texel");
+    return true;
+}
+
+static void free_levels(struct luma_probe *probe) {
+    for (int i = 0; i < probe->num_levels; i++) {
+        gs_texrender_destroy(probe->levels[i]);
+        probe->levels[i] = NULL;
+    }
+    probe->num_levels = 0;
+}
+
+// Sizes the pyramid for a width x height input; rebuilds it if that changes
+static bool ensure_levels(struct luma_probe *probe, uint32_t width, uint32_t height) {
+    uint32_t cx[LUMA_MAX_LEVELS], cy[LUMA_MAX_LEVELS];
+    int count = 0;
+    do {
+        width = (width + LUMA_REDUCE_FACTOR - 1) / LUMA_REDUCE_FACTOR;
+        height = (height + LUMA_REDUCE_FACTOR - 1) / LUMA_REDUCE_FACTOR;
+        cx[count] = width;
+        cy[count] = height;
+        count++;
+    } while ((width > LUMA_TOP_SIZE || height > LUMA_TOP_SIZE) && count < LUMA_MAX_LEVELS);
+
+    bool same = count == probe->num_levels;
+    for (int i = 0; same && i < count; i++) same = cx[i] == probe->level_cx[i] && cy[i] == probe->level_cy[i];
+    if (same) return true;
+
+    free_levels(probe);
+    for (int i = 0; i < count; i++) {
+        probe->levels[i] = gs_texrender_create(i == count - 1 ? GS_RG32F : GS_RG16F, GS_ZS_NONE);
+        probe->level_cx[i] = cx[i];
+        probe->level_cy[i] = cy[i];
+        probe->num_levels = i + 1;
+        if (!probe->levels[i]) return false;
+    }
+    return true;
+}
+
+// Folds one measurement into ed->luma, smoothed over the time since the last
+static void fold_sample(effect_data_t *ed, struct luma_probe *probe, float mean, float peak) {
+    uint64_t now = obs_get_video_frame_time();
+    luma_stats_t *stats = &ed->luma;
+
+    if (!stats->valid) {
+        stats->mean = mean;
+        stats->peak = peak;
+        stats->valid = true;
+    } else {
+        float blend = 1.0f - expf(-(float)(now - probe->sample_time) / LUMA_SMOOTHING_NS);
+        stats->mean += (mean - stats->mean) * blend;
+        stats->peak += (peak - stats->peak) * blend;
+    }
+    probe->sample_time = now;
+}
+
+// Maps the newest readback that is at least two frames old and folds it
+// into ed->luma
+static void collect_readback(effect_data_t *ed, struct luma_probe *probe) {
+    int slot = -1;
+    for (int i = 0; i < LUMA_READBACK_SLOTS; i++) {
+        if (probe->staged_frame[i] == 0 || probe->staged_frame[i] + 2 > probe->frame_count) continue;
+        if (slot < 0 || probe->staged_frame[i] > probe->staged_frame[slot]) slot = i;
+    }
+    if (slot < 0) return;
+
+    // Older ones are stale now
+    uint64_t taken = probe->staged_frame[slot];
+    for (int i = 0; i < LUMA_READBACK_SLOTS; i++) {
+        if (probe->staged_frame[i] <= taken) probe->staged_frame[i] = 0;
+    }
+
+    gs_stagesurf_t *stage = probe->stage[slot];
+    uint32_t cx = gs_stagesurface_get_width(stage);
+    uint32_t cy = gs_stagesurface_get_height(stage);
+    uint8_t *data;
+    uint32_t linesize;
+    if (!gs_stagesurface_map(stage, &data, &linesize)) return;
+
+    float sum = 0.0f, peak = 0.0f;
+    for (uint32_t y = 0; y < cy; y++) {
+        const float *row = (const float *)(data + (size_t)y * linesize);
+        for (uint32_t x = 0; x < cx; x++) {
+            sum += row[x * 2];
+            if (row[x * 2 + 1] > peak) peak = row[x * 2 + 1];
+        }
+    }
+    gs_stagesurface_unmap(stage);
+
+    fold_sample(ed, probe, sum / (float)(cx * cy), peak);
+}
+
+static bool reduce(struct luma_probe *probe, gs_texture_t *input, uint32_t width, uint32_t height) {
+    gs_texture_t *src = input;
+    uint32_t src_cx = width, src_cy = height;
+
+    for (int i = 0; i < probe->num_levels; i++) {
+        struct vec2 texel;
+        vec2_set(&texel, 1.0f / (float)src_cx, 1.0f / (float)src_cy);
+        gs_effect_set_vec2(param_texel, &texel);
+        gs_effect_set_texture(param_image, src);
+
+        if (!src || !render_pass_begin(probe->levels[i], probe->level_cx[i], probe->level_cy[i], false)) return false;
+        render_pass_draw(luma_effect, i == 0 ? "ReduceLuma" : "Reduce", probe->level_cx[i], probe->level_cy[i]);
+        gs_texrender_end(probe->levels[i]);
+
+        src = gs_texrender_get_texture(probe->levels[i]);
+        src_cx = probe->level_cx[i];
+        src_cy = probe->level_cy[i];
+    }
+    return src != NULL;
+}
+
+// Starts copying the top of the pyramid to a free stage surface
+static void stage_top(struct luma_probe *probe) {
+    int slot = 0;
+    for (int i = 0; i < LUMA_READBACK_SLOTS; i++) {
+        if (probe->staged_frame[i] == 0) {
+            slot = i;
+            break;
+        }
+        if (probe->staged_frame[i] < probe->staged_frame[slot]) slot = i;
+    }
+
+    int top = probe->num_levels - 1;
+    uint32_t cx = probe->level_cx[top], cy = probe->level_cy[top];
+    gs_stagesurf_t *stage = probe->stage[slot];
+    if (!stage || gs_stagesurface_get_width(stage) != cx || gs_stagesurface_get_height(stage) != cy) {
+        gs_stagesurface_destroy(stage);
+        stage = probe->stage[slot] = gs_stagesurface_create(cx, cy, GS_RG32F);
+        if (!stage) return;
+    }
+
+    gs_stage_texture(stage, gs_texrender_get_texture(probe->levels[top]));
+    probe->staged_frame[slot] = probe->frame_count;
+}
+
+// Measures `input` (the effect's input at width x height) for ed->luma.
+// The result lands in ed->luma two frames later, smoothed over time; call
+// once per frame from video_render while the effect needs it.
+void luma_probe_analyze(effect_data_t *ed, gs_texture_t *input, uint32_t width, uint32_t height) {
+    if (!ed || !input || width == 0 || height == 0 || !luma_ensure_effect()) return;
+
+    if (!ed->luma_probe) ed->luma_probe = bzalloc(sizeof(struct luma_probe));
+    struct luma_probe *probe = ed->luma_probe;
+    probe->frame_count++;
+    probe->reduced = false;
+
+    collect_readback(ed, probe);
+    if (!ensure_levels(probe, width, height)) return;
+
+    // The passes overwrite the shared effect's uniforms
+    effect_cache_claim(luma_effect, &luma_effect);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    bool reduced = reduce(probe, input, width, height);
+    gs_blend_state_pop();
+
+    probe->reduced = reduced;
+    if (reduced) {
+        stage_top(probe);
+    } else {
+        EFFECT_LOG_WARNING(ed, "Failed to reduce luminance (%ux%u)", width, height);
+    }
+}
+
+// Measures a frame the CPU path converted, for effects whose render is
+// skipped because filter_video applied them already. Unlike
+// luma_probe_analyze the result is in ed->luma straight away.
+void luma_stats_measure_frame(effect_data_t *ed, const cpu_image_t *image) {
+    if (!ed || !image || image->width == 0 || image->height == 0) return;
+    if (!ed->luma_probe) ed->luma_probe = bzalloc(sizeof(struct luma_probe));
+
+    float sum = 0.0f, peak = 0.0f;
+    size_t count = 0;
+    for (uint32_t y = 0; y < image->height; y += LUMA_FRAME_STEP) {
+        const uint32_t *row = image->pixels + (size_t)y * image->stride;
+        for (uint32_t x = 0; x < image->width; x += LUMA_FRAME_STEP) {
+            uint32_t texel = row[x];
+            float luminance = ((float)(texel & 0xFF) * 0.299f + (float)((texel >> 8) & 0xFF) * 0.587f +
+                               (float)((texel >> 16) & 0xFF) * 0.114f) / 255.0f;
+            sum += luminance;
+            if (luminance > peak) peak = luminance;
+            count++;
+        }
+    }
+    fold_sample(ed, ed->luma_probe, sum / (float)count, peak);
+}
+
+// The finest level of the last analysed input with both sides at most
+// max_size: mean luminance of each block in r, its peak in g. Blocks are
+// 4^n texels of the input wide, so sample it with linear filtering for a
+// smooth, cache friendly brightness lookup. NULL if luma_probe_analyze
+// hasn't succeeded.
+gs_texture_t *luma_probe_texture(const effect_data_t *ed, uint32_t max_size) {
+    const struct luma_probe *probe = ed ? ed->luma_probe : NULL;
+    if (!probe || !probe->reduced) return NULL;
+
+    for (int i = 0; i < probe->num_levels; i++) {
+        if (probe->level_cx[i] <= max_size && probe->level_cy[i] <= max_size) {
+            return gs_texrender_get_texture(probe->levels[i]);
+        }
+    }
+    return gs_texrender_get_texture(probe->levels[probe->num_levels - 1]);
+}
+
+// Renders the filter input into a texture of the probe and measures it, for
+// effects that otherwise draw straight from obs_source_process_filter_begin.
+// Returns the input texture, or NULL if it couldn't be rendered.
+gs_texture_t *luma_probe_capture(effect_data_t *ed, uint32_t width, uint32_t height) {
+    if (!ed) return NULL;
+    if (!ed->luma_probe) ed->luma_probe = bzalloc(sizeof(struct luma_probe));
+
+    struct luma_probe *probe = ed->luma_probe;
+    if (!render_filter_input(ed, ensure_render_target(ed, &probe->input), width, height)) return NULL;
+
+    gs_texture_t *input = gs_texrender_get_texture(probe->input);
+    luma_probe_analyze(ed, input, width, height);
+    return input;
+}
+
+// Graphics thread
+void luma_probe_free(effect_data_t *ed) {
+    struct luma_probe *probe = ed ? ed->luma_probe : NULL;
+    if (!probe) return;
+
+    gs_texrender_destroy(probe->input);
+    free_levels(probe);
+    for (int i = 0; i < LUMA_READBACK_SLOTS; i++) gs_stagesurface_destroy(probe->stage[i]);
+    bfree(probe);
+    ed->luma_probe = NULL;
+}
+
+// Releases the shader reference. Call from obs_module_unload, before
+// effect_cache_shutdown().
+void luma_stats_shutdown(void) {
+    obs_enter_graphics();
+    effect_cache_release(luma_effect);
+    luma_effect = NULL;
+    obs_leave_graphics();
+}
+
+// Luminance `fraction` of the way from the scene's mean to its peak: 0
+// follows the average, values near 1 leave only the brightest highlights.
+// `fallback` until the first measurement.
+float luma_stats_threshold(const luma_stats_t *stats, float fraction, float fallback) {
+    if (!stats || !stats->valid) return fallback;
+    return stats->mean + (stats->peak - stats->mean) * fraction;
+}
+
+// Scene brightness relative to mid grey, for intensities that should follow
+// exposure. 1 until the first measurement.
+float luma_stats_exposure(const luma_stats_t *stats) {
+    if (!stats || !stats->valid) return 1.0f;
+    float exposure = stats->mean / LUMA_MID_GREY;
+    if (exposure < 0.25f) exposure = 0.25f;
+    if (exposure > 2.0f) exposure = 2.0f;
+    return exposure;
+}
@@ -6,8 +6,177 @@
 #include "effect-core.h"
 #include "../utils/logging.h"
 #include <graphics/effect.h>
+#include <util/threading.h>
 #include <math.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// --- Parameter Store ---
+
+static uint32_t param_name_hash(const char *name) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (const char *p = name; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t name_table_size(size_t num_params) {
+    uint32_t size = 8;
+    while (size < num_params * 2) size <<= 1;
+    return size;
+}
+
+static size_t align_up(size_t offset, size_t align) {
+    return (offset + align - 1) & ~(align - 1);
+}
+
+// Lays the store out in `block` (NULL just measures). Returns the bytes used.
+static size_t param_store_layout(param_store_t *store, const effect_info_t *info, uint8_t *block) {
+    size_t n = info->num_params;
+    size_t counts[4] = {0}; // Indexed by param_type_t
+    for (size_t i = 0; i < n; i++) counts[info->params[i].type]++;
+
+    size_t words = (n + PARAM_DIRTY_WORD_BITS - 1) / PARAM_DIRTY_WORD_BITS;
+    uint32_t table_size = name_table_size(n);
+
+    // Widest alignment first so each array lands aligned
+    size_t offset = 0;
+    size_t handles_at = offset;   offset += sizeof(gs_eparam_t *) * n;
+    size_t dirty_at = offset;     offset += sizeof(long) * words;
+    size_t taken_at = offset;     offset += sizeof(unsigned long) * words;
+    size_t unapplied_at = offset; offset += sizeof(unsigned long) * words;
+    offset = align_up(offset, sizeof(float));
+    size_t floats_at[3], ints_at[3], colors_at[3], bools_at[3]; // front, back, scratch
+    for (int b = 0; b < 3; b++) {
+        floats_at[b] = offset;    offset += sizeof(float) * counts[PARAM_FLOAT];
+        ints_at[b] = offset;      offset += sizeof(int) * counts[PARAM_INT];
+        colors_at[b] = offset;    offset += sizeof(uint32_t) * counts[PARAM_COLOR];
+    }
+    size_t slots_at = offset;     offset += sizeof(uint16_t) * n;
+    size_t table_at = offset;     offset += sizeof(uint16_t) * table_size;
+    for (int b = 0; b < 3; b++) {
+        bools_at[b] = offset;     offset += sizeof(bool) * counts[PARAM_BOOL];
+    }
+    offset = align_up(offset, sizeof(void *));
+
+    if (block) {
+        store->handles = (gs_eparam_t **)(void *)(block + handles_at);
+        store->dirty = (volatile long *)(void *)(block + dirty_at);
+        store->taken = (unsigned long *)(void *)(block + taken_at);
+        store->unapplied = (unsigned long *)(void *)(block + unapplied_at);
+        param_values_t *banks[3] = {&store->front, &store->back, &store->scratch};
+        for (int b = 0; b < 3; b++) {
+            banks[b]->floats = (float *)(void *)(block + floats_at[b]);
+            banks[b]->ints = (int *)(void *)(block + ints_at[b]);
+            banks[b]->colors = (uint32_t *)(void *)(block + colors_at[b]);
+            banks[b]->bools = (bool *)(block + bools_at[b]);
+        }
+        store->slots = (uint16_t *)(void *)(block + slots_at);
+        store->name_table = (uint16_t *)(void *)(block + table_at);
+        store->name_mask = table_size - 1;
+        store->num_dirty_words = words;
+        for (int t = 0; t < 4; t++) store->counts[t] = (uint16_t)counts[t];
+    }
+    return offset;
+}
+
+// Bytes of zeroed memory param_store_init() needs for `info`
+size_t param_store_size(const effect_info_t *info) {
+    return param_store_layout(NULL, info, NULL);
+}
+
+// Points the store into `block` (zeroed, param_store_size() bytes) and
+// precomputes each parameter's slot and the name lookup table.
+void param_store_init(param_store_t *store, const effect_info_t *info, void *block) {
+    param_store_layout(store, info, block);
+
+    uint16_t next_slot[4] = {0};
+    for (size_t i = 0; i < info->num_params; i++) {
+        const param_def_t *def = &info->params[i];
+        store->slots[i] = next_slot[def->type]++;
+
+        uint32_t pos = param_name_hash(def->name) & store->name_mask;
+        while (store->name_table[pos]) pos = (pos + 1) & store->name_mask;
+        store->name_table[pos] = (uint16_t)(i + 1);
+    }
+}
+
+// Index of the parameter called `name`, or -1
+int param_store_find(const param_store_t *store, const effect_info_t *info, const char *name) {
+    uint32_t pos = param_name_hash(name) & store->name_mask;
+    for (uint16_t entry; (entry = store->name_table[pos]) != 0; pos = (pos + 1) & store->name_mask) {
+        if (strcmp(info->params[entry - 1].name, name) == 0) return entry - 1;
+    }
+    return -1;
+}
+
+static void dirty_word_set(volatile long *word, unsigned long bits) {
+    long old_val;
+    do {
+        old_val = *word;
+    } while (!os_atomic_compare_swap_long(word, old_val, (long)((unsigned long)old_val | bits)));
+}
+
+static void param_store_mark_dirty(param_store_t *store, size_t index) {
+    dirty_word_set(&store->dirty[index / PARAM_DIRTY_WORD_BITS], 1ul << (index % PARAM_DIRTY_WORD_BITS));
+}
+
+// Dirty bits for word `w` with every parameter set
+static unsigned long all_params_in_word(size_t w, size_t num_params) {
+    size_t remaining = num_params - w * PARAM_DIRTY_WORD_BITS;
+    if (remaining >= PARAM_DIRTY_WORD_BITS) return 0xFFFFFFFFul;
+    return (1ul << remaining) - 1;
+}
+
+// Queues every parameter for the next apply. Graphics thread.
+void param_store_mark_all_dirty(param_store_t *store, size_t num_params) {
+    for (size_t w = 0; w < store->num_dirty_words; w++) {
+        store->unapplied[w] = all_params_in_word(w, num_params);
+    }
+}
+
+// True while QUALITY_BUDGET_SETTING is on in the front values
+static bool param_store_governed(const param_store_t *store, const effect_info_t *info) {
+    int index = param_store_find(store, info, QUALITY_BUDGET_SETTING);
+    return index >= 0 && store->front.floats[store->slots[index]] > 0.0f;
+}
+
+// Builds the SPEC_ defines for the current PARAM_FLAG_SPECIALIZE values,
+// e.g. "#define SPEC_use_polygons true\n". Empty if the effect has none.
+// While the quality governor is on, the ones it may lower are left to
+// their uniforms: a new level must not wait on a variant compile.
+void param_store_variant_defines(const param_store_t *store, const effect_info_t *info, struct dstr *defines) {
+    bool governed = param_store_governed(store, info);
+    dstr_copy(defines, "");
+    for (size_t i = 0; i < info->num_params; i++) {
+        const param_def_t *def = &info->params[i];
+        if (!(def->flags & PARAM_FLAG_SPECIALIZE)) continue;
+        if (governed && (def->flags & PARAM_FLAG_QUALITY)) continue;
+
+        uint16_t slot = store->slots[i];
+        if (def->type == PARAM_BOOL) {
+            dstr_catf(defines, "#define SPEC_%s %s\n", def->name, store->front.bools[slot] ? "true" : "false");
+        } else if (def->type == PARAM_INT) {
+            dstr_catf(defines, "#define SPEC_%s %d\n", def->name, store->front.ints[slot]);
+        }
+    }
+}
+
+static inline unsigned lowest_set_bit(unsigned long bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctzl(bits);
+#endif
+}
+
+// --- Binding ---
+
 void bind_effect_parameters(effect_data_t *ed) {
     if (!ed || !ed->effect || !ed->info) return;
 
@@ -17,168 +186,348 @@ void bind_effect_parameters(effect_data_t *ed) {
     ed->param_uv_pixel_interval = gs_effect_get_param_by_name(ed->effect, "uv_pixel_interval");
     ed->param_elapsed_time = gs_effect_get_param_by_name(ed->effect, "elapsed_time");
 
-    // Dynamic Parameter Binding
-    if (ed->info->num_params > 0) {
-        // Free existing handles if any (though usually this starts empty)
-        if (ed->param_handles) {
-            bfree(ed->param_handles);
-            ed->param_handles = NULL;
+    // Reduced-resolution overlay support
+    ed->param_overlay_image = gs_effect_get_param_by_name(ed->effect, "overlay_image");
+    ed->param_overlay_size = gs_effect_get_param_by_name(ed->effect, "overlay_size");
+    ed->split_supported = (ed->info->flags & EFFECT_FLAG_SPLIT_OVERLAY) && !ed->is_member && ed->param_image &&
+                          ed->param_overlay_image && ed->param_overlay_size &&
+                          gs_effect_get_technique(ed->effect, "DrawOverlay") &&
+                          gs_effect_get_technique(ed->effect, "Composite");
+    if ((ed->info->flags & EFFECT_FLAG_SPLIT_OVERLAY) && !ed->is_member && !ed->split_supported) {
+        PLUGIN_LOG_WARNING("param-system", "[%s] Shader lacks overlay techniques, render scale disabled", ed->info->name);
+    }
+
+    // Dynamic Parameter Binding (handles live in the parameter store)
+    for (size_t i = 0; i < ed->info->num_params; i++) {
+        const char *param_name = ed->info->params[i].name;
+        if (ed->info->params[i].flags & PARAM_FLAG_NO_UNIFORM) continue;
+
+        ed->params.handles[i] = gs_effect_get_param_by_name(ed->effect, param_name);
+        
+        if (!ed->params.handles[i]) {
+            PLUGIN_LOG_WARNING("param-system", "[%s] Shader parameter '%s' not found", 
+                ed->info->name, param_name);
+        }
+    }
+}
+
+// --- Updates ---
+
+// Reads one settings item into the back values. Returns true if it changed.
+static bool update_param(param_store_t *store, const param_def_t *def, size_t index, obs_data_item_t *item) {
+    uint16_t slot = store->slots[index];
+    param_values_t *back = &store->back;
+
+    switch (def->type) {
+        case PARAM_FLOAT: {
+            double val = obs_data_item_get_double(item);
+            if (val < def->min) val = def->min;
+            if (val > def->max) val = def->max;
+
+            float fval = (float)val;
+            if (fabsf(fval - back->floats[slot]) <= 0.0001f) return false;
+            back->floats[slot] = fval;
+            return true;
         }
+        case PARAM_INT: {
+            long long val = obs_data_item_get_int(item);
+            if (val < (long long)def->min) val = (long long)def->min;
+            if (val > (long long)def->max) val = (long long)def->max;
 
-        // Allocate new handles with verification
-        ed->param_handles = bzalloc(sizeof(gs_eparam_t *) * ed->info->num_params);
-        if (!ed->param_handles) {
-            PLUGIN_LOG_ERROR("param-system", "%s: Failed to allocate parameter handles for %zu params", 
-                 ed->info->name, ed->info->num_params);
-            return;
+            int ival = (int)val;
+            if (ival == back->ints[slot]) return false;
+            back->ints[slot] = ival;
+            return true;
         }
-        
-        for (size_t i = 0; i < ed->info->num_params; i++) {
-            const char *param_name = ed->info->params[i].name;
-            ed->param_handles[i] = gs_effect_get_param_by_name(ed->effect, param_name);
-            
-            if (!ed->param_handles[i]) {
-                PLUGIN_LOG_WARNING("param-system", "[%s] Shader parameter '%s' not found", 
-                    ed->info->name, param_name);
-            }
+        case PARAM_BOOL: {
+            bool val = obs_data_item_get_bool(item);
+            if (val == back->bools[slot]) return false;
+            PLUGIN_LOG_DEBUG("param-trace", "Bool Param '%s' -> %d", def->name, val);
+            back->bools[slot] = val;
+            return true;
+        }
+        case PARAM_COLOR: {
+            uint32_t color_val = (uint32_t)obs_data_item_get_int(item);
+            if (color_val == back->colors[slot]) return false;
+            back->colors[slot] = color_val;
+            return true;
         }
     }
+    return false;
 }
 
 void generic_update(void *data, obs_data_t *settings) {
     effect_data_t *ed = data;
-    if (!ed || !ed->effect || !ed->info) return;
+    if (!ed || !ed->info) return;
 
-    bool any_changed = false;
+    os_atomic_inc_long(&ed->settings_serial); // Invalidates the render cache
 
-    // Iterate through metadata and update shader parameters based on type
-    for (size_t i = 0; i < ed->info->num_params; i++) {
-        const param_def_t *def = &ed->info->params[i];
-        gs_eparam_t *handle = ed->param_handles[i];
-        if (!handle) continue;
+    // One pass over the settings, matching names through the store's hash
+    // table, instead of one obs_data_get_* name search per parameter.
+    // Changed values, host-side settings included, are marked dirty for
+    // sync_effect_parameters(), which won't copy them while `seq` is odd.
+    size_t changed = 0;
+    os_atomic_inc_long(&ed->params.seq);
+    obs_data_item_t *item = obs_data_first(settings);
+    for (; item; obs_data_item_next(&item)) {
+        int index = param_store_find(&ed->params, ed->info, obs_data_item_get_name(item));
+        if (index < 0) continue;
 
-        // Robust Type Checking: Ensure we match the shader's expectation
-        enum gs_shader_param_type type = handle->type;
-        
-        bool param_changed = false;
+        const param_def_t *def = &ed->info->params[index];
+        if (update_param(&ed->params, def, (size_t)index, item)) {
+            param_store_mark_dirty(&ed->params, (size_t)index);
+            changed++;
+        }
+    }
+    os_atomic_inc_long(&ed->params.seq);
 
-        PLUGIN_LOG_DEBUG("param-trace", "Update param '%s': type=%d", def->name, (int)type);
+    if (changed > 0) {
+        PLUGIN_LOG_DEBUG("param-system", "%s: %zu parameters updated", ed->info->name, changed);
+    }
+}
 
-        switch (def->type) {
-            case PARAM_FLOAT: {
-                double val = obs_data_get_double(settings, def->name);
-                if (val < def->min) val = def->min;
-                if (val > def->max) val = def->max;
-                
-                float fval = (float)val;
-                
-                if (type == GS_SHADER_PARAM_FLOAT) {
-                    if (fabsf(fval - ed->cached_float_values[i]) > 0.0001f) {
-                        gs_effect_set_float(handle, fval);
-                        ed->cached_float_values[i] = fval;
-                        param_changed = true;
-                    }
-                } else if (type == GS_SHADER_PARAM_INT) {
-                     int ival = (int)val;
-                     if (ival != ed->cached_int_values[i]) {
-                        gs_effect_set_int(handle, ival);
-                        ed->cached_int_values[i] = ival;
-                        param_changed = true;
-                     }
-                }
-                break;
+// --- Apply ---
+
+static void apply_param(const param_store_t *store, const param_def_t *def, size_t index) {
+    gs_eparam_t *handle = store->handles[index];
+    if (!handle) return;
+
+    uint16_t slot = store->slots[index];
+    const param_values_t *front = &store->front;
+    enum gs_shader_param_type type = handle->type;
+
+    switch (def->type) {
+        case PARAM_FLOAT:
+            if (type == GS_SHADER_PARAM_FLOAT) {
+                gs_effect_set_float(handle, front->floats[slot]);
+            } else if (type == GS_SHADER_PARAM_INT) {
+                gs_effect_set_int(handle, (int)front->floats[slot]);
             }
-            case PARAM_INT: {
-                long long val = obs_data_get_int(settings, def->name);
-                if (val < (long long)def->min) val = (long long)def->min;
-                if (val > (long long)def->max) val = (long long)def->max;
-
-                int ival = (int)val;
-
-                if (type == GS_SHADER_PARAM_INT) {
-                    if (ival != ed->cached_int_values[i]) {
-                        gs_effect_set_int(handle, ival);
-                        ed->cached_int_values[i] = ival;
-                        param_changed = true;
-                    }
-                } else if (type == GS_SHADER_PARAM_FLOAT) {
-                    float fval = (float)val;
-                    if (fabsf(fval - ed->cached_float_values[i]) > 0.0001f) {
-                        gs_effect_set_float(handle, fval);
-                        ed->cached_float_values[i] = fval;
-                        param_changed = true;
-                    }
-                }
-                break;
+            break;
+        case PARAM_INT:
+            if (type == GS_SHADER_PARAM_INT) {
+                gs_effect_set_int(handle, front->ints[slot]);
+            } else if (type == GS_SHADER_PARAM_FLOAT) {
+                gs_effect_set_float(handle, (float)front->ints[slot]);
             }
-            case PARAM_BOOL: {
-                bool val = obs_data_get_bool(settings, def->name);
-                
-                if (val != ed->cached_bool_values[i]) {
-                    PLUGIN_LOG_DEBUG("param-trace", "Bool Param '%s' -> %d (Shader Type: %d)", def->name, val, type);
-                    if (type == GS_SHADER_PARAM_BOOL) {
-                        // Use set_int to match standard 4-byte bool expectation in GLSL/HLSL uniforms to verify size
-                        gs_effect_set_int(handle, val ? 1 : 0);
-                    } else if (type == GS_SHADER_PARAM_INT) {
-                        gs_effect_set_int(handle, val ? 1 : 0);
-                    } else if (type == GS_SHADER_PARAM_FLOAT) {
-                        gs_effect_set_float(handle, val ? 1.0f : 0.0f);
-                    }
-                    ed->cached_bool_values[i] = val;
-                    param_changed = true;
-                }
-                break;
+            break;
+        case PARAM_BOOL: {
+            bool val = front->bools[slot];
+            if (type == GS_SHADER_PARAM_BOOL || type == GS_SHADER_PARAM_INT) {
+                // Use set_int to match standard 4-byte bool expectation in GLSL/HLSL uniforms
+                gs_effect_set_int(handle, val ? 1 : 0);
+            } else if (type == GS_SHADER_PARAM_FLOAT) {
+                gs_effect_set_float(handle, val ? 1.0f : 0.0f);
             }
-            case PARAM_COLOR: {
-                long long val = obs_data_get_int(settings, def->name);
-                uint32_t color_val = (uint32_t)val;
-                
-                if (color_val != ed->cached_color_values[i]) {
-                    struct vec4 color_vec;
-                    vec4_from_rgba(&color_vec, color_val); // OBS math helper
-
-                    if (type == GS_SHADER_PARAM_VEC4) {
-                        gs_effect_set_vec4(handle, &color_vec);
-                    } else if (type == GS_SHADER_PARAM_INT) {
-                        gs_effect_set_int(handle, color_val);
-                    }
-                    ed->cached_color_values[i] = color_val;
-                    param_changed = true;
-                }
-                break;
+            break;
+        }
+        case PARAM_COLOR: {
+            uint32_t color_val = front->colors[slot];
+            if (type == GS_SHADER_PARAM_VEC4) {
+                struct vec4 color_vec;
+                vec4_from_rgba(&color_vec, color_val); // OBS math helper
+                gs_effect_set_vec4(handle, &color_vec);
+            } else if (type == GS_SHADER_PARAM_INT) {
+                gs_effect_set_int(handle, (int)color_val);
             }
+            break;
         }
-        
-        if (param_changed) any_changed = true;
     }
-    
-    if (any_changed) PLUGIN_LOG_DEBUG("param-system", "%s: Parameters updated", ed->info->name);
 }
 
-obs_properties_t *generic_properties(void *data) {
-    obs_properties_t *props = obs_properties_create();
-    effect_data_t *ed = data;
-    if (!ed || !ed->info) return props;
+// Lowers the PARAM_FLAG_QUALITY values in `front` to the governor's level.
+// When the level changed they are all queued for apply, whatever update
+// touched. None of them is in the variant while the governor is on (see
+// param_store_variant_defines), so a level it sets never needs a new one.
+static void lower_quality_params(effect_data_t *ed, bool level_changed) {
+    param_store_t *store = &ed->params;
+    param_values_t *front = &store->front;
+    int level = ed->quality_level;
 
-    // Generate UI from Metadata
     for (size_t i = 0; i < ed->info->num_params; i++) {
         const param_def_t *def = &ed->info->params[i];
-        
+        if (!(def->flags & PARAM_FLAG_QUALITY) || (def->flags & PARAM_FLAG_NO_UNIFORM)) continue;
+
+        uint16_t slot = store->slots[i];
+        switch (def->type) {
+            case PARAM_FLOAT:
+                front->floats[slot] = (float)quality_scale_value(def, front->floats[slot], level);
+                break;
+            case PARAM_INT:
+                front->ints[slot] = (int)quality_scale_value(def, front->ints[slot], level);
+                break;
+            case PARAM_BOOL:
+                front->bools[slot] = quality_scale_value(def, front->bools[slot] ? 1.0 : 0.0, level) >= 0.5;
+                break;
+            case PARAM_COLOR:
+                break;
+        }
+
+        if (level_changed) store->unapplied[i / PARAM_DIRTY_WORD_BITS] |= 1ul << (i % PARAM_DIRTY_WORD_BITS);
+    }
+    store->quality_level = level;
+}
+
+// Copies the latest update into the front values and queues the changed
+// parameters for apply. Once a frame on the graphics thread (generic_tick),
+// before anything reads them. `back` is copied to `scratch`, and the dirty
+// bits taken, before `seq` is checked again: unchanged, every bit taken
+// belongs to a copied value and `scratch` becomes `front`. If an update
+// raced the copy, the bits go back and `front` stays as it was until the
+// next frame. A new quality level (quality-governor.c) also forces a copy,
+// since the lowered values are derived from `back`. After a copy the
+// effect's params_synced refreshes whatever it keeps outside the store.
+void sync_effect_parameters(effect_data_t *ed) {
+    if (!ed || !ed->info) return;
+
+    param_store_t *store = &ed->params;
+    long seq = os_atomic_load_long(&store->seq);
+    bool level_changed = store->quality_level != ed->quality_level;
+    if ((seq == store->synced_seq && !level_changed) || (seq & 1)) return; // Unchanged, or next frame
+
+    memcpy(store->scratch.floats, store->back.floats, sizeof(float) * store->counts[PARAM_FLOAT]);
+    memcpy(store->scratch.ints, store->back.ints, sizeof(int) * store->counts[PARAM_INT]);
+    memcpy(store->scratch.colors, store->back.colors, sizeof(uint32_t) * store->counts[PARAM_COLOR]);
+    memcpy(store->scratch.bools, store->back.bools, sizeof(bool) * store->counts[PARAM_BOOL]);
+
+    for (size_t w = 0; w < store->num_dirty_words; w++) {
+        store->taken[w] = (unsigned long)os_atomic_exchange_long(&store->dirty[w], 0);
+    }
+
+    if (os_atomic_load_long(&store->seq) != seq) { // `scratch` may be torn
+        for (size_t w = 0; w < store->num_dirty_words; w++) {
+            if (store->taken[w]) dirty_word_set(&store->dirty[w], store->taken[w]);
+        }
+        return;
+    }
+
+    param_values_t previous = store->front;
+    store->front = store->scratch;
+    store->scratch = previous;
+    store->synced_seq = seq;
+
+    // Turning the budget on or off moves the governed values in or out of the variant
+    int budget = param_store_find(store, ed->info, QUALITY_BUDGET_SETTING);
+    bool respecialize = false;
+    for (size_t w = 0; w < store->num_dirty_words; w++) {
+        unsigned long bits = store->taken[w];
+        store->unapplied[w] |= bits;
+
+        while (bits) {
+            size_t index = w * PARAM_DIRTY_WORD_BITS + lowest_set_bit(bits);
+            bits &= bits - 1;
+            if ((ed->info->params[index].flags & PARAM_FLAG_SPECIALIZE) || (int)index == budget) respecialize = true;
+        }
+    }
+    lower_quality_params(ed, level_changed);
+    // Back at level 0 after the budget went off, the variant takes them again
+    if (level_changed && !param_store_governed(store, ed->info)) respecialize = true;
+
+    if (respecialize) os_atomic_set_bool(&ed->variant_stale, true);
+    os_atomic_inc_long(&ed->settings_serial); // What draws changed
+    if (ed->info->params_synced) ed->info->params_synced(ed);
+}
+
+// Uploads the parameters sync queued. The effect is shared between
+// instances, so everything is re-uploaded whenever another instance used it
+// since our last upload. Graphics thread.
+void apply_effect_parameters(effect_data_t *ed) {
+    if (!ed || !ed->effect || !ed->info) return;
+
+    bool owner_changed = effect_cache_claim(ed->effect, ed);
+    param_store_t *store = &ed->params;
+
+    for (size_t w = 0; w < store->num_dirty_words; w++) {
+        unsigned long bits = store->unapplied[w];
+        store->unapplied[w] = 0;
+        if (owner_changed) bits = all_params_in_word(w, ed->info->num_params);
+
+        while (bits) {
+            size_t index = w * PARAM_DIRTY_WORD_BITS + lowest_set_bit(bits);
+            bits &= bits - 1;
+            apply_param(store, &ed->info->params[index], index);
+        }
+    }
+}
+
+// --- Reads ---
+// Current values in `front` by name, for CPU code computing what the shader
+// would from the same table and for host-side settings. Unknown names read
+// as 0; ints and floats convert as apply_param does. Graphics thread.
+
+static int param_lookup(const effect_data_t *ed, const char *name, param_type_t *type) {
+    int index = (ed && ed->info) ? param_store_find(&ed->params, ed->info, name) : -1;
+    if (index < 0) return -1;
+
+    *type = ed->info->params[index].type;
+    return ed->params.slots[index];
+}
+
+float param_get_float(const effect_data_t *ed, const char *name) {
+    param_type_t type;
+    int slot = param_lookup(ed, name, &type);
+    if (slot < 0) return 0.0f;
+    if (type == PARAM_FLOAT) return ed->params.front.floats[slot];
+    if (type == PARAM_INT) return (float)ed->params.front.ints[slot];
+    return 0.0f;
+}
+
+int param_get_int(const effect_data_t *ed, const char *name) {
+    param_type_t type;
+    int slot = param_lookup(ed, name, &type);
+    if (slot < 0) return 0;
+    if (type == PARAM_INT) return ed->params.front.ints[slot];
+    if (type == PARAM_FLOAT) return (int)ed->params.front.floats[slot];
+    return 0;
+}
+
+bool param_get_bool(const effect_data_t *ed, const char *name) {
+    param_type_t type;
+    int slot = param_lookup(ed, name, &type);
+    return slot >= 0 && type == PARAM_BOOL && ed->params.front.bools[slot];
+}
+
+// 0xAABBGGRR, as vec4_from_rgba reads it
+uint32_t param_get_color(const effect_data_t *ed, const char *name) {
+    param_type_t type;
+    int slot = param_lookup(ed, name, &type);
+    return (slot >= 0 && type == PARAM_COLOR) ? ed->params.front.colors[slot] : 0;
+}
+
+// Adds a property per parameter of `info`. A non-NULL `prefix` is prepended
+// to each setting name, for effects hosted inside another filter.
+void add_param_properties(obs_properties_t *props, const effect_info_t *info, const char *prefix) {
+    if (!props || !info) return;
+
+    struct dstr name = {0};
+    for (size_t i = 0; i < info->num_params; i++) {
+        const param_def_t *def = &info->params[i];
+        dstr_printf(&name, "%s%s", prefix ? prefix : "", def->name);
+
         switch (def->type) {
             case PARAM_FLOAT:
-                obs_properties_add_float_slider(props, def->name, def->display_name, def->min, def->max, def->step);
+                obs_properties_add_float_slider(props, name.array, def->display_name, def->min, def->max, def->step);
                 break;
             case PARAM_INT:
-                obs_properties_add_int_slider(props, def->name, def->display_name, (int)def->min, (int)def->max, (int)def->step);
+                obs_properties_add_int_slider(props, name.array, def->display_name, (int)def->min, (int)def->max, (int)def->step);
                 break;
             case PARAM_BOOL:
-                obs_properties_add_bool(props, def->name, def->display_name);
+                obs_properties_add_bool(props, name.array, def->display_name);
                 break;
             case PARAM_COLOR:
-                obs_properties_add_color(props, def->name, def->display_name);
+                obs_properties_add_color(props, name.array, def->display_name);
                 break;
         }
     }
+    dstr_free(&name);
+}
 
+obs_properties_t *generic_properties(void *data) {
+    obs_properties_t *props = obs_properties_create();
+    effect_data_t *ed = data;
+    if (!ed || !ed->info) return props;
+
+    // Generate UI from Metadata
+    add_param_properties(props, ed->info, NULL);
     return props;
 }
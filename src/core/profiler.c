@@ -0,0 +1,368 @@
+/*
+ * src/core/profiler.c
+ * Rolling per-instance GPU and CPU timings (EMULENS_PROFILING builds only)
+ */
+
+#include "profiler.h"
+#include "../utils/logging.h"
+#include <util/threading.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef EMULENS_PROFILING_LOG_INTERVAL
+#define EMULENS_PROFILING_LOG_INTERVAL 0 // Seconds between log summaries, 0 = off
+#endif
+
+#define PROFILE_WINDOW 240      // Samples kept per metric, about 4 s at 60 fps
+#define PROFILE_GPU_QUERIES 4   // Frames a GPU timing may take to come back
+
+typedef enum {
+    METRIC_RENDER_GPU,
+    METRIC_RENDER_CPU,
+    METRIC_UPDATE_CPU,
+    METRIC_TICK_CPU,
+    NUM_METRICS
+} profile_metric_t;
+
+static const char *const metric_names[NUM_METRICS] = {
+    "render_gpu_ms", "render_cpu_ms", "update_cpu_ms", "tick_cpu_ms"
+};
+
+typedef struct {
+    float samples[PROFILE_WINDOW];  // Milliseconds, oldest overwritten first
+    size_t count;
+    size_t next;
+} profile_series_t;
+
+typedef struct {
+    float mean;
+    float p95;
+    float max;
+    size_t samples;
+} profile_summary_t;
+
+typedef struct {
+    gs_timer_range_t *range;  // Disjoint query and tick frequency (D3D11)
+    gs_timer_t *timer;
+    bool pending;             // Issued, result not read back yet
+} gpu_query_t;
+
+struct effect_profile {
+    struct effect_profile *next;
+    effect_data_t *ed;
+
+    // Guarded by profiler_mutex
+    profile_series_t series[NUM_METRICS];
+    uint32_t width, height;   // Last rendered size
+    struct dstr variant;      // Defines of the bound effect, see compact_variant()
+
+    // Graphics thread only
+    gpu_query_t queries[PROFILE_GPU_QUERIES];
+    size_t next_query;
+    gpu_query_t *armed;       // Query profiler_input_ready starts this render, if any
+    bool timing;              // Inside profiled_render, past the input
+    uint64_t own_start_ns;    // When the input was ready
+};
+
+static pthread_mutex_t profiler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct effect_profile *profiles = NULL;
+
+static float ms_since(uint64_t start_ns) {
+    return (float)((double)(os_gettime_ns() - start_ns) / 1000000.0);
+}
+
+// --- Statistics ---
+
+static void record_locked(struct effect_profile *profile, profile_metric_t metric, float ms) {
+    profile_series_t *series = &profile->series[metric];
+    series->samples[series->next] = ms;
+    series->next = (series->next + 1) % PROFILE_WINDOW;
+    if (series->count < PROFILE_WINDOW) series->count++;
+}
+
+static void record(struct effect_profile *profile, profile_metric_t metric, float ms) {
+    pthread_mutex_lock(&profiler_mutex);
+    record_locked(profile, metric, ms);
+    pthread_mutex_unlock(&profiler_mutex);
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+static profile_summary_t summarise(const profile_series_t *series) {
+    profile_summary_t summary = {0};
+    size_t n = series->count;
+    if (n == 0) return summary;
+
+    // Until the window wraps, samples [0, count) are the filled ones
+    float sorted[PROFILE_WINDOW];
+    memcpy(sorted, series->samples, n * sizeof(float));
+    qsort(sorted, n, sizeof(float), compare_floats);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += sorted[i];
+
+    summary.mean = (float)(sum / (double)n);
+    summary.p95 = sorted[(n * 95 + 99) / 100 - 1];
+    summary.max = sorted[n - 1];
+    summary.samples = n;
+    return summary;
+}
+
+// "#define SPEC_ExtendRays true\n#define SPEC_ColorizeRays false\n" becomes
+// "ExtendRays=true ColorizeRays=false"
+static void compact_variant(struct dstr *out, const struct dstr *defines) {
+    dstr_copy(out, defines->array ? defines->array : "");
+    dstr_replace(out, "#define SPEC_", "");
+    dstr_replace(out, " ", "=");
+    dstr_replace(out, "\n", " ");
+    dstr_depad(out);
+}
+
+// --- GPU timers ---
+
+static bool ensure_query(gpu_query_t *query) {
+    if (!query->range) query->range = gs_timer_range_create();
+    if (!query->timer) query->timer = gs_timer_create();
+    return query->range && query->timer;
+}
+
+// Reads back finished GPU timings. Queries still in flight are left for a
+// later frame, so measuring never waits on the GPU.
+static void collect_gpu_results(struct effect_profile *profile) {
+    for (size_t i = 0; i < PROFILE_GPU_QUERIES; i++) {
+        gpu_query_t *query = &profile->queries[i];
+        if (!query->pending) continue;
+
+        bool disjoint = false;
+        uint64_t frequency = 0;
+        uint64_t ticks = 0;
+        if (!gs_timer_range_get_data(query->range, &disjoint, &frequency)) continue;
+        if (!gs_timer_get_data(query->timer, &ticks)) continue;
+
+        query->pending = false;
+        if (!disjoint && frequency > 0) {
+            record(profile, METRIC_RENDER_GPU, (float)((double)ticks * 1000.0 / (double)frequency));
+        }
+    }
+}
+
+// --- Wrapped callbacks ---
+
+static void *profiled_create(obs_data_t *settings, obs_source_t *source) {
+    const effect_info_t *info = obs_source_get_type_data(source);
+    effect_data_t *ed = info->create(settings, source);
+    if (!ed) return NULL;
+
+    struct effect_profile *profile = bzalloc(sizeof(struct effect_profile));
+    profile->ed = ed;
+    ed->profile = profile;
+
+    pthread_mutex_lock(&profiler_mutex);
+    profile->next = profiles;
+    profiles = profile;
+    pthread_mutex_unlock(&profiler_mutex);
+    return ed;
+}
+
+static void profiled_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    struct effect_profile *profile = ed->profile;
+    if (profile) {
+        pthread_mutex_lock(&profiler_mutex);
+        for (struct effect_profile **link = &profiles; *link; link = &(*link)->next) {
+            if (*link == profile) {
+                *link = profile->next;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&profiler_mutex);
+
+        obs_enter_graphics();
+        for (size_t i = 0; i < PROFILE_GPU_QUERIES; i++) {
+            gs_timer_range_destroy(profile->queries[i].range);
+            gs_timer_destroy(profile->queries[i].timer);
+        }
+        obs_leave_graphics();
+
+        dstr_free(&profile->variant);
+        bfree(profile);
+        ed->profile = NULL;
+    }
+
+    ed->info->destroy(ed);
+}
+
+static void profiled_update(void *data, obs_data_t *settings) {
+    effect_data_t *ed = data;
+    uint64_t start_ns = os_gettime_ns();
+    ed->info->update(data, settings);
+    if (ed->profile) record(ed->profile, METRIC_UPDATE_CPU, ms_since(start_ns));
+}
+
+#if EMULENS_PROFILING_LOG_INTERVAL > 0
+static uint64_t last_log_ns = 0;
+
+static void log_summary_locked(void) {
+    struct dstr variant = {0};
+    for (struct effect_profile *p = profiles; p; p = p->next) {
+        profile_summary_t gpu = summarise(&p->series[METRIC_RENDER_GPU]);
+        profile_summary_t cpu = summarise(&p->series[METRIC_RENDER_CPU]);
+        compact_variant(&variant, &p->variant);
+        PLUGIN_LOG_INFO("profiler", "'%s' (%s) %ux%u: GPU %.2f/%.2f/%.2f ms, CPU %.2f/%.2f/%.2f ms (mean/p95/max) %s",
+                        obs_source_get_name(p->ed->context), p->ed->info->name, p->width, p->height,
+                        gpu.mean, gpu.p95, gpu.max, cpu.mean, cpu.p95, cpu.max,
+                        variant.array ? variant.array : "");
+    }
+    dstr_free(&variant);
+}
+#endif
+
+static void profiled_tick(void *data, float seconds) {
+    effect_data_t *ed = data;
+    uint64_t start_ns = os_gettime_ns();
+    ed->info->video_tick(data, seconds);
+    if (!ed->profile) return;
+
+    pthread_mutex_lock(&profiler_mutex);
+    record_locked(ed->profile, METRIC_TICK_CPU, ms_since(start_ns));
+#if EMULENS_PROFILING_LOG_INTERVAL > 0
+    // Whichever instance ticks first once the interval is up logs them all
+    if (start_ns - last_log_ns >= (uint64_t)EMULENS_PROFILING_LOG_INTERVAL * 1000000000ull) {
+        last_log_ns = start_ns;
+        log_summary_locked();
+    }
+#endif
+    pthread_mutex_unlock(&profiler_mutex);
+}
+
+void profiler_input_ready(effect_data_t *ed) {
+    struct effect_profile *profile = ed ? ed->profile : NULL;
+    if (!profile || profile->timing) return;
+
+    profile->timing = true;
+    profile->own_start_ns = os_gettime_ns();
+    if (profile->armed) {
+        gs_timer_range_begin(profile->armed->range);
+        gs_timer_begin(profile->armed->timer);
+    }
+}
+
+// Times the filter's own passes, from profiler_input_ready on: what draws
+// its input (the source, and the filters below it, EmuLens ones included)
+// is theirs. Frames it skips or draws from its render cache record nothing.
+static void profiled_render(void *data, gs_effect_t *effect) {
+    effect_data_t *ed = data;
+    struct effect_profile *profile = ed->profile;
+    if (!profile) {
+        effect_video_render(data, effect);
+        return;
+    }
+
+    collect_gpu_results(profile);
+
+    gpu_query_t *query = &profile->queries[profile->next_query];
+    profile->armed = !query->pending && ensure_query(query) ? query : NULL;
+    profile->timing = false;
+
+    effect_video_render(data, effect);
+
+    bool timed = profile->timing;
+    float cpu_ms = timed ? ms_since(profile->own_start_ns) : 0.0f;
+    if (timed && profile->armed) {
+        gs_timer_end(query->timer);
+        gs_timer_range_end(query->range);
+        query->pending = true;
+        profile->next_query = (profile->next_query + 1) % PROFILE_GPU_QUERIES;
+    }
+    profile->armed = NULL;
+    profile->timing = false;
+
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    const char *variant = ed->variant.array ? ed->variant.array : "";
+
+    pthread_mutex_lock(&profiler_mutex);
+    if (timed) record_locked(profile, METRIC_RENDER_CPU, cpu_ms);
+    profile->width = target ? obs_source_get_width(target) : 0;
+    profile->height = target ? obs_source_get_height(target) : 0;
+
+    if (strcmp(profile->variant.array ? profile->variant.array : "", variant) != 0) {
+        dstr_copy(&profile->variant, variant);
+    }
+    pthread_mutex_unlock(&profiler_mutex);
+}
+
+// --- Stats surface ---
+
+static obs_data_t *profile_to_data(const struct effect_profile *profile) {
+    obs_data_t *item = obs_data_create();
+    obs_data_set_string(item, "source", obs_source_get_name(profile->ed->context));
+    obs_data_set_string(item, "effect", profile->ed->info->id);
+    obs_data_set_int(item, "width", profile->width);
+    obs_data_set_int(item, "height", profile->height);
+    obs_data_set_int(item, "quality_level", profile->ed->quality_level);
+
+    struct dstr variant = {0};
+    compact_variant(&variant, &profile->variant);
+    obs_data_set_string(item, "variant", variant.array ? variant.array : "");
+    dstr_free(&variant);
+
+    for (size_t i = 0; i < NUM_METRICS; i++) {
+        profile_summary_t summary = summarise(&profile->series[i]);
+        obs_data_t *metric = obs_data_create();
+        obs_data_set_double(metric, "mean", summary.mean);
+        obs_data_set_double(metric, "p95", summary.p95);
+        obs_data_set_double(metric, "max", summary.max);
+        obs_data_set_int(metric, "samples", (long long)summary.samples);
+        obs_data_set_obj(item, metric_names[i], metric);
+        obs_data_release(metric);
+    }
+    return item;
+}
+
+// void emulens_stats(out string json): {"instances": [{"source", "effect",
+// "width", "height", "quality_level", "variant", "<metric>": {"mean", "p95",
+// "max", "samples"}}, ...]} over the last PROFILE_WINDOW samples of each
+// metric. render_* are the filter's own passes, without its input.
+static void proc_stats(void *data, calldata_t *cd) {
+    (void)data;
+    obs_data_t *root = obs_data_create();
+    obs_data_array_t *instances = obs_data_array_create();
+
+    pthread_mutex_lock(&profiler_mutex);
+    for (struct effect_profile *p = profiles; p; p = p->next) {
+        obs_data_t *item = profile_to_data(p);
+        obs_data_array_push_back(instances, item);
+        obs_data_release(item);
+    }
+    pthread_mutex_unlock(&profiler_mutex);
+
+    obs_data_set_array(root, "instances", instances);
+    calldata_set_string(cd, "json", obs_data_get_json(root));
+
+    obs_data_array_release(instances);
+    obs_data_release(root);
+}
+
+// --- Module ---
+
+void profiler_module_load(void) {
+    proc_handler_add(obs_get_proc_handler(), "void emulens_stats(out string json)", proc_stats, NULL);
+    PLUGIN_LOG_INFO("profiler", "Timing enabled, query with the emulens_stats proc");
+}
+
+void profiler_wrap_source_info(struct obs_source_info *source_info) {
+    const effect_info_t *info = source_info->type_data;
+    if (!info) return;
+
+    if (info->create) source_info->create = profiled_create;
+    if (info->destroy) source_info->destroy = profiled_destroy;
+    if (info->update) source_info->update = profiled_update;
+    if (info->video_tick) source_info->video_tick = profiled_tick;
+    if (info->video_render) source_info->video_render = profiled_render;
+}
@@ -0,0 +1,38 @@
+/*
+ * src/core/profiler.h
+ * Per-instance GPU and CPU timings, built with -DENABLE_PROFILING=ON.
+ * Without EMULENS_PROFILING every call below compiles to nothing.
+ */
+
+#pragma once
+
+#include "effect-core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef EMULENS_PROFILING
+
+// Registers the "emulens_stats" proc on the core proc handler
+void profiler_module_load(void);
+
+// Routes create/destroy/update/tick/render through timing wrappers that call
+// the effect_info_t callbacks, so every effect is measured the same way
+void profiler_wrap_source_info(struct obs_source_info *source_info);
+
+// Starts the render timings once the filter's input is drawn, see
+// effect_input_ready
+void profiler_input_ready(effect_data_t *ed);
+
+#else
+
+#define profiler_module_load() ((void)0)
+#define profiler_wrap_source_info(source_info) ((void)(source_info))
+#define profiler_input_ready(ed) ((void)(ed))
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
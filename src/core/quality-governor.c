@@ -0,0 +1,235 @@
+/*
+ * src/core/quality-governor.c
+ * Frame-budget quality governor: times each filter on the GPU and trades
+ * PARAM_FLAG_QUALITY parameters for time while it runs over its budget
+ */
+
+#include "effect-core.h"
+#include "profiler.h"
+#include "../utils/logging.h"
+#include <math.h>
+
+#define GOVERNOR_QUERIES 4          // Frames a GPU timing may take to come back
+#define GOVERNOR_SMOOTHING 0.1f     // Weight of each new sample in the running mean
+#define GOVERNOR_DEGRADE_FRAMES 15  // Samples over budget before stepping down
+#define GOVERNOR_RECOVER_FRAMES 180 // Samples with headroom before stepping up, about 3 s at 60 fps
+#define GOVERNOR_RECOVER_MAX (GOVERNOR_RECOVER_FRAMES * 16)
+#define GOVERNOR_HEADROOM 0.7f      // Step up only below this fraction of the budget
+
+// How much of the range above its minimum a PARAM_FLAG_QUALITY value keeps
+// at each level. Bools switch off from the first level that keeps < 0.5.
+static const float level_keep[QUALITY_LEVELS] = {1.0f, 0.7f, 0.45f, 0.25f};
+
+// Smallest render scale shift at each level for a governed RENDER_SCALE_SETTING
+static const int level_render_shift[QUALITY_LEVELS] = {0, 1, 1, RENDER_SCALE_MAX_SHIFT};
+
+typedef struct {
+    gs_timer_range_t *range;    // Disjoint query and tick frequency (D3D11)
+    gs_timer_t *timer;
+    bool pending;               // Issued, result not read back yet
+    int level;                  // Level of the values it was drawn with
+} governor_query_t;
+
+struct quality_governor {
+    governor_query_t queries[GOVERNOR_QUERIES];
+    size_t next_query;
+    float mean_ms;              // Smoothed GPU time at the current level, < 0 before a sample
+    uint32_t over;              // Consecutive samples over budget
+    uint32_t under;             // Consecutive samples with headroom
+    uint32_t recover_wait;      // Samples with headroom needed to step up
+    uint32_t since_step_up;     // Samples since the last step up
+    governor_query_t *armed;    // Query effect_input_ready starts this render, if any
+    bool timing;                // `armed` was started
+};
+
+// --- Scaling ---
+
+// `value` of a PARAM_FLAG_QUALITY parameter at `level`: lowered toward the
+// parameter's minimum and rounded down to its step. Other parameters, and level
+// 0, keep `value`.
+double quality_scale_value(const param_def_t *def, double value, int level) {
+    if (!def || !(def->flags & PARAM_FLAG_QUALITY) || level <= 0) return value;
+    if (level >= QUALITY_LEVELS) level = QUALITY_LEVELS - 1;
+
+    double keep = level_keep[level];
+    if (def->type == PARAM_BOOL) return keep < 0.5 ? 0.0 : value;
+    if (value <= def->min) return value;
+
+    double scaled = def->min + (value - def->min) * keep;
+    if (def->step > 0.0) scaled = def->min + floor((scaled - def->min) / def->step + 1e-6) * def->step;
+    return scaled;
+}
+
+// quality_scale_value() at the instance's current level, for quality
+// parameters the effect applies itself (PARAM_FLAG_NO_UNIFORM)
+double quality_setting(const effect_data_t *ed, const char *name, double value) {
+    if (!ed || ed->quality_level <= 0) return value;
+    int index = param_store_find(&ed->params, ed->info, name);
+    if (index < 0) return value;
+    return quality_scale_value(&ed->info->params[index], value, ed->quality_level);
+}
+
+// Render scale shift of the split overlay. Lowering the layer's resolution
+// is the opposite direction of quality_scale_value, so a RENDER_SCALE_SETTING
+// with PARAM_FLAG_QUALITY is raised here instead, at the level of the values
+// in `front`. Otherwise the setting as given.
+int quality_render_scale_shift(const effect_data_t *ed) {
+    int shift = param_get_int(ed, RENDER_SCALE_SETTING);
+    if (shift < 0) shift = 0;
+    if (shift > RENDER_SCALE_MAX_SHIFT) shift = RENDER_SCALE_MAX_SHIFT;
+
+    int level = ed->params.quality_level;
+    if (level <= 0) return shift;
+    if (level >= QUALITY_LEVELS) level = QUALITY_LEVELS - 1;
+
+    int index = param_store_find(&ed->params, ed->info, RENDER_SCALE_SETTING);
+    if (index < 0 || !(ed->info->params[index].flags & PARAM_FLAG_QUALITY)) return shift;
+    return shift > level_render_shift[level] ? shift : level_render_shift[level];
+}
+
+// --- Governor ---
+
+// QUALITY_BUDGET_SETTING in ms, 0 = off (also for effects without one)
+static float quality_budget_ms(const effect_data_t *ed) {
+    float budget = param_get_float(ed, QUALITY_BUDGET_SETTING);
+    return budget > 0.0f ? budget : 0.0f;
+}
+
+static void set_level(effect_data_t *ed, struct quality_governor *gov, int level, float mean_ms) {
+    PLUGIN_LOG_INFO("quality", "'%s' (%s): GPU %.2f ms against a %.2f ms budget, quality level %d -> %d",
+                    obs_source_get_name(ed->context), ed->info->name, mean_ms, quality_budget_ms(ed),
+                    ed->quality_level, level);
+
+    ed->quality_level = level; // Picked up by the next sync_effect_parameters
+    gov->mean_ms = -1.0f;
+    gov->over = 0;
+    gov->under = 0;
+}
+
+// One GPU time at the current level. Steps down after a run of samples
+// over budget. Steps up after a longer run with headroom; if that step up
+// overruns again soon after, the next one waits twice as long.
+static void governor_sample(effect_data_t *ed, struct quality_governor *gov, float ms) {
+    float budget = quality_budget_ms(ed);
+    gov->mean_ms = gov->mean_ms < 0.0f ? ms : gov->mean_ms + (ms - gov->mean_ms) * GOVERNOR_SMOOTHING;
+    if (gov->since_step_up < UINT32_MAX) gov->since_step_up++;
+
+    gov->over = gov->mean_ms > budget ? gov->over + 1 : 0;
+    gov->under = gov->mean_ms < budget * GOVERNOR_HEADROOM ? gov->under + 1 : 0;
+
+    if (gov->over >= GOVERNOR_DEGRADE_FRAMES && ed->quality_level < QUALITY_LEVELS - 1) {
+        if (gov->since_step_up < gov->recover_wait && gov->recover_wait < GOVERNOR_RECOVER_MAX) {
+            gov->recover_wait *= 2;
+        }
+        set_level(ed, gov, ed->quality_level + 1, gov->mean_ms);
+    } else if (gov->under >= gov->recover_wait && ed->quality_level > 0) {
+        gov->since_step_up = 0;
+        set_level(ed, gov, ed->quality_level - 1, gov->mean_ms);
+    }
+}
+
+static bool ensure_query(governor_query_t *query) {
+    if (!query->range) query->range = gs_timer_range_create();
+    if (!query->timer) query->timer = gs_timer_create();
+    return query->range && query->timer;
+}
+
+// Reads back finished timings without waiting on the GPU. Timings of
+// frames drawn at another level no longer say anything and are dropped.
+static void collect_results(effect_data_t *ed, struct quality_governor *gov) {
+    for (size_t i = 0; i < GOVERNOR_QUERIES; i++) {
+        governor_query_t *query = &gov->queries[i];
+        if (!query->pending) continue;
+
+        bool disjoint = false;
+        uint64_t frequency = 0;
+        uint64_t ticks = 0;
+        if (!gs_timer_range_get_data(query->range, &disjoint, &frequency)) continue;
+        if (!gs_timer_get_data(query->timer, &ticks)) continue;
+
+        query->pending = false;
+        if (disjoint || frequency == 0 || query->level != ed->quality_level) continue;
+        governor_sample(ed, gov, (float)((double)ticks * 1000.0 / (double)frequency));
+    }
+}
+
+// Without a budget only calls the effect's video_render; with one also
+// times it from effect_input_ready on, so the sources and filters below it,
+// which it can't make cheaper, don't count against its budget
+static void governed_render(effect_data_t *ed, gs_effect_t *effect) {
+    if (quality_budget_ms(ed) <= 0.0f) {
+        if (ed->quality_level != 0) {
+            ed->quality_level = 0;
+            if (ed->governor) ed->governor->mean_ms = -1.0f;
+        }
+        ed->info->video_render(ed, effect);
+        return;
+    }
+
+    struct quality_governor *gov = ed->governor;
+    if (!gov) {
+        gov = bzalloc(sizeof(struct quality_governor));
+        gov->mean_ms = -1.0f;
+        gov->recover_wait = GOVERNOR_RECOVER_FRAMES;
+        gov->since_step_up = UINT32_MAX;
+        ed->governor = gov;
+    }
+    collect_results(ed, gov);
+
+    governor_query_t *query = &gov->queries[gov->next_query];
+    gov->armed = !query->pending && ensure_query(query) ? query : NULL;
+    gov->timing = false;
+
+    ed->info->video_render(ed, effect);
+
+    // Not started if the filter skipped itself or drew from its cache
+    if (gov->timing) {
+        gs_timer_end(query->timer);
+        gs_timer_range_end(query->range);
+        query->pending = true;
+        query->level = ed->params.quality_level;
+        gov->next_query = (gov->next_query + 1) % GOVERNOR_QUERIES;
+    }
+    gov->armed = NULL;
+}
+
+// Call once the filter's input has been drawn: at the end of
+// render_filter_input, or after obs_source_process_filter_begin. Starts the
+// governor's and the profiler's timers, so they cover only the filter's own
+// passes. Later calls in the same render do nothing. Graphics thread.
+void effect_input_ready(effect_data_t *ed) {
+    struct quality_governor *gov = ed ? ed->governor : NULL;
+    if (gov && gov->armed && !gov->timing) {
+        gs_timer_range_begin(gov->armed->range);
+        gs_timer_begin(gov->armed->timer);
+        gov->timing = true;
+    }
+    profiler_input_ready(ed);
+}
+
+// video_render for every effect. Shaders work on the values as stored in
+// the filter's colour space (see effect_color_space), so whatever the
+// caller left on, nothing encodes on writing while the effect draws. Sources
+// drawn as its input still set their own state. Graphics thread.
+void effect_video_render(void *data, gs_effect_t *effect) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    bool previous_srgb = gs_framebuffer_srgb_enabled();
+    gs_enable_framebuffer_srgb(false);
+    governed_render(ed, effect);
+    gs_enable_framebuffer_srgb(previous_srgb);
+}
+
+// Graphics thread
+void quality_governor_free(effect_data_t *ed) {
+    struct quality_governor *gov = ed ? ed->governor : NULL;
+    if (!gov) return;
+
+    for (size_t i = 0; i < GOVERNOR_QUERIES; i++) {
+        gs_timer_range_destroy(gov->queries[i].range);
+        gs_timer_destroy(gov->queries[i].timer);
+    }
+    bfree(gov);
+    ed->governor = NULL;
+}
@@ -0,0 +1,139 @@
+/*
+ * src/core/render-cache.c
+ * Render elision: filters that are a no-op skip themselves, and effects
+ * whose output depends only on their input and settings redraw their last
+ * output while neither changed
+ */
+
+#include "effect-core.h"
+#include "../utils/logging.h"
+
+struct render_cache {
+    gs_texrender_t *output;     // What video_render drew, at the input's size
+    uint32_t cx;
+    uint32_t cy;
+    uint64_t frame_serial;      // ed->frame_serial it was drawn from
+    long settings_serial;       // ed->settings_serial it was drawn with
+    gs_effect_t *effect;        // Effect (variant) it was drawn with
+    bool valid;
+    bool filling;               // Inside the video_render that fills it
+};
+
+// filter_video for every effect. Counts async frames, which is how the
+// cache knows the input changed, then runs the CPU path if the effect has
+// one and isn't an identity. Graphics thread, before the chain renders.
+struct obs_source_frame *effect_filter_video(void *data, struct obs_source_frame *frame) {
+    effect_data_t *ed = data;
+    if (!ed || !frame) return frame;
+
+    ed->frame_serial++;
+    if (ed->info->is_identity && ed->info->is_identity(ed)) {
+        ed->cpu_active = false;
+        return frame;
+    }
+    return cpu_filter_video(data, frame);
+}
+
+// True while the filter is in a scene that is on program or preview
+bool effect_is_showing(const effect_data_t *ed) {
+    return ed && ed->context && obs_source_showing(ed->context);
+}
+
+// The input only changes when a new frame arrives (counted by
+// effect_filter_video) if the filter is first in the chain of an async
+// source that draws frames as they are. Sets cx x cy to the input size.
+static bool render_cache_usable(effect_data_t *ed, uint32_t *cx, uint32_t *cy) {
+    if (ed->is_member || !ed->info->is_static || ed->frame_serial == 0) return false;
+    if (!ed->effect || os_atomic_load_bool(&ed->variant_stale)) return false;
+
+    obs_source_t *parent = obs_filter_get_parent(ed->context);
+    if (!parent || obs_filter_get_target(ed->context) != parent) return false;
+    if (!(obs_source_get_output_flags(parent) & OBS_SOURCE_ASYNC)) return false;
+    if (obs_source_get_deinterlace_mode(parent) != OBS_DEINTERLACE_MODE_DISABLE) return false;
+
+    // The cache is 8-bit; HDR output and float inputs render every frame
+    if (gs_get_color_space() != GS_CS_SRGB || effect_color_space(ed) != GS_CS_SRGB) return false;
+
+    *cx = obs_source_get_width(parent);
+    *cy = obs_source_get_height(parent);
+    return *cx > 0 && *cy > 0 && ed->info->is_static(ed);
+}
+
+// Runs video_render into the cache with replace blending, so drawing the
+// cache later under the caller's blend state gives the same result
+static bool render_cache_fill(effect_data_t *ed, struct render_cache *cache, uint32_t cx, uint32_t cy) {
+    if (!cache->output) cache->output = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+    bool drawn = render_pass_begin(cache->output, cx, cy, true);
+    if (drawn) {
+        cache->filling = true;
+        ed->info->video_render(ed, NULL);
+        cache->filling = false;
+        gs_texrender_end(cache->output);
+    }
+    gs_blend_state_pop();
+
+    cache->valid = drawn;
+    cache->cx = cx;
+    cache->cy = cy;
+    cache->frame_serial = ed->frame_serial;
+    cache->settings_serial = os_atomic_load_long(&ed->settings_serial);
+    cache->effect = ed->effect;
+    if (!drawn) EFFECT_LOG_WARNING(ed, "Failed to begin render cache (%ux%u)", cx, cy);
+    return drawn;
+}
+
+// Draws the cached output, refilling it first if the input, settings or
+// effect changed. Returns false if the effect should render normally.
+static bool render_cache_draw(effect_data_t *ed) {
+    uint32_t cx = 0, cy = 0;
+    if (!render_cache_usable(ed, &cx, &cy)) {
+        if (ed->cache) ed->cache->valid = false;
+        return false;
+    }
+
+    if (!ed->cache) ed->cache = bzalloc(sizeof(struct render_cache));
+    struct render_cache *cache = ed->cache;
+
+    bool hit = cache->valid && cache->cx == cx && cache->cy == cy && cache->frame_serial == ed->frame_serial &&
+               cache->settings_serial == os_atomic_load_long(&ed->settings_serial) && cache->effect == ed->effect;
+    if (!hit && !render_cache_fill(ed, cache, cx, cy)) return false;
+
+    gs_texture_t *texture = gs_texrender_get_texture(cache->output);
+    if (!texture) return false;
+
+    gs_effect_t *draw = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_effect_set_texture(gs_effect_get_param_by_name(draw, "image"), texture);
+    while (gs_effect_loop(draw, "Draw")) {
+        gs_draw_sprite(texture, 0, cx, cy);
+    }
+    return true;
+}
+
+// Call first in video_render. Returns true when the frame was handled
+// without running the effect: already filtered on the CPU, an identity
+// (input passed through) or drawn from the cache.
+bool render_elide(effect_data_t *ed) {
+    if (!ed) return true;
+    if (ed->cache && ed->cache->filling) return false;
+    if (cpu_filter_skip_render(ed)) return true;
+
+    if (ed->info->is_identity && ed->info->is_identity(ed)) {
+        obs_source_skip_video_filter(ed->context);
+        return true;
+    }
+
+    return render_cache_draw(ed);
+}
+
+// Graphics context
+void render_cache_free(effect_data_t *ed) {
+    if (!ed || !ed->cache) return;
+
+    gs_texrender_destroy(ed->cache->output);
+    bfree(ed->cache);
+    ed->cache = NULL;
+}
@@ -0,0 +1,171 @@
+/*
+ * src/core/render-passes.c
+ * Helpers for effects that render through intermediate targets
+ */
+
+#include "effect-core.h"
+#include "../utils/logging.h"
+#include <util/threading.h>
+
+// --- Colour spaces ---
+
+// Spaces a filter can render in without OBS converting around it
+static const enum gs_color_space filter_spaces[] = {GS_CS_SRGB, GS_CS_SRGB_16F, GS_CS_709_EXTENDED};
+
+// The colour space of the filter's input, which it also renders and outputs
+// in: GS_CS_SRGB for 8-bit SDR sources, a float space for HDR and high bit
+// depth ones, so OBS converts nothing on either side of the filter
+enum gs_color_space effect_color_space(const effect_data_t *ed) {
+    obs_source_t *target = ed ? obs_filter_get_target(ed->context) : NULL;
+    if (!target) return GS_CS_SRGB;
+    return obs_source_get_color_space(target, sizeof(filter_spaces) / sizeof(filter_spaces[0]), filter_spaces);
+}
+
+// video_get_color_space for every effect
+enum gs_color_space effect_get_color_space(void *data, size_t count, const enum gs_color_space *preferred_spaces) {
+    (void)count;
+    (void)preferred_spaces;
+    return effect_color_space(data);
+}
+
+// Returns *target, (re)created in the format of the filter's colour space,
+// so a copy of an HDR or high bit depth input keeps its range
+gs_texrender_t *ensure_render_target(effect_data_t *ed, gs_texrender_t **target) {
+    enum gs_color_format format = gs_get_format_from_space(effect_color_space(ed));
+    if (*target && gs_texrender_get_format(*target) != format) {
+        gs_texrender_destroy(*target);
+        *target = NULL;
+    }
+    if (!*target) *target = gs_texrender_create(format, GS_ZS_NONE);
+    return *target;
+}
+
+// Renders the filter's input into `target` at cx x cy (scaled to fit).
+// Must be called from video_render; replaces obs_source_process_filter_begin
+// for effects that need the input as a texture across several passes.
+// Targets from ensure_render_target get the input in the filter's colour
+// space; 8-bit ones get OBS's SDR conversion of it. Timing of the filter's
+// own work starts once this returns true (effect_input_ready).
+bool render_filter_input(effect_data_t *ed, gs_texrender_t *target, uint32_t cx, uint32_t cy) {
+    if (!ed || !target || cx == 0 || cy == 0) return false;
+
+    obs_source_t *source = obs_filter_get_target(ed->context);
+    obs_source_t *parent = obs_filter_get_parent(ed->context);
+    if (!source || !parent) return false;
+
+    uint32_t width = obs_source_get_width(source);
+    uint32_t height = obs_source_get_height(source);
+    if (width == 0 || height == 0) return false;
+
+    enum gs_color_space space = gs_texrender_get_format(target) == GS_RGBA ? GS_CS_SRGB : effect_color_space(ed);
+
+    gs_texrender_reset(target);
+    if (!gs_texrender_begin_with_color_space(target, cx, cy, space)) {
+        EFFECT_LOG_WARNING(ed, "Failed to begin input capture (%ux%u)", cx, cy);
+        return false;
+    }
+
+    struct vec4 clear_color;
+    vec4_zero(&clear_color);
+    gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+    gs_ortho(0.0f, (float)width, 0.0f, (float)height, -100.0f, 100.0f);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+    // Same dispatch obs_source_process_filter_begin uses for its own copy
+    uint32_t flags = obs_source_get_output_flags(source);
+    bool custom_draw = (flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
+    bool async = (flags & OBS_SOURCE_ASYNC) != 0;
+
+    if (source == parent && !custom_draw && !async) {
+        obs_source_default_render(source);
+    } else {
+        obs_source_video_render(source);
+    }
+
+    gs_blend_state_pop();
+    gs_texrender_end(target);
+    effect_input_ready(ed);
+    return true;
+}
+
+// Begins an intermediate pass into `target`; pair with gs_texrender_end().
+// Keeping `clear` false preserves the previous contents for accumulation.
+bool render_pass_begin(gs_texrender_t *target, uint32_t cx, uint32_t cy, bool clear) {
+    if (!target || cx == 0 || cy == 0) return false;
+
+    gs_texrender_reset(target);
+    if (!gs_texrender_begin(target, cx, cy)) return false;
+
+    if (clear) {
+        struct vec4 clear_color;
+        vec4_zero(&clear_color);
+        gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+    }
+
+    gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+    return true;
+}
+
+// Draws a full-target quad with the given technique. Textures and uniforms
+// must already be set on the effect.
+void render_pass_draw(gs_effect_t *effect, const char *technique, uint32_t cx, uint32_t cy) {
+    if (!effect || !technique) return;
+
+    while (gs_effect_loop(effect, technique)) {
+        gs_draw_sprite(NULL, 0, cx, cy);
+    }
+}
+
+// Renders the effect's generated layer at 1 / (1 << quality_render_scale_shift)
+// size with the DrawOverlay technique, then draws the Composite technique at
+// full size, which upsamples the layer (overlay_image) over the input.
+// Returns false without drawing anything if the intermediate passes fail.
+bool render_split_overlay(effect_data_t *ed, uint32_t cx, uint32_t cy) {
+    if (!ed || !ed->effect || !ed->split_supported || cx == 0 || cy == 0) return false;
+
+    int shift = quality_render_scale_shift(ed);
+    uint32_t round_up = (1u << shift) - 1;
+    uint32_t overlay_cx = (cx + round_up) >> shift;
+    uint32_t overlay_cy = (cy + round_up) >> shift;
+
+    ensure_render_target(ed, &ed->split_input);
+    if (!ed->split_overlay) ed->split_overlay = gs_texrender_create(GS_RGBA16F, GS_ZS_NONE);
+
+    if (!render_filter_input(ed, ed->split_input, cx, cy)) return false;
+    gs_texture_t *input = gs_texrender_get_texture(ed->split_input);
+    if (!input) return false;
+    if (ed->luma_wanted) luma_probe_analyze(ed, input, cx, cy);
+
+    // The layer is evaluated at fewer points, but uniforms still describe
+    // the full-size image so shapes and pixel offsets don't change with scale
+    generic_prepare_draw(ed, (float)cx, (float)cy);
+    gs_effect_set_texture(ed->param_image, input);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    bool drawn = render_pass_begin(ed->split_overlay, overlay_cx, overlay_cy, true);
+    if (drawn) {
+        render_pass_draw(ed->effect, "DrawOverlay", overlay_cx, overlay_cy);
+        gs_texrender_end(ed->split_overlay);
+    }
+    gs_blend_state_pop();
+
+    gs_texture_t *overlay = drawn ? gs_texrender_get_texture(ed->split_overlay) : NULL;
+    if (!overlay) {
+        EFFECT_LOG_WARNING(ed, "Failed to render overlay (%ux%u)", overlay_cx, overlay_cy);
+        return false;
+    }
+
+    struct vec2 overlay_size;
+    vec2_set(&overlay_size, (float)overlay_cx, (float)overlay_cy);
+    gs_effect_set_texture(ed->param_image, input);
+    gs_effect_set_texture(ed->param_overlay_image, overlay);
+    gs_effect_set_vec2(ed->param_overlay_size, &overlay_size);
+
+    while (gs_effect_loop(ed->effect, "Composite")) {
+        gs_draw_sprite(input, 0, cx, cy);
+    }
+    return true;
+}
@@ -67,6 +67,14 @@ bool is_valid_shader_path(const char *path) {
     return true;
 }
 
+static uint32_t variant_hash(const char *defines) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (const char *p = defines; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 16777619u;
+    }
+    return h;
+}
+
 gs_effect_t *load_shader_effect(const char *shader_path) {
     VALIDATE_POINTER_RETURN(shader_path, "shader-loader", NULL);
 
@@ -115,3 +123,53 @@ gs_effect_t *load_shader_effect(const char *shader_path) {
     
     return effect;
 }
+
+// Compiles `shader_path` with `defines` (preprocessor lines) prepended, for
+// PARAM_FLAG_SPECIALIZE variants. Returns NULL if the variant doesn't
+// compile; callers keep using the plain effect, which reads the same values
+// from uniforms. Must be called inside obs_enter_graphics().
+gs_effect_t *load_shader_variant(const char *shader_path, const char *defines) {
+    if (!defines || !*defines) return load_shader_effect(shader_path);
+    VALIDATE_POINTER_RETURN(shader_path, "shader-loader", NULL);
+
+    if (!is_valid_shader_path(shader_path)) {
+        PLUGIN_LOG_ERROR("shader-loader", "Invalid shader path: %s", shader_path);
+        return NULL;
+    }
+
+    obs_module_t *module = obs_get_module("obs-emulens");
+    char *full_path = obs_find_module_file(module, shader_path);
+    char *source = full_path ? os_quick_read_utf8_file(full_path) : NULL;
+    if (!source) {
+        PLUGIN_LOG_ERROR("shader-loader", "Could not read shader file: %s", shader_path);
+        bfree(full_path);
+        return NULL;
+    }
+
+    struct dstr text = {0};
+    dstr_copy(&text, defines);
+    dstr_cat(&text, source);
+    bfree(source);
+
+    // libobs caches effects by file name, so each variant gets its own; the
+    // directory part is unchanged so #include still resolves next to it
+    struct dstr name = {0};
+    dstr_printf(&name, "%s#%08x", full_path, variant_hash(defines));
+    bfree(full_path);
+
+    char *error_string = NULL;
+    gs_effect_t *effect = gs_effect_create(text.array, name.array, &error_string);
+    dstr_free(&text);
+    dstr_free(&name);
+
+    if (error_string || !effect) {
+        PLUGIN_LOG_ERROR("shader-loader", "Variant of %s failed to compile: %s", shader_path,
+                         error_string ? error_string : "unknown error");
+        bfree(error_string);
+        if (effect) gs_effect_destroy(effect);
+        return NULL;
+    }
+
+    PLUGIN_LOG_INFO("shader-loader", "Compiled variant of %s", shader_path);
+    return effect;
+}
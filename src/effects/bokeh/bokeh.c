@@ -3,42 +3,817 @@
  */
 
 #include "bokeh.h"
+#include "../../utils/logging.h"
+#include <util/threading.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BOKEH_SPRITES_SHADER "shaders/bokeh-sprites.shader"
+#define BOKEH_PI 3.14159265359f
+#define SPRITE_VERTS 6  // Two triangles per particle, no index buffer
+#define BOKEH_LUMA_MAX_SIZE 128 // Brightness lookups read a luminance level at most this big
+#define HIGHLIGHT_GRID_SIZE 128 // Long side of the bright pass, in blocks of the input
+#define HIGHLIGHT_READBACK_SLOTS 3 // Staged on frame n, mapped on frame n + 2
+#define AUTO_HIGHLIGHT_FRACTION 0.8f // Of the way from mean to peak scene luminance
+
+enum bokeh_mode {
+    BOKEH_MODE_CELLS = 0,     // Per-pixel neighbour cell search (bokeh.shader)
+    BOKEH_MODE_SPRITES = 1,   // CPU simulated particles drawn as quads (bokeh-sprites.shader)
+    BOKEH_MODE_HIGHLIGHTS = 2 // Quads on the source's bright spots (bokeh-sprites.shader)
+};
 
 static const param_def_t bokeh_params[] = {
-    {"particle_density", "Density", "Particle count density", PARAM_FLOAT, {.f_val=25.0}, 1.0, 100.0, 1.0},
-    {"particle_base_size", "Size", "Base particle size", PARAM_FLOAT, {.f_val=0.05}, 0.001, 0.2, 0.001},
-    {"particle_size_variation", "Size Variation", "Randomizes particle size", PARAM_FLOAT, {.f_val=0.5}, 0.0, 1.0, 0.01},
-    {"animation_speed", "Animation Speed", "Speed of the effect", PARAM_FLOAT, {.f_val=0.3}, 0.0, 5.0, 0.01},
-    {"particle_color_start", "Color Start", "Particle color at start of life", PARAM_COLOR, {.i_val=0xCCFFCCCC}, 0, 0, 0}, // approx 0.8, 0.8, 1.0, 0.8 (RGBA) -> ABGR? OBS uses 0xAABBGGRR usually? No, OBS color is often 0xFFRRGGBB or ABGR.
+    {"particle_density", "Density", "Particle count density", PARAM_FLOAT, {.f_val=25.0}, 1.0, 100.0, 1.0, 0},
+    {"particle_base_size", "Size", "Base particle size", PARAM_FLOAT, {.f_val=0.05}, 0.001, 0.2, 0.001, 0},
+    {"particle_size_variation", "Size Variation", "Randomizes particle size", PARAM_FLOAT, {.f_val=0.5}, 0.0, 1.0, 0.01, 0},
+    {"animation_speed", "Animation Speed", "Speed of the effect", PARAM_FLOAT, {.f_val=0.3}, 0.0, 5.0, 0.01, 0},
+    {"particle_color_start", "Color Start", "Particle color at start of life", PARAM_COLOR, {.i_val=0xCCFFCCCC}, 0, 0, 0, 0}, // approx 0.8, 0.8, 1.0, 0.8 (RGBA) -> ABGR? OBS uses 0xAABBGGRR usually? No, OBS color is often 0xFFRRGGBB or ABGR.
     // defaults: 0.8, 0.8, 1.0, 0.8. In hex (ARGB): 0xCC CCCC FF. 
     // OBS `obs_data_set_default_int` for color usually takes 0xBBGGRR or 0xAABBGGRR.
     // Let's assume standard integer color. 
-    {"particle_color_end", "Color End", "Particle color at end of life", PARAM_COLOR, {.i_val=0x00803333}, 0, 0, 0},
-
-    {"enable_source_brightness_affect", "Source Brightness Affect", "Particles affected by source brightness", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"source_brightness_strength", "Brightness Strength", "Strength of source brightness effect", PARAM_FLOAT, {.f_val=0.75}, 0.0, 1.0, 0.01},
-    {"source_brightness_threshold", "Brightness Threshold", "Threshold for source brightness", PARAM_FLOAT, {.f_val=0.2}, 0.0, 1.0, 0.01},
-
-    {"focus_point_x", "Focus X", "Focus Point X", PARAM_FLOAT, {.f_val=0.5}, -0.5, 1.5, 0.01},
-    {"focus_point_y", "Focus Y", "Focus Point Y", PARAM_FLOAT, {.f_val=0.5}, -0.5, 1.5, 0.01},
-    {"focus_strength", "Focus Strength", "Blur falloff from focus", PARAM_FLOAT, {.f_val=2.0}, 0.0, 10.0, 0.1},
-    {"motion_blur_amount", "Motion Blur", "Trail/Motion blur amount", PARAM_FLOAT, {.f_val=0.1}, 0.0, 0.95, 0.01},
-    {"bokeh_edge_softness", "Softness", "Bokeh shape edge softness", PARAM_FLOAT, {.f_val=0.5}, 0.0, 1.0, 0.01},
-
-    {"use_polygons", "Use Polygons", "Use polygonal shapes instead of circles", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"poly_sides", "Polygon Sides", "Number of sides for polygon", PARAM_INT, {.i_val=6}, 3, 10, 1},
-    {"poly_rotation", "Polygon Rotation", "Static rotation of polygons", PARAM_FLOAT, {.f_val=0.0}, 0.0, 360.0, 1.0},
-    {"poly_rotation_speed", "Rotation Speed", "Speed of polygon rotation", PARAM_FLOAT, {.f_val=0.0}, -360.0, 360.0, 1.0},
-
-    {"enable_chromatic_aberration", "Chromatic Aberration", "Enable CA", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"ca_strength", "CA Strength", "Chromatic Aberration Amount", PARAM_FLOAT, {.f_val=2.0}, 0.0, 10.0, 0.1},
-
-    {"enable_onion_rings", "Onion Rings", "Enable Onion Ring artifact", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"onion_ring_frequency", "Ring Frequency", "Frequency of onion rings", PARAM_FLOAT, {.f_val=5.0}, 1.0, 25.0, 0.5},
-    {"onion_ring_strength", "Ring Strength", "Strength of onion rings", PARAM_FLOAT, {.f_val=0.4}, 0.0, 1.0, 0.01},
-    {"onion_ring_animation_speed", "Ring Speed", "Animation speed of rings", PARAM_FLOAT, {.f_val=0.0}, -5.0, 5.0, 0.1}
+    {"particle_color_end", "Color End", "Particle color at end of life", PARAM_COLOR, {.i_val=0x00803333}, 0, 0, 0, 0},
+
+    {"enable_source_brightness_affect", "Source Brightness Affect", "Particles affected by source brightness", PARAM_BOOL, {.b_val=false}, 0, 0, 0, 0},
+    {"source_brightness_strength", "Brightness Strength", "Strength of source brightness effect", PARAM_FLOAT, {.f_val=0.75}, 0.0, 1.0, 0.01, 0},
+    {"source_brightness_threshold", "Brightness Threshold", "Threshold for source brightness", PARAM_FLOAT, {.f_val=0.2}, 0.0, 1.0, 0.01, 0},
+    {"auto_brightness_threshold", "Auto Threshold", "Follow the scene's average brightness (replaces Brightness Threshold), or in highlights mode its brightest spots (replaces Highlight Threshold)", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM},
+
+    {"focus_point_x", "Focus X", "Focus Point X", PARAM_FLOAT, {.f_val=0.5}, -0.5, 1.5, 0.01, 0},
+    {"focus_point_y", "Focus Y", "Focus Point Y", PARAM_FLOAT, {.f_val=0.5}, -0.5, 1.5, 0.01, 0},
+    {"focus_strength", "Focus Strength", "Blur falloff from focus", PARAM_FLOAT, {.f_val=2.0}, 0.0, 10.0, 0.1, 0},
+    {"motion_blur_amount", "Motion Blur", "Trail/Motion blur amount", PARAM_FLOAT, {.f_val=0.1}, 0.0, 0.95, 0.01, 0},
+    {"bokeh_edge_softness", "Softness", "Bokeh shape edge softness", PARAM_FLOAT, {.f_val=0.5}, 0.0, 1.0, 0.01, 0},
+
+    {"use_polygons", "Use Polygons", "Use polygonal shapes instead of circles", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_SPECIALIZE},
+    {"poly_sides", "Polygon Sides", "Number of sides for polygon", PARAM_INT, {.i_val=6}, 3, 10, 1, 0},
+    {"poly_rotation", "Polygon Rotation", "Static rotation of polygons", PARAM_FLOAT, {.f_val=0.0}, 0.0, 360.0, 1.0, 0},
+    {"poly_rotation_speed", "Rotation Speed", "Speed of polygon rotation", PARAM_FLOAT, {.f_val=0.0}, -360.0, 360.0, 1.0, 0},
+
+    {"enable_chromatic_aberration", "Chromatic Aberration", "Enable CA", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_SPECIALIZE | PARAM_FLAG_QUALITY},
+    {"ca_strength", "CA Strength", "Chromatic Aberration Amount", PARAM_FLOAT, {.f_val=2.0}, 0.0, 10.0, 0.1, 0},
+
+    {"enable_onion_rings", "Onion Rings", "Enable Onion Ring artifact", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_SPECIALIZE},
+    {"onion_ring_frequency", "Ring Frequency", "Frequency of onion rings", PARAM_FLOAT, {.f_val=5.0}, 1.0, 25.0, 0.5, 0},
+    {"onion_ring_strength", "Ring Strength", "Strength of onion rings", PARAM_FLOAT, {.f_val=0.4}, 0.0, 1.0, 0.01, 0},
+    {"onion_ring_animation_speed", "Ring Speed", "Animation speed of rings", PARAM_FLOAT, {.f_val=0.0}, -5.0, 5.0, 0.1, 0},
+
+    {"bokeh_mode", "Render Mode", "0:Cells 1:Sprites (CPU simulated, cost follows covered pixels) 2:Highlights (sprites on the source's bright spots)", PARAM_INT, {.i_val=BOKEH_MODE_CELLS}, 0, 2, 1, PARAM_FLAG_NO_UNIFORM},
+    {"sprite_count", "Sprite Count", "Number of particles in sprite mode, most highlights drawn in highlights mode", PARAM_INT, {.i_val=400}, 16, 5000, 1, PARAM_FLAG_NO_UNIFORM},
+    {"highlight_threshold", "Highlight Threshold", "Highlights mode: brightness a spot needs to cast a bokeh", PARAM_FLOAT, {.f_val=0.85}, 0.0, 1.0, 0.01, PARAM_FLAG_NO_UNIFORM},
+    {"search_radius", "Search Radius", "Cells mode: neighbouring cells each pixel checks for particles", PARAM_INT, {.i_val=1}, 0, 2, 1, PARAM_FLAG_QUALITY},
+
+    // Cells mode only; sprites already shade just the pixels they cover
+    PARAM_RENDER_SCALE,
+    PARAM_QUALITY_BUDGET
 };
 
+typedef struct {
+    float spawn_x, spawn_y;  // Spawn position in source UV
+    float rand_a, rand_b;    // Per-particle random values in [0, 1)
+    float phase;             // Life phase in [0, 1)
+} bokeh_particle_t;
+
+// Per-frame particle values consumed by the vertex buffer fill
+typedef struct {
+    float center_x, center_y;  // Source UV
+    float radius;              // Aspect units (1.0 = source height)
+    struct vec4 color;
+} bokeh_sprite_t;
+
+// A local maximum of the bright pass
+typedef struct {
+    uint32_t x, y;             // Bright pass texel
+    float strength;            // 0 at the threshold, 1 at full white
+    uint8_t rgb[3];
+} bokeh_highlight_t;
+
+// Sprite shader handles, looked up once the shader is bound
+typedef struct {
+    gs_eparam_t *image;
+    gs_eparam_t *highlight_block;
+    gs_eparam_t *uv_pixel_interval;
+    gs_eparam_t *elapsed_time;
+    gs_eparam_t *enable_source_brightness_affect;
+    gs_eparam_t *source_brightness_strength;
+    gs_eparam_t *source_brightness_threshold;
+    gs_eparam_t *use_luma_image;
+    gs_eparam_t *luma_image;
+    gs_eparam_t *use_polygons;
+    gs_eparam_t *poly_sides;
+    gs_eparam_t *enable_chromatic_aberration;
+    gs_eparam_t *ca_strength;
+    gs_eparam_t *enable_onion_rings;
+    gs_eparam_t *onion_ring_frequency;
+    gs_eparam_t *onion_ring_strength;
+    gs_eparam_t *onion_ring_animation_speed;
+    gs_eparam_t *sprite_rotation;
+    gs_eparam_t *sprite_opacity;
+} bokeh_sprite_params_t;
+
+typedef struct {
+    // Synced settings for the simulation and sprite shader, see
+    // bokeh_params_synced
+    int mode;
+    int sprite_count;
+    float particle_density;
+    float particle_base_size;
+    float particle_size_variation;
+    float animation_speed;
+    uint32_t particle_color_start;
+    uint32_t particle_color_end;
+    bool enable_source_brightness_affect;
+    float source_brightness_strength;
+    float source_brightness_threshold;
+    bool auto_brightness_threshold;
+    float focus_point_x;
+    float focus_point_y;
+    float focus_strength;
+    float motion_blur_amount;
+    float bokeh_edge_softness;
+    bool use_polygons;
+    int poly_sides;
+    float poly_rotation;
+    float poly_rotation_speed;
+    bool ca_active;          // enable_chromatic_aberration at the governor's quality level
+    float ca_strength;
+    bool enable_onion_rings;
+    float onion_ring_frequency;
+    float onion_ring_strength;
+    float onion_ring_animation_speed;
+
+    float highlight_threshold;
+
+    struct vec2 shape_rotation; // (cos, sin) of the polygon rotation this frame
+
+    // Simulation (advanced in video_tick)
+    bokeh_particle_t *particles;
+    bokeh_sprite_t *sprites;
+    size_t num_particles;
+    uint32_t rng;
+
+    // Graphics
+    gs_eparam_t *param_shape_rotation;  // bokeh.shader handles, looked up in bokeh_bind_effect
+    gs_eparam_t *param_source_brightness_threshold;
+    gs_eparam_t *param_use_particle_luma;
+    gs_eparam_t *param_particle_luma_layout;
+    gs_eparam_t *param_luma_image;
+    gs_eparam_t *param_particle_luma;
+    gs_effect_t *effect;      // Bound on first sprite-mode render
+    bokeh_sprite_params_t sprite_params;
+    bool effect_failed;
+    gs_vertbuffer_t *vbuffer;
+    size_t vbuffer_capacity;  // In particles
+    gs_texrender_t *input;
+    gs_texrender_t *particle_luma; // Cell mode: brightness factor per grid cell
+
+    // Highlights mode: the bright pass is read back two frames late and
+    // compacted into `highlights`, which are drawn until the next readback
+    gs_texrender_t *bright_pass;
+    gs_stagesurf_t *highlight_stage[HIGHLIGHT_READBACK_SLOTS];
+    uint64_t highlight_staged[HIGHLIGHT_READBACK_SLOTS]; // Frame staged on, 0 = nothing staged
+    uint64_t highlight_frame;
+    bokeh_highlight_t *candidates;
+    size_t candidates_capacity;
+    bokeh_sprite_t *highlights;
+    size_t num_highlights;
+} bokeh_state_t;
+
+static inline float bokeh_rand(bokeh_state_t *st) {
+    // xorshift32
+    uint32_t x = st->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    st->rng = x;
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+static void bokeh_spawn_particle(bokeh_state_t *st, bokeh_particle_t *p) {
+    p->spawn_x = bokeh_rand(st);
+    p->spawn_y = bokeh_rand(st);
+    p->rand_a = bokeh_rand(st);
+    p->rand_b = bokeh_rand(st);
+}
+
+static void bokeh_resize_particles(bokeh_state_t *st, size_t count) {
+    if (count == st->num_particles) return;
+
+    st->particles = brealloc(st->particles, sizeof(bokeh_particle_t) * count);
+    st->sprites = brealloc(st->sprites, sizeof(bokeh_sprite_t) * count);
+
+    // New particles start at random phases so they don't all pop in together
+    for (size_t i = st->num_particles; i < count; i++) {
+        bokeh_spawn_particle(st, &st->particles[i]);
+        st->particles[i].phase = bokeh_rand(st);
+    }
+    st->num_particles = count;
+}
+
+static void bokeh_lerp_color(struct vec4 *dst, uint32_t start, uint32_t end, float t) {
+    struct vec4 a, b;
+    vec4_from_rgba(&a, start);
+    vec4_from_rgba(&b, end);
+    vec4_set(dst, a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+}
+
+// Advances every particle by one frame and derives the values the sprite
+// shader needs. Mirrors the per-cell particle maths of bokeh.shader, with the
+// cell size standing in for the drift distance.
+static void bokeh_simulate(bokeh_state_t *st, float seconds) {
+    bokeh_resize_particles(st, (size_t)st->sprite_count);
+
+    float cells = st->particle_density / 5.0f;
+    if (cells < 3.0f) cells = 3.0f;
+    if (cells > 10.0f) cells = 10.0f;
+    float drift = 1.0f / cells;
+
+    float time_step = seconds * st->animation_speed;
+
+    for (size_t i = 0; i < st->num_particles; i++) {
+        bokeh_particle_t *p = &st->particles[i];
+        bokeh_sprite_t *sprite = &st->sprites[i];
+
+        float particle_life = p->rand_a * 5.0f + 2.0f;
+        p->phase += time_step / particle_life;
+        if (p->phase >= 1.0f) {
+            p->phase -= floorf(p->phase);
+            bokeh_spawn_particle(st, p);
+        }
+
+        sprite->center_x = p->spawn_x + sinf(p->phase * BOKEH_PI * 2.0f + p->rand_a * BOKEH_PI) * 0.5f * drift;
+        sprite->center_y = p->spawn_y + (p->phase * 2.0f - 1.0f) * drift;
+
+        float dx = sprite->center_x - st->focus_point_x;
+        float dy = sprite->center_y - st->focus_point_y;
+        float focus_factor = 1.0f - fminf(fmaxf(sqrtf(dx * dx + dy * dy) * st->focus_strength, 0.0f), 1.0f);
+
+        float size = st->particle_base_size * (1.0f - st->particle_size_variation * p->rand_a);
+        size *= (1.0f + focus_factor);
+        sprite->radius = fmaxf(0.0001f, size);
+
+        bokeh_lerp_color(&sprite->color, st->particle_color_start, st->particle_color_end, p->phase);
+        sprite->color.w *= sinf(p->phase * BOKEH_PI);
+    }
+}
+
+static void *bokeh_create(obs_data_t *settings, obs_source_t *source) {
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed) return NULL;
+
+    bokeh_state_t *st = bzalloc(sizeof(bokeh_state_t));
+    st->rng = (uint32_t)((uintptr_t)ed >> 4) ^ (uint32_t)os_gettime_ns();
+    if (!st->rng) st->rng = 0x9E3779B9u;
+    ed->effect_state = st;
+
+    return ed;
+}
+
+// Binds the sprite effect once the loader has it. Returns false while it is
+// compiling or if it is unavailable; cell mode renders meanwhile.
+static bool bokeh_ensure_effect(effect_data_t *ed, bokeh_state_t *st) {
+    if (st->effect) return true;
+    if (st->effect_failed) return false;
+
+    bool failed = false;
+    st->effect = effect_cache_try_acquire(BOKEH_SPRITES_SHADER, &failed);
+
+    // load_shader_effect may hand back the passthrough fallback
+    if (st->effect && !gs_effect_get_technique(st->effect, "DrawSprites")) {
+        effect_cache_release(st->effect);
+        st->effect = NULL;
+        failed = true;
+    }
+
+    if (failed) {
+        st->effect_failed = true;
+        EFFECT_LOG_WARNING(ed, "Sprite shader unavailable, sprite mode disabled");
+    }
+    if (!st->effect) return false;
+
+    bokeh_sprite_params_t *sp = &st->sprite_params;
+    gs_effect_t *e = st->effect;
+    sp->image = gs_effect_get_param_by_name(e, "image");
+    sp->highlight_block = gs_effect_get_param_by_name(e, "highlight_block");
+    sp->uv_pixel_interval = gs_effect_get_param_by_name(e, "uv_pixel_interval");
+    sp->elapsed_time = gs_effect_get_param_by_name(e, "elapsed_time");
+    sp->enable_source_brightness_affect = gs_effect_get_param_by_name(e, "enable_source_brightness_affect");
+    sp->source_brightness_strength = gs_effect_get_param_by_name(e, "source_brightness_strength");
+    sp->source_brightness_threshold = gs_effect_get_param_by_name(e, "source_brightness_threshold");
+    sp->use_luma_image = gs_effect_get_param_by_name(e, "use_luma_image");
+    sp->luma_image = gs_effect_get_param_by_name(e, "luma_image");
+    sp->use_polygons = gs_effect_get_param_by_name(e, "use_polygons");
+    sp->poly_sides = gs_effect_get_param_by_name(e, "poly_sides");
+    sp->enable_chromatic_aberration = gs_effect_get_param_by_name(e, "enable_chromatic_aberration");
+    sp->ca_strength = gs_effect_get_param_by_name(e, "ca_strength");
+    sp->enable_onion_rings = gs_effect_get_param_by_name(e, "enable_onion_rings");
+    sp->onion_ring_frequency = gs_effect_get_param_by_name(e, "onion_ring_frequency");
+    sp->onion_ring_strength = gs_effect_get_param_by_name(e, "onion_ring_strength");
+    sp->onion_ring_animation_speed = gs_effect_get_param_by_name(e, "onion_ring_animation_speed");
+    sp->sprite_rotation = gs_effect_get_param_by_name(e, "sprite_rotation");
+    sp->sprite_opacity = gs_effect_get_param_by_name(e, "sprite_opacity");
+    return true;
+}
+
+static void bokeh_bind_effect(void *data) {
+    effect_data_t *ed = data;
+    bokeh_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->param_shape_rotation = gs_effect_get_param_by_name(ed->effect, "shape_rotation");
+    st->param_source_brightness_threshold = gs_effect_get_param_by_name(ed->effect, "source_brightness_threshold");
+    st->param_use_particle_luma = gs_effect_get_param_by_name(ed->effect, "use_particle_luma");
+    st->param_particle_luma_layout = gs_effect_get_param_by_name(ed->effect, "particle_luma_layout");
+    st->param_luma_image = gs_effect_get_param_by_name(ed->effect, "luma_image");
+    st->param_particle_luma = gs_effect_get_param_by_name(ed->effect, "particle_luma");
+}
+
+static void bokeh_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    bokeh_state_t *st = ed->effect_state;
+    if (st) {
+        obs_enter_graphics();
+        effect_cache_release(st->effect);
+        if (st->vbuffer) gs_vertexbuffer_destroy(st->vbuffer);
+        gs_texrender_destroy(st->input);
+        gs_texrender_destroy(st->particle_luma);
+        gs_texrender_destroy(st->bright_pass);
+        for (size_t i = 0; i < HIGHLIGHT_READBACK_SLOTS; i++) gs_stagesurface_destroy(st->highlight_stage[i]);
+        obs_leave_graphics();
+
+        bfree(st->particles);
+        bfree(st->sprites);
+        bfree(st->candidates);
+        bfree(st->highlights);
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+
+    generic_destroy(ed);
+}
+
+static void bokeh_params_synced(void *data) {
+    effect_data_t *ed = data;
+    bokeh_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->mode = param_get_int(ed, "bokeh_mode");
+    st->sprite_count = param_get_int(ed, "sprite_count");
+    st->particle_density = param_get_float(ed, "particle_density");
+    st->particle_base_size = param_get_float(ed, "particle_base_size");
+    st->particle_size_variation = param_get_float(ed, "particle_size_variation");
+    st->animation_speed = param_get_float(ed, "animation_speed");
+    st->particle_color_start = param_get_color(ed, "particle_color_start");
+    st->particle_color_end = param_get_color(ed, "particle_color_end");
+    st->enable_source_brightness_affect = param_get_bool(ed, "enable_source_brightness_affect");
+    st->source_brightness_strength = param_get_float(ed, "source_brightness_strength");
+    st->source_brightness_threshold = param_get_float(ed, "source_brightness_threshold");
+    st->auto_brightness_threshold = param_get_bool(ed, "auto_brightness_threshold");
+    st->focus_point_x = param_get_float(ed, "focus_point_x");
+    st->focus_point_y = param_get_float(ed, "focus_point_y");
+    st->focus_strength = param_get_float(ed, "focus_strength");
+    st->motion_blur_amount = param_get_float(ed, "motion_blur_amount");
+    st->bokeh_edge_softness = param_get_float(ed, "bokeh_edge_softness");
+    st->use_polygons = param_get_bool(ed, "use_polygons");
+    st->poly_sides = param_get_int(ed, "poly_sides");
+    st->poly_rotation = param_get_float(ed, "poly_rotation");
+    st->poly_rotation_speed = param_get_float(ed, "poly_rotation_speed");
+    st->ca_strength = param_get_float(ed, "ca_strength");
+    st->enable_onion_rings = param_get_bool(ed, "enable_onion_rings");
+    st->onion_ring_frequency = param_get_float(ed, "onion_ring_frequency");
+    st->onion_ring_strength = param_get_float(ed, "onion_ring_strength");
+    st->onion_ring_animation_speed = param_get_float(ed, "onion_ring_animation_speed");
+    st->highlight_threshold = param_get_float(ed, "highlight_threshold");
+
+    if (st->sprite_count < 16) st->sprite_count = 16;
+    if (st->sprite_count > 5000) st->sprite_count = 5000;
+
+    // Brightness lookups read the luminance pyramid too, not only the auto
+    // threshold. Highlights only need it for theirs.
+    bool highlights = st->mode == BOKEH_MODE_HIGHLIGHTS;
+    ed->luma_wanted = highlights ? st->auto_brightness_threshold : st->enable_source_brightness_affect;
+}
+
+// Brightness Threshold, or with auto_brightness_threshold the scene's mean
+static float bokeh_brightness_threshold(const effect_data_t *ed, const bokeh_state_t *st) {
+    if (!st->auto_brightness_threshold) return st->source_brightness_threshold;
+    return luma_stats_threshold(&ed->luma, 0.0f, st->source_brightness_threshold);
+}
+
+// Highlight Threshold, or with auto_brightness_threshold most of the way
+// from the scene's mean to its peak
+static float bokeh_highlight_threshold(const effect_data_t *ed, const bokeh_state_t *st) {
+    if (!st->auto_brightness_threshold) return st->highlight_threshold;
+    return luma_stats_threshold(&ed->luma, AUTO_HIGHLIGHT_FRACTION, st->highlight_threshold);
+}
+
+// Cell mode: runs the ParticleLuma prepass, which looks up every reachable
+// particle's brightness once in the low-res luminance, so the per-pixel
+// particle loop reads one tiny texture instead of sampling the source for
+// every neighbour. Returns false if the loop has to sample the source.
+static bool bokeh_render_particle_luma(effect_data_t *ed, bokeh_state_t *st) {
+    gs_effect_t *e = ed->effect;
+    gs_texture_t *luma = luma_probe_texture(ed, BOKEH_LUMA_MAX_SIZE);
+    if (!luma || !gs_effect_get_technique(e, "ParticleLuma")) return false;
+
+    // Same grid as particle_layer in bokeh.shader: cell ids run from
+    // floor(uv * cells) - search to floor(uv * cells) + search over uv 0..1,
+    // at the widest search_radius
+    float cells = fminf(fmaxf(fmaxf(st->particle_density, 1.0f) / 5.0f, 3.0f), 10.0f);
+    uint32_t search = (uint32_t)ceilf(fminf(2.0f, cells / 5.0f));
+    uint32_t size = (uint32_t)floorf(cells) + 1 + 2 * search;
+
+    if (!st->particle_luma) st->particle_luma = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+
+    struct vec2 layout;
+    vec2_set(&layout, (float)size, (float)search);
+    gs_effect_set_vec2(st->param_particle_luma_layout, &layout);
+    gs_effect_set_texture(st->param_luma_image, luma);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    bool drawn = render_pass_begin(st->particle_luma, size, size, false);
+    if (drawn) {
+        render_pass_draw(e, "ParticleLuma", size, size);
+        gs_texrender_end(st->particle_luma);
+    }
+    gs_blend_state_pop();
+
+    gs_texture_t *factors = drawn ? gs_texrender_get_texture(st->particle_luma) : NULL;
+    if (!factors) return false;
+    gs_effect_set_texture(st->param_particle_luma, factors);
+    return true;
+}
+
+// Both modes turn every polygon by the same angle; the shaders take its
+// cos and sin instead of working them out per pixel
+static void bokeh_frame_constants(void *data) {
+    effect_data_t *ed = data;
+    bokeh_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    float rotation = (st->poly_rotation + ed->elapsed_time * st->poly_rotation_speed) * (BOKEH_PI / 180.0f);
+    vec2_set(&st->shape_rotation, cosf(rotation), sinf(rotation));
+    st->ca_active = param_get_bool(ed, "enable_chromatic_aberration");
+}
+
+// Cell mode: the polygon rotation, the auto threshold over the
+// source_brightness_threshold uniform the param store just applied, then
+// the brightness prepass
+static void bokeh_prepare_draw(void *data, float width, float height) {
+    (void)width;
+    (void)height;
+    effect_data_t *ed = data;
+    bokeh_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    gs_effect_set_vec2(st->param_shape_rotation, &st->shape_rotation);
+    if (!st->enable_source_brightness_affect) return;
+
+    if (st->auto_brightness_threshold) {
+        gs_effect_set_float(st->param_source_brightness_threshold, bokeh_brightness_threshold(ed, st));
+    }
+
+    bool prepass = bokeh_render_particle_luma(ed, st);
+    gs_effect_set_bool(st->param_use_particle_luma, prepass);
+}
+
+static void bokeh_tick(void *data, float seconds) {
+    generic_tick(data, seconds);
+
+    effect_data_t *ed = data;
+    bokeh_state_t *st = ed ? ed->effect_state : NULL;
+
+    // Nothing draws a hidden filter; the sprites pick up where they were
+    if (st && st->mode == BOKEH_MODE_SPRITES && effect_is_showing(ed)) {
+        bokeh_simulate(st, seconds);
+    }
+}
+
+static bool bokeh_ensure_vbuffer(bokeh_state_t *st, size_t particles) {
+    if (st->vbuffer && st->vbuffer_capacity >= particles) return true;
+
+    if (st->vbuffer) {
+        gs_vertexbuffer_destroy(st->vbuffer);
+        st->vbuffer = NULL;
+    }
+
+    size_t num_verts = particles * SPRITE_VERTS;
+    struct gs_vb_data *vbd = gs_vbdata_create();
+    vbd->num = num_verts;
+    vbd->points = bzalloc(sizeof(struct vec3) * num_verts);
+    vbd->num_tex = 3;
+    vbd->tvarray = bzalloc(sizeof(struct gs_tvertarray) * 3);
+    vbd->tvarray[0].width = 4;
+    vbd->tvarray[0].array = bzalloc(sizeof(struct vec4) * num_verts);
+    vbd->tvarray[1].width = 4;
+    vbd->tvarray[1].array = bzalloc(sizeof(struct vec4) * num_verts);
+    vbd->tvarray[2].width = 2;
+    vbd->tvarray[2].array = bzalloc(sizeof(struct vec2) * num_verts);
+
+    st->vbuffer = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+    st->vbuffer_capacity = st->vbuffer ? particles : 0;
+    return st->vbuffer != NULL;
+}
+
+// Expands each sprite into a quad in source pixel space
+static void bokeh_fill_vbuffer(bokeh_state_t *st, const bokeh_sprite_t *sprites, size_t count, float width, float height) {
+    struct gs_vb_data *vbd = gs_vertexbuffer_get_data(st->vbuffer);
+    struct vec3 *points = vbd->points;
+    struct vec4 *shape = vbd->tvarray[0].array;
+    struct vec4 *color = vbd->tvarray[1].array;
+    struct vec2 *center = vbd->tvarray[2].array;
+
+    static const float corners[SPRITE_VERTS][2] = {
+        {-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f},
+        {-1.0f, 1.0f},  {1.0f, -1.0f}, {1.0f, 1.0f}
+    };
+
+    // Chromatic aberration samples the shape up to ca_strength pixels outside its radius
+    float ca_margin = st->ca_active ? st->ca_strength / height : 0.0f;
+
+    for (size_t i = 0; i < count; i++) {
+        const bokeh_sprite_t *sprite = &sprites[i];
+        float blur_width = sprite->radius * st->bokeh_edge_softness;
+        float extent = sprite->radius + blur_width * 0.5f + ca_margin + 1.0f / height;
+        float cx = sprite->center_x * width;
+        float cy = sprite->center_y * height;
+
+        for (size_t v = 0; v < SPRITE_VERTS; v++) {
+            size_t idx = i * SPRITE_VERTS + v;
+            float ox = corners[v][0] * extent;
+            float oy = corners[v][1] * extent;
+
+            // One aspect unit spans the source height in both axes
+            vec3_set(&points[idx], cx + ox * height, cy + oy * height, 0.0f);
+            vec4_set(&shape[idx], ox, oy, sprite->radius, blur_width);
+            color[idx] = sprite->color;
+            vec2_set(&center[idx], sprite->center_x, sprite->center_y);
+        }
+    }
+
+    gs_vertexbuffer_flush(st->vbuffer);
+}
+
+// --- Highlights mode ---
+
+static int compare_highlights(const void *a, const void *b) {
+    float sa = ((const bokeh_highlight_t *)a)->strength;
+    float sb = ((const bokeh_highlight_t *)b)->strength;
+    return (sa < sb) - (sa > sb); // Brightest first
+}
+
+// Whether bright pass texel (x, y) outshines its 8 neighbours. Ties go to
+// the neighbour earlier in scan order, so a flat clipped area doesn't turn
+// into a sprite per texel.
+static bool is_local_max(const uint8_t *data, uint32_t linesize, uint32_t cx, uint32_t cy, uint32_t x, uint32_t y) {
+    uint8_t luminance = data[(size_t)y * linesize + (size_t)x * 4 + 3];
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = (int)x + dx;
+            int ny = (int)y + dy;
+            if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= (int)cx || ny >= (int)cy) continue;
+
+            uint8_t neighbour = data[(size_t)ny * linesize + (size_t)nx * 4 + 3];
+            bool earlier = dy < 0 || (dy == 0 && dx < 0);
+            if (neighbour > luminance || (earlier && neighbour == luminance)) return false;
+        }
+    }
+    return true;
+}
+
+// Turns the candidates into sprites the way bokeh_simulate sizes particles,
+// with a highlight's strength standing in for its random size
+static void bokeh_place_highlights(bokeh_state_t *st, size_t count, uint32_t cx, uint32_t cy) {
+    for (size_t i = 0; i < count; i++) {
+        const bokeh_highlight_t *h = &st->candidates[i];
+        bokeh_sprite_t *sprite = &st->highlights[i];
+
+        sprite->center_x = ((float)h->x + 0.5f) / (float)cx;
+        sprite->center_y = ((float)h->y + 0.5f) / (float)cy;
+
+        float dx = sprite->center_x - st->focus_point_x;
+        float dy = sprite->center_y - st->focus_point_y;
+        float focus_factor = 1.0f - fminf(fmaxf(sqrtf(dx * dx + dy * dy) * st->focus_strength, 0.0f), 1.0f);
+
+        float size = st->particle_base_size * (1.0f - st->particle_size_variation * (1.0f - h->strength));
+        size *= (1.0f + focus_factor);
+        sprite->radius = fmaxf(0.0001f, size);
+
+        // The highlight's own colour, fading in from the threshold
+        vec4_set(&sprite->color, h->rgb[0] / 255.0f, h->rgb[1] / 255.0f, h->rgb[2] / 255.0f, 1.0f);
+        vec4_mulf(&sprite->color, &sprite->color, h->strength);
+    }
+    st->num_highlights = count;
+}
+
+// Maps the newest bright pass that is at least two frames old and keeps its
+// local maxima above the threshold, the brightest sprite_count of them
+static void bokeh_collect_highlights(effect_data_t *ed, bokeh_state_t *st) {
+    int slot = -1;
+    for (int i = 0; i < HIGHLIGHT_READBACK_SLOTS; i++) {
+        if (st->highlight_staged[i] == 0 || st->highlight_staged[i] + 2 > st->highlight_frame) continue;
+        if (slot < 0 || st->highlight_staged[i] > st->highlight_staged[slot]) slot = i;
+    }
+    if (slot < 0) return;
+
+    // Older ones are stale now
+    uint64_t taken = st->highlight_staged[slot];
+    for (int i = 0; i < HIGHLIGHT_READBACK_SLOTS; i++) {
+        if (st->highlight_staged[i] <= taken) st->highlight_staged[i] = 0;
+    }
+
+    gs_stagesurf_t *stage = st->highlight_stage[slot];
+    uint32_t cx = gs_stagesurface_get_width(stage);
+    uint32_t cy = gs_stagesurface_get_height(stage);
+    size_t texels = (size_t)cx * cy;
+    if (st->candidates_capacity < texels) {
+        st->candidates = brealloc(st->candidates, sizeof(bokeh_highlight_t) * texels);
+        st->highlights = brealloc(st->highlights, sizeof(bokeh_sprite_t) * texels);
+        st->candidates_capacity = texels;
+    }
+
+    uint8_t *data;
+    uint32_t linesize;
+    if (!gs_stagesurface_map(stage, &data, &linesize)) return;
+
+    float threshold = fminf(fmaxf(bokeh_highlight_threshold(ed, st), 0.0f), 0.99f);
+    size_t count = 0;
+    for (uint32_t y = 0; y < cy; y++) {
+        const uint8_t *row = data + (size_t)y * linesize;
+        for (uint32_t x = 0; x < cx; x++) {
+            const uint8_t *texel = row + (size_t)x * 4;
+            float luminance = texel[3] / 255.0f;
+            if (luminance <= threshold || !is_local_max(data, linesize, cx, cy, x, y)) continue;
+
+            bokeh_highlight_t *h = &st->candidates[count++];
+            h->x = x;
+            h->y = y;
+            h->strength = (luminance - threshold) / (1.0f - threshold);
+            memcpy(h->rgb, texel, sizeof(h->rgb));
+        }
+    }
+    gs_stagesurface_unmap(stage);
+
+    if (count > (size_t)st->sprite_count) {
+        qsort(st->candidates, count, sizeof(bokeh_highlight_t), compare_highlights);
+        count = (size_t)st->sprite_count;
+    }
+    bokeh_place_highlights(st, count, cx, cy);
+}
+
+// Renders the bright pass of `input` and starts copying it to a free stage
+// surface
+static void bokeh_stage_highlights(effect_data_t *ed, bokeh_state_t *st, gs_texture_t *input, uint32_t width, uint32_t height) {
+    uint32_t longest = width > height ? width : height;
+    uint32_t cx = (width * HIGHLIGHT_GRID_SIZE + longest - 1) / longest;
+    uint32_t cy = (height * HIGHLIGHT_GRID_SIZE + longest - 1) / longest;
+
+    if (!st->bright_pass) st->bright_pass = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+    struct vec2 block;
+    vec2_set(&block, 1.0f / (float)cx, 1.0f / (float)cy);
+    gs_effect_set_texture(st->sprite_params.image, input);
+    gs_effect_set_vec2(st->sprite_params.highlight_block, &block);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    bool drawn = render_pass_begin(st->bright_pass, cx, cy, false);
+    if (drawn) {
+        render_pass_draw(st->effect, "HighlightPass", cx, cy);
+        gs_texrender_end(st->bright_pass);
+    }
+    gs_blend_state_pop();
+
+    if (!drawn) {
+        EFFECT_LOG_WARNING(ed, "Failed to render highlight pass (%ux%u)", cx, cy);
+        return;
+    }
+
+    int slot = 0;
+    for (int i = 0; i < HIGHLIGHT_READBACK_SLOTS; i++) {
+        if (st->highlight_staged[i] == 0) {
+            slot = i;
+            break;
+        }
+        if (st->highlight_staged[i] < st->highlight_staged[slot]) slot = i;
+    }
+
+    gs_stagesurf_t *stage = st->highlight_stage[slot];
+    if (!stage || gs_stagesurface_get_width(stage) != cx || gs_stagesurface_get_height(stage) != cy) {
+        gs_stagesurface_destroy(stage);
+        stage = st->highlight_stage[slot] = gs_stagesurface_create(cx, cy, GS_RGBA);
+        if (!stage) return;
+    }
+
+    gs_stage_texture(stage, gs_texrender_get_texture(st->bright_pass));
+    st->highlight_staged[slot] = st->highlight_frame;
+}
+
+// Once a frame in highlights mode: takes up the highlights found two
+// frames ago and looks for this frame's, so the GPU is never waited on
+static void bokeh_find_highlights(effect_data_t *ed, bokeh_state_t *st, gs_texture_t *input, uint32_t width, uint32_t height) {
+    st->highlight_frame++;
+    bokeh_collect_highlights(ed, st);
+    bokeh_stage_highlights(ed, st, input, width, height);
+}
+
+static void bokeh_set_sprite_params(effect_data_t *ed, bokeh_state_t *st, gs_texture_t *input, float width, float height) {
+    const bokeh_sprite_params_t *sp = &st->sprite_params;
+
+    struct vec2 interval;
+    vec2_set(&interval, 1.0f / width, 1.0f / height);
+
+    gs_effect_set_texture(sp->image, input);
+    gs_effect_set_vec2(sp->uv_pixel_interval, &interval);
+    gs_effect_set_float(sp->elapsed_time, ed->elapsed_time);
+    gs_effect_set_bool(sp->enable_source_brightness_affect, st->enable_source_brightness_affect && input);
+    gs_effect_set_float(sp->source_brightness_strength, st->source_brightness_strength);
+    gs_effect_set_float(sp->source_brightness_threshold, bokeh_brightness_threshold(ed, st));
+
+    gs_texture_t *luma = input ? luma_probe_texture(ed, BOKEH_LUMA_MAX_SIZE) : NULL;
+    gs_effect_set_bool(sp->use_luma_image, luma != NULL);
+    gs_effect_set_texture(sp->luma_image, luma);
+    gs_effect_set_bool(sp->use_polygons, st->use_polygons);
+    gs_effect_set_int(sp->poly_sides, st->poly_sides);
+    gs_effect_set_bool(sp->enable_chromatic_aberration, st->ca_active);
+    gs_effect_set_float(sp->ca_strength, st->ca_strength);
+    gs_effect_set_bool(sp->enable_onion_rings, st->enable_onion_rings);
+    gs_effect_set_float(sp->onion_ring_frequency, st->onion_ring_frequency);
+    gs_effect_set_float(sp->onion_ring_strength, st->onion_ring_strength);
+    gs_effect_set_float(sp->onion_ring_animation_speed, st->onion_ring_animation_speed);
+    gs_effect_set_vec2(sp->sprite_rotation, &st->shape_rotation);
+    gs_effect_set_float(sp->sprite_opacity, 1.0f - st->motion_blur_amount);
+}
+
+static void bokeh_render(void *data, gs_effect_t *effect) {
+    effect_data_t *ed = data;
+    bokeh_state_t *st = ed ? ed->effect_state : NULL;
+
+    if (!st || st->mode == BOKEH_MODE_CELLS || !bokeh_ensure_effect(ed, st)) {
+        generic_render(data, effect);
+        return;
+    }
+
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    uint32_t width = target ? obs_source_get_width(target) : 0;
+    uint32_t height = target ? obs_source_get_height(target) : 0;
+    if (width == 0 || height == 0) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    // 1. Source underneath. Highlights and brightness interaction need it
+    // as a texture, otherwise let OBS draw it directly.
+    bool highlights = st->mode == BOKEH_MODE_HIGHLIGHTS;
+    enum gs_color_space space = effect_color_space(ed);
+    gs_texture_t *input_tex = NULL;
+    gs_effect_t *default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+
+    if (highlights || st->enable_source_brightness_affect) {
+        if (!render_filter_input(ed, ensure_render_target(ed, &st->input), width, height)) {
+            obs_source_skip_video_filter(ed->context);
+            return;
+        }
+        input_tex = gs_texrender_get_texture(st->input);
+        if (ed->luma_wanted) luma_probe_analyze(ed, input_tex, width, height);
+        if (highlights) bokeh_find_highlights(ed, st, input_tex, width, height);
+        gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), input_tex);
+        while (gs_effect_loop(default_effect, "Draw")) {
+            gs_draw_sprite(input_tex, 0, width, height);
+        }
+    } else if (obs_source_process_filter_begin_with_color_space(ed->context, gs_get_format_from_space(space), space,
+                                                                OBS_ALLOW_DIRECT_RENDERING)) {
+        effect_input_ready(ed);
+        obs_source_process_filter_end(ed->context, default_effect, width, height);
+    } else {
+        return;
+    }
+
+    // 2. Particles on top. Highlights already follow the source's
+    // brightness, so their sprites don't look it up again.
+    const bokeh_sprite_t *sprites = highlights ? st->highlights : st->sprites;
+    size_t count = highlights ? st->num_highlights : st->num_particles;
+    if (count == 0 || !bokeh_ensure_vbuffer(st, count)) return;
+
+    bokeh_fill_vbuffer(st, sprites, count, (float)width, (float)height);
+    bokeh_set_sprite_params(ed, st, highlights ? NULL : input_tex, (float)width, (float)height);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+    while (gs_effect_loop(st->effect, "DrawSprites")) {
+        gs_load_vertexbuffer(st->vbuffer);
+        gs_load_indexbuffer(NULL);
+        gs_draw(GS_TRIS, 0, (uint32_t)(count * SPRITE_VERTS));
+    }
+    gs_load_vertexbuffer(NULL);
+
+    gs_blend_state_pop();
+}
+
 static void bokeh_defaults(obs_data_t *s) {
     for (size_t i = 0; i < sizeof(bokeh_params)/sizeof(bokeh_params[0]); i++) {
         const param_def_t *def = &bokeh_params[i];
@@ -51,8 +826,26 @@ static void bokeh_defaults(obs_data_t *s) {
     }
 }
 
+static const char *const bokeh_extra_shaders[] = {BOKEH_SPRITES_SHADER, LUMA_REDUCE_SHADER, NULL};
+
 const effect_info_t bokeh_info = {
-    "bokeh_effect", "Bokeh", "Creates beautiful bokeh light effects", "shaders/bokeh.shader",
-    bokeh_params, sizeof(bokeh_params)/sizeof(bokeh_params[0]),
-    generic_create, generic_destroy, generic_update, generic_render, generic_tick, generic_properties, bokeh_defaults
+    .id = "bokeh_effect",
+    .name = "Bokeh",
+    .description = "Creates beautiful bokeh light effects",
+    .shader_path = "shaders/bokeh.shader",
+    .extra_shaders = bokeh_extra_shaders,
+    .params = bokeh_params,
+    .num_params = sizeof(bokeh_params)/sizeof(bokeh_params[0]),
+    .create = bokeh_create,
+    .destroy = bokeh_destroy,
+    .update = generic_update,
+    .video_render = bokeh_render,
+    .video_tick = bokeh_tick,
+    .get_properties = generic_properties,
+    .get_defaults = bokeh_defaults,
+    .bind_effect = bokeh_bind_effect,
+    .frame_constants = bokeh_frame_constants,
+    .params_synced = bokeh_params_synced,
+    .prepare_draw = bokeh_prepare_draw,
+    .flags = EFFECT_FLAG_SPLIT_OVERLAY
 };
@@ -0,0 +1,165 @@
+/*
+ * src/effects/canny/canny.c
+ */
+
+#include "canny.h"
+#include "../../utils/logging.h"
+
+static const param_def_t canny_edge_params[] = {
+    {"blur_sigma", "Smoothing", "Gaussian blur before edge detection, in edge map pixels", PARAM_FLOAT, {.f_val=1.4}, 0.5, 3.0, 0.1, PARAM_FLAG_NO_UNIFORM},
+    {"low_threshold", "Low Threshold", "Gradient strength that can continue an edge", PARAM_FLOAT, {.f_val=0.15}, 0.01, 2.0, 0.01, PARAM_FLAG_NO_UNIFORM},
+    {"high_threshold", "High Threshold", "Gradient strength that starts an edge", PARAM_FLOAT, {.f_val=0.4}, 0.01, 2.0, 0.01, PARAM_FLAG_NO_UNIFORM},
+    {"hysteresis_passes", "Edge Linking", "Passes extending strong edges along weak ones (one pixel each)", PARAM_INT, {.i_val=4}, 1, 16, 1, PARAM_FLAG_NO_UNIFORM},
+    {"edge_resolution", "Resolution", "Resolution of the edge map 0:Full 1:Half 2:Quarter", PARAM_INT, {.i_val=0}, 0, 2, 1, PARAM_FLAG_NO_UNIFORM},
+
+    {"overlay_source", "Overlay on Source", "Draw the edges over the image instead of on black", PARAM_BOOL, {.b_val=false}, 0, 0, 0, 0},
+    {"edge_color", "Edge Color", "Color of the edges", PARAM_COLOR, {.i_val=0xFFFFFFFF}, 0, 0, 0, 0},
+    {"edge_opacity", "Edge Opacity", "Strength of the edges", PARAM_FLOAT, {.f_val=1.0}, 0.0, 1.0, 0.01, 0}
+};
+
+typedef struct {
+    // Synced settings, see canny_params_synced
+    edge_map_params_t edges;
+    bool overlay_source;
+    float edge_opacity;
+
+    gs_eparam_t *param_edge_image;  // Looked up in canny_bind_effect
+    gs_texrender_t *input;
+} canny_state_t;
+
+static void *canny_create(obs_data_t *settings, obs_source_t *source) {
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed) return NULL;
+
+    ed->effect_state = bzalloc(sizeof(canny_state_t));
+    return ed;
+}
+
+static void canny_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    canny_state_t *st = ed->effect_state;
+    if (st) {
+        obs_enter_graphics();
+        gs_texrender_destroy(st->input);
+        obs_leave_graphics();
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+
+    generic_destroy(ed);
+}
+
+static void canny_params_synced(void *data) {
+    effect_data_t *ed = data;
+    canny_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->edges.blur_sigma = param_get_float(ed, "blur_sigma");
+    st->edges.low_threshold = param_get_float(ed, "low_threshold");
+    st->edges.high_threshold = param_get_float(ed, "high_threshold");
+    st->edges.hysteresis_passes = param_get_int(ed, "hysteresis_passes");
+    st->edges.scale_shift = param_get_int(ed, "edge_resolution");
+    st->overlay_source = param_get_bool(ed, "overlay_source");
+    st->edge_opacity = param_get_float(ed, "edge_opacity");
+
+    if (st->edges.blur_sigma < 0.5f) st->edges.blur_sigma = 0.5f;
+    if (st->edges.high_threshold < st->edges.low_threshold) st->edges.high_threshold = st->edges.low_threshold;
+    if (st->edges.hysteresis_passes < 1) st->edges.hysteresis_passes = 1;
+    if (st->edges.hysteresis_passes > 16) st->edges.hysteresis_passes = 16;
+    if (st->edges.scale_shift < 0) st->edges.scale_shift = 0;
+    if (st->edges.scale_shift > 2) st->edges.scale_shift = 2;
+}
+
+static void canny_bind_effect(void *data) {
+    effect_data_t *ed = data;
+    canny_state_t *st = ed->effect_state;
+    if (st) st->param_edge_image = gs_effect_get_param_by_name(ed->effect, "edge_image");
+}
+
+// --- Elision ---
+
+// Faded out edges over the source leave the source
+static bool canny_is_identity(void *data) {
+    effect_data_t *ed = data;
+    const canny_state_t *st = ed->effect_state;
+    return st && st->overlay_source && st->edge_opacity <= 0.0f;
+}
+
+// Edges depend only on the input
+static bool canny_is_static(void *data) {
+    (void)data;
+    return true;
+}
+
+static void canny_render(void *data, gs_effect_t *effect) {
+    (void)effect;
+    effect_data_t *ed = data;
+    canny_state_t *st = ed ? ed->effect_state : NULL;
+    if (!ed || render_elide(ed)) return;
+
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    uint32_t width = target ? obs_source_get_width(target) : 0;
+    uint32_t height = target ? obs_source_get_height(target) : 0;
+
+    if (!st || width == 0 || height == 0 || !generic_ensure_effect(ed) || !st->param_edge_image) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    if (!st->input) st->input = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    if (!render_filter_input(ed, st->input, width, height)) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    // Shared with any other effect asking for these edges of `target`
+    gs_texture_t *input = gs_texrender_get_texture(st->input);
+    gs_texture_t *edges = edge_map_get(target, input, width, height, &st->edges);
+    if (!edges) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    generic_prepare_draw(ed, (float)width, (float)height);
+    gs_effect_set_texture(ed->param_image, input);
+    gs_effect_set_texture(st->param_edge_image, edges);
+
+    while (gs_effect_loop(ed->effect, "Draw")) {
+        gs_draw_sprite(input, 0, width, height);
+    }
+}
+
+static void canny_defaults(obs_data_t *s) {
+    for (size_t i = 0; i < sizeof(canny_edge_params)/sizeof(canny_edge_params[0]); i++) {
+        const param_def_t *def = &canny_edge_params[i];
+        switch (def->type) {
+            case PARAM_FLOAT: obs_data_set_default_double(s, def->name, def->default_val.f_val); break;
+            case PARAM_INT:   obs_data_set_default_int(s, def->name, def->default_val.i_val); break;
+            case PARAM_BOOL:  obs_data_set_default_bool(s, def->name, def->default_val.b_val); break;
+            case PARAM_COLOR: obs_data_set_default_int(s, def->name, def->default_val.i_val); break;
+        }
+    }
+}
+
+const effect_info_t canny_edge_info = {
+    .id = "canny_edge_effect",
+    .name = "Canny Edges",
+    .description = "Detects edges with a multi-pass Canny pipeline",
+    .shader_path = EDGE_MAP_SHADER,
+    .params = canny_edge_params,
+    .num_params = sizeof(canny_edge_params)/sizeof(canny_edge_params[0]),
+    .create = canny_create,
+    .destroy = canny_destroy,
+    .update = generic_update,
+    .video_render = canny_render,
+    .video_tick = generic_tick,
+    .get_properties = generic_properties,
+    .get_defaults = canny_defaults,
+    .bind_effect = canny_bind_effect,
+    .params_synced = canny_params_synced,
+    .is_identity = canny_is_identity,
+    .is_static = canny_is_static,
+    .flags = EFFECT_FLAG_NO_STACK
+};
@@ -8,13 +8,17 @@
 #include "handheld/handheld.h"
 #include "bokeh/bokeh.h"
 #include "style_transfer/style_transfer.h"
+#include "stack/stack.h"
+#include "canny/canny.h"
 
 const effect_info_t *effects[] = {
     &star_burst_info, 
     &light_leak_info, 
     &handheld_info, 
     &bokeh_info, 
-    &style_transfer_info
+    &style_transfer_info,
+    &stack_info,
+    &canny_edge_info
 };
 
 const size_t num_effects = sizeof(effects) / sizeof(effects[0]);
@@ -3,30 +3,581 @@
  */
 
 #include "handheld.h"
+#include "../../core/cpu-image.h"
+#include "../../utils/logging.h"
+#include "../../utils/task-pool.h"
+#include <graphics/matrix4.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define HANDHELD_PI 3.14159265359f
+#define SMOOTHING_TAPS 9  // Odd, centred on the current time
+#define MOTION_TAP_SPACING 1.5f  // Texels between motion blur taps before adding more
+#define MOTION_MAX_TAPS 32       // Matches MAX_MOTION_TAPS in handheld.shader
 
 static const param_def_t handheld_params[] = {
-    {"preset", "Preset", "0:Stable 1:Breath 2:Handheld 3:Shaky 4:Quake 99:Custom", PARAM_INT, {.i_val=2}, 0, 99, 1},
-    {"masterIntensity", "Master Intensity", "Global strength multiplier", PARAM_FLOAT, {.f_val=1.0}, 0.0, 2.0, 0.05},
+    // The trajectory is evaluated in handheld_tick, so only the edge
+    // feather and the per-frame values it produces reach the shader.
+    {"preset", "Preset", "0:Stable 1:Breath 2:Handheld 3:Shaky 4:Quake 99:Custom", PARAM_INT, {.i_val=2}, 0, 99, 1, PARAM_FLAG_NO_UNIFORM},
+    {"masterIntensity", "Master Intensity", "Global strength multiplier", PARAM_FLOAT, {.f_val=1.0}, 0.0, 2.0, 0.05, PARAM_FLAG_NO_UNIFORM},
     
     // Custom Settings
-    {"positionAmount", "Position Amount", "Max screen offset", PARAM_FLOAT, {.f_val=0.005}, 0.0, 0.1, 0.001},
-    {"rotationAmount", "Rotation Amount", "Max rotation (degrees)", PARAM_FLOAT, {.f_val=0.5}, 0.0, 10.0, 0.1},
-    {"zoomAmount", "Zoom Amount", "Max zoom fluctuation", PARAM_FLOAT, {.f_val=0.01}, 0.0, 0.2, 0.001},
+    {"positionAmount", "Position Amount", "Max screen offset", PARAM_FLOAT, {.f_val=0.005}, 0.0, 0.1, 0.001, PARAM_FLAG_NO_UNIFORM},
+    {"rotationAmount", "Rotation Amount", "Max rotation (degrees)", PARAM_FLOAT, {.f_val=0.5}, 0.0, 10.0, 0.1, PARAM_FLAG_NO_UNIFORM},
+    {"zoomAmount", "Zoom Amount", "Max zoom fluctuation", PARAM_FLOAT, {.f_val=0.01}, 0.0, 0.2, 0.001, PARAM_FLAG_NO_UNIFORM},
     
-    {"positionSpeed", "Pos Speed", "Position shake frequency", PARAM_FLOAT, {.f_val=1.5}, 0.1, 10.0, 0.1},
-    {"rotationSpeed", "Rot Speed", "Rotation shake frequency", PARAM_FLOAT, {.f_val=1.0}, 0.1, 10.0, 0.1},
-    {"zoomSpeed", "Zoom Speed", "Zoom breathing frequency", PARAM_FLOAT, {.f_val=0.8}, 0.1, 10.0, 0.1},
+    {"positionSpeed", "Pos Speed", "Position shake frequency", PARAM_FLOAT, {.f_val=1.5}, 0.1, 10.0, 0.1, PARAM_FLAG_NO_UNIFORM},
+    {"rotationSpeed", "Rot Speed", "Rotation shake frequency", PARAM_FLOAT, {.f_val=1.0}, 0.1, 10.0, 0.1, PARAM_FLAG_NO_UNIFORM},
+    {"zoomSpeed", "Zoom Speed", "Zoom breathing frequency", PARAM_FLOAT, {.f_val=0.8}, 0.1, 10.0, 0.1, PARAM_FLAG_NO_UNIFORM},
     
     // Focus & Blur
-    {"enableDynamicBlur", "Motion Blur", "Enable dynamic motion blur", PARAM_BOOL, {.b_val=true}, 0, 0, 0},
-    {"blurAmount", "Blur Amount", "Strength of motion blur", PARAM_FLOAT, {.f_val=1.0}, 0.0, 5.0, 0.1},
-    {"blurSpeed", "Blur Speed", "Speed of blur fluctuation", PARAM_FLOAT, {.f_val=1.5}, 0.1, 10.0, 0.1},
-    {"staticBlurAmount", "Static Blur", "Constant blur amount", PARAM_FLOAT, {.f_val=0.0}, 0.0, 3.0, 0.05},
+    {"enableDynamicBlur", "Motion Blur", "Enable dynamic motion blur", PARAM_BOOL, {.b_val=true}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM},
+    {"blurAmount", "Blur Amount", "Strength of motion blur", PARAM_FLOAT, {.f_val=1.0}, 0.0, 5.0, 0.1, PARAM_FLAG_NO_UNIFORM},
+    {"blurSpeed", "Blur Speed", "Speed of blur fluctuation", PARAM_FLOAT, {.f_val=1.5}, 0.1, 10.0, 0.1, PARAM_FLAG_NO_UNIFORM},
+    {"staticBlurAmount", "Static Blur", "Constant blur amount (focus mode)", PARAM_FLOAT, {.f_val=0.0}, 0.0, 3.0, 0.05, PARAM_FLAG_NO_UNIFORM},
+    {"blurMode", "Blur Mode", "0:Focus pulse (box) 1:Motion (follows camera movement)", PARAM_INT, {.i_val=0}, 0, 1, 1, PARAM_FLAG_NO_UNIFORM},
+    {"maxBlurTaps", "Max Blur Taps", "Upper bound on motion blur samples per pixel", PARAM_INT, {.i_val=16}, 2, MOTION_MAX_TAPS, 1, PARAM_FLAG_NO_UNIFORM | PARAM_FLAG_QUALITY},
+    {"blurDownsample", "Downsample Long Blurs", "Blur a half resolution copy when the motion needs more taps than allowed", PARAM_BOOL, {.b_val=true}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM},
     
     // Edge Handling
-    {"edgeFeatherAmount", "Edge Feather", "Soften edges", PARAM_FLOAT, {.f_val=0.05}, 0.0, 0.25, 0.005}
+    {"edgeFeatherAmount", "Edge Feather", "Soften edges", PARAM_FLOAT, {.f_val=0.05}, 0.0, 0.25, 0.005, 0},
+
+    // Trajectory
+    {"seed", "Seed", "Trajectory seed (0 = derived from the source name)", PARAM_INT, {.i_val=0}, 0, 65535, 1, PARAM_FLAG_NO_UNIFORM},
+    {"smoothing", "Smoothing", "Lookahead smoothing window in seconds", PARAM_FLOAT, {.f_val=0.0}, 0.0, 1.0, 0.01, PARAM_FLAG_NO_UNIFORM},
+
+    PARAM_CPU_PATH,
+    PARAM_QUALITY_BUDGET
+};
+
+enum handheld_blur_mode {
+    BLUR_MODE_FOCUS = 0,   // Pulsing 3x3 box, radius from blurAmount/blurSpeed
+    BLUR_MODE_MOTION = 1   // Taps along this frame's camera motion
+};
+
+enum handheld_preset {
+    PRESET_STABLE = 0,
+    PRESET_BREATHING = 1,
+    PRESET_HANDHELD = 2,
+    PRESET_SHAKY = 3,
+    PRESET_EARTHQUAKE = 4,
+    PRESET_CUSTOM = 99
+};
+
+typedef struct {
+    float pos_amount;
+    float rot_amount_deg;
+    float zoom_amount;
+    float pos_speed;
+    float rot_speed;
+    float zoom_speed;
+    float blur_amount_factor;
+    float blur_speed_factor;
+} handheld_motion_t;
+
+static const handheld_motion_t handheld_presets[] = {
+    [PRESET_STABLE]     = {0.0005f, 0.05f, 0.000f, 0.2f, 0.15f, 0.1f, 0.1f, 0.5f},
+    [PRESET_BREATHING]  = {0.0015f, 0.15f, 0.002f, 0.4f, 0.3f, 0.25f, 0.3f, 0.8f},
+    [PRESET_HANDHELD]   = {0.005f, 0.5f, 0.01f, 1.5f, 1.0f, 0.8f, 1.0f, 1.0f},
+    [PRESET_SHAKY]      = {0.015f, 1.5f, 0.02f, 5.0f, 4.0f, 3.0f, 1.2f, 1.2f},
+    [PRESET_EARTHQUAKE] = {0.05f, 5.0f, 0.05f, 10.0f, 8.0f, 6.0f, 1.5f, 1.5f}
+};
+
+// Noise channels, one independent 1D curve each
+enum {
+    CHANNEL_POS_X1, CHANNEL_POS_X2,
+    CHANNEL_POS_Y1, CHANNEL_POS_Y2,
+    CHANNEL_ROT1, CHANNEL_ROT2,
+    CHANNEL_ZOOM1, CHANNEL_ZOOM2
 };
 
+typedef struct {
+    float offset_x, offset_y;  // UV
+    float rotation;            // Radians
+    float zoom;                // Scale factor around the centre
+} handheld_pose_t;
+
+typedef struct {
+    // Synced settings, see handheld_params_synced
+    handheld_motion_t motion;
+    bool enable_dynamic_blur;
+    float blur_amount;
+    float blur_speed;
+    float static_blur_amount;
+    uint32_t seed;          // 0 = derive from names
+    float smoothing;
+    int blur_mode;
+    int max_blur_taps;
+    bool blur_downsample;
+
+    uint32_t active_seed;   // Seed in use, resolved in tick
+    int tap_limit;          // max_blur_taps at the governor's quality level, set in tick
+
+    gs_eparam_t *param_uv_transform;
+    gs_eparam_t *param_prev_uv_transform;
+    gs_eparam_t *param_blur_radius;
+    gs_eparam_t *param_motion_taps;
+    gs_eparam_t *param_motion_scale;
+
+    // Per-frame values from tick, uploaded in render
+    struct matrix4 uv_transform;
+    struct matrix4 prev_uv_transform;
+    bool has_prev_transform;
+    float blur_radius;   // Focus mode
+    float motion_scale;  // Motion mode, fraction of one frame's motion to smear over
+
+    gs_texrender_t *half_res;  // Downsampled input for long motion blurs
+} handheld_state_t;
+
+static inline uint32_t handheld_hash(uint32_t x, uint32_t channel, uint32_t seed) {
+    uint32_t h = x * 0x8DA6B343u ^ channel * 0xD8163841u ^ seed * 0xCB1AB31Fu;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// 1D value noise in [0, 1], same smoothstep interpolation as the old shader noise()
+static float handheld_noise(double t, uint32_t channel, uint32_t seed) {
+    double fl = floor(t);
+    float f = (float)(t - fl);
+    uint32_t i = (uint32_t)(int64_t)fl;
+    f = f * f * (3.0f - 2.0f * f);
+
+    float a = (float)(handheld_hash(i, channel, seed) >> 8) * (1.0f / 16777216.0f);
+    float b = (float)(handheld_hash(i + 1, channel, seed) >> 8) * (1.0f / 16777216.0f);
+    return a + (b - a) * f;
+}
+
+// Two octaves per axis, centred on zero (formerly evaluated per pixel)
+static float handheld_wobble(double t, float speed, float slow, float fast, uint32_t channel, uint32_t seed) {
+    float v = (handheld_noise(t * speed * slow, channel, seed) - 0.5f) * 2.0f;
+    v += (handheld_noise(t * speed * fast, channel + 1, seed) - 0.5f) * 1.0f;
+    return v * 0.333f;
+}
+
+static void handheld_eval_pose(const handheld_motion_t *m, double t, uint32_t seed, handheld_pose_t *pose) {
+    pose->offset_x = handheld_wobble(t, m->pos_speed, 0.7f, 1.5f, CHANNEL_POS_X1, seed) * m->pos_amount;
+    pose->offset_y = handheld_wobble(t, m->pos_speed, 0.7f, 1.5f, CHANNEL_POS_Y1, seed) * m->pos_amount;
+    pose->rotation = handheld_wobble(t, m->rot_speed, 0.6f, 2.1f, CHANNEL_ROT1, seed) * m->rot_amount_deg * (HANDHELD_PI / 180.0f);
+    pose->zoom = 1.0f + handheld_wobble(t, m->zoom_speed, 0.5f, 1.8f, CHANNEL_ZOOM1, seed) * m->zoom_amount;
+}
+
+// The trajectory is a pure function of time, so smoothing can average
+// samples on both sides of `t` without adding latency.
+static void handheld_smoothed_pose(const handheld_state_t *st, double t, handheld_pose_t *pose) {
+    if (st->smoothing <= 0.001f) {
+        handheld_eval_pose(&st->motion, t, st->active_seed, pose);
+        return;
+    }
+
+    handheld_pose_t sum = {0.0f, 0.0f, 0.0f, 0.0f};
+    float total_weight = 0.0f;
+    const int half = SMOOTHING_TAPS / 2;
+
+    for (int i = -half; i <= half; i++) {
+        handheld_pose_t sample;
+        float weight = (float)(half + 1 - abs(i));  // Triangle window
+        handheld_eval_pose(&st->motion, t + (double)st->smoothing * i / (SMOOTHING_TAPS - 1), st->active_seed, &sample);
+
+        sum.offset_x += sample.offset_x * weight;
+        sum.offset_y += sample.offset_y * weight;
+        sum.rotation += sample.rotation * weight;
+        sum.zoom += sample.zoom * weight;
+        total_weight += weight;
+    }
+
+    pose->offset_x = sum.offset_x / total_weight;
+    pose->offset_y = sum.offset_y / total_weight;
+    pose->rotation = sum.rotation / total_weight;
+    pose->zoom = sum.zoom / total_weight;
+}
+
+// Builds the UV transform for the shader's row-vector mul(float4(uv, 0, 1), m):
+// uv' = R * (uv - 0.5) / zoom + 0.5 + offset
+static void handheld_pose_to_matrix(const handheld_pose_t *pose, struct matrix4 *m) {
+    float s = sinf(pose->rotation) / pose->zoom;
+    float c = cosf(pose->rotation) / pose->zoom;
+
+    vec4_set(&m->x, c, s, 0.0f, 0.0f);
+    vec4_set(&m->y, -s, c, 0.0f, 0.0f);
+    vec4_set(&m->z, 0.0f, 0.0f, 1.0f, 0.0f);
+    vec4_set(&m->t, 0.5f - 0.5f * c + 0.5f * s + pose->offset_x,
+                    0.5f - 0.5f * s - 0.5f * c + pose->offset_y, 0.0f, 1.0f);
+}
+
+// FNV-1a over the parent and filter names, so each camera gets its own phase
+// that stays the same across restarts
+static uint32_t handheld_auto_seed(const effect_data_t *ed) {
+    const char *names[2] = {NULL, obs_source_get_name(ed->context)};
+    obs_source_t *parent = obs_filter_get_parent(ed->context);
+    if (parent) names[0] = obs_source_get_name(parent);
+
+    uint32_t h = 2166136261u;
+    for (size_t n = 0; n < 2; n++) {
+        for (const char *p = names[n]; p && *p; p++) {
+            h = (h ^ (uint8_t)*p) * 16777619u;
+        }
+        h = (h ^ 0xFFu) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+static void *handheld_create(obs_data_t *settings, obs_source_t *source) {
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed) return NULL;
+
+    handheld_state_t *st = bzalloc(sizeof(handheld_state_t));
+    matrix4_identity(&st->uv_transform);
+    st->motion = handheld_presets[PRESET_HANDHELD];
+    ed->effect_state = st;
+
+    return ed;
+}
+
+static void handheld_bind_effect(void *data) {
+    effect_data_t *ed = data;
+    handheld_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->param_uv_transform = gs_effect_get_param_by_name(ed->effect, "uv_transform");
+    st->param_prev_uv_transform = gs_effect_get_param_by_name(ed->effect, "prev_uv_transform");
+    st->param_blur_radius = gs_effect_get_param_by_name(ed->effect, "blur_radius");
+    st->param_motion_taps = gs_effect_get_param_by_name(ed->effect, "motion_taps");
+    st->param_motion_scale = gs_effect_get_param_by_name(ed->effect, "motion_scale");
+
+    if (!st->param_uv_transform) {
+        EFFECT_LOG_WARNING(ed, "Shader has no uv_transform uniform, output will be static");
+    }
+}
+
+static void handheld_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    handheld_state_t *st = ed->effect_state;
+    if (st) {
+        obs_enter_graphics();
+        gs_texrender_destroy(st->half_res);
+        obs_leave_graphics();
+
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+    generic_destroy(ed);
+}
+
+static void handheld_params_synced(void *data) {
+    effect_data_t *ed = data;
+    handheld_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    int preset = param_get_int(ed, "preset");
+    float master = param_get_float(ed, "masterIntensity");
+    if (preset == PRESET_CUSTOM) {
+        st->motion.pos_amount = param_get_float(ed, "positionAmount");
+        st->motion.rot_amount_deg = param_get_float(ed, "rotationAmount");
+        st->motion.zoom_amount = param_get_float(ed, "zoomAmount");
+        st->motion.pos_speed = param_get_float(ed, "positionSpeed");
+        st->motion.rot_speed = param_get_float(ed, "rotationSpeed");
+        st->motion.zoom_speed = param_get_float(ed, "zoomSpeed");
+        st->motion.blur_amount_factor = 1.0f;
+        st->motion.blur_speed_factor = 1.0f;
+    } else {
+        if (preset < PRESET_STABLE) preset = PRESET_STABLE;
+        if (preset > PRESET_EARTHQUAKE) preset = PRESET_EARTHQUAKE;
+        st->motion = handheld_presets[preset];
+    }
+    st->motion.pos_amount *= master;
+    st->motion.rot_amount_deg *= master;
+    st->motion.zoom_amount *= master;
+
+    st->enable_dynamic_blur = param_get_bool(ed, "enableDynamicBlur");
+    st->blur_amount = param_get_float(ed, "blurAmount");
+    st->blur_speed = param_get_float(ed, "blurSpeed");
+    st->static_blur_amount = param_get_float(ed, "staticBlurAmount");
+    st->seed = (uint32_t)param_get_int(ed, "seed");
+    st->smoothing = param_get_float(ed, "smoothing");
+    st->blur_mode = param_get_int(ed, "blurMode");
+    st->max_blur_taps = param_get_int(ed, "maxBlurTaps");
+    st->blur_downsample = param_get_bool(ed, "blurDownsample");
+    if (st->max_blur_taps < 2) st->max_blur_taps = 2;
+    if (st->max_blur_taps > MOTION_MAX_TAPS) st->max_blur_taps = MOTION_MAX_TAPS;
+    st->active_seed = 0;  // Re-resolve on the next tick
+}
+
+// --- Elision ---
+
+// No camera motion and no pulsing focus blur: every frame draws the same
+static bool handheld_is_static(void *data) {
+    effect_data_t *ed = data;
+    const handheld_state_t *st = ed->effect_state;
+    if (!st) return false;
+
+    const handheld_motion_t *m = &st->motion;
+    if (m->pos_amount > 0.0f || m->rot_amount_deg > 0.0f || m->zoom_amount > 0.0f) return false;
+    return !st->enable_dynamic_blur || st->blur_mode == BLUR_MODE_MOTION || st->blur_amount <= 0.001f;
+}
+
+// Static, and neither the focus blur nor the edge feather reach the shader's
+// thresholds
+static bool handheld_is_identity(void *data) {
+    effect_data_t *ed = data;
+    const handheld_state_t *st = ed->effect_state;
+    if (!handheld_is_static(data)) return false;
+
+    bool focus_blur = st->enable_dynamic_blur && st->blur_mode == BLUR_MODE_FOCUS &&
+                      st->static_blur_amount + st->blur_amount * st->motion.blur_amount_factor > 0.01f;
+    return !focus_blur && param_get_float(ed, "edgeFeatherAmount") <= 0.0001f;
+}
+
+static void handheld_tick(void *data, float seconds) {
+    generic_tick(data, seconds);
+
+    effect_data_t *ed = data;
+    handheld_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    st->tap_limit = (int)quality_setting(ed, "maxBlurTaps", st->max_blur_taps);
+
+    // Nothing draws a hidden filter; start the motion blur afresh on show
+    if (!effect_is_showing(ed)) {
+        st->has_prev_transform = false;
+        return;
+    }
+
+    if (st->active_seed == 0) {
+        st->active_seed = st->seed ? st->seed : handheld_auto_seed(ed);
+    }
+
+    double t = ed->elapsed_time;
+    handheld_pose_t pose;
+    handheld_smoothed_pose(st, t, &pose);
+    st->prev_uv_transform = st->uv_transform;
+    handheld_pose_to_matrix(&pose, &st->uv_transform);
+    if (!st->has_prev_transform) {
+        st->prev_uv_transform = st->uv_transform;
+        st->has_prev_transform = true;
+    }
+
+    st->blur_radius = 0.0f;
+    st->motion_scale = 0.0f;
+    if (!st->enable_dynamic_blur) return;
+
+    if (st->blur_mode == BLUR_MODE_MOTION) {
+        st->motion_scale = st->blur_amount;
+    } else if (st->blur_amount > 0.001f || st->static_blur_amount > 0.001f) {
+        float pulse = sinf((float)t * st->blur_speed * st->motion.blur_speed_factor * 0.5f) * 0.5f + 0.5f;
+        st->blur_radius = st->static_blur_amount + st->blur_amount * st->motion.blur_amount_factor * pulse;
+    }
+}
+
+static void transform_uv(const struct matrix4 *m, float u, float v, float *out_u, float *out_v) {
+    *out_u = u * m->x.x + v * m->y.x + m->t.x;
+    *out_v = u * m->x.y + v * m->y.y + m->t.y;
+}
+
+// Longest motion streak in pixels. The transform is affine, so the
+// displacement is largest at one of the corners.
+static float handheld_motion_length(const handheld_state_t *st, float width, float height) {
+    static const float corners[4][2] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}};
+    float longest = 0.0f;
+
+    for (size_t i = 0; i < 4; i++) {
+        float cu, cv, pu, pv;
+        transform_uv(&st->uv_transform, corners[i][0], corners[i][1], &cu, &cv);
+        transform_uv(&st->prev_uv_transform, corners[i][0], corners[i][1], &pu, &pv);
+        float dx = (cu - pu) * width;
+        float dy = (cv - pv) * height;
+        longest = fmaxf(longest, sqrtf(dx * dx + dy * dy));
+    }
+
+    return longest * st->motion_scale;
+}
+
+static int motion_taps_for_length(float length_px) {
+    return (int)ceilf(length_px / MOTION_TAP_SPACING) + 1;
+}
+
+// Tap count follows the streak length across a width x height image, so
+// small or no motion stays cheap
+static int handheld_motion_taps(const handheld_state_t *st, float width, float height) {
+    if (st->motion_scale <= 0.0f || width <= 0.0f || height <= 0.0f) return 0;
+
+    int taps = motion_taps_for_length(handheld_motion_length(st, width, height));
+    if (taps > st->tap_limit) taps = st->tap_limit;
+    return taps < 2 ? 0 : taps;  // Under a texel of motion: plain sample
+}
+
+// Blurs a half resolution copy of the input so each tap covers twice the
+// distance. Returns false if the copy couldn't be made.
+static bool handheld_render_downsampled(effect_data_t *ed, handheld_state_t *st, uint32_t width, uint32_t height) {
+    uint32_t half_width = (width + 1) / 2;
+    uint32_t half_height = (height + 1) / 2;
+
+    if (!render_filter_input(ed, ensure_render_target(ed, &st->half_res), half_width, half_height)) return false;
+
+    gs_texture_t *tex = gs_texrender_get_texture(st->half_res);
+    if (!tex) return false;
+
+    generic_prepare_draw(ed, (float)half_width, (float)half_height);
+    gs_effect_set_texture(ed->param_image, tex);
+
+    while (gs_effect_loop(ed->effect, "Draw")) {
+        gs_draw_sprite(tex, 0, width, height);
+    }
+    return true;
+}
+
+// Called with the size of the image being blurred, so a half resolution
+// input gets taps twice as far apart
+static void handheld_prepare_draw(void *data, float width, float height) {
+    effect_data_t *ed = data;
+    handheld_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    if (st->param_uv_transform) gs_effect_set_matrix4(st->param_uv_transform, &st->uv_transform);
+    if (st->param_prev_uv_transform) gs_effect_set_matrix4(st->param_prev_uv_transform, &st->prev_uv_transform);
+    if (st->param_blur_radius) gs_effect_set_float(st->param_blur_radius, st->blur_radius);
+    if (st->param_motion_scale) gs_effect_set_float(st->param_motion_scale, st->motion_scale);
+    if (st->param_motion_taps) gs_effect_set_int(st->param_motion_taps, handheld_motion_taps(st, width, height));
+}
+
+static void handheld_render(void *data, gs_effect_t *effect) {
+    effect_data_t *ed = data;
+    handheld_state_t *st = ed ? ed->effect_state : NULL;
+    if (!ed || render_elide(ed)) return;
+
+    if (!st || !generic_ensure_effect(ed)) {
+        generic_render(data, effect);
+        return;
+    }
+
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    uint32_t width = target ? obs_source_get_width(target) : 0;
+    uint32_t height = target ? obs_source_get_height(target) : 0;
+
+    // Past the tap limit, blur a half resolution copy instead
+    bool downsample = false;
+    if (st->blur_downsample && st->motion_scale > 0.0f && width > 0 && height > 0) {
+        float length_px = handheld_motion_length(st, (float)width, (float)height);
+        downsample = motion_taps_for_length(length_px) > st->tap_limit;
+    }
+
+    if (downsample && handheld_render_downsampled(ed, st, width, height)) return;
+    generic_render(data, effect);
+}
+
+// --- CPU path ---
+// handheld_shade per pixel on RGBA8 frames. Long motion blurs are clamped
+// to maxBlurTaps here; there's no half resolution copy to fall back to.
+
+typedef struct {
+    const handheld_state_t *st;
+    const cpu_image_t *src;
+    cpu_image_t *dst;
+    int motion_taps;
+    float feather;              // edgeFeatherAmount, 0 = off
+} handheld_frame_t;
+
+static inline simd_rgba_t rgba_add(simd_rgba_t a, simd_rgba_t b) {
+    simd_rgba_t c = {simd_add(a.r, b.r), simd_add(a.g, b.g), simd_add(a.b, b.b), simd_add(a.a, b.a)};
+    return c;
+}
+
+static inline simd_rgba_t rgba_scale(simd_rgba_t a, simd_f s) {
+    simd_rgba_t c = {simd_mul(a.r, s), simd_mul(a.g, s), simd_mul(a.b, s), simd_mul(a.a, s)};
+    return c;
+}
+
+// smoothstep(0, e, x) * smoothstep(0, e, 1 - x), one axis of the feather
+static inline simd_f feather_axis(simd_f e, simd_f x) {
+    return simd_mul(simd_smoothstep0(e, x), simd_smoothstep0(e, simd_sub(simd_set1(1.0f), x)));
+}
+
+static simd_rgba_t handheld_sample(const handheld_frame_t *f, simd_f u, simd_f v, simd_f motion_u, simd_f motion_v) {
+    const handheld_state_t *st = f->st;
+    const cpu_image_t *src = f->src;
+    const simd_f zero = simd_set1(0.0f);
+    simd_rgba_t sum = {zero, zero, zero, zero};
+
+    if (f->motion_taps > 1) {
+        float inv_taps = 1.0f / (float)f->motion_taps;
+        for (int i = 0; i < f->motion_taps; i++) {
+            simd_f t = simd_set1(((float)i + 0.5f) * inv_taps - 0.5f);
+            sum = rgba_add(sum, cpu_sample_rgba(src, simd_madd(motion_u, t, u), simd_madd(motion_v, t, v)));
+        }
+        return rgba_scale(sum, simd_set1(inv_taps));
+    }
+
+    if (st->blur_radius > 0.01f) {
+        float step_u = st->blur_radius / (float)src->width;
+        float step_v = st->blur_radius / (float)src->height;
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                sum = rgba_add(sum, cpu_sample_rgba(src, simd_add(u, simd_set1(step_u * (float)dx)),
+                                                    simd_add(v, simd_set1(step_v * (float)dy))));
+            }
+        }
+        return rgba_scale(sum, simd_set1(1.0f / 9.0f));
+    }
+
+    return cpu_sample_rgba(src, u, v);
+}
+
+static void handheld_rows(void *ctx, size_t begin, size_t end) {
+    const handheld_frame_t *f = ctx;
+    const struct matrix4 *m = &f->st->uv_transform;
+    const struct matrix4 *prev = &f->st->prev_uv_transform;
+    const float inv_width = 1.0f / (float)f->src->width;
+    const simd_f motion_scale = simd_set1(f->st->motion_scale);
+    const simd_f feather = simd_set1(f->feather);
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        float v = ((float)y + 0.5f) / (float)f->src->height;
+        const simd_f v_u = simd_set1(v * m->y.x + m->t.x);
+        const simd_f v_v = simd_set1(v * m->y.y + m->t.y);
+        const simd_f prev_v_u = simd_set1(v * prev->y.x + prev->t.x);
+        const simd_f prev_v_v = simd_set1(v * prev->y.y + prev->t.y);
+        const simd_f feather_y = f->feather > 0.0001f ? feather_axis(feather, simd_set1(v)) : simd_set1(1.0f);
+        uint32_t *out = cpu_image_row(f->dst, y);
+
+        for (uint32_t x = 0; x < f->src->width; x += SIMD_LANES) {
+            simd_f u = cpu_pixel_u(x, inv_width);
+            simd_f su = simd_madd(u, simd_set1(m->x.x), v_u);
+            simd_f sv = simd_madd(u, simd_set1(m->x.y), v_v);
+            simd_f motion_u = simd_mul(simd_sub(su, simd_madd(u, simd_set1(prev->x.x), prev_v_u)), motion_scale);
+            simd_f motion_v = simd_mul(simd_sub(sv, simd_madd(u, simd_set1(prev->x.y), prev_v_v)), motion_scale);
+
+            simd_rgba_t c = handheld_sample(f, su, sv, motion_u, motion_v);
+            if (f->feather > 0.0001f) {
+                c = rgba_scale(c, simd_saturate(simd_mul(feather_axis(feather, u), feather_y)));
+            }
+            cpu_store_rgba(out, x, c);
+        }
+    }
+}
+
+static void handheld_filter_frame(void *data, const cpu_image_t *src, cpu_image_t *dst) {
+    effect_data_t *ed = data;
+    handheld_state_t *st = ed->effect_state;
+    if (!st) {
+        memcpy(dst->pixels, src->pixels, sizeof(uint32_t) * src->stride * src->height);
+        return;
+    }
+
+    handheld_frame_t f = {
+        .st = st,
+        .src = src,
+        .dst = dst,
+        .motion_taps = handheld_motion_taps(st, (float)src->width, (float)src->height),
+        .feather = param_get_float(ed, "edgeFeatherAmount")
+    };
+    task_pool_parallel_for(task_pool_shared(), src->height, CPU_ROWS_PER_TASK, handheld_rows, &f);
+}
+
 static void handheld_defaults(obs_data_t *s) {
     for (size_t i = 0; i < sizeof(handheld_params)/sizeof(handheld_params[0]); i++) {
         const param_def_t *def = &handheld_params[i];
@@ -39,8 +590,31 @@ static void handheld_defaults(obs_data_t *s) {
     }
 }
 
+static const effect_stage_t handheld_stage = {
+    .define = "STACK_WITH_HANDHELD",
+    .function = "handheld_stage_sample",
+    .samples_input = true
+};
+
 const effect_info_t handheld_info = {
-    "handheld_effect", "Handheld Camera", "Simulates handheld camera movement", "shaders/handheld.shader",
-    handheld_params, sizeof(handheld_params)/sizeof(handheld_params[0]),
-    generic_create, generic_destroy, generic_update, generic_render, generic_tick, generic_properties, handheld_defaults
+    .id = "handheld_effect",
+    .name = "Handheld Camera",
+    .description = "Simulates handheld camera movement",
+    .shader_path = "shaders/handheld.shader",
+    .params = handheld_params,
+    .num_params = sizeof(handheld_params)/sizeof(handheld_params[0]),
+    .create = handheld_create,
+    .destroy = handheld_destroy,
+    .update = generic_update,
+    .video_render = handheld_render,
+    .video_tick = handheld_tick,
+    .get_properties = generic_properties,
+    .get_defaults = handheld_defaults,
+    .prepare_draw = handheld_prepare_draw,
+    .bind_effect = handheld_bind_effect,
+    .params_synced = handheld_params_synced,
+    .stage = &handheld_stage,
+    .filter_frame = handheld_filter_frame,
+    .is_identity = handheld_is_identity,
+    .is_static = handheld_is_static
 };
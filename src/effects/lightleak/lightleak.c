@@ -3,46 +3,690 @@
  */
 
 #include "lightleak.h"
+#include "../../core/cpu-image.h"
+#include "../../utils/logging.h"
+#include "../../utils/task-pool.h"
+#include "../../utils/tileable-noise.h"
+#include <util/threading.h>
+#include <math.h>
+
+#define NOISE_SEED 0x4C4C4B31u          // Fixed so a given setup always looks the same
+#define NOISE_MAX_EXTENT 2048           // Longest side of the baked fbm texture
+#define NOISE_MAX_TEXELS_PER_CELL 256
+#define NOISE_MIN_TEXELS_PER_CELL 8
+#define NOISE_ROWS_PER_TASK 16
+#define NOISE_ROWS_PER_BATCH 128        // Rows per task_pool_parallel_for call, see light_leak_bake
+#define GRAIN_SIZE_LOG2 6               // 64x64, matches GRAIN_TEX_SIZE in light-leak.shader
 
 static const param_def_t light_leak_params[] = {
-    {"leakIntensity", "Intensity", "Opacity of the light leak", PARAM_FLOAT, {.f_val=0.8}, 0.0, 3.0, 0.05},
-    {"leakColor", "Leak Color", "Primary leak color", PARAM_COLOR, {.i_val=0xFF3380FF}, 0, 0, 0}, 
+    {"leakIntensity", "Intensity", "Opacity of the light leak", PARAM_FLOAT, {.f_val=0.8}, 0.0, 3.0, 0.05, 0},
+    {"autoExposure", "Auto Exposure", "Scale Intensity with the scene's brightness", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM},
+    {"leakColor", "Leak Color", "Primary leak color", PARAM_COLOR, {.i_val=0xFF3380FF}, 0, 0, 0, 0},
 
-    {"leakScale", "Scale", "Noise pattern size", PARAM_FLOAT, {.f_val=2.0}, 0.1, 10.0, 0.1},
-    {"leakSpeed", "Speed", "Animation speed", PARAM_FLOAT, {.f_val=0.5}, 0.0, 5.0, 0.1},
-    {"edgeFalloff", "Edge Falloff", "Edge clamping tightness", PARAM_FLOAT, {.f_val=3.0}, 0.5, 10.0, 0.1},
-    {"noiseComplexity", "Complexity", "Noise detail level", PARAM_FLOAT, {.f_val=3.0}, 1.0, 8.0, 1.0},
+    {"leakScale", "Scale", "Noise pattern size", PARAM_FLOAT, {.f_val=2.0}, 0.1, 10.0, 0.1, 0},
+    {"leakSpeed", "Speed", "Animation speed", PARAM_FLOAT, {.f_val=0.5}, 0.0, 5.0, 0.1, 0},
+    {"edgeFalloff", "Edge Falloff", "Edge clamping tightness", PARAM_FLOAT, {.f_val=3.0}, 0.5, 10.0, 0.1, 0},
+    {"noiseComplexity", "Complexity", "Noise detail level", PARAM_FLOAT, {.f_val=3.0}, 1.0, 8.0, 1.0, 0},
     
     // Edge Biasing
-    {"topBias", "Top Bias", "Top edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05},
-    {"bottomBias", "Bottom Bias", "Bottom edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05},
-    {"leftBias", "Left Bias", "Left edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05},
-    {"rightBias", "Right Bias", "Right edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05},
+    {"topBias", "Top Bias", "Top edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05, 0},
+    {"bottomBias", "Bottom Bias", "Bottom edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05, 0},
+    {"leftBias", "Left Bias", "Left edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05, 0},
+    {"rightBias", "Right Bias", "Right edge bias", PARAM_FLOAT, {.f_val=0.25}, 0.0, 2.0, 0.05, 0},
 
     // Leak Shape
-    {"streakiness", "Streakiness", "Horizontal stretching", PARAM_FLOAT, {.f_val=1.0}, 0.1, 10.0, 0.05},
-    {"leakShapeContrast", "Shape Contrast", "Shape definition contrast", PARAM_FLOAT, {.f_val=1.5}, 0.5, 5.0, 0.05},
+    {"streakiness", "Streakiness", "Horizontal stretching", PARAM_FLOAT, {.f_val=1.0}, 0.1, 10.0, 0.05, 0},
+    {"leakShapeContrast", "Shape Contrast", "Shape definition contrast", PARAM_FLOAT, {.f_val=1.5}, 0.5, 5.0, 0.05, 0},
 
     // Dynamic Behavior
-    {"enablePulsing", "Pulsing", "Enable intensity pulsing", PARAM_BOOL, {.b_val=true}, 0, 0, 0},
-    {"pulseSpeed", "Pulse Speed", "Pulsing frequency", PARAM_FLOAT, {.f_val=0.5}, 0.1, 5.0, 0.05},
-    {"pulseMinAlpha", "Pulse Min", "Minimum alpha during pulse", PARAM_FLOAT, {.f_val=0.05}, 0.0, 1.0, 0.01},
-    {"pulseMaxAlpha", "Pulse Max", "Maximum alpha during pulse", PARAM_FLOAT, {.f_val=0.3}, 0.0, 1.0, 0.01},
+    {"enablePulsing", "Pulsing", "Enable intensity pulsing", PARAM_BOOL, {.b_val=true}, 0, 0, 0, 0},
+    {"pulseSpeed", "Pulse Speed", "Pulsing frequency", PARAM_FLOAT, {.f_val=0.5}, 0.1, 5.0, 0.05, 0},
+    {"pulseMinAlpha", "Pulse Min", "Minimum alpha during pulse", PARAM_FLOAT, {.f_val=0.05}, 0.0, 1.0, 0.01, 0},
+    {"pulseMaxAlpha", "Pulse Max", "Maximum alpha during pulse", PARAM_FLOAT, {.f_val=0.3}, 0.0, 1.0, 0.01, 0},
     
-    {"enableColorShift", "Color Shift", "Enable color shifting", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"secondLeakColor", "Second Color", "Secondary leak color", PARAM_COLOR, {.i_val=0x591A33FF}, 0, 0, 0}, // approx 1.0, 0.2, 0.1, 0.35 (RGBA)
-    {"colorShiftSpeed", "Shift Speed", "Color shift speed", PARAM_FLOAT, {.f_val=0.2}, 0.05, 2.0, 0.05},
+    {"enableColorShift", "Color Shift", "Enable color shifting", PARAM_BOOL, {.b_val=false}, 0, 0, 0, 0},
+    {"secondLeakColor", "Second Color", "Secondary leak color", PARAM_COLOR, {.i_val=0x591A33FF}, 0, 0, 0, 0}, // approx 1.0, 0.2, 0.1, 0.35 (RGBA)
+    {"colorShiftSpeed", "Shift Speed", "Color shift speed", PARAM_FLOAT, {.f_val=0.2}, 0.05, 2.0, 0.05, 0},
 
     // Visual Complexity
-    {"hotspotIntensity", "Hotspot Intensity", "Brightness boost for core", PARAM_FLOAT, {.f_val=0.5}, 0.0, 3.0, 0.05},
-    {"hotspotExponent", "Hotspot Tightness", "Size of hotspot", PARAM_FLOAT, {.f_val=3.0}, 1.0, 10.0, 0.1},
-    {"hotspotColor", "Hotspot Tint", "Color tint for hotspot", PARAM_COLOR, {.i_val=0x00000D1A}, 0, 0, 0}, // 0.1, 0.05, 0.0
-    {"grainAmount", "Grain Amount", "Noise texture intensity", PARAM_FLOAT, {.f_val=0.05}, 0.0, 0.5, 0.01},
-    {"grainScale", "Grain Scale", "Size of grain", PARAM_FLOAT, {.f_val=50.0}, 10.0, 100.0, 1.0},
+    {"hotspotIntensity", "Hotspot Intensity", "Brightness boost for core", PARAM_FLOAT, {.f_val=0.5}, 0.0, 3.0, 0.05, 0},
+    {"hotspotExponent", "Hotspot Tightness", "Size of hotspot", PARAM_FLOAT, {.f_val=3.0}, 1.0, 10.0, 0.1, 0},
+    {"hotspotColor", "Hotspot Tint", "Color tint for hotspot", PARAM_COLOR, {.i_val=0x00000D1A}, 0, 0, 0, 0}, // 0.1, 0.05, 0.0
+    {"grainAmount", "Grain Amount", "Noise texture intensity", PARAM_FLOAT, {.f_val=0.05}, 0.0, 0.5, 0.01, 0},
+    {"grainScale", "Grain Scale", "Size of grain", PARAM_FLOAT, {.f_val=50.0}, 10.0, 100.0, 1.0, 0},
+
+    {"blendMode", "Blend Mode", "0:Alpha 1:Add 2:Screen 3:Over 4:Soft", PARAM_INT, {.i_val=0}, 0, 4, 1, PARAM_FLAG_SPECIALIZE},
 
-    {"blendMode", "Blend Mode", "0:Alpha 1:Add 2:Screen 3:Over 4:Soft", PARAM_INT, {.i_val=0}, 0, 4, 1}
+    // The leak layer is what costs GPU time; the noise is one baked texture
+    // fetch whatever its octaves, so it is the layer's resolution that drops
+    PARAM_RENDER_SCALE_FLAGS(PARAM_FLAG_QUALITY),
+    PARAM_CPU_PATH,
+    PARAM_QUALITY_BUDGET
 };
 
+// Everything the baked fbm texture depends on. leakScale and streakiness
+// only matter through the lattice period, so slider moves that keep the
+// period don't trigger a rebake.
+typedef struct {
+    uint32_t period_x;
+    uint32_t period_y;
+    int octaves;
+    uint32_t width;
+    uint32_t height;
+} noise_bake_key_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+
+    // Written by update, taken by the bake worker; guarded by mutex
+    noise_bake_key_t requested_key;
+    bool bake_requested;
+
+    // Written by the bake worker, consumed by render; guarded by mutex
+    uint16_t *pending_noise;
+    noise_bake_key_t pending_key;
+
+    // Graphics thread only. OBS defers filter updates to video_tick, and the
+    // EmuLens Stack updates its members from its own update.
+    noise_bake_key_t baked_key;   // Last bake requested by update
+    noise_bake_key_t active_key;  // What noise_tex holds
+
+    // Graphics thread only: the latest bake, kept for the CPU path, and
+    // whether noise_tex still has to be (re)created from it
+    uint16_t *noise_texels;
+    noise_bake_key_t texels_key;
+    bool noise_upload;
+    float *mask_columns;          // CPU path: per-column edge mask terms
+    uint32_t mask_columns_size;
+
+    gs_texture_t *noise_tex;
+    gs_texture_t *grain_tex;
+    uint32_t grain_rng;
+
+    bool auto_exposure;           // autoExposure, see light_leak_params_synced
+
+    // Bakes noise off the graphics thread, so dragging a slider that changes
+    // the key never holds up rendering
+    pthread_t worker;
+    bool worker_started;
+    os_sem_t *wake;
+    volatile bool stopping;
+
+    // Per frame, see light_leak_frame_constants
+    struct vec4 frame_color;      // Shifted leakColor, alpha target in w
+    struct vec2 noise_scroll;     // In noise lattice cells
+
+    gs_eparam_t *param_leak_intensity;
+    gs_eparam_t *param_leak_frame_color;
+    gs_eparam_t *param_leak_noise_scroll;
+    gs_eparam_t *param_use_baked_noise;
+    gs_eparam_t *param_noise_tex;
+    gs_eparam_t *param_noise_period;
+    gs_eparam_t *param_grain_tex;
+    gs_eparam_t *param_grain_offset;
+} light_leak_state_t;
+
+// Blue noise doesn't depend on any setting, so every instance shares one bake.
+// One texel of padding for simd_gather_u16.
+static uint16_t grain_texels[(1 << (GRAIN_SIZE_LOG2 * 2)) + 1];
+static bool grain_ready = false;
+static pthread_once_t grain_once = PTHREAD_ONCE_INIT;
+
+static void bake_grain(void) {
+    grain_ready = blue_noise_bake(grain_texels, GRAIN_SIZE_LOG2, NOISE_SEED);
+    if (!grain_ready) PLUGIN_LOG_WARNING("light-leak", "Blue noise bake failed, using shader grain");
+}
+
+static bool keys_equal(const noise_bake_key_t *a, const noise_bake_key_t *b) {
+    return a->period_x == b->period_x && a->period_y == b->period_y && a->octaves == b->octaves &&
+           a->width == b->width && a->height == b->height;
+}
+
+// Mirrors the noise_uv setup in light-leak.shader: the texture covers the
+// whole visible noise domain, rounded up to whole lattice cells so it tiles.
+static noise_bake_key_t make_bake_key(obs_data_t *settings) {
+    float scale = (float)obs_data_get_double(settings, "leakScale");
+    float streakiness = (float)obs_data_get_double(settings, "streakiness");
+    int octaves = (int)obs_data_get_double(settings, "noiseComplexity");
+
+    float span_x = scale;
+    float span_y = scale;
+    if (streakiness > 1.01f) {
+        span_x *= streakiness;
+    } else if (streakiness < 0.99f && streakiness > 0.0f) {
+        span_y /= streakiness;
+    }
+
+    noise_bake_key_t key;
+    key.period_x = (uint32_t)fmaxf(1.0f, ceilf(span_x));
+    key.period_y = (uint32_t)fmaxf(1.0f, ceilf(span_y));
+    key.octaves = octaves < 1 ? 1 : (octaves > 8 ? 8 : octaves);
+
+    uint32_t longest = key.period_x > key.period_y ? key.period_x : key.period_y;
+    uint32_t texels_per_cell = NOISE_MAX_EXTENT / longest;
+    if (texels_per_cell > NOISE_MAX_TEXELS_PER_CELL) texels_per_cell = NOISE_MAX_TEXELS_PER_CELL;
+    if (texels_per_cell < NOISE_MIN_TEXELS_PER_CELL) texels_per_cell = NOISE_MIN_TEXELS_PER_CELL;
+    key.width = key.period_x * texels_per_cell;
+    key.height = key.period_y * texels_per_cell;
+    return key;
+}
+
+typedef struct {
+    const tileable_fbm_desc_t *desc;
+    uint16_t *out;
+    uint32_t first_row;
+} noise_bake_job_t;
+
+static void bake_noise_rows(void *ctx, size_t begin, size_t end) {
+    noise_bake_job_t *job = ctx;
+    tileable_fbm_rows(job->desc, job->out, job->first_row + (uint32_t)begin, job->first_row + (uint32_t)end);
+}
+
+// Bake worker. The shared pool serialises its callers, so the rows go in
+// batches: a CPU path filtering on the graphics thread meanwhile waits for
+// one batch at most, not the whole bake. Gives up if the filter is going away.
+static void light_leak_bake(effect_data_t *ed, light_leak_state_t *st, const noise_bake_key_t *key) {
+    // One texel of padding for simd_gather_u16 on the CPU path
+    uint16_t *texels = bmalloc(sizeof(uint16_t) * (key->width * key->height + 1));
+
+    tileable_fbm_desc_t desc = {
+        .width = key->width,
+        .height = key->height,
+        .period_x = key->period_x,
+        .period_y = key->period_y,
+        .octaves = key->octaves,
+        .persistence = 0.5f,
+        .seed = NOISE_SEED
+    };
+    noise_bake_job_t job = {&desc, texels, 0};
+
+    uint64_t start = os_gettime_ns();
+    for (; job.first_row < key->height; job.first_row += NOISE_ROWS_PER_BATCH) {
+        if (os_atomic_load_bool(&st->stopping)) {
+            bfree(texels);
+            return;
+        }
+        uint32_t rows = key->height - job.first_row;
+        if (rows > NOISE_ROWS_PER_BATCH) rows = NOISE_ROWS_PER_BATCH;
+        task_pool_parallel_for(task_pool_shared(), rows, NOISE_ROWS_PER_TASK, bake_noise_rows, &job);
+    }
+    EFFECT_LOG_DEBUG(ed, "Baked %ux%u noise (%d octaves) in %.2f ms", key->width, key->height, key->octaves,
+                     (double)(os_gettime_ns() - start) / 1000000.0);
+
+    pthread_mutex_lock(&st->mutex);
+    bfree(st->pending_noise);
+    st->pending_noise = texels;
+    st->pending_key = *key;
+    pthread_mutex_unlock(&st->mutex);
+}
+
+// Bakes the latest key update asked for; requests made during a bake
+// replace each other, so a slider drag bakes only where it stops
+static void *light_leak_worker_main(void *data) {
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed->effect_state;
+    os_set_thread_name("emulens: light leak bake");
+
+    while (os_sem_wait(st->wake) == 0 && !os_atomic_load_bool(&st->stopping)) {
+        pthread_mutex_lock(&st->mutex);
+        bool requested = st->bake_requested;
+        noise_bake_key_t key = st->requested_key;
+        st->bake_requested = false;
+        pthread_mutex_unlock(&st->mutex);
+
+        if (requested) light_leak_bake(ed, st, &key);
+    }
+    return NULL;
+}
+
+static void *light_leak_create(obs_data_t *settings, obs_source_t *source) {
+    light_leak_state_t *st = bzalloc(sizeof(light_leak_state_t));
+    pthread_mutex_init(&st->mutex, NULL);
+    st->grain_rng = (uint32_t)os_gettime_ns() | 1u;
+    pthread_once(&grain_once, bake_grain);
+
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed || os_sem_init(&st->wake, 0) != 0) {
+        if (ed) generic_destroy(ed);
+        pthread_mutex_destroy(&st->mutex);
+        bfree(st);
+        return NULL;
+    }
+    ed->effect_state = st;
+
+    // The deferred update from generic_create posts the first bake
+    st->worker_started = pthread_create(&st->worker, NULL, light_leak_worker_main, ed) == 0;
+    if (!st->worker_started) EFFECT_LOG_ERROR(ed, "Failed to start the noise bake worker, baking in update");
+
+    return ed;
+}
+
+static void light_leak_bind_effect(void *data) {
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->param_leak_intensity = gs_effect_get_param_by_name(ed->effect, "leakIntensity");
+    st->param_leak_frame_color = gs_effect_get_param_by_name(ed->effect, "leak_frame_color");
+    st->param_leak_noise_scroll = gs_effect_get_param_by_name(ed->effect, "leak_noise_scroll");
+    st->param_use_baked_noise = gs_effect_get_param_by_name(ed->effect, "use_baked_noise");
+    st->param_noise_tex = gs_effect_get_param_by_name(ed->effect, "noise_tex");
+    st->param_noise_period = gs_effect_get_param_by_name(ed->effect, "noise_period");
+    st->param_grain_tex = gs_effect_get_param_by_name(ed->effect, "grain_tex");
+    st->param_grain_offset = gs_effect_get_param_by_name(ed->effect, "grain_offset");
+}
+
+static void light_leak_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    light_leak_state_t *st = ed->effect_state;
+    if (st) {
+        if (st->worker_started) {
+            os_atomic_set_bool(&st->stopping, true);
+            os_sem_post(st->wake);
+            pthread_join(st->worker, NULL);
+        }
+        os_sem_destroy(st->wake);
+
+        obs_enter_graphics();
+        gs_texture_destroy(st->noise_tex);
+        gs_texture_destroy(st->grain_tex);
+        obs_leave_graphics();
+
+        bfree(st->pending_noise);
+        bfree(st->noise_texels);
+        bfree(st->mask_columns);
+        pthread_mutex_destroy(&st->mutex);
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+
+    generic_destroy(ed);
+}
+
+static void light_leak_params_synced(void *data) {
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->auto_exposure = param_get_bool(ed, "autoExposure");
+    ed->luma_wanted = st->auto_exposure;
+}
+
+static void light_leak_update(void *data, obs_data_t *settings) {
+    generic_update(data, settings);
+
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    noise_bake_key_t key = make_bake_key(settings);
+    if (keys_equal(&key, &st->baked_key)) return;
+    st->baked_key = key;
+
+    if (!st->worker_started) {
+        light_leak_bake(ed, st, &key);
+        return;
+    }
+    pthread_mutex_lock(&st->mutex);
+    st->requested_key = key;
+    st->bake_requested = true;
+    pthread_mutex_unlock(&st->mutex);
+    os_sem_post(st->wake);
+}
+
+// --- Elision ---
+
+// The leak's alpha is zero everywhere, so every blend mode returns the input
+static bool light_leak_is_identity(void *data) {
+    effect_data_t *ed = data;
+    if (param_get_float(ed, "leakIntensity") <= 0.0f) return true;
+
+    float bias = param_get_float(ed, "topBias") + param_get_float(ed, "bottomBias") +
+                 param_get_float(ed, "leftBias") + param_get_float(ed, "rightBias");
+    if (bias <= 0.0f) return true;
+
+    if (param_get_bool(ed, "enablePulsing")) {
+        return fmaxf(param_get_float(ed, "pulseMinAlpha"), param_get_float(ed, "pulseMaxAlpha")) <= 0.0f;
+    }
+    bool shift = param_get_bool(ed, "enableColorShift");
+    return (param_get_color(ed, "leakColor") >> 24) == 0 &&
+           (!shift || (param_get_color(ed, "secondLeakColor") >> 24) == 0);
+}
+
+// Nothing moves with elapsed_time and the grain (re-placed every frame) is
+// off. Also waits for the current bake, which replaces the per-pixel noise.
+static bool light_leak_is_static(void *data) {
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed->effect_state;
+    if (!st || st->auto_exposure) return false; // Follows the scene
+    if (!st->noise_tex || !st->grain_tex || !keys_equal(&st->active_key, &st->baked_key)) return false;
+
+    return param_get_float(ed, "leakSpeed") <= 0.0f && !param_get_bool(ed, "enablePulsing") &&
+           !param_get_bool(ed, "enableColorShift") && param_get_float(ed, "grainAmount") <= 0.0f;
+}
+
+// Takes a finished bake, if any, as the current noise_texels
+static void light_leak_take_bake(light_leak_state_t *st) {
+    pthread_mutex_lock(&st->mutex);
+    uint16_t *texels = st->pending_noise;
+    noise_bake_key_t key = st->pending_key;
+    st->pending_noise = NULL;
+    pthread_mutex_unlock(&st->mutex);
+
+    if (!texels) return;
+    bfree(st->noise_texels);
+    st->noise_texels = texels;
+    st->texels_key = key;
+    st->noise_upload = true;
+}
+
+// New grain placement every frame keeps it from reading as a fixed pattern
+static struct vec2 light_leak_next_grain_offset(light_leak_state_t *st) {
+    struct vec2 offset;
+    st->grain_rng ^= st->grain_rng << 13;
+    st->grain_rng ^= st->grain_rng >> 17;
+    st->grain_rng ^= st->grain_rng << 5;
+    vec2_set(&offset, (float)(st->grain_rng & 0xFFFF) / 65536.0f, (float)(st->grain_rng >> 16) / 65536.0f);
+    return offset;
+}
+
+// Uploads finished bakes and points the shader at them. Until the first
+// upload the shader keeps generating noise per pixel.
+static void light_leak_prepare_textures(light_leak_state_t *st) {
+    light_leak_take_bake(st);
+
+    if (st->noise_upload) {
+        const uint8_t *levels[1] = {(const uint8_t *)st->noise_texels};
+        gs_texture_destroy(st->noise_tex);
+        st->noise_tex = gs_texture_create(st->texels_key.width, st->texels_key.height, GS_R16, 1, levels, 0);
+        st->active_key = st->texels_key;
+        st->noise_upload = false;
+    }
+
+    if (!st->grain_tex && grain_ready) {
+        const uint8_t *levels[1] = {(const uint8_t *)grain_texels};
+        uint32_t size = 1u << GRAIN_SIZE_LOG2;
+        st->grain_tex = gs_texture_create(size, size, GS_R16, 1, levels, 0);
+    }
+
+    bool baked = st->noise_tex && st->grain_tex;
+    gs_effect_set_bool(st->param_use_baked_noise, baked);
+    if (!baked) return;
+
+    struct vec2 period;
+    vec2_set(&period, (float)st->active_key.period_x, (float)st->active_key.period_y);
+    gs_effect_set_texture(st->param_noise_tex, st->noise_tex);
+    gs_effect_set_vec2(st->param_noise_period, &period);
+    gs_effect_set_texture(st->param_grain_tex, st->grain_tex);
+
+    struct vec2 offset = light_leak_next_grain_offset(st);
+    gs_effect_set_vec2(st->param_grain_offset, &offset);
+}
+
+// The colour shift, pulse and noise scroll of apply_leak/leak_spatial, which
+// only depend on elapsed_time, for the shader and the CPU path alike
+static void light_leak_frame_constants(void *data) {
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    float t = ed->elapsed_time;
+    float speed = param_get_float(ed, "leakSpeed");
+    vec2_set(&st->noise_scroll, t * speed * 0.3f, -t * speed * 0.2f);
+
+    struct vec4 leak;
+    vec4_from_rgba(&leak, param_get_color(ed, "leakColor"));
+    if (param_get_bool(ed, "enableColorShift")) {
+        struct vec4 second;
+        vec4_from_rgba(&second, param_get_color(ed, "secondLeakColor"));
+        float shift = (sinf(t * param_get_float(ed, "colorShiftSpeed")) + 1.0f) * 0.5f;
+        leak.x += (second.x - leak.x) * shift;
+        leak.y += (second.y - leak.y) * shift;
+        leak.z += (second.z - leak.z) * shift;
+        leak.w += (second.w - leak.w) * shift;
+    }
+    if (param_get_bool(ed, "enablePulsing")) {
+        float a = param_get_float(ed, "pulseMinAlpha");
+        float b = param_get_float(ed, "pulseMaxAlpha");
+        float pulse = (sinf(t * param_get_float(ed, "pulseSpeed")) + 1.0f) * 0.5f;
+        leak.w = fminf(a, b) + (fmaxf(a, b) - fminf(a, b)) * pulse;
+    }
+    st->frame_color = leak;
+}
+
+// leakIntensity. With auto_exposure brighter scenes take a stronger leak to
+// stay visible, darker ones a weaker one not to wash out.
+static float light_leak_intensity(const effect_data_t *ed, const light_leak_state_t *st) {
+    float intensity = param_get_float(ed, "leakIntensity");
+    return st->auto_exposure ? intensity * luma_stats_exposure(&ed->luma) : intensity;
+}
+
+static void light_leak_prepare_draw(void *data, float width, float height) {
+    (void)width;
+    (void)height;
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed ? ed->effect_state : NULL;
+
+    // Missing when the shader failed to load and passthrough was used instead
+    if (st && st->param_use_baked_noise) light_leak_prepare_textures(st);
+
+    if (st && st->param_leak_frame_color) {
+        gs_effect_set_vec4(st->param_leak_frame_color, &st->frame_color);
+        gs_effect_set_vec2(st->param_leak_noise_scroll, &st->noise_scroll);
+    }
+
+    if (st && st->auto_exposure && st->param_leak_intensity) {
+        gs_effect_set_float(st->param_leak_intensity, light_leak_intensity(ed, st));
+    }
+}
+
+// --- CPU path ---
+// light-leak-stage.inc per pixel on RGBA8 frames, from the same baked noise
+// and grain. The edge mask is a column term plus a row term, and the noise
+// row is fixed per image row, so only x varies inside the SIMD loop.
+
+typedef struct {
+    const light_leak_state_t *st;
+    const cpu_image_t *src;
+    cpu_image_t *dst;
+
+    float falloff;
+    float top_bias;
+    float bottom_bias;
+    float noise_scale[2];       // uv -> baked noise texture coordinates
+    float noise_offset[2];
+    float contrast;
+    float leak_rgb[3];
+    float alpha_scale;          // Alpha target * intensity
+    float hotspot_exponent;
+    float hotspot_intensity;
+    float hotspot_rgb[3];
+    float grain_amount;
+    float grain_scale[2];       // uv -> grain tiles
+    struct vec2 grain_offset;
+    int blend_mode;
+} leak_frame_t;
+
+// Index in [-1, size] wrapped into [0, size)
+static inline simd_i wrap_index(simd_i i, int size) {
+    simd_i low = simd_i_and(simd_i_lt(i, simd_i_set1(0)), simd_i_set1(size));
+    simd_i high = simd_i_and(simd_i_eq(i, simd_i_set1(size)), simd_i_set1(-size));
+    return simd_i_add(simd_i_add(i, low), high);
+}
+
+static inline simd_f leak_blend(int mode, simd_f base, simd_f leak, simd_f alpha) {
+    const simd_f one = simd_set1(1.0f);
+    const simd_f two = simd_set1(2.0f);
+    const simd_f half = simd_set1(0.5f);
+
+    switch (mode) {
+        case 1: // Additive
+            return simd_madd(leak, alpha, base);
+        case 2: { // Screen
+            simd_f screened = simd_sub(one, simd_mul(simd_sub(one, base), simd_sub(one, leak)));
+            return simd_lerp(base, screened, alpha);
+        }
+        case 3: { // Overlay
+            simd_f low = simd_mul(two, simd_mul(base, leak));
+            simd_f high = simd_sub(one, simd_mul(two, simd_mul(simd_sub(one, base), simd_sub(one, leak))));
+            return simd_lerp(base, simd_select(simd_lt(base, half), low, high), alpha);
+        }
+        case 4: { // Soft Light
+            simd_f low = simd_madd(simd_mul(base, base), simd_sub(one, simd_mul(two, leak)),
+                                   simd_mul(two, simd_mul(base, leak)));
+            simd_f high = simd_madd(simd_sqrt(base), simd_sub(simd_mul(two, leak), one),
+                                    simd_mul(two, simd_mul(base, simd_sub(one, leak))));
+            return simd_lerp(base, simd_select(simd_lt(leak, half), low, high), alpha);
+        }
+        default: // Alpha Blend
+            return simd_lerp(base, leak, alpha);
+    }
+}
+
+static void light_leak_rows(void *ctx, size_t begin, size_t end) {
+    const leak_frame_t *f = ctx;
+    const light_leak_state_t *st = f->st;
+    const int noise_w = (int)st->texels_key.width;
+    const int noise_h = (int)st->texels_key.height;
+    const int grain_size = 1 << GRAIN_SIZE_LOG2;
+    const float inv_width = 1.0f / (float)f->src->width;
+
+    const simd_f half = simd_set1(0.5f);
+    const simd_f unorm = simd_set1(1.0f / 65535.0f);
+    const simd_f contrast = simd_set1(f->contrast);
+    const simd_f hotspot_exponent = simd_set1(f->hotspot_exponent);
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        float v = ((float)y + 0.5f) / (float)f->src->height;
+        float row_mask = powf(1.0f - v, f->falloff) * f->top_bias + powf(v, f->falloff) * f->bottom_bias;
+
+        // Noise and grain rows are the same across the image row
+        float tv = v * f->noise_scale[1] + f->noise_offset[1];
+        float py = (tv - floorf(tv)) * (float)noise_h - 0.5f;
+        float fy0 = floorf(py);
+        int ny0 = (int)fy0 < 0 ? noise_h - 1 : (int)fy0;
+        int ny1 = (int)fy0 + 1 >= noise_h ? 0 : (int)fy0 + 1;
+        const simd_i noise_row0 = simd_i_set1(ny0 * noise_w);
+        const simd_i noise_row1 = simd_i_set1(ny1 * noise_w);
+        const simd_f noise_fy = simd_set1(py - fy0);
+
+        float gv = v * f->grain_scale[1] + f->grain_offset.y;
+        int grain_y = (int)((gv - floorf(gv)) * (float)grain_size);
+        const simd_i grain_row = simd_i_set1((grain_y < grain_size ? grain_y : grain_size - 1) * grain_size);
+
+        const uint32_t *in = cpu_image_row(f->src, y);
+        uint32_t *out = cpu_image_row(f->dst, y);
+        const simd_f row_term = simd_set1(row_mask);
+
+        for (uint32_t x = 0; x < f->src->width; x += SIMD_LANES) {
+            simd_f u = cpu_pixel_u(x, inv_width);
+            simd_f mask = simd_saturate(simd_add(simd_load(st->mask_columns + x), row_term));
+
+            // noise_tex.Sample(noiseSampler, ...): Linear, Wrap
+            simd_f tu = simd_frac(simd_madd(u, simd_set1(f->noise_scale[0]), simd_set1(f->noise_offset[0])));
+            simd_f px = simd_sub(simd_mul(tu, simd_set1((float)noise_w)), half);
+            simd_f fx0 = simd_floor(px);
+            simd_f fx = simd_sub(px, fx0);
+            simd_i ix = simd_i_from_f(fx0);
+            simd_i nx0 = wrap_index(ix, noise_w);
+            simd_i nx1 = wrap_index(simd_i_add(ix, simd_i_set1(1)), noise_w);
+            simd_f top = simd_lerp(simd_gather_u16(st->noise_texels, simd_i_add(noise_row0, nx0)),
+                                   simd_gather_u16(st->noise_texels, simd_i_add(noise_row0, nx1)), fx);
+            simd_f bottom = simd_lerp(simd_gather_u16(st->noise_texels, simd_i_add(noise_row1, nx0)),
+                                      simd_gather_u16(st->noise_texels, simd_i_add(noise_row1, nx1)), fx);
+            simd_f noise = simd_mul(simd_lerp(top, bottom, noise_fy), unorm);
+
+            simd_f spatial = simd_mul(simd_pow(simd_saturate(noise), contrast), mask);
+            simd_f hotspot = simd_mul(simd_pow(simd_saturate(spatial), hotspot_exponent),
+                                      simd_set1(f->hotspot_intensity));
+
+            // grain_tex.Sample(grainSampler, ...): Point, Wrap
+            simd_f gu = simd_frac(simd_madd(u, simd_set1(f->grain_scale[0]), simd_set1(f->grain_offset.x)));
+            simd_i gx = simd_i_min(simd_i_from_f(simd_mul(gu, simd_set1((float)grain_size))),
+                                   simd_i_set1(grain_size - 1));
+            simd_f grain = simd_madd(simd_gather_u16(grain_texels, simd_i_add(grain_row, gx)),
+                                     simd_set1(2.0f / 65535.0f), simd_set1(-1.0f));
+            simd_f modulator = simd_saturate(simd_madd(hotspot, half, spatial));
+            simd_f grain_term = simd_mul(simd_mul(grain, simd_set1(f->grain_amount)), modulator);
+
+            simd_f alpha = simd_saturate(simd_mul(spatial, simd_set1(f->alpha_scale)));
+            simd_rgba_t c = cpu_load_rgba(in, x);
+            simd_f *channels[3] = {&c.r, &c.g, &c.b};
+            for (int k = 0; k < 3; k++) {
+                simd_f leak = simd_add(simd_madd(simd_set1(f->hotspot_rgb[k]), hotspot, simd_set1(f->leak_rgb[k])),
+                                       grain_term);
+                *channels[k] = leak_blend(f->blend_mode, *channels[k], leak, alpha);
+            }
+            cpu_store_rgba(out, x, c);
+        }
+    }
+}
+
+static void light_leak_filter_frame(void *data, const cpu_image_t *src, cpu_image_t *dst) {
+    effect_data_t *ed = data;
+    light_leak_state_t *st = ed->effect_state;
+    if (st) light_leak_take_bake(st);
+
+    // Same fallback condition as use_baked_noise; the per-pixel fbm is
+    // left to the shader
+    if (!st || !st->noise_texels || !grain_ready) {
+        memcpy(dst->pixels, src->pixels, sizeof(uint32_t) * src->stride * src->height);
+        return;
+    }
+
+    if (st->mask_columns_size < src->stride) {
+        bfree(st->mask_columns);
+        st->mask_columns = bmalloc(sizeof(float) * src->stride);
+        st->mask_columns_size = src->stride;
+    }
+
+    leak_frame_t f = {.st = st, .src = src, .dst = dst};
+    f.falloff = param_get_float(ed, "edgeFalloff");
+    f.top_bias = param_get_float(ed, "topBias");
+    f.bottom_bias = param_get_float(ed, "bottomBias");
+
+    float left_bias = param_get_float(ed, "leftBias");
+    float right_bias = param_get_float(ed, "rightBias");
+    for (uint32_t x = 0; x < src->stride; x++) {
+        float u = ((float)x + 0.5f) / (float)src->width;
+        st->mask_columns[x] = powf(fmaxf(1.0f - u, 0.0f), f.falloff) * left_bias + powf(u, f.falloff) * right_bias;
+    }
+
+    float scale = param_get_float(ed, "leakScale");
+    float streakiness = param_get_float(ed, "streakiness");
+    float stretch_x = streakiness > 1.01f ? streakiness : 1.0f;
+    float stretch_y = (streakiness < 0.99f && streakiness > 0.0f) ? 1.0f / streakiness : 1.0f;
+    f.noise_scale[0] = scale * stretch_x / (float)st->texels_key.period_x;
+    f.noise_scale[1] = scale * stretch_y / (float)st->texels_key.period_y;
+    f.noise_offset[0] = st->noise_scroll.x / (float)st->texels_key.period_x;
+    f.noise_offset[1] = st->noise_scroll.y / (float)st->texels_key.period_y;
+    f.contrast = param_get_float(ed, "leakShapeContrast");
+
+    const struct vec4 *leak = &st->frame_color;
+    struct vec4 hotspot;
+    vec4_from_rgba(&hotspot, param_get_color(ed, "hotspotColor"));
+    f.leak_rgb[0] = leak->x;
+    f.leak_rgb[1] = leak->y;
+    f.leak_rgb[2] = leak->z;
+    f.hotspot_rgb[0] = hotspot.x;
+    f.hotspot_rgb[1] = hotspot.y;
+    f.hotspot_rgb[2] = hotspot.z;
+    f.alpha_scale = leak->w * light_leak_intensity(ed, st);
+    f.hotspot_exponent = param_get_float(ed, "hotspotExponent");
+    f.hotspot_intensity = param_get_float(ed, "hotspotIntensity");
+
+    float grain_scale = param_get_float(ed, "grainScale") / 100.0f / (float)(1 << GRAIN_SIZE_LOG2);
+    f.grain_amount = param_get_float(ed, "grainAmount");
+    f.grain_scale[0] = (float)src->width * grain_scale;
+    f.grain_scale[1] = (float)src->height * grain_scale;
+    f.grain_offset = light_leak_next_grain_offset(st);
+    f.blend_mode = param_get_int(ed, "blendMode");
+
+    task_pool_parallel_for(task_pool_shared(), src->height, CPU_ROWS_PER_TASK, light_leak_rows, &f);
+}
+
 static void light_leak_defaults(obs_data_t *s) {
     for (size_t i = 0; i < sizeof(light_leak_params)/sizeof(light_leak_params[0]); i++) {
         const param_def_t *def = &light_leak_params[i];
@@ -55,8 +699,36 @@ static void light_leak_defaults(obs_data_t *s) {
     }
 }
 
+static const effect_stage_t light_leak_stage = {
+    .define = "STACK_WITH_LIGHT_LEAK",
+    .function = "light_leak_stage",
+    .samples_input = false
+};
+
+static const char *const light_leak_extra_shaders[] = {LUMA_REDUCE_SHADER, NULL};
+
 const effect_info_t light_leak_info = {
-    "liteleke_effect", "Light Leak", "Adds organic light leaks", "shaders/light-leak.shader",
-    light_leak_params, sizeof(light_leak_params)/sizeof(light_leak_params[0]),
-    generic_create, generic_destroy, generic_update, generic_render, generic_tick, generic_properties, light_leak_defaults
+    .id = "liteleke_effect",
+    .name = "Light Leak",
+    .description = "Adds organic light leaks",
+    .shader_path = "shaders/light-leak.shader",
+    .extra_shaders = light_leak_extra_shaders,
+    .params = light_leak_params,
+    .num_params = sizeof(light_leak_params)/sizeof(light_leak_params[0]),
+    .create = light_leak_create,
+    .destroy = light_leak_destroy,
+    .update = light_leak_update,
+    .video_render = generic_render,
+    .video_tick = generic_tick,
+    .get_properties = generic_properties,
+    .get_defaults = light_leak_defaults,
+    .frame_constants = light_leak_frame_constants,
+    .params_synced = light_leak_params_synced,
+    .prepare_draw = light_leak_prepare_draw,
+    .bind_effect = light_leak_bind_effect,
+    .stage = &light_leak_stage,
+    .filter_frame = light_leak_filter_frame,
+    .is_identity = light_leak_is_identity,
+    .is_static = light_leak_is_static,
+    .flags = EFFECT_FLAG_SPLIT_OVERLAY
 };
@@ -0,0 +1,471 @@
+/*
+ * src/effects/stack/stack.c
+ * EmuLens Stack: runs several registered effects inside one filter. Members
+ * with a per-pixel stage share one generated pass; the rest ping-pong
+ * between two render targets instead of each capturing the source again.
+ */
+
+#include "stack.h"
+#include "../effect-registry.h"
+#include "../handheld/handheld.h"
+#include "../lightleak/lightleak.h"
+#include "../starburst/starburst.h"
+#include "../../utils/logging.h"
+#include <util/threading.h>
+
+#define STACK_SHADER "shaders/emulens-stack.shader"
+#define STACK_MAX_SLOTS 4  // STACK_STAGE_0..3 in emulens-stack.shader
+#define STACK_SLOT_SETTING "stack_slot_%zu"
+
+typedef struct {
+    const effect_info_t *info;  // NULL = empty slot
+    effect_data_t *member;      // From effect_create_member
+    uint32_t fused_group;       // Slot mask of the fused pass it is bound to, 0 = its own effect
+} stack_slot_t;
+
+typedef struct {
+    stack_slot_t slots[STACK_MAX_SLOTS];
+    gs_texrender_t *ping[2];
+    bool fuse_failed;           // Stack shader didn't compile: every member draws alone
+} stack_state_t;
+
+// One draw: a fused group of members or a single member with its own effect
+typedef struct {
+    gs_effect_t *effect;
+    effect_data_t *members[STACK_MAX_SLOTS];
+    size_t num_members;
+} stack_pass_t;
+
+static const effect_info_t *const stack_default_slots[STACK_MAX_SLOTS] = {
+    &handheld_info, &light_leak_info, &star_burst_info, NULL
+};
+
+static bool stack_can_host(const effect_info_t *info) {
+    return info && info != &stack_info && info->create && info->id && !(info->flags & EFFECT_FLAG_NO_STACK);
+}
+
+static const effect_info_t *stack_find_effect(const char *id) {
+    if (!id || !*id) return NULL;
+
+    for (size_t i = 0; i < num_effects; i++) {
+        if (stack_can_host(effects[i]) && strcmp(effects[i]->id, id) == 0) return effects[i];
+    }
+    return NULL;
+}
+
+// Setting name of a member parameter, e.g. "s0.handheld_effect.preset".
+// An empty `name` gives the prefix for the slot and effect.
+static void stack_param_key(struct dstr *key, size_t slot, const effect_info_t *info, const char *name) {
+    dstr_printf(key, "s%zu.%s.%s", slot, info->id, name);
+}
+
+// --- Members ---
+
+// The member's own settings, read from the stack's prefixed ones
+static obs_data_t *stack_member_settings(obs_data_t *settings, size_t slot, const effect_info_t *info) {
+    obs_data_t *member_settings = obs_data_create();
+    struct dstr key = {0};
+
+    for (size_t i = 0; i < info->num_params; i++) {
+        const param_def_t *def = &info->params[i];
+        stack_param_key(&key, slot, info, def->name);
+
+        switch (def->type) {
+            case PARAM_FLOAT:
+                obs_data_set_double(member_settings, def->name, obs_data_get_double(settings, key.array));
+                break;
+            case PARAM_INT:
+            case PARAM_COLOR:
+                obs_data_set_int(member_settings, def->name, obs_data_get_int(settings, key.array));
+                break;
+            case PARAM_BOOL:
+                obs_data_set_bool(member_settings, def->name, obs_data_get_bool(settings, key.array));
+                break;
+        }
+    }
+
+    dstr_free(&key);
+    return member_settings;
+}
+
+static void stack_clear_slot(stack_slot_t *slot) {
+    if (slot->member) slot->info->destroy(slot->member);
+    slot->info = NULL;
+    slot->member = NULL;
+    slot->fused_group = 0;
+}
+
+static void *stack_create(obs_data_t *settings, obs_source_t *source) {
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed) return NULL;
+
+    ed->effect_state = bzalloc(sizeof(stack_state_t));
+    return ed;
+}
+
+static void stack_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    stack_state_t *st = ed->effect_state;
+    if (st) {
+        for (size_t i = 0; i < STACK_MAX_SLOTS; i++) stack_clear_slot(&st->slots[i]);
+
+        obs_enter_graphics();
+        gs_texrender_destroy(st->ping[0]);
+        gs_texrender_destroy(st->ping[1]);
+        obs_leave_graphics();
+
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+    generic_destroy(ed);
+}
+
+// Filter updates are deferred to the graphics thread, so members are never
+// replaced under a render
+static void stack_update(void *data, obs_data_t *settings) {
+    effect_data_t *ed = data;
+    stack_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    struct dstr key = {0};
+    for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+        stack_slot_t *slot = &st->slots[i];
+        dstr_printf(&key, STACK_SLOT_SETTING, i);
+        const effect_info_t *info = stack_find_effect(obs_data_get_string(settings, key.array));
+
+        if (info != slot->info) stack_clear_slot(slot);
+        if (!info) continue;
+
+        obs_data_t *member_settings = stack_member_settings(settings, i, info);
+        if (slot->member) {
+            info->update(slot->member, member_settings);
+        } else {
+            slot->member = effect_create_member(info, member_settings, ed->context);
+            slot->info = slot->member ? info : NULL;
+            if (!slot->member) EFFECT_LOG_WARNING(ed, "Failed to create %s in slot %zu", info->name, i + 1);
+        }
+        obs_data_release(member_settings);
+    }
+    dstr_free(&key);
+}
+
+static void stack_tick(void *data, float seconds) {
+    generic_tick(data, seconds);
+
+    effect_data_t *ed = data;
+    stack_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+        stack_slot_t *slot = &st->slots[i];
+        if (slot->member && slot->info->video_tick) slot->info->video_tick(slot->member, seconds);
+    }
+}
+
+// --- Pass planning ---
+
+static bool stack_group_has(const stack_state_t *st, uint32_t group, const effect_info_t *info) {
+    for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+        if ((group & (1u << i)) && st->slots[i].info == info) return true;
+    }
+    return false;
+}
+
+// Splits the members, in order, into slot masks. A stage that samples the
+// input starts a group; per-pixel stages join the open group unless an
+// instance of the same effect is in it already, since both would bind the
+// same uniforms. Members without a stage are groups of their own.
+static size_t stack_group_slots(const stack_state_t *st, uint32_t groups[STACK_MAX_SLOTS]) {
+    size_t num_groups = 0;
+    bool open = false;
+
+    for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+        const stack_slot_t *slot = &st->slots[i];
+        if (!slot->member) continue;
+
+        const effect_stage_t *stage = st->fuse_failed ? NULL : slot->info->stage;
+        if (stage && open && !stage->samples_input && !stack_group_has(st, groups[num_groups - 1], slot->info)) {
+            groups[num_groups - 1] |= 1u << i;
+            continue;
+        }
+
+        groups[num_groups++] = 1u << i;
+        open = stage != NULL;
+    }
+    return num_groups;
+}
+
+// Binds a group's members to the stack shader variant that chains their
+// stages. Each member holds its own reference and sets its own uniforms.
+// Returns the effect, or NULL while the variant compiles.
+static gs_effect_t *stack_fuse(effect_data_t *ed, stack_state_t *st, uint32_t group) {
+    gs_effect_t *bound = NULL;
+    bool rebind = false;
+    for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+        stack_slot_t *slot = &st->slots[i];
+        if (!(group & (1u << i))) continue;
+
+        if (!bound) bound = slot->member->effect;
+        rebind |= slot->fused_group != group || slot->member->effect != bound ||
+                  os_atomic_load_bool(&slot->member->variant_stale);
+    }
+    if (!rebind) return bound;
+
+    struct dstr defines = {0};
+    struct dstr spec = {0};
+    size_t num_stages = 0;
+    for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+        stack_slot_t *slot = &st->slots[i];
+        if (!(group & (1u << i))) continue;
+
+        // Cleared before reading the values; the next sync re-flags it if they change
+        os_atomic_set_bool(&slot->member->variant_stale, false);
+
+        const effect_stage_t *stage = slot->info->stage;
+        dstr_catf(&defines, "#define %s\n", stage->define);
+        if (stage->samples_input) {
+            dstr_catf(&defines, "#define STACK_SAMPLE(uv) %s(uv)\n", stage->function);
+        } else {
+            dstr_catf(&defines, "#define STACK_STAGE_%zu(c, uv) %s(c, uv)\n", num_stages++, stage->function);
+        }
+
+        param_store_variant_defines(&slot->member->params, slot->info, &spec);
+        if (spec.array) dstr_cat(&defines, spec.array);
+    }
+
+    bool failed = false;
+    gs_effect_t *effect = effect_cache_try_acquire_variant(STACK_SHADER, defines.array, &failed);
+    if (effect) {
+        gs_effect_t *ref = effect;
+        for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+            stack_slot_t *slot = &st->slots[i];
+            if (!(group & (1u << i))) continue;
+
+            if (!ref) ref = effect_cache_try_acquire_variant(STACK_SHADER, defines.array, NULL);
+            generic_bind_effect(slot->member, ref, defines.array);
+            slot->fused_group = group;
+            ref = NULL;
+        }
+    } else if (failed) {
+        st->fuse_failed = true;
+        EFFECT_LOG_WARNING(ed, "Stack shader failed to compile, drawing each effect separately");
+    }
+
+    dstr_free(&spec);
+    dstr_free(&defines);
+    return effect;
+}
+
+// The member's own effect, dropping a fused one first. NULL while that is
+// still compiling; the member is then skipped this frame.
+static gs_effect_t *stack_unfuse(stack_slot_t *slot) {
+    effect_data_t *member = slot->member;
+    if (slot->fused_group) {
+        effect_cache_release(member->effect);
+        member->effect = NULL;
+        dstr_free(&member->variant);
+        os_atomic_set_bool(&member->variant_stale, true);
+        slot->fused_group = 0;
+    }
+    return generic_ensure_effect(member) ? member->effect : NULL;
+}
+
+static size_t stack_plan_passes(effect_data_t *ed, stack_state_t *st, stack_pass_t passes[STACK_MAX_SLOTS]) {
+    uint32_t groups[STACK_MAX_SLOTS];
+    size_t num_groups = stack_group_slots(st, groups);
+    size_t num_passes = 0;
+
+    for (size_t g = 0; g < num_groups; g++) {
+        bool fusable = (groups[g] & (groups[g] - 1)) != 0; // More than one member
+        gs_effect_t *fused = fusable ? stack_fuse(ed, st, groups[g]) : NULL;
+
+        if (fused) {
+            stack_pass_t *pass = &passes[num_passes++];
+            pass->effect = fused;
+            pass->num_members = 0;
+            for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+                if (groups[g] & (1u << i)) pass->members[pass->num_members++] = st->slots[i].member;
+            }
+            continue;
+        }
+
+        // Alone, or separately until the fused variant has compiled
+        for (size_t i = 0; i < STACK_MAX_SLOTS; i++) {
+            if (!(groups[g] & (1u << i))) continue;
+
+            gs_effect_t *own = stack_unfuse(&st->slots[i]);
+            if (!own) continue;
+
+            stack_pass_t *pass = &passes[num_passes++];
+            pass->effect = own;
+            pass->members[0] = st->slots[i].member;
+            pass->num_members = 1;
+        }
+    }
+    return num_passes;
+}
+
+// --- Rendering ---
+
+static void stack_draw_pass(const stack_pass_t *pass, gs_texture_t *input, uint32_t cx, uint32_t cy) {
+    for (size_t i = 0; i < pass->num_members; i++) {
+        generic_prepare_draw(pass->members[i], (float)cx, (float)cy);
+    }
+
+    gs_eparam_t *image = pass->members[0]->param_image;
+    if (image) gs_effect_set_texture(image, input);
+
+    while (gs_effect_loop(pass->effect, "Draw")) {
+        gs_draw_sprite(input, 0, cx, cy);
+    }
+}
+
+static void stack_render(void *data, gs_effect_t *effect) {
+    (void)effect;
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    stack_state_t *st = ed->effect_state;
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    uint32_t width = target ? obs_source_get_width(target) : 0;
+    uint32_t height = target ? obs_source_get_height(target) : 0;
+
+    stack_pass_t passes[STACK_MAX_SLOTS];
+    size_t num_passes = (st && width > 0 && height > 0) ? stack_plan_passes(ed, st, passes) : 0;
+    if (num_passes == 0) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    ensure_render_target(ed, &st->ping[1]);
+    if (!render_filter_input(ed, ensure_render_target(ed, &st->ping[0]), width, height)) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    // Every pass but the last replaces its target; the last draws to the
+    // filter's output with the caller's blending, as generic_render does
+    size_t src = 0;
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    for (size_t i = 0; i + 1 < num_passes; i++) {
+        gs_texture_t *input = gs_texrender_get_texture(st->ping[src]);
+        if (!input || !render_pass_begin(st->ping[1 - src], width, height, false)) continue;
+
+        stack_draw_pass(&passes[i], input, width, height);
+        gs_texrender_end(st->ping[1 - src]);
+        src = 1 - src;
+    }
+    gs_blend_state_pop();
+
+    gs_texture_t *input = gs_texrender_get_texture(st->ping[src]);
+    if (input) stack_draw_pass(&passes[num_passes - 1], input, width, height);
+}
+
+// --- Settings & UI ---
+
+static void stack_defaults(obs_data_t *s) {
+    struct dstr key = {0};
+
+    for (size_t slot = 0; slot < STACK_MAX_SLOTS; slot++) {
+        const effect_info_t *initial = stack_default_slots[slot];
+        dstr_printf(&key, STACK_SLOT_SETTING, slot);
+        obs_data_set_default_string(s, key.array, initial ? initial->id : "");
+
+        for (size_t e = 0; e < num_effects; e++) {
+            const effect_info_t *info = effects[e];
+            if (!stack_can_host(info)) continue;
+
+            for (size_t i = 0; i < info->num_params; i++) {
+                const param_def_t *def = &info->params[i];
+                stack_param_key(&key, slot, info, def->name);
+                switch (def->type) {
+                    case PARAM_FLOAT: obs_data_set_default_double(s, key.array, def->default_val.f_val); break;
+                    case PARAM_INT:   obs_data_set_default_int(s, key.array, def->default_val.i_val); break;
+                    case PARAM_BOOL:  obs_data_set_default_bool(s, key.array, def->default_val.b_val); break;
+                    case PARAM_COLOR: obs_data_set_default_int(s, key.array, def->default_val.i_val); break;
+                }
+            }
+        }
+    }
+
+    dstr_free(&key);
+}
+
+// Shows the settings group of the effect picked in each slot
+static bool stack_slot_modified(obs_properties_t *props, obs_property_t *property, obs_data_t *settings) {
+    (void)property;
+    struct dstr key = {0};
+
+    for (size_t slot = 0; slot < STACK_MAX_SLOTS; slot++) {
+        dstr_printf(&key, STACK_SLOT_SETTING, slot);
+        const effect_info_t *picked = stack_find_effect(obs_data_get_string(settings, key.array));
+
+        for (size_t e = 0; e < num_effects; e++) {
+            const effect_info_t *info = effects[e];
+            if (!stack_can_host(info)) continue;
+
+            dstr_printf(&key, "s%zu.%s", slot, info->id);
+            obs_property_t *group = obs_properties_get(props, key.array);
+            if (group) obs_property_set_visible(group, info == picked);
+        }
+    }
+
+    dstr_free(&key);
+    return true;
+}
+
+static obs_properties_t *stack_properties(void *data) {
+    (void)data;
+    obs_properties_t *props = obs_properties_create();
+    struct dstr name = {0};
+    struct dstr label = {0};
+
+    for (size_t slot = 0; slot < STACK_MAX_SLOTS; slot++) {
+        dstr_printf(&name, STACK_SLOT_SETTING, slot);
+        dstr_printf(&label, "Effect %zu", slot + 1);
+        obs_property_t *list = obs_properties_add_list(props, name.array, label.array,
+                                                       OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+        obs_property_list_add_string(list, "None", "");
+        for (size_t e = 0; e < num_effects; e++) {
+            if (stack_can_host(effects[e])) obs_property_list_add_string(list, effects[e]->name, effects[e]->id);
+        }
+        obs_property_set_modified_callback(list, stack_slot_modified);
+
+        // One group per effect the slot can hold, shown when it is picked
+        for (size_t e = 0; e < num_effects; e++) {
+            const effect_info_t *info = effects[e];
+            if (!stack_can_host(info)) continue;
+
+            obs_properties_t *group = obs_properties_create();
+            stack_param_key(&name, slot, info, "");
+            add_param_properties(group, info, name.array);
+
+            dstr_printf(&name, "s%zu.%s", slot, info->id);
+            dstr_printf(&label, "%zu: %s", slot + 1, info->name);
+            obs_properties_add_group(props, name.array, label.array, OBS_GROUP_NORMAL, group);
+        }
+    }
+
+    dstr_free(&label);
+    dstr_free(&name);
+    return props;
+}
+
+const effect_info_t stack_info = {
+    .id = "emulens_stack",
+    .name = "EmuLens Stack",
+    .description = "Runs several EmuLens effects as one filter, fusing per-pixel effects into a single pass",
+    .shader_path = STACK_SHADER,
+    .params = NULL,
+    .num_params = 0,
+    .create = stack_create,
+    .destroy = stack_destroy,
+    .update = stack_update,
+    .video_render = stack_render,
+    .video_tick = stack_tick,
+    .get_properties = stack_properties,
+    .get_defaults = stack_defaults
+};
@@ -0,0 +1,4 @@
+#pragma once
+#include "../../core/effect-core.h"
+
+extern const effect_info_t stack_info;
@@ -3,27 +3,622 @@
  */
 
 #include "starburst.h"
+#include "../../core/cpu-image.h"
+#include "../../utils/logging.h"
+#include "../../utils/task-pool.h"
+#include <util/threading.h>
+#include <math.h>
+
+#define STAR_BURST_MULTIPASS_SHADER "shaders/star-burst-multipass.shader"
+#define STREAK_TAPS 4        // Must match STREAK_TAPS in star-burst-multipass.shader
+#define STREAK_MAX_PASSES 6  // 4^6 taps covers a 4K ray at half resolution
+#define BRIGHT_PASS_DIVISOR 2
+#define AUTO_THRESHOLD_FRACTION 0.8f // Of the way from mean to peak scene luminance
+#define MAX_STAR_POINTS 16   // Must match MAX_STAR_POINTS in star-burst.shader
 
 static const param_def_t star_burst_params[] = {
-    {"Threshold", "Threshold", "Brightness threshold", PARAM_FLOAT, {.f_val=0.7}, 0.33, 2.0, 0.01},
-    {"Intensity", "Intensity", "Ray intensity", PARAM_FLOAT, {.f_val=3.0}, 1.0, 10.0, 0.5},
-    {"StarPoints", "Star Points", "Number of points", PARAM_INT, {.i_val=8}, 4, 16, 2},
-    {"RayLength", "Ray Length", "Length of rays", PARAM_FLOAT, {.f_val=0.2}, 0.05, 0.5, 0.05},
-    {"RayThickness", "Ray Thickness", "Thickness of rays", PARAM_FLOAT, {.f_val=2.0}, 0.5, 5.0, 0.5},
-    {"RaySmoothness", "Ray Smoothness", "Falloff smoothness", PARAM_FLOAT, {.f_val=3.0}, 1.0, 10.0, 0.5},
-    {"Rotation", "Rotation", "Static rotation", PARAM_FLOAT, {.f_val=0.0}, 0.0, 6.283, 0.1},
-    {"ColorizeRays", "Colorize Rays", "Enable custom ray color", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"RayColor", "Ray Color", "Custom ray color", PARAM_COLOR, {.i_val=0xFFFFFFFF}, 0, 0, 0},
-    {"EnableRotation", "Animate Rotation", "Enable continuous rotation", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"RotationSpeed", "Rotation Speed", "Speed of rotation animation", PARAM_FLOAT, {.f_val=0.5}, -2.0, 2.0, 0.1},
-    {"ExtendRays", "Extend Rays", "Extend rays beyond bright areas", PARAM_BOOL, {.b_val=true}, 0, 0, 0},
-    {"AnamorphicRays", "Anamorphic", "Stretch rays horizontally", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"ray_sample_count", "Quality", "Ray sample quality", PARAM_INT, {.i_val=8}, 4, 12, 1},
-    {"CoreGlowIntensity", "Core Glow", "Source glow intensity", PARAM_FLOAT, {.f_val=0.3}, 0.0, 2.0, 0.05},
-    {"CoreGlowUsesRayColor", "Tint Core Glow", "Use ray color for core glow", PARAM_BOOL, {.b_val=false}, 0, 0, 0},
-    {"RayEdgeSoftness", "Ray Softness", "Edge softness of rays", PARAM_FLOAT, {.f_val=1.5}, 0.5, 5.0, 0.1}
+    {"Threshold", "Threshold", "Brightness threshold", PARAM_FLOAT, {.f_val=0.7}, 0.33, 2.0, 0.01, 0},
+    {"Intensity", "Intensity", "Ray intensity", PARAM_FLOAT, {.f_val=3.0}, 1.0, 10.0, 0.5, 0},
+    {"StarPoints", "Star Points", "Number of points", PARAM_INT, {.i_val=8}, 4, 16, 2, PARAM_FLAG_QUALITY},
+    {"RayLength", "Ray Length", "Length of rays", PARAM_FLOAT, {.f_val=0.2}, 0.05, 0.5, 0.05, 0},
+    {"RayThickness", "Ray Thickness", "Thickness of rays", PARAM_FLOAT, {.f_val=2.0}, 0.5, 5.0, 0.5, 0},
+    {"RaySmoothness", "Ray Smoothness", "Falloff smoothness", PARAM_FLOAT, {.f_val=3.0}, 1.0, 10.0, 0.5, 0},
+    {"Rotation", "Rotation", "Static rotation", PARAM_FLOAT, {.f_val=0.0}, 0.0, 6.283, 0.1, 0},
+    {"ColorizeRays", "Colorize Rays", "Enable custom ray color", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_SPECIALIZE},
+    {"RayColor", "Ray Color", "Custom ray color", PARAM_COLOR, {.i_val=0xFFFFFFFF}, 0, 0, 0, 0},
+    {"EnableRotation", "Animate Rotation", "Enable continuous rotation", PARAM_BOOL, {.b_val=false}, 0, 0, 0, 0},
+    {"RotationSpeed", "Rotation Speed", "Speed of rotation animation", PARAM_FLOAT, {.f_val=0.5}, -2.0, 2.0, 0.1, 0},
+    {"ExtendRays", "Extend Rays", "Extend rays beyond bright areas", PARAM_BOOL, {.b_val=true}, 0, 0, 0, PARAM_FLAG_SPECIALIZE},
+    {"AnamorphicRays", "Anamorphic", "Stretch rays horizontally", PARAM_BOOL, {.b_val=false}, 0, 0, 0, 0},
+    {"ray_sample_count", "Quality", "Ray sample quality", PARAM_INT, {.i_val=8}, 4, 12, 1, PARAM_FLAG_QUALITY},
+    {"CoreGlowIntensity", "Core Glow", "Source glow intensity", PARAM_FLOAT, {.f_val=0.3}, 0.0, 2.0, 0.05, 0},
+    {"CoreGlowUsesRayColor", "Tint Core Glow", "Use ray color for core glow", PARAM_BOOL, {.b_val=false}, 0, 0, 0, 0},
+    {"RayEdgeSoftness", "Ray Softness", "Edge softness of rays", PARAM_FLOAT, {.f_val=1.5}, 0.5, 5.0, 0.1, 0},
+    {"auto_threshold", "Auto Threshold", "Follow the scene so only its brightest highlights cast rays (replaces Threshold)", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM},
+    {"multi_pass", "Fast Multi-pass", "Render rays with separable streak passes (cost scales with ray length, not Quality)", PARAM_BOOL, {.b_val=false}, 0, 0, 0, PARAM_FLAG_NO_UNIFORM},
+
+    PARAM_CPU_PATH,
+    PARAM_QUALITY_BUDGET
 };
 
+// State for the multi-pass renderer
+typedef struct {
+    // Synced settings, see star_burst_params_synced (the multi-pass effect has
+    // its own uniforms)
+    bool multi_pass;
+    bool auto_threshold;
+    float threshold;
+    float intensity;
+    float ray_length;
+    float ray_smoothness;
+    bool colorize_rays;
+    uint32_t ray_color;
+    bool enable_rotation;
+    float core_glow_intensity;
+    bool core_glow_uses_ray_color;
+    float ray_edge_softness;
+
+    // Ray directions for this frame, see star_burst_frame_constants
+    float ray_dirs[MAX_STAR_POINTS][2];
+    int num_rays;
+
+    gs_eparam_t *param_ray_dirs;        // Single-pass shader handles, looked up in star_burst_bind_effect
+    gs_eparam_t *param_single_threshold;
+
+    gs_effect_t *effect;   // Bound on first multi-pass render
+    bool effect_failed;
+    gs_eparam_t *param_image;
+    gs_eparam_t *param_streak_image;
+    gs_eparam_t *param_streak_step;
+    gs_eparam_t *param_streak_decay;
+    gs_eparam_t *param_streak_gain;
+    gs_eparam_t *param_ray_gain;
+    gs_eparam_t *param_threshold;
+    gs_eparam_t *param_intensity;
+    gs_eparam_t *param_colorize_rays;
+    gs_eparam_t *param_ray_color;
+    gs_eparam_t *param_core_glow_intensity;
+    gs_eparam_t *param_core_glow_uses_ray_color;
+
+    gs_texrender_t *input;
+    gs_texrender_t *bright;
+    gs_texrender_t *streak[2];
+    gs_texrender_t *accum;
+
+    // CPU path: the bright, streak and accumulator targets above as planes
+    cpu_plane_t cpu_bright;
+    cpu_plane_t cpu_streak[2];
+    cpu_plane_t cpu_accum;
+} star_burst_state_t;
+
+// One streak chain, see star_burst_render_streak
+typedef struct {
+    int passes;
+    float step_u, step_v;       // UV between taps of the first pass
+    float tap_decay;            // Falloff per tap of the first pass
+} streak_plan_t;
+
+static void *star_burst_create(obs_data_t *settings, obs_source_t *source) {
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed) return NULL;
+
+    star_burst_state_t *st = bzalloc(sizeof(star_burst_state_t));
+    ed->effect_state = st;
+
+    return ed;
+}
+
+// Binds the multi-pass effect once the loader has it. Returns false while it
+// is compiling or if it is unavailable, in which case the single-pass shader
+// renders instead.
+static bool star_burst_ensure_effect(effect_data_t *ed, star_burst_state_t *st) {
+    if (st->effect) return true;
+    if (st->effect_failed) return false;
+
+    bool failed = false;
+    st->effect = effect_cache_try_acquire(STAR_BURST_MULTIPASS_SHADER, &failed);
+
+    // load_shader_effect may hand back the passthrough fallback
+    if (st->effect && !gs_effect_get_technique(st->effect, "Composite")) {
+        effect_cache_release(st->effect);
+        st->effect = NULL;
+        failed = true;
+    }
+
+    if (failed) {
+        st->effect_failed = true;
+        EFFECT_LOG_WARNING(ed, "Multi-pass shader unavailable, fast mode disabled");
+    }
+    if (!st->effect) return false;
+
+    st->param_image = gs_effect_get_param_by_name(st->effect, "image");
+    st->param_streak_image = gs_effect_get_param_by_name(st->effect, "streak_image");
+    st->param_streak_step = gs_effect_get_param_by_name(st->effect, "streak_step");
+    st->param_streak_decay = gs_effect_get_param_by_name(st->effect, "streak_decay");
+    st->param_streak_gain = gs_effect_get_param_by_name(st->effect, "streak_gain");
+    st->param_ray_gain = gs_effect_get_param_by_name(st->effect, "ray_gain");
+    st->param_threshold = gs_effect_get_param_by_name(st->effect, "Threshold");
+    st->param_intensity = gs_effect_get_param_by_name(st->effect, "Intensity");
+    st->param_colorize_rays = gs_effect_get_param_by_name(st->effect, "ColorizeRays");
+    st->param_ray_color = gs_effect_get_param_by_name(st->effect, "RayColor");
+    st->param_core_glow_intensity = gs_effect_get_param_by_name(st->effect, "CoreGlowIntensity");
+    st->param_core_glow_uses_ray_color = gs_effect_get_param_by_name(st->effect, "CoreGlowUsesRayColor");
+    return true;
+}
+
+static void star_burst_bind_effect(void *data) {
+    effect_data_t *ed = data;
+    star_burst_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->param_ray_dirs = gs_effect_get_param_by_name(ed->effect, "ray_dirs");
+    st->param_single_threshold = gs_effect_get_param_by_name(ed->effect, "Threshold");
+}
+
+static void star_burst_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    star_burst_state_t *st = ed->effect_state;
+    if (st) {
+        obs_enter_graphics();
+        effect_cache_release(st->effect);
+        gs_texrender_destroy(st->input);
+        gs_texrender_destroy(st->bright);
+        gs_texrender_destroy(st->streak[0]);
+        gs_texrender_destroy(st->streak[1]);
+        gs_texrender_destroy(st->accum);
+        obs_leave_graphics();
+
+        cpu_plane_free(&st->cpu_bright);
+        cpu_plane_free(&st->cpu_streak[0]);
+        cpu_plane_free(&st->cpu_streak[1]);
+        cpu_plane_free(&st->cpu_accum);
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+
+    generic_destroy(ed);
+}
+
+static void star_burst_params_synced(void *data) {
+    effect_data_t *ed = data;
+    star_burst_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->multi_pass = param_get_bool(ed, "multi_pass");
+    st->auto_threshold = param_get_bool(ed, "auto_threshold");
+    st->threshold = param_get_float(ed, "Threshold");
+    st->intensity = param_get_float(ed, "Intensity");
+    st->ray_length = param_get_float(ed, "RayLength");
+    st->ray_smoothness = param_get_float(ed, "RaySmoothness");
+    st->colorize_rays = param_get_bool(ed, "ColorizeRays");
+    st->ray_color = param_get_color(ed, "RayColor");
+    st->enable_rotation = param_get_bool(ed, "EnableRotation");
+    st->core_glow_intensity = param_get_float(ed, "CoreGlowIntensity");
+    st->core_glow_uses_ray_color = param_get_bool(ed, "CoreGlowUsesRayColor");
+    st->ray_edge_softness = param_get_float(ed, "RayEdgeSoftness");
+
+    ed->luma_wanted = st->auto_threshold;
+}
+
+// --- Elision ---
+// Threshold stops at 0.33, so whether anything casts rays depends on the
+// frame; only the CPU path, which sees the bright pass, skips on that.
+
+// Rays stay put without EnableRotation. Not while the multi-pass effect is
+// still compiling, or the single-pass output would be kept.
+static bool star_burst_is_static(void *data) {
+    effect_data_t *ed = data;
+    const star_burst_state_t *st = ed->effect_state;
+    if (!st || st->enable_rotation || st->auto_threshold) return false;
+    return !st->multi_pass || st->effect || st->effect_failed;
+}
+
+// The input copy keeps the source's range, so highlights over 1.0 in HDR
+// still cast rays
+static bool star_burst_ensure_targets(effect_data_t *ed, star_burst_state_t *st) {
+    ensure_render_target(ed, &st->input);
+    if (!st->bright) st->bright = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+    if (!st->streak[0]) st->streak[0] = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+    if (!st->streak[1]) st->streak[1] = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+    if (!st->accum) st->accum = gs_texrender_create(GS_R16F, GS_ZS_NONE);
+
+    return st->input && st->bright && st->streak[0] && st->streak[1] && st->accum;
+}
+
+// Threshold, or with auto_threshold the one the scene's luminance calls for
+static float star_burst_threshold(const effect_data_t *ed, const star_burst_state_t *st) {
+    if (!st->auto_threshold) return st->threshold;
+
+    float threshold = luma_stats_threshold(&ed->luma, AUTO_THRESHOLD_FRACTION, st->threshold);
+    if (threshold < 0.33f) threshold = 0.33f;
+    if (threshold > 2.0f) threshold = 2.0f;
+    return threshold;
+}
+
+// --- Ray layout ---
+// Every path draws the same rays, so their directions are worked out once a
+// frame from the values the single-pass shader's uniforms hold.
+
+static void star_burst_frame_constants(void *data) {
+    effect_data_t *ed = data;
+    star_burst_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    int points = param_get_int(ed, "StarPoints");
+    if (points < 4) points = 4;
+    if (points > MAX_STAR_POINTS) points = MAX_STAR_POINTS;
+
+    float rotation = param_get_float(ed, "Rotation");
+    if (param_get_bool(ed, "EnableRotation")) rotation += ed->elapsed_time * param_get_float(ed, "RotationSpeed");
+    bool anamorphic = param_get_bool(ed, "AnamorphicRays");
+
+    for (int i = 0; i < points; i++) {
+        float angle = (6.2831853f / (float)points) * (float)i + rotation;
+        float dir_x = cosf(angle);
+        float dir_y = sinf(angle);
+
+        if (anamorphic) {
+            dir_y *= 0.5f;
+            float len = sqrtf(dir_x * dir_x + dir_y * dir_y);
+            dir_x /= len;
+            dir_y /= len;
+        }
+        st->ray_dirs[i][0] = dir_x;
+        st->ray_dirs[i][1] = dir_y;
+    }
+    st->num_rays = points;
+}
+
+// Single-pass shader: the ray table (direction in xy, one thickness step
+// across the ray in zw), and with auto_threshold the Threshold uniform the
+// param store just applied
+static void star_burst_prepare_draw(void *data, float width, float height) {
+    (void)width;
+    effect_data_t *ed = data;
+    const star_burst_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    float ray_length = param_get_float(ed, "RayLength");
+    float perp_step = ray_length > 0.0f ? param_get_float(ed, "RayThickness") * 0.005f / height / ray_length : 0.0f;
+
+    struct vec4 rays[MAX_STAR_POINTS] = {0};
+    for (int i = 0; i < st->num_rays; i++) {
+        float dir_x = st->ray_dirs[i][0];
+        float dir_y = st->ray_dirs[i][1];
+        vec4_set(&rays[i], dir_x, dir_y, -dir_y * perp_step, dir_x * perp_step);
+    }
+    gs_effect_set_val(st->param_ray_dirs, rays, sizeof(rays));
+
+    if (st->auto_threshold) {
+        gs_effect_set_float(st->param_single_threshold, star_burst_threshold(ed, st));
+    }
+}
+
+// Pass p samples STREAK_TAPS taps spaced STREAK_TAPS^p apart, so after n passes
+// each pixel has gathered STREAK_TAPS^n samples along the ray. The per-tap
+// decay multiplies across passes into exp(-(RaySmoothness + 1) * s), which has
+// the same integral over the ray as the single-pass (1 - s)^RaySmoothness.
+static streak_plan_t star_burst_streak_plan(const star_burst_state_t *st, float dir_x, float dir_y, uint32_t cx,
+                                            uint32_t cy) {
+    float ray_px = st->ray_length * sqrtf(dir_x * dir_x * (float)(cx * cx) + dir_y * dir_y * (float)(cy * cy));
+
+    streak_plan_t plan = {1, 0.0f, 0.0f, 0.0f};
+    uint32_t total_taps = STREAK_TAPS;
+    while ((float)total_taps < ray_px && plan.passes < STREAK_MAX_PASSES) {
+        total_taps *= STREAK_TAPS;
+        plan.passes++;
+    }
+
+    plan.step_u = dir_x * st->ray_length / (float)total_taps;
+    plan.step_v = dir_y * st->ray_length / (float)total_taps;
+    plan.tap_decay = expf(-(st->ray_smoothness + 1.0f) / (float)total_taps);
+    return plan;
+}
+
+// Side samples of the single-pass shader add up to (1 + 0.5^RayEdgeSoftness)
+// on top of the centre tap; fold that and the StarPoints normalisation into
+// one gain.
+static float star_burst_ray_gain(const star_burst_state_t *st) {
+    float thickness_gain = 2.0f + powf(0.5f, st->ray_edge_softness);
+    return thickness_gain / (sqrtf((float)st->num_rays) * 0.5f + 0.1f);
+}
+
+// --- Multi-pass renderer ---
+
+// Streaks one ray direction from the bright pass and adds it to the accumulator
+static void star_burst_render_streak(star_burst_state_t *st, float dir_x, float dir_y, uint32_t cx, uint32_t cy) {
+    streak_plan_t plan = star_burst_streak_plan(st, dir_x, dir_y, cx, cy);
+
+    gs_texrender_t *src = st->bright;
+    uint32_t span = 1;
+
+    for (int p = 0; p < plan.passes; p++) {
+        bool last = (p == plan.passes - 1);
+        gs_texrender_t *dst = last ? st->accum : st->streak[p & 1];
+
+        struct vec2 step;
+        vec2_set(&step, plan.step_u * (float)span, plan.step_v * (float)span);
+        gs_effect_set_vec2(st->param_streak_step, &step);
+        gs_effect_set_float(st->param_streak_decay, powf(plan.tap_decay, (float)span));
+        gs_effect_set_float(st->param_streak_gain, 1.0f / (float)STREAK_TAPS);
+        gs_effect_set_texture(st->param_image, gs_texrender_get_texture(src));
+
+        // The last pass of every direction adds into the shared accumulator
+        if (last) gs_blend_function(GS_BLEND_ONE, GS_BLEND_ONE);
+
+        if (render_pass_begin(dst, cx, cy, !last)) {
+            render_pass_draw(st->effect, "Streak", cx, cy);
+            gs_texrender_end(dst);
+        }
+
+        if (last) gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+        src = dst;
+        span *= STREAK_TAPS;
+    }
+}
+
+static void star_burst_render(void *data, gs_effect_t *effect) {
+    effect_data_t *ed = data;
+    star_burst_state_t *st = ed ? ed->effect_state : NULL;
+    if (!ed || render_elide(ed)) return;
+
+    if (!st || !st->multi_pass || !star_burst_ensure_effect(ed, st)) {
+        generic_render(data, effect);
+        return;
+    }
+
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    uint32_t width = target ? obs_source_get_width(target) : 0;
+    uint32_t height = target ? obs_source_get_height(target) : 0;
+
+    if (width == 0 || height == 0 || !star_burst_ensure_targets(ed, st) ||
+        !render_filter_input(ed, st->input, width, height)) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    uint32_t cx = width / BRIGHT_PASS_DIVISOR;
+    uint32_t cy = height / BRIGHT_PASS_DIVISOR;
+    if (cx == 0) cx = 1;
+    if (cy == 0) cy = 1;
+
+    gs_texture_t *input_tex = gs_texrender_get_texture(st->input);
+    if (st->auto_threshold) luma_probe_analyze(ed, input_tex, width, height);
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+    // 1. Bright pass at reduced resolution
+    gs_effect_set_float(st->param_threshold, star_burst_threshold(ed, st));
+    gs_effect_set_texture(st->param_image, input_tex);
+    if (render_pass_begin(st->bright, cx, cy, false)) {
+        render_pass_draw(st->effect, "BrightPass", cx, cy);
+        gs_texrender_end(st->bright);
+    }
+
+    if (render_pass_begin(st->accum, cx, cy, true)) {
+        gs_texrender_end(st->accum);
+    }
+
+    // 2. One streak chain per ray direction
+    for (int i = 0; i < st->num_rays; i++) {
+        star_burst_render_streak(st, st->ray_dirs[i][0], st->ray_dirs[i][1], cx, cy);
+    }
+
+    gs_blend_state_pop();
+
+    // 3. Composite over the source
+    float ray_gain = star_burst_ray_gain(st);
+
+    struct vec4 ray_color;
+    vec4_from_rgba(&ray_color, st->ray_color);
+
+    gs_effect_set_float(st->param_intensity, st->intensity);
+    gs_effect_set_bool(st->param_colorize_rays, st->colorize_rays);
+    gs_effect_set_vec4(st->param_ray_color, &ray_color);
+    gs_effect_set_float(st->param_core_glow_intensity, st->core_glow_intensity);
+    gs_effect_set_bool(st->param_core_glow_uses_ray_color, st->core_glow_uses_ray_color);
+    gs_effect_set_float(st->param_ray_gain, ray_gain);
+    gs_effect_set_texture(st->param_image, input_tex);
+    gs_effect_set_texture(st->param_streak_image, gs_texrender_get_texture(st->accum));
+
+    while (gs_effect_loop(st->effect, "Composite")) {
+        gs_draw_sprite(input_tex, 0, width, height);
+    }
+}
+
+// --- CPU path ---
+// The multi-pass renderer on planes, whichever mode the GPU path uses:
+// marching every ray per pixel would be far too slow on the CPU.
+
+typedef struct {
+    const star_burst_state_t *st;
+    const cpu_image_t *image;   // Source frame
+    cpu_image_t *dst;
+    const cpu_plane_t *src;     // Streak input
+    cpu_plane_t *plane;         // Pass output
+    float threshold;            // star_burst_threshold
+    float step_u, step_v;
+    float weights[STREAK_TAPS]; // decay^i * gain
+    bool accumulate;            // Add into `plane` instead of overwriting
+    float ray_gain;
+    struct vec4 ray_color;      // RayColor
+    float ray_rgb[3];           // Colour the rays add
+} star_burst_frame_t;
+
+static inline simd_f luma(simd_rgba_t c) {
+    return simd_madd(c.r, simd_set1(0.299f), simd_madd(c.g, simd_set1(0.587f), simd_mul(c.b, simd_set1(0.114f))));
+}
+
+static void bright_pass_rows(void *ctx, size_t begin, size_t end) {
+    const star_burst_frame_t *f = ctx;
+    const cpu_plane_t *plane = f->plane;
+    const float inv_width = 1.0f / (float)plane->width;
+    const simd_f low = simd_set1(f->threshold * 0.4f);
+    const simd_f band = simd_set1(f->threshold * 0.4f);
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        simd_f v = simd_set1(((float)y + 0.5f) / (float)plane->height);
+        float *out = cpu_plane_row(plane, y);
+
+        for (uint32_t x = 0; x < plane->width; x += SIMD_LANES) {
+            // Half size, so one bilinear fetch averages a 2x2 block
+            simd_f brightness = luma(cpu_sample_rgba(f->image, cpu_pixel_u(x, inv_width), v));
+            simd_store(out + x, simd_smoothstep0(band, simd_sub(brightness, low)));
+        }
+    }
+}
+
+static void streak_rows(void *ctx, size_t begin, size_t end) {
+    const star_burst_frame_t *f = ctx;
+    const cpu_plane_t *plane = f->plane;
+    const float inv_width = 1.0f / (float)plane->width;
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        float v = ((float)y + 0.5f) / (float)plane->height;
+        float *out = cpu_plane_row(plane, y);
+
+        for (uint32_t x = 0; x < plane->width; x += SIMD_LANES) {
+            simd_f u = cpu_pixel_u(x, inv_width);
+            simd_f sum = f->accumulate ? simd_load(out + x) : simd_set1(0.0f);
+
+            // Towards the potential ray sources, zero outside the frame
+            for (int i = 0; i < STREAK_TAPS; i++) {
+                simd_f tap = cpu_sample_plane_border(f->src, simd_sub(u, simd_set1(f->step_u * (float)i)),
+                                                     simd_set1(v - f->step_v * (float)i));
+                sum = simd_madd(tap, simd_set1(f->weights[i]), sum);
+            }
+            simd_store(out + x, sum);
+        }
+    }
+}
+
+static void composite_rows(void *ctx, size_t begin, size_t end) {
+    const star_burst_frame_t *f = ctx;
+    const star_burst_state_t *st = f->st;
+    const float inv_width = 1.0f / (float)f->image->width;
+    const simd_f zero = simd_set1(0.0f);
+    const simd_f threshold = simd_set1(f->threshold);
+    const simd_f glow_range = simd_set1(1.0f - f->threshold + 0.001f);
+    const simd_f glow_intensity = simd_set1(st->core_glow_intensity);
+    const simd_f mix_scale = simd_set1(st->intensity * 0.5f);
+    const float glow_tint[3] = {f->ray_color.x, f->ray_color.y, f->ray_color.z};
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        simd_f v = simd_set1(((float)y + 0.5f) / (float)f->image->height);
+        const uint32_t *in = cpu_image_row(f->image, y);
+        uint32_t *out = cpu_image_row(f->dst, y);
+
+        for (uint32_t x = 0; x < f->image->width; x += SIMD_LANES) {
+            simd_rgba_t c = cpu_load_rgba(in, x);
+            simd_f *rgb[3] = {&c.r, &c.g, &c.b};
+
+            if (st->core_glow_intensity > 0.0f) {
+                simd_f brightness = luma(c);
+                simd_m glowing = simd_gt(brightness, threshold);
+                if (simd_any(glowing)) {
+                    simd_f amount = simd_pow(simd_saturate(simd_div(simd_sub(brightness, threshold), glow_range)),
+                                             simd_set1(1.5f));
+                    simd_f glow = simd_select(glowing, simd_mul(amount, glow_intensity), zero);
+                    for (int k = 0; k < 3; k++) {
+                        simd_f tint = st->core_glow_uses_ray_color
+                                          ? simd_set1(glow_tint[k])
+                                          : simd_lerp(simd_set1(1.0f), *rgb[k], simd_set1(0.5f));
+                        *rgb[k] = simd_saturate(simd_madd(tint, glow, *rgb[k]));
+                    }
+                }
+            }
+
+            simd_f rays = simd_saturate(simd_mul(cpu_sample_plane(f->src, cpu_pixel_u(x, inv_width), v),
+                                                 simd_set1(f->ray_gain)));
+            simd_f mix = simd_mul(rays, mix_scale);
+            mix = simd_select(simd_gt(mix, simd_set1(0.001f)), mix, zero);
+            for (int k = 0; k < 3; k++) *rgb[k] = simd_saturate(simd_madd(simd_set1(f->ray_rgb[k]), mix, *rgb[k]));
+
+            cpu_store_rgba(out, x, c);
+        }
+    }
+}
+
+// True if any bright pass texel can start a ray
+static bool plane_has_signal(const cpu_plane_t *plane) {
+    const simd_f zero = simd_set1(0.0f);
+    for (uint32_t y = 0; y < plane->height; y++) {
+        const float *row = cpu_plane_row(plane, y);
+        for (uint32_t x = 0; x < plane->width; x += SIMD_LANES) {
+            if (simd_any(simd_gt(simd_load(row + x), zero))) return true;
+        }
+    }
+    return false;
+}
+
+static void star_burst_filter_frame(void *data, const cpu_image_t *src, cpu_image_t *dst) {
+    effect_data_t *ed = data;
+    star_burst_state_t *st = ed->effect_state;
+
+    uint32_t cx = src->width / BRIGHT_PASS_DIVISOR;
+    uint32_t cy = src->height / BRIGHT_PASS_DIVISOR;
+    if (cx == 0) cx = 1;
+    if (cy == 0) cy = 1;
+
+    if (!st || !cpu_plane_reserve(&st->cpu_bright, cx, cy) || !cpu_plane_reserve(&st->cpu_streak[0], cx, cy) ||
+        !cpu_plane_reserve(&st->cpu_streak[1], cx, cy) || !cpu_plane_reserve(&st->cpu_accum, cx, cy)) {
+        memcpy(dst->pixels, src->pixels, sizeof(uint32_t) * src->stride * src->height);
+        return;
+    }
+
+    task_pool_t *pool = task_pool_shared();
+    star_burst_frame_t f = {.st = st, .image = src, .dst = dst, .threshold = star_burst_threshold(ed, st)};
+
+    // 1. Bright pass at reduced resolution
+    f.plane = &st->cpu_bright;
+    task_pool_parallel_for(pool, cy, CPU_ROWS_PER_TASK, bright_pass_rows, &f);
+    memset(st->cpu_accum.data, 0, sizeof(float) * st->cpu_accum.stride * cy);
+
+    // Nothing above the threshold: no rays, and without core glow no change
+    bool lit = plane_has_signal(&st->cpu_bright);
+    if (!lit && st->core_glow_intensity <= 0.0f) {
+        memcpy(dst->pixels, src->pixels, sizeof(uint32_t) * src->stride * src->height);
+        return;
+    }
+
+    // 2. One streak chain per ray direction; the last pass adds into the accumulator
+    for (int i = 0; lit && i < st->num_rays; i++) {
+        float dir_x = st->ray_dirs[i][0];
+        float dir_y = st->ray_dirs[i][1];
+        streak_plan_t plan = star_burst_streak_plan(st, dir_x, dir_y, cx, cy);
+
+        f.src = &st->cpu_bright;
+        uint32_t span = 1;
+        for (int p = 0; p < plan.passes; p++) {
+            f.accumulate = (p == plan.passes - 1);
+            f.plane = f.accumulate ? &st->cpu_accum : &st->cpu_streak[p & 1];
+            f.step_u = plan.step_u * (float)span;
+            f.step_v = plan.step_v * (float)span;
+
+            float decay = powf(plan.tap_decay, (float)span);
+            float weight = 1.0f / (float)STREAK_TAPS;
+            for (int k = 0; k < STREAK_TAPS; k++, weight *= decay) f.weights[k] = weight;
+
+            task_pool_parallel_for(pool, cy, CPU_ROWS_PER_TASK, streak_rows, &f);
+            f.src = f.plane;
+            span *= STREAK_TAPS;
+        }
+    }
+
+    // 3. Composite over the source
+    vec4_from_rgba(&f.ray_color, st->ray_color);
+    f.ray_rgb[0] = st->colorize_rays ? f.ray_color.x : 1.0f;
+    f.ray_rgb[1] = st->colorize_rays ? f.ray_color.y : 1.0f;
+    f.ray_rgb[2] = st->colorize_rays ? f.ray_color.z : 1.0f;
+    f.ray_gain = star_burst_ray_gain(st);
+    f.src = &st->cpu_accum;
+    task_pool_parallel_for(pool, src->height, CPU_ROWS_PER_TASK, composite_rows, &f);
+}
+
 static void star_burst_defaults(obs_data_t *s) {
     for (size_t i = 0; i < sizeof(star_burst_params)/sizeof(star_burst_params[0]); i++) {
         const param_def_t *def = &star_burst_params[i];
@@ -36,8 +631,27 @@ static void star_burst_defaults(obs_data_t *s) {
     }
 }
 
+static const char *const star_burst_extra_shaders[] = {STAR_BURST_MULTIPASS_SHADER, LUMA_REDUCE_SHADER, NULL};
+
 const effect_info_t star_burst_info = {
-    "star_burst_effect", "Star Burst", "Creates dramatic star-shaped rays", "shaders/star-burst.shader",
-    star_burst_params, sizeof(star_burst_params)/sizeof(star_burst_params[0]),
-    generic_create, generic_destroy, generic_update, generic_render, generic_tick, generic_properties, star_burst_defaults
+    .id = "star_burst_effect",
+    .name = "Star Burst",
+    .description = "Creates dramatic star-shaped rays",
+    .shader_path = "shaders/star-burst.shader",
+    .extra_shaders = star_burst_extra_shaders,
+    .params = star_burst_params,
+    .num_params = sizeof(star_burst_params)/sizeof(star_burst_params[0]),
+    .create = star_burst_create,
+    .destroy = star_burst_destroy,
+    .update = generic_update,
+    .video_render = star_burst_render,
+    .video_tick = generic_tick,
+    .get_properties = generic_properties,
+    .get_defaults = star_burst_defaults,
+    .bind_effect = star_burst_bind_effect,
+    .frame_constants = star_burst_frame_constants,
+    .params_synced = star_burst_params_synced,
+    .prepare_draw = star_burst_prepare_draw,
+    .filter_frame = star_burst_filter_frame,
+    .is_static = star_burst_is_static
 };
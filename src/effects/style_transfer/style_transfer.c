@@ -1,16 +1,458 @@
 /*
  * src/effects/style_transfer/style_transfer.c
+ * Feed-forward style network run on the CPU (src/utils/style-net.c). The
+ * input is scaled to the network size, read back through stage surfaces two
+ * frames after it was drawn, stylised on a worker thread and uploaded to a
+ * dynamic texture when done, so video_render never waits on the network.
+ * The styled image trails the source by one or two network runs.
  */
 
 #include "style_transfer.h"
+#include "../../utils/logging.h"
+#include "../../utils/style-net.h"
+#include "../../utils/task-pool.h"
+#include <util/threading.h>
+#include <string.h>
 
-// Style Transfer has no parameters in the original code
-static void style_transfer_defaults(obs_data_t *s) { 
-    (void)s; 
+#define STYLE_MODEL_SETTING "model_path"
+#define STYLE_READBACK_SLOTS 3 // Staged on frame n, mapped on frame n + 2
+
+static const param_def_t style_transfer_params[] = {
+    {"style_strength", "Strength", "Blend of the styled image over the source", PARAM_FLOAT, {.f_val=1.0}, 0.0, 1.0, 0.01, 0},
+    {"edge_preserve", "Preserve Edges", "Keep the source's own detail along its edges", PARAM_FLOAT, {.f_val=0.0}, 0.0, 1.0, 0.01, 0},
+    {"net_width", "Network Width", "Width the network runs at; its cost grows with the square", PARAM_INT, {.i_val=256}, 64, 512, 16, PARAM_FLAG_NO_UNIFORM},
+    {"frame_skip", "Frame Skip", "Frames between network inputs", PARAM_INT, {.i_val=1}, 0, 5, 1, PARAM_FLAG_NO_UNIFORM},
+    {"threads", "Threads", "Threads running the network, 0 = one per core", PARAM_INT, {.i_val=0}, 0, 16, 1, PARAM_FLAG_NO_UNIFORM}
+};
+
+// edge_preserve only needs a soft mask, so half resolution is plenty
+static const edge_map_params_t style_edge_params = {1.4f, 0.15f, 0.4f, 4, 1};
+
+typedef struct {
+    pthread_mutex_t mutex;
+
+    // Written by update, read by the worker; guarded by mutex. The model
+    // path is a string setting, which the param store doesn't hold.
+    char *model_path;
+    bool model_changed;
+    int threads;
+
+    // Newest readback waiting for the worker, and the newest finished
+    // result waiting for upload; guarded by mutex, newer ones replace them
+    uint32_t *job;
+    uint32_t job_cx, job_cy;
+    uint32_t *result;
+    uint32_t result_cx, result_cy;
+
+    // Synced settings, see style_transfer_params_synced
+    float style_strength;
+    float edge_preserve;
+    int net_width;
+    int frame_skip;
+
+    // Worker thread only
+    style_net_t *net;
+    task_pool_t *pool;      // Own pool: the shared one serialises its callers
+    int pool_threads;
+
+    pthread_t worker;
+    bool worker_started;
+    os_sem_t *wake;
+    volatile bool stopping;
+    volatile long alignment; // Of the loaded network, 0 while there is none
+
+    // Graphics thread only
+    gs_texrender_t *input;
+    gs_texrender_t *scaled;
+    gs_stagesurf_t *stage[STYLE_READBACK_SLOTS];
+    uint64_t staged_frame[STYLE_READBACK_SLOTS]; // 0 = nothing staged
+    uint64_t frame_count;
+    gs_texture_t *styled;
+    uint32_t styled_cx, styled_cy;
+
+    gs_eparam_t *param_styled_image;
+    gs_eparam_t *param_condition_image;
+} style_state_t;
+
+// --- Worker ---
+
+// Reloads the network and resizes the pool when update changed them
+static void style_worker_sync(effect_data_t *ed, style_state_t *st) {
+    pthread_mutex_lock(&st->mutex);
+    char *path = st->model_changed ? bstrdup(st->model_path) : NULL;
+    bool reload = st->model_changed;
+    int threads = st->threads;
+    st->model_changed = false;
+    pthread_mutex_unlock(&st->mutex);
+
+    if (!st->pool || threads != st->pool_threads) {
+        task_pool_destroy(st->pool);
+        st->pool = task_pool_create((size_t)threads);
+        st->pool_threads = threads;
+    }
+
+    if (!reload) return;
+
+    style_net_destroy(st->net);
+    st->net = NULL;
+    os_atomic_set_long(&st->alignment, 0);
+
+    if (path && *path) {
+        char error[256];
+        st->net = style_net_load(path, error, sizeof(error));
+        if (st->net) {
+            EFFECT_LOG_INFO(ed, "Loaded style network '%s' (%s weights)", path, style_net_precision(st->net));
+            os_atomic_set_long(&st->alignment, (long)style_net_alignment(st->net));
+        } else {
+            EFFECT_LOG_WARNING(ed, "Failed to load style network '%s': %s", path, error);
+        }
+    }
+    bfree(path);
+}
+
+static void *style_worker_main(void *data) {
+    effect_data_t *ed = data;
+    style_state_t *st = ed->effect_state;
+    os_set_thread_name("emulens: style transfer");
+
+    while (os_sem_wait(st->wake) == 0 && !os_atomic_load_bool(&st->stopping)) {
+        style_worker_sync(ed, st);
+
+        pthread_mutex_lock(&st->mutex);
+        uint32_t *job = st->job;
+        uint32_t cx = st->job_cx, cy = st->job_cy;
+        st->job = NULL;
+        pthread_mutex_unlock(&st->mutex);
+
+        if (!job) continue;
+
+        // A job staged for a previous network may not fit this one
+        uint32_t *out = st->net ? bmalloc((size_t)cx * cy * sizeof(uint32_t)) : NULL;
+        if (out && style_net_run(st->net, st->pool, job, out, cx, cy, cx)) {
+            pthread_mutex_lock(&st->mutex);
+            bfree(st->result);
+            st->result = out;
+            st->result_cx = cx;
+            st->result_cy = cy;
+            pthread_mutex_unlock(&st->mutex);
+        } else {
+            bfree(out);
+        }
+        bfree(job);
+    }
+    return NULL;
+}
+
+// --- Lifecycle ---
+
+static void *style_transfer_create(obs_data_t *settings, obs_source_t *source) {
+    style_state_t *st = bzalloc(sizeof(style_state_t));
+    pthread_mutex_init(&st->mutex, NULL);
+
+    effect_data_t *ed = generic_create(settings, source);
+    if (!ed || os_sem_init(&st->wake, 0) != 0) {
+        if (ed) generic_destroy(ed);
+        pthread_mutex_destroy(&st->mutex);
+        bfree(st);
+        return NULL;
+    }
+    ed->effect_state = st;
+
+    // The deferred update from generic_create posts the first model load
+    st->worker_started = pthread_create(&st->worker, NULL, style_worker_main, ed) == 0;
+    if (!st->worker_started) EFFECT_LOG_ERROR(ed, "Failed to start the style transfer worker");
+
+    return ed;
+}
+
+static void style_transfer_destroy(void *data) {
+    effect_data_t *ed = data;
+    if (!ed) return;
+
+    style_state_t *st = ed->effect_state;
+    if (st) {
+        if (st->worker_started) {
+            os_atomic_set_bool(&st->stopping, true);
+            os_sem_post(st->wake);
+            pthread_join(st->worker, NULL);
+        }
+        os_sem_destroy(st->wake);
+
+        obs_enter_graphics();
+        gs_texrender_destroy(st->input);
+        gs_texrender_destroy(st->scaled);
+        for (size_t i = 0; i < STYLE_READBACK_SLOTS; i++) gs_stagesurface_destroy(st->stage[i]);
+        gs_texture_destroy(st->styled);
+        obs_leave_graphics();
+
+        style_net_destroy(st->net);
+        task_pool_destroy(st->pool);
+        bfree(st->job);
+        bfree(st->result);
+        bfree(st->model_path);
+        pthread_mutex_destroy(&st->mutex);
+        bfree(st);
+        ed->effect_state = NULL;
+    }
+
+    generic_destroy(ed);
+}
+
+static void style_transfer_params_synced(void *data) {
+    effect_data_t *ed = data;
+    style_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->style_strength = param_get_float(ed, "style_strength");
+    st->edge_preserve = param_get_float(ed, "edge_preserve");
+    st->net_width = param_get_int(ed, "net_width");
+    st->frame_skip = param_get_int(ed, "frame_skip");
+    if (st->net_width < 64) st->net_width = 64;
+    if (st->frame_skip < 0) st->frame_skip = 0;
+}
+
+static void style_transfer_update(void *data, obs_data_t *settings) {
+    generic_update(data, settings);
+
+    effect_data_t *ed = data;
+    style_state_t *st = ed ? ed->effect_state : NULL;
+    if (!st) return;
+
+    const char *path = obs_data_get_string(settings, STYLE_MODEL_SETTING);
+    int threads = (int)obs_data_get_int(settings, "threads");
+    if (threads < 0) threads = 0;
+
+    pthread_mutex_lock(&st->mutex);
+    bool new_model = !st->model_path || strcmp(st->model_path, path) != 0;
+    bool changed = new_model || threads != st->threads;
+    if (new_model) {
+        bfree(st->model_path);
+        st->model_path = bstrdup(path);
+        st->model_changed = true;
+    }
+    st->threads = threads;
+    pthread_mutex_unlock(&st->mutex);
+
+    // The worker loads the network, so the UI doesn't hang on big files
+    if (changed) os_sem_post(st->wake);
+}
+
+static void style_transfer_bind_effect(void *data) {
+    effect_data_t *ed = data;
+    style_state_t *st = ed->effect_state;
+    if (!st) return;
+
+    st->param_styled_image = gs_effect_get_param_by_name(ed->effect, "styled_image");
+    st->param_condition_image = gs_effect_get_param_by_name(ed->effect, "condition_image");
+}
+
+// --- Elision ---
+
+// Without a network, or at zero strength, the source passes through
+static bool style_transfer_is_identity(void *data) {
+    effect_data_t *ed = data;
+    const style_state_t *st = ed->effect_state;
+    return !st || os_atomic_load_long(&st->alignment) == 0 || st->style_strength <= 0.0f;
+}
+
+// --- Render ---
+
+// Uploads the newest finished result, if any
+static void style_upload_result(style_state_t *st) {
+    pthread_mutex_lock(&st->mutex);
+    uint32_t *result = st->result;
+    uint32_t cx = st->result_cx, cy = st->result_cy;
+    st->result = NULL;
+    pthread_mutex_unlock(&st->mutex);
+
+    if (!result) return;
+
+    if (!st->styled || st->styled_cx != cx || st->styled_cy != cy) {
+        gs_texture_destroy(st->styled);
+        st->styled = gs_texture_create(cx, cy, GS_RGBA, 1, NULL, GS_DYNAMIC);
+        st->styled_cx = cx;
+        st->styled_cy = cy;
+    }
+    if (st->styled) gs_texture_set_image(st->styled, (const uint8_t *)result, cx * sizeof(uint32_t), false);
+    bfree(result);
+}
+
+// Maps the newest readback that is at least two frames old and hands it to
+// the worker. A copy staged the frame before may still be in flight,
+// especially on OpenGL, and mapping it would wait for the GPU.
+static void style_collect_readbacks(style_state_t *st) {
+    int newest = -1;
+    for (int i = 0; i < STYLE_READBACK_SLOTS; i++) {
+        if (st->staged_frame[i] == 0 || st->staged_frame[i] + 2 > st->frame_count) continue;
+        if (newest < 0 || st->staged_frame[i] > st->staged_frame[newest]) newest = i;
+    }
+    if (newest < 0) return;
+
+    // Older ones are stale now
+    uint64_t taken = st->staged_frame[newest];
+    for (int i = 0; i < STYLE_READBACK_SLOTS; i++) {
+        if (st->staged_frame[i] <= taken) st->staged_frame[i] = 0;
+    }
+
+    gs_stagesurf_t *stage = st->stage[newest];
+    uint32_t cx = gs_stagesurface_get_width(stage);
+    uint32_t cy = gs_stagesurface_get_height(stage);
+    uint8_t *data;
+    uint32_t linesize;
+    if (!gs_stagesurface_map(stage, &data, &linesize)) return;
+
+    uint32_t *job = bmalloc((size_t)cx * cy * sizeof(uint32_t));
+    for (uint32_t y = 0; y < cy; y++) {
+        memcpy(job + (size_t)y * cx, data + (size_t)y * linesize, cx * sizeof(uint32_t));
+    }
+    gs_stagesurface_unmap(stage);
+
+    pthread_mutex_lock(&st->mutex);
+    bfree(st->job);
+    st->job = job;
+    st->job_cx = cx;
+    st->job_cy = cy;
+    pthread_mutex_unlock(&st->mutex);
+    os_sem_post(st->wake);
+}
+
+// Network input size: net_width wide, the source's aspect, both multiples
+// of the network's alignment
+static void style_net_size(const style_state_t *st, uint32_t alignment, uint32_t width, uint32_t height,
+                           uint32_t *cx, uint32_t *cy) {
+    uint32_t w = (uint32_t)st->net_width < width ? (uint32_t)st->net_width : width;
+    uint32_t h = (uint32_t)(((uint64_t)w * height + width / 2) / width);
+    w = w / alignment * alignment;
+    h = (h + alignment / 2) / alignment * alignment;
+    *cx = w ? w : alignment;
+    *cy = h ? h : alignment;
+}
+
+// Scales the input to the network size and starts copying it to a free
+// stage surface
+static void style_stage_input(style_state_t *st, gs_texture_t *input, uint32_t width, uint32_t height) {
+    uint32_t alignment = (uint32_t)os_atomic_load_long(&st->alignment);
+    if (alignment == 0 || st->frame_count % (uint64_t)(st->frame_skip + 1) != 0) return;
+
+    int slot = 0;
+    for (int i = 0; i < STYLE_READBACK_SLOTS; i++) {
+        if (st->staged_frame[i] == 0) {
+            slot = i;
+            break;
+        }
+        if (st->staged_frame[i] < st->staged_frame[slot]) slot = i;
+    }
+
+    uint32_t cx, cy;
+    style_net_size(st, alignment, width, height, &cx, &cy);
+
+    gs_stagesurf_t *stage = st->stage[slot];
+    if (!stage || gs_stagesurface_get_width(stage) != cx || gs_stagesurface_get_height(stage) != cy) {
+        gs_stagesurface_destroy(stage);
+        stage = st->stage[slot] = gs_stagesurface_create(cx, cy, GS_RGBA);
+        if (!stage) return;
+    }
+
+    if (!st->scaled) st->scaled = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    if (!render_pass_begin(st->scaled, cx, cy, false)) return;
+
+    gs_effect_t *default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), input);
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    while (gs_effect_loop(default_effect, "Draw")) {
+        gs_draw_sprite(input, 0, cx, cy);
+    }
+    gs_blend_state_pop();
+    gs_texrender_end(st->scaled);
+
+    gs_stage_texture(stage, gs_texrender_get_texture(st->scaled));
+    st->staged_frame[slot] = st->frame_count;
+}
+
+static void style_transfer_render(void *data, gs_effect_t *effect) {
+    (void)effect;
+    effect_data_t *ed = data;
+    style_state_t *st = ed ? ed->effect_state : NULL;
+    if (!ed || render_elide(ed)) return;
+
+    obs_source_t *target = obs_filter_get_target(ed->context);
+    uint32_t width = target ? obs_source_get_width(target) : 0;
+    uint32_t height = target ? obs_source_get_height(target) : 0;
+
+    if (!st || width == 0 || height == 0 || !generic_ensure_effect(ed) || !st->param_styled_image) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+
+    if (!st->input) st->input = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    if (!render_filter_input(ed, st->input, width, height)) {
+        obs_source_skip_video_filter(ed->context);
+        return;
+    }
+    gs_texture_t *input = gs_texrender_get_texture(st->input);
+
+    // Collect before staging, so a slot staged this frame is left alone
+    st->frame_count++;
+    style_upload_result(st);
+    style_collect_readbacks(st);
+    style_stage_input(st, input, width, height);
+
+    // Until the first result the input blends with itself
+    gs_texture_t *styled = st->styled ? st->styled : input;
+    gs_texture_t *edges = NULL;
+    if (st->styled && st->edge_preserve > 0.0f) {
+        edges = edge_map_get(target, input, width, height, &style_edge_params);
+    }
+
+    generic_prepare_draw(ed, (float)width, (float)height);
+    gs_effect_set_texture(ed->param_image, input);
+    gs_effect_set_texture(st->param_styled_image, styled);
+    gs_effect_set_texture(st->param_condition_image, edges);
+
+    while (gs_effect_loop(ed->effect, "Draw")) {
+        gs_draw_sprite(input, 0, width, height);
+    }
+}
+
+// --- Properties ---
+
+static obs_properties_t *style_transfer_properties(void *data) {
+    obs_properties_t *props = generic_properties(data);
+    obs_properties_add_path(props, STYLE_MODEL_SETTING, "Style Model", OBS_PATH_FILE,
+                            "EmuLens style network (*.esn)", NULL);
+    return props;
+}
+
+static void style_transfer_defaults(obs_data_t *s) {
+    for (size_t i = 0; i < sizeof(style_transfer_params)/sizeof(style_transfer_params[0]); i++) {
+        const param_def_t *def = &style_transfer_params[i];
+        switch (def->type) {
+            case PARAM_FLOAT: obs_data_set_default_double(s, def->name, def->default_val.f_val); break;
+            case PARAM_INT:   obs_data_set_default_int(s, def->name, def->default_val.i_val); break;
+            case PARAM_BOOL:  obs_data_set_default_bool(s, def->name, def->default_val.b_val); break;
+            case PARAM_COLOR: obs_data_set_default_int(s, def->name, def->default_val.i_val); break;
+        }
+    }
+    obs_data_set_default_string(s, STYLE_MODEL_SETTING, "");
 }
 
 const effect_info_t style_transfer_info = {
-    "style_transfer_effect", "Style Transfer", "Applies artistic style transfer", "shaders/style-transfer.shader",
-    NULL, 0,
-    generic_create, generic_destroy, generic_update, generic_render, generic_tick, generic_properties, style_transfer_defaults
+    .id = "style_transfer_effect",
+    .name = "Style Transfer",
+    .description = "Applies artistic style transfer",
+    .shader_path = "shaders/style-transfer.shader",
+    .params = style_transfer_params,
+    .num_params = sizeof(style_transfer_params)/sizeof(style_transfer_params[0]),
+    .create = style_transfer_create,
+    .destroy = style_transfer_destroy,
+    .update = style_transfer_update,
+    .video_render = style_transfer_render,
+    .video_tick = generic_tick,
+    .get_properties = style_transfer_properties,
+    .get_defaults = style_transfer_defaults,
+    .bind_effect = style_transfer_bind_effect,
+    .params_synced = style_transfer_params_synced,
+    .is_identity = style_transfer_is_identity,
+    .flags = EFFECT_FLAG_NO_STACK
 };
@@ -4,7 +4,9 @@
 
 #include <obs-module.h>
 #include "effects/effect-registry.h"
+#include "core/profiler.h"
 #include "plugin-support.h"
+#include "utils/task-pool.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
@@ -28,19 +30,35 @@ bool obs_module_load(void)
             .create = info->create,
             .destroy = info->destroy,
             .update = info->update,
-            .video_render = info->video_render,
+            .video_render = info->video_render ? effect_video_render : NULL,
             .video_tick = info->video_tick,
+            .filter_video = effect_filter_video,
+            .video_get_color_space = effect_get_color_space,
             .get_properties = info->get_properties,
             .get_defaults = info->get_defaults,
             .type_data = (void*)info
         };
+        profiler_wrap_source_info(&source_info);
         obs_register_source(&source_info);
+
+        // Compile in the background now so creating filters later, e.g.
+        // when a scene collection loads mid-show, never waits on a shader
+        effect_cache_prefetch(info->shader_path);
+        for (const char *const *extra = info->extra_shaders; extra && *extra; extra++) {
+            effect_cache_prefetch(*extra);
+        }
     }
-    
+
+    profiler_module_load();
     return true;
 }
 
 void obs_module_unload(void)
 {
+    task_pool_shared_release();
+    edge_map_shutdown();
+    luma_stats_shutdown();
+    effect_cache_log_stats();
+    effect_cache_shutdown();
     blog(LOG_INFO, "Unloaded %s", PLUGIN_NAME);
 }
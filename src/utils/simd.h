@@ -0,0 +1,406 @@
+/*
+ * src/utils/simd.h
+ * Fixed-width float lanes for the CPU effect kernels (no libobs dependency).
+ * Picks AVX2 (8 lanes), SSE4.1 (4 lanes) or plain C (1 lane) at compile
+ * time; kernels are written once against these helpers. Define
+ * EMULENS_NO_SIMD to force the scalar build, which uses libm throughout
+ * and is the reference the vector builds are compared against.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(EMULENS_NO_SIMD) && defined(__AVX2__)
+#define SIMD_AVX2 1
+#define SIMD_LANES 8
+#include <immintrin.h>
+#elif !defined(EMULENS_NO_SIMD) && (defined(__SSE4_1__) || defined(__AVX__))
+#define SIMD_SSE41 1
+#define SIMD_LANES 4
+#include <smmintrin.h>
+#else
+#define SIMD_SCALAR 1
+#define SIMD_LANES 1
+#endif
+
+#define SIMD_NAME (SIMD_LANES == 8 ? "AVX2" : SIMD_LANES == 4 ? "SSE4.1" : "scalar")
+
+// IEEE half to float, subnormals, infinities and NaN included. The
+// simd_load_f16 loads use it where F16C isn't available.
+static inline float simd_half_to_float(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    uint32_t bits;
+
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // Subnormal: normalise the mantissa
+        exponent = 113;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    } else {
+        bits = sign;
+    }
+
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// --- Types ---
+// simd_f: float lanes. simd_i: int32 lanes. simd_m: per-lane condition,
+// only consumed by simd_select/simd_any and the simd_m_* helpers.
+
+#if defined(SIMD_AVX2)
+typedef __m256 simd_f;
+typedef __m256i simd_i;
+typedef __m256 simd_m;
+
+static inline simd_f simd_set1(float v) { return _mm256_set1_ps(v); }
+static inline simd_f simd_ramp(void) { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+static inline simd_f simd_add(simd_f a, simd_f b) { return _mm256_add_ps(a, b); }
+static inline simd_f simd_sub(simd_f a, simd_f b) { return _mm256_sub_ps(a, b); }
+static inline simd_f simd_mul(simd_f a, simd_f b) { return _mm256_mul_ps(a, b); }
+static inline simd_f simd_div(simd_f a, simd_f b) { return _mm256_div_ps(a, b); }
+static inline simd_f simd_min(simd_f a, simd_f b) { return _mm256_min_ps(a, b); }
+static inline simd_f simd_max(simd_f a, simd_f b) { return _mm256_max_ps(a, b); }
+static inline simd_f simd_sqrt(simd_f a) { return _mm256_sqrt_ps(a); }
+static inline simd_f simd_floor(simd_f a) { return _mm256_floor_ps(a); }
+#ifdef __FMA__
+static inline simd_f simd_madd(simd_f a, simd_f b, simd_f c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+static inline simd_f simd_madd(simd_f a, simd_f b, simd_f c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+
+static inline simd_m simd_lt(simd_f a, simd_f b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline simd_m simd_gt(simd_f a, simd_f b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline simd_m simd_m_and(simd_m a, simd_m b) { return _mm256_and_ps(a, b); }
+static inline simd_m simd_m_or(simd_m a, simd_m b) { return _mm256_or_ps(a, b); }
+static inline simd_f simd_select(simd_m m, simd_f a, simd_f b) { return _mm256_blendv_ps(b, a, m); }
+static inline bool simd_any(simd_m m) { return _mm256_movemask_ps(m) != 0; }
+
+static inline simd_i simd_i_set1(int v) { return _mm256_set1_epi32(v); }
+static inline simd_i simd_i_add(simd_i a, simd_i b) { return _mm256_add_epi32(a, b); }
+static inline simd_i simd_i_mul(simd_i a, simd_i b) { return _mm256_mullo_epi32(a, b); }
+static inline simd_i simd_i_min(simd_i a, simd_i b) { return _mm256_min_epi32(a, b); }
+static inline simd_i simd_i_max(simd_i a, simd_i b) { return _mm256_max_epi32(a, b); }
+static inline simd_i simd_i_and(simd_i a, simd_i b) { return _mm256_and_si256(a, b); }
+static inline simd_i simd_i_lt(simd_i a, simd_i b) { return _mm256_cmpgt_epi32(b, a); }
+static inline simd_i simd_i_eq(simd_i a, simd_i b) { return _mm256_cmpeq_epi32(a, b); }
+static inline simd_i simd_i_from_f(simd_f a) { return _mm256_cvttps_epi32(a); }
+static inline simd_f simd_f_from_i(simd_i a) { return _mm256_cvtepi32_ps(a); }
+static inline simd_f simd_gather(const float *base, simd_i index) { return _mm256_i32gather_ps(base, index, 4); }
+static inline simd_i simd_gather_u32(const uint32_t *base, simd_i index) {
+    return _mm256_i32gather_epi32((const int *)base, index, 4);
+}
+
+// Reads 32 bits at each index, so the array needs one element of padding
+static inline simd_f simd_gather_u16(const uint16_t *base, simd_i index) {
+    __m256i words = _mm256_i32gather_epi32((const int *)(const void *)base, index, 2);
+    return _mm256_cvtepi32_ps(_mm256_and_si256(words, _mm256_set1_epi32(0xFFFF)));
+}
+
+// Bytes 0, 8, 16 and 24 of each lane's texel as floats
+static inline simd_f simd_byte_f(simd_i texels, int shift) {
+    return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(texels, _mm_cvtsi32_si128(shift)), _mm256_set1_epi32(0xFF)));
+}
+
+static inline simd_f simd_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void simd_store(float *p, simd_f v) { _mm256_storeu_ps(p, v); }
+static inline simd_i simd_load_u32(const uint32_t *p) { return _mm256_loadu_si256((const __m256i *)(const void *)p); }
+
+static inline simd_f simd_load_u8(const uint8_t *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(const void *)p)));
+}
+
+static inline simd_f simd_load_i8(const int8_t *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(const void *)p)));
+}
+
+#ifdef __F16C__
+static inline simd_f simd_load_f16(const uint16_t *p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(const void *)p));
+}
+#else
+static inline simd_f simd_load_f16(const uint16_t *p) {
+    return _mm256_setr_ps(simd_half_to_float(p[0]), simd_half_to_float(p[1]), simd_half_to_float(p[2]),
+                          simd_half_to_float(p[3]), simd_half_to_float(p[4]), simd_half_to_float(p[5]),
+                          simd_half_to_float(p[6]), simd_half_to_float(p[7]));
+}
+#endif
+
+// Rounds and saturates lanes holding 0..255 and stores them as bytes
+static inline void simd_store_u8(uint8_t *p, simd_f v) {
+    __m256i i = _mm256_cvtps_epi32(v);
+    __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+    _mm_storel_epi64((__m128i *)(void *)p, _mm_packus_epi16(w, w));
+}
+
+// Packs four lanes of 0..255 into RGBA8 texels
+static inline simd_i simd_pack_rgba8(simd_f r, simd_f g, simd_f b, simd_f a) {
+    __m256i rg = _mm256_packus_epi32(_mm256_cvtps_epi32(r), _mm256_cvtps_epi32(g));
+    __m256i ba = _mm256_packus_epi32(_mm256_cvtps_epi32(b), _mm256_cvtps_epi32(a));
+    // Per 128-bit half: rg = r0..3 g0..3, ba = b0..3 a0..3 (16-bit)
+    __m256i rgba = _mm256_packus_epi16(rg, ba); // r0..3 g0..3 b0..3 a0..3 per half
+    const __m256i order = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+                                           0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    return _mm256_shuffle_epi8(rgba, order);
+}
+
+static inline void simd_store_u32(uint32_t *p, simd_i v) { _mm256_storeu_si256((__m256i *)(void *)p, v); }
+
+#elif defined(SIMD_SSE41)
+typedef __m128 simd_f;
+typedef __m128i simd_i;
+typedef __m128 simd_m;
+
+static inline simd_f simd_set1(float v) { return _mm_set1_ps(v); }
+static inline simd_f simd_ramp(void) { return _mm_setr_ps(0, 1, 2, 3); }
+static inline simd_f simd_add(simd_f a, simd_f b) { return _mm_add_ps(a, b); }
+static inline simd_f simd_sub(simd_f a, simd_f b) { return _mm_sub_ps(a, b); }
+static inline simd_f simd_mul(simd_f a, simd_f b) { return _mm_mul_ps(a, b); }
+static inline simd_f simd_div(simd_f a, simd_f b) { return _mm_div_ps(a, b); }
+static inline simd_f simd_min(simd_f a, simd_f b) { return _mm_min_ps(a, b); }
+static inline simd_f simd_max(simd_f a, simd_f b) { return _mm_max_ps(a, b); }
+static inline simd_f simd_sqrt(simd_f a) { return _mm_sqrt_ps(a); }
+static inline simd_f simd_floor(simd_f a) { return _mm_floor_ps(a); }
+static inline simd_f simd_madd(simd_f a, simd_f b, simd_f c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+static inline simd_m simd_lt(simd_f a, simd_f b) { return _mm_cmplt_ps(a, b); }
+static inline simd_m simd_gt(simd_f a, simd_f b) { return _mm_cmpgt_ps(a, b); }
+static inline simd_m simd_m_and(simd_m a, simd_m b) { return _mm_and_ps(a, b); }
+static inline simd_m simd_m_or(simd_m a, simd_m b) { return _mm_or_ps(a, b); }
+static inline simd_f simd_select(simd_m m, simd_f a, simd_f b) { return _mm_blendv_ps(b, a, m); }
+static inline bool simd_any(simd_m m) { return _mm_movemask_ps(m) != 0; }
+
+static inline simd_i simd_i_set1(int v) { return _mm_set1_epi32(v); }
+static inline simd_i simd_i_add(simd_i a, simd_i b) { return _mm_add_epi32(a, b); }
+static inline simd_i simd_i_mul(simd_i a, simd_i b) { return _mm_mullo_epi32(a, b); }
+static inline simd_i simd_i_min(simd_i a, simd_i b) { return _mm_min_epi32(a, b); }
+static inline simd_i simd_i_max(simd_i a, simd_i b) { return _mm_max_epi32(a, b); }
+static inline simd_i simd_i_and(simd_i a, simd_i b) { return _mm_and_si128(a, b); }
+static inline simd_i simd_i_lt(simd_i a, simd_i b) { return _mm_cmplt_epi32(a, b); }
+static inline simd_i simd_i_eq(simd_i a, simd_i b) { return _mm_cmpeq_epi32(a, b); }
+static inline simd_i simd_i_from_f(simd_f a) { return _mm_cvttps_epi32(a); }
+static inline simd_f simd_f_from_i(simd_i a) { return _mm_cvtepi32_ps(a); }
+
+// No gather instruction before AVX2
+static inline simd_f simd_gather(const float *base, simd_i index) {
+    return _mm_setr_ps(base[_mm_extract_epi32(index, 0)], base[_mm_extract_epi32(index, 1)],
+                       base[_mm_extract_epi32(index, 2)], base[_mm_extract_epi32(index, 3)]);
+}
+static inline simd_i simd_gather_u32(const uint32_t *base, simd_i index) {
+    return _mm_setr_epi32((int)base[_mm_extract_epi32(index, 0)], (int)base[_mm_extract_epi32(index, 1)],
+                          (int)base[_mm_extract_epi32(index, 2)], (int)base[_mm_extract_epi32(index, 3)]);
+}
+static inline simd_f simd_gather_u16(const uint16_t *base, simd_i index) {
+    return _mm_setr_ps(base[_mm_extract_epi32(index, 0)], base[_mm_extract_epi32(index, 1)],
+                       base[_mm_extract_epi32(index, 2)], base[_mm_extract_epi32(index, 3)]);
+}
+
+static inline simd_f simd_byte_f(simd_i texels, int shift) {
+    return _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(texels, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF)));
+}
+
+static inline simd_f simd_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void simd_store(float *p, simd_f v) { _mm_storeu_ps(p, v); }
+static inline simd_i simd_load_u32(const uint32_t *p) { return _mm_loadu_si128((const __m128i *)(const void *)p); }
+
+static inline simd_f simd_load_u8(const uint8_t *p) {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+}
+
+static inline simd_f simd_load_i8(const int8_t *p) {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return _mm_cvtepi32_ps(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(v)));
+}
+
+#ifdef __F16C__
+static inline simd_f simd_load_f16(const uint16_t *p) {
+    return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)(const void *)p));
+}
+#else
+static inline simd_f simd_load_f16(const uint16_t *p) {
+    return _mm_setr_ps(simd_half_to_float(p[0]), simd_half_to_float(p[1]), simd_half_to_float(p[2]),
+                       simd_half_to_float(p[3]));
+}
+#endif
+
+static inline void simd_store_u8(uint8_t *p, simd_f v) {
+    __m128i i = _mm_cvtps_epi32(v);
+    __m128i w = _mm_packus_epi32(i, i);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+    memcpy(p, &bytes, sizeof(bytes));
+}
+
+static inline simd_i simd_pack_rgba8(simd_f r, simd_f g, simd_f b, simd_f a) {
+    __m128i rg = _mm_packus_epi32(_mm_cvtps_epi32(r), _mm_cvtps_epi32(g));
+    __m128i ba = _mm_packus_epi32(_mm_cvtps_epi32(b), _mm_cvtps_epi32(a));
+    __m128i rgba = _mm_packus_epi16(rg, ba);
+    const __m128i order = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    return _mm_shuffle_epi8(rgba, order);
+}
+
+static inline void simd_store_u32(uint32_t *p, simd_i v) { _mm_storeu_si128((__m128i *)(void *)p, v); }
+
+#else
+typedef float simd_f;
+typedef int32_t simd_i;
+typedef bool simd_m;
+
+static inline simd_f simd_set1(float v) { return v; }
+static inline simd_f simd_ramp(void) { return 0.0f; }
+static inline simd_f simd_add(simd_f a, simd_f b) { return a + b; }
+static inline simd_f simd_sub(simd_f a, simd_f b) { return a - b; }
+static inline simd_f simd_mul(simd_f a, simd_f b) { return a * b; }
+static inline simd_f simd_div(simd_f a, simd_f b) { return a / b; }
+static inline simd_f simd_min(simd_f a, simd_f b) { return a < b ? a : b; }
+static inline simd_f simd_max(simd_f a, simd_f b) { return a > b ? a : b; }
+static inline simd_f simd_sqrt(simd_f a) { return sqrtf(a); }
+static inline simd_f simd_floor(simd_f a) { return floorf(a); }
+static inline simd_f simd_madd(simd_f a, simd_f b, simd_f c) { return a * b + c; }
+
+static inline simd_m simd_lt(simd_f a, simd_f b) { return a < b; }
+static inline simd_m simd_gt(simd_f a, simd_f b) { return a > b; }
+static inline simd_m simd_m_and(simd_m a, simd_m b) { return a && b; }
+static inline simd_m simd_m_or(simd_m a, simd_m b) { return a || b; }
+static inline simd_f simd_select(simd_m m, simd_f a, simd_f b) { return m ? a : b; }
+static inline bool simd_any(simd_m m) { return m; }
+
+static inline simd_i simd_i_set1(int v) { return v; }
+static inline simd_i simd_i_add(simd_i a, simd_i b) { return a + b; }
+static inline simd_i simd_i_mul(simd_i a, simd_i b) { return a * b; }
+static inline simd_i simd_i_min(simd_i a, simd_i b) { return a < b ? a : b; }
+static inline simd_i simd_i_max(simd_i a, simd_i b) { return a > b ? a : b; }
+static inline simd_i simd_i_and(simd_i a, simd_i b) { return a & b; }
+static inline simd_i simd_i_lt(simd_i a, simd_i b) { return a < b ? -1 : 0; }
+static inline simd_i simd_i_eq(simd_i a, simd_i b) { return a == b ? -1 : 0; }
+static inline simd_i simd_i_from_f(simd_f a) { return (simd_i)a; }
+static inline simd_f simd_f_from_i(simd_i a) { return (simd_f)a; }
+static inline simd_f simd_gather(const float *base, simd_i index) { return base[index]; }
+static inline simd_i simd_gather_u32(const uint32_t *base, simd_i index) { return (simd_i)base[index]; }
+static inline simd_f simd_gather_u16(const uint16_t *base, simd_i index) { return (float)base[index]; }
+
+static inline simd_f simd_byte_f(simd_i texels, int shift) { return (float)(((uint32_t)texels >> shift) & 0xFF); }
+
+static inline simd_f simd_load(const float *p) { return *p; }
+static inline void simd_store(float *p, simd_f v) { *p = v; }
+static inline simd_i simd_load_u32(const uint32_t *p) { return (simd_i)*p; }
+static inline simd_f simd_load_u8(const uint8_t *p) { return (float)*p; }
+static inline simd_f simd_load_i8(const int8_t *p) { return (float)*p; }
+static inline simd_f simd_load_f16(const uint16_t *p) { return simd_half_to_float(*p); }
+
+static inline uint32_t simd_round_u8(float v) {
+    if (!(v > 0.0f)) return 0;
+    if (v >= 255.0f) return 255;
+    return (uint32_t)lrintf(v);
+}
+
+static inline void simd_store_u8(uint8_t *p, simd_f v) { *p = (uint8_t)simd_round_u8(v); }
+
+static inline simd_i simd_pack_rgba8(simd_f r, simd_f g, simd_f b, simd_f a) {
+    return (simd_i)(simd_round_u8(r) | simd_round_u8(g) << 8 | simd_round_u8(b) << 16 | simd_round_u8(a) << 24);
+}
+
+static inline void simd_store_u32(uint32_t *p, simd_i v) { *p = (uint32_t)v; }
+#endif
+
+// --- Shared helpers ---
+
+static inline simd_f simd_saturate(simd_f a) { return simd_min(simd_max(a, simd_set1(0.0f)), simd_set1(1.0f)); }
+static inline simd_f simd_lerp(simd_f a, simd_f b, simd_f t) { return simd_madd(simd_sub(b, a), t, a); }
+static inline simd_f simd_frac(simd_f a) { return simd_sub(a, simd_floor(a)); }
+
+// Lanes holding consecutive values start, start + 1, ...
+static inline simd_f simd_iota(float start) { return simd_add(simd_set1(start), simd_ramp()); }
+
+// smoothstep(0, edge, x) as in HLSL, edge > 0
+static inline simd_f simd_smoothstep0(simd_f edge, simd_f x) {
+    simd_f t = simd_saturate(simd_div(x, edge));
+    return simd_mul(simd_mul(t, t), simd_sub(simd_set1(3.0f), simd_add(t, t)));
+}
+
+static inline void simd_unpack_rgba8(simd_i texels, simd_f *r, simd_f *g, simd_f *b, simd_f *a) {
+    *r = simd_byte_f(texels, 0);
+    *g = simd_byte_f(texels, 8);
+    *b = simd_byte_f(texels, 16);
+    *a = simd_byte_f(texels, 24);
+}
+
+#if defined(SIMD_SCALAR)
+static inline simd_f simd_log2(simd_f x) { return log2f(x); }
+static inline simd_f simd_exp2(simd_f x) { return exp2f(x); }
+#else
+// log2 for x > 0: exponent plus log2 of the mantissa folded into
+// [sqrt(1/2), sqrt(2)), from the atanh series in t = (m - 1) / (m + 1).
+// Max error a few 1e-7.
+static inline simd_f simd_log2(simd_f x) {
+    union { float f; int32_t i; } one = {1.0f};
+#if defined(SIMD_AVX2)
+    __m256i bits = _mm256_castps_si256(x);
+    simd_f e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    simd_f m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                   _mm256_set1_epi32(one.i)));
+#else
+    __m128i bits = _mm_castps_si128(x);
+    simd_f e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    simd_f m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(one.i)));
+#endif
+    simd_m high = simd_gt(m, simd_set1(1.41421356f));
+    m = simd_select(high, simd_mul(m, simd_set1(0.5f)), m);
+    e = simd_select(high, simd_add(e, simd_set1(1.0f)), e);
+
+    simd_f t = simd_div(simd_sub(m, simd_set1(1.0f)), simd_add(m, simd_set1(1.0f)));
+    simd_f t2 = simd_mul(t, t);
+    simd_f p = simd_madd(t2, simd_set1(1.0f / 7.0f), simd_set1(1.0f / 5.0f));
+    p = simd_madd(p, t2, simd_set1(1.0f / 3.0f));
+    p = simd_madd(p, t2, simd_set1(1.0f));
+    return simd_madd(simd_mul(p, t), simd_set1(2.88539008f), e); // 2 / ln(2)
+}
+
+// exp2 for x in about [-126, 127]: integer part into the exponent, degree 5
+// fit of 2^f on f in [0, 1)
+static inline simd_f simd_exp2(simd_f x) {
+    x = simd_max(x, simd_set1(-126.0f));
+    x = simd_min(x, simd_set1(127.0f));
+    simd_f fl = simd_floor(x);
+    simd_f f = simd_sub(x, fl);
+
+    simd_f p = simd_set1(1.8775767e-3f);
+    p = simd_madd(p, f, simd_set1(8.9893397e-3f));
+    p = simd_madd(p, f, simd_set1(5.5826318e-2f));
+    p = simd_madd(p, f, simd_set1(2.4015361e-1f));
+    p = simd_madd(p, f, simd_set1(6.9315308e-1f));
+    p = simd_madd(p, f, simd_set1(1.0f));
+
+#if defined(SIMD_AVX2)
+    __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(fl), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+#else
+    __m128i scale = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(fl), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(scale));
+#endif
+}
+#endif
+
+// pow(x, y) for x >= 0 (0 where x is 0), as the shaders use it on saturated values
+static inline simd_f simd_pow(simd_f x, simd_f y) {
+    simd_m positive = simd_gt(x, simd_set1(0.0f));
+    simd_f safe = simd_max(x, simd_set1(1e-30f));
+    return simd_select(positive, simd_exp2(simd_mul(simd_log2(safe), y)), simd_set1(0.0f));
+}
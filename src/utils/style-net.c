@@ -0,0 +1,558 @@
+/*
+ * src/utils/style-net.c
+ * CPU inference for small feed-forward style transfer networks (no libobs
+ * dependency)
+ */
+
+#include "style-net.h"
+#include "simd.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STYLE_MAX_LAYERS 64
+#define STYLE_MAX_CHANNELS 256
+#define STYLE_MAX_KERNEL 9
+#define STYLE_CHANNEL_ALIGN 8   // Activations pad channels to this, a multiple of SIMD_LANES
+#define STYLE_PIXEL_BLOCK 4     // Output pixels sharing each weight load
+#define STYLE_ROWS_PER_TASK 2
+#define STYLE_NORM_EPSILON 1e-5f
+
+typedef struct {
+    uint8_t op, act, norm, weights;
+    uint32_t kernel, stride;
+    uint32_t in, out;
+    uint32_t out_pad;           // `out` rounded up to STYLE_CHANNEL_ALIGN
+    void *w;                    // [ky][kx][in][out_pad] of the weights' type, padding zeroed
+    float *scale;               // [out_pad], int8 dequantisation, 1 otherwise
+    float *bias;                // [out_pad]
+    float *gamma;               // [out_pad], instance norm only
+    float *beta;
+} style_layer_t;
+
+// Activations, channels innermost so a SIMD load covers adjacent channels
+typedef struct {
+    float *data;                // [y][x][channels]
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;          // Padded
+    size_t capacity;            // Floats allocated
+} style_tensor_t;
+
+struct style_net {
+    style_layer_t layers[STYLE_MAX_LAYERS];
+    size_t num_layers;
+    uint32_t alignment;
+    const char *precision;
+    style_tensor_t buffers[3];  // Two ping-pong plus a residual block's input
+};
+
+static uint32_t pad_channels(uint32_t channels) {
+    return (channels + STYLE_CHANNEL_ALIGN - 1) & ~(uint32_t)(STYLE_CHANNEL_ALIGN - 1);
+}
+
+static size_t weight_size(uint8_t type) {
+    return type == STYLE_WEIGHTS_FP32 ? 4 : type == STYLE_WEIGHTS_FP16 ? 2 : 1;
+}
+
+static void set_error(char *error, size_t error_size, const char *fmt, ...) {
+    if (!error || error_size == 0) return;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(error, error_size, fmt, args);
+    va_end(args);
+}
+
+// --- Loading ---
+
+static bool read_bytes(FILE *file, void *out, size_t size) {
+    return fread(out, 1, size, file) == size;
+}
+
+static bool read_u16(FILE *file, uint32_t *out) {
+    uint8_t b[2];
+    if (!read_bytes(file, b, sizeof(b))) return false;
+    *out = (uint32_t)b[0] | (uint32_t)b[1] << 8;
+    return true;
+}
+
+static bool read_u32(FILE *file, uint32_t *out) {
+    uint8_t b[4];
+    if (!read_bytes(file, b, sizeof(b))) return false;
+    *out = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+    return true;
+}
+
+// `count` float32 values into a zeroed [out_pad] array
+static float *read_channel_floats(FILE *file, uint32_t count, uint32_t padded) {
+    float *values = calloc(padded, sizeof(float));
+    if (values && !read_bytes(file, values, sizeof(float) * count)) {
+        free(values);
+        return NULL;
+    }
+    return values;
+}
+
+// Reads [ky][kx][in][out] weights, spreading each output row to out_pad
+static bool read_conv_weights(FILE *file, style_layer_t *layer) {
+    size_t elem = weight_size(layer->weights);
+    size_t rows = (size_t)layer->kernel * layer->kernel * layer->in;
+    layer->w = calloc(rows * layer->out_pad, elem);
+    if (!layer->w) return false;
+
+    uint8_t *dst = layer->w;
+    for (size_t r = 0; r < rows; r++) {
+        if (!read_bytes(file, dst + r * layer->out_pad * elem, layer->out * elem)) return false;
+    }
+    return true;
+}
+
+static bool read_conv(FILE *file, style_layer_t *layer) {
+    if (!read_conv_weights(file, layer)) return false;
+
+    if (layer->weights == STYLE_WEIGHTS_INT8) {
+        layer->scale = read_channel_floats(file, layer->out, layer->out_pad);
+    } else {
+        layer->scale = calloc(layer->out_pad, sizeof(float));
+        for (uint32_t c = 0; layer->scale && c < layer->out_pad; c++) layer->scale[c] = 1.0f;
+    }
+    layer->bias = layer->scale ? read_channel_floats(file, layer->out, layer->out_pad) : NULL;
+    if (!layer->bias) return false;
+
+    if (layer->norm) {
+        layer->gamma = read_channel_floats(file, layer->out, layer->out_pad);
+        layer->beta = layer->gamma ? read_channel_floats(file, layer->out, layer->out_pad) : NULL;
+        if (!layer->beta) return false;
+    }
+    return true;
+}
+
+// Checks the layer against the activations reaching it. `channels` and
+// `factor` (input size / current size) track those; `residual_*` the open
+// residual block, channels 0 when none.
+static bool validate_layer(const style_layer_t *layer, uint32_t *channels, uint32_t *factor, uint32_t *alignment,
+                           uint32_t *residual_channels, uint32_t *residual_factor, char *error, size_t error_size) {
+    switch (layer->op) {
+        case STYLE_OP_CONV:
+            if (layer->in != *channels) {
+                set_error(error, error_size, "convolution expects %u channels, gets %u", layer->in, *channels);
+                return false;
+            }
+            if (!(layer->kernel & 1) || layer->kernel > STYLE_MAX_KERNEL || (layer->stride != 1 && layer->stride != 2) ||
+                layer->out == 0 || layer->out > STYLE_MAX_CHANNELS || layer->act > STYLE_ACT_SIGMOID ||
+                layer->weights > STYLE_WEIGHTS_INT8 || layer->norm > 1) {
+                set_error(error, error_size, "unsupported convolution (kernel %u, stride %u, %u channels)",
+                          layer->kernel, layer->stride, layer->out);
+                return false;
+            }
+            *channels = layer->out;
+            *factor *= layer->stride;
+            if (*factor > *alignment) *alignment = *factor;
+            return true;
+        case STYLE_OP_UPSAMPLE:
+            if (*factor < 2) {
+                set_error(error, error_size, "upsampling past the input size");
+                return false;
+            }
+            *factor /= 2;
+            return true;
+        case STYLE_OP_RESIDUAL_BEGIN:
+            if (*residual_channels) {
+                set_error(error, error_size, "nested residual blocks");
+                return false;
+            }
+            *residual_channels = *channels;
+            *residual_factor = *factor;
+            return true;
+        case STYLE_OP_RESIDUAL_ADD:
+            if (*residual_channels != *channels || *residual_factor != *factor) {
+                set_error(error, error_size, "residual block changes the activations' shape");
+                return false;
+            }
+            *residual_channels = 0;
+            return true;
+        default:
+            set_error(error, error_size, "unknown layer type %u", layer->op);
+            return false;
+    }
+}
+
+style_net_t *style_net_load(const char *path, char *error, size_t error_size) {
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    if (!file) {
+        set_error(error, error_size, "cannot open %s", path ? path : "(null)");
+        return NULL;
+    }
+
+    style_net_t *net = calloc(1, sizeof(style_net_t));
+    char magic[4];
+    uint32_t num_layers = 0;
+    bool ok = net && read_bytes(file, magic, sizeof(magic)) && memcmp(magic, "ESN1", 4) == 0 &&
+              read_u32(file, &num_layers);
+    if (!ok || num_layers == 0 || num_layers > STYLE_MAX_LAYERS) {
+        set_error(error, error_size, "not a style network file");
+        goto fail;
+    }
+
+    uint32_t channels = 3, factor = 1, alignment = 1, residual_channels = 0, residual_factor = 0;
+    bool types_used[3] = {false, false, false};
+
+    for (uint32_t i = 0; i < num_layers; i++) {
+        style_layer_t *layer = &net->layers[net->num_layers++];
+        uint8_t head[4];
+        if (!read_bytes(file, head, sizeof(head)) || !read_u16(file, &layer->kernel) ||
+            !read_u16(file, &layer->stride) || !read_u16(file, &layer->in) || !read_u16(file, &layer->out)) {
+            set_error(error, error_size, "truncated at layer %u", i);
+            goto fail;
+        }
+        layer->op = head[0];
+        layer->act = head[1];
+        layer->norm = head[2];
+        layer->weights = head[3];
+        layer->out_pad = pad_channels(layer->out);
+
+        if (!validate_layer(layer, &channels, &factor, &alignment, &residual_channels, &residual_factor, error,
+                            error_size)) {
+            goto fail;
+        }
+        if (layer->op != STYLE_OP_CONV) continue;
+
+        types_used[layer->weights] = true;
+        if (!read_conv(file, layer)) {
+            set_error(error, error_size, "truncated weights at layer %u", i);
+            goto fail;
+        }
+    }
+
+    if (channels < 3 || factor != 1 || residual_channels) {
+        set_error(error, error_size, "network doesn't end in RGB at the input size");
+        goto fail;
+    }
+
+    net->alignment = alignment;
+    int kinds = types_used[0] + types_used[1] + types_used[2];
+    net->precision = kinds > 1 ? "mixed" : types_used[STYLE_WEIGHTS_INT8] ? "int8" :
+                     types_used[STYLE_WEIGHTS_FP16] ? "fp16" : "fp32";
+    fclose(file);
+    return net;
+
+fail:
+    fclose(file);
+    style_net_destroy(net);
+    return NULL;
+}
+
+void style_net_destroy(style_net_t *net) {
+    if (!net) return;
+
+    for (size_t i = 0; i < net->num_layers; i++) {
+        style_layer_t *layer = &net->layers[i];
+        free(layer->w);
+        free(layer->scale);
+        free(layer->bias);
+        free(layer->gamma);
+        free(layer->beta);
+    }
+    for (size_t i = 0; i < 3; i++) free(net->buffers[i].data);
+    free(net);
+}
+
+uint32_t style_net_alignment(const style_net_t *net) {
+    return net ? net->alignment : 1;
+}
+
+const char *style_net_precision(const style_net_t *net) {
+    return net ? net->precision : "";
+}
+
+// --- Kernels ---
+
+static bool tensor_reserve(style_tensor_t *t, uint32_t width, uint32_t height, uint32_t channels) {
+    size_t needed = (size_t)width * height * channels;
+    if (needed > t->capacity) {
+        float *data = realloc(t->data, sizeof(float) * needed);
+        if (!data) return false;
+        t->data = data;
+        t->capacity = needed;
+    }
+    t->width = width;
+    t->height = height;
+    t->channels = channels;
+    return true;
+}
+
+static inline float *tensor_at(const style_tensor_t *t, uint32_t x, uint32_t y) {
+    return t->data + ((size_t)y * t->width + x) * t->channels;
+}
+
+// Reflection padding: -1 reads 1, n reads n - 2. Keeps reflecting past a
+// whole edge, for kernels wider than the input, so any i lands in [0, n).
+static inline uint32_t reflect(int i, uint32_t n) {
+    if (i >= 0 && i < (int)n) return (uint32_t)i;
+    if (n == 1) return 0;
+
+    int period = 2 * (int)n - 2;
+    if (i < 0) i = -i;
+    i %= period;
+    if (i >= (int)n) i = period - i;
+    return (uint32_t)i;
+}
+
+static inline simd_f activate(simd_f v, uint8_t act) {
+    if (act == STYLE_ACT_RELU) return simd_max(v, simd_set1(0.0f));
+    if (act == STYLE_ACT_SIGMOID) {
+        // 1 / (1 + 2^(-v * log2(e)))
+        simd_f e = simd_exp2(simd_mul(v, simd_set1(-1.44269504f)));
+        return simd_div(simd_set1(1.0f), simd_add(simd_set1(1.0f), e));
+    }
+    return v;
+}
+
+typedef struct {
+    const style_layer_t *layer;
+    const style_tensor_t *in;
+    style_tensor_t *out;
+    bool fuse_act;              // No norm follows, apply the activation here
+} conv_job_t;
+
+// acc[p] += in[p][ci] * w[ci][co..co + SIMD_LANES) over the layer's inputs,
+// for one kernel tap. One switch per tap keeps the type out of the inner loop.
+static inline void conv_tap(const style_layer_t *layer, size_t row, uint32_t co, const float *const *px, uint32_t n,
+                            simd_f *acc) {
+    size_t stride = layer->out_pad;
+
+#define CONV_TAP_LOOP(load)                                                    \
+    for (uint32_t ci = 0; ci < layer->in; ci++) {                              \
+        simd_f wv = load;                                                      \
+        for (uint32_t p = 0; p < n; p++) {                                     \
+            acc[p] = simd_madd(simd_set1(px[p][ci]), wv, acc[p]);              \
+        }                                                                      \
+    }
+
+    switch (layer->weights) {
+        case STYLE_WEIGHTS_FP32: {
+            const float *w = (const float *)layer->w + row * stride + co;
+            CONV_TAP_LOOP(simd_load(w + ci * stride))
+            break;
+        }
+        case STYLE_WEIGHTS_FP16: {
+            const uint16_t *w = (const uint16_t *)layer->w + row * stride + co;
+            CONV_TAP_LOOP(simd_load_f16(w + ci * stride))
+            break;
+        }
+        case STYLE_WEIGHTS_INT8: {
+            const int8_t *w = (const int8_t *)layer->w + row * stride + co;
+            CONV_TAP_LOOP(simd_load_i8(w + ci * stride))
+            break;
+        }
+    }
+
+#undef CONV_TAP_LOOP
+}
+
+static void conv_rows(void *ctx, size_t begin, size_t end) {
+    const conv_job_t *job = ctx;
+    const style_layer_t *layer = job->layer;
+    const style_tensor_t *in = job->in;
+    const style_tensor_t *out = job->out;
+    const int half = (int)layer->kernel / 2;
+
+    for (uint32_t oy = (uint32_t)begin; oy < (uint32_t)end; oy++) {
+        for (uint32_t ox = 0; ox < out->width; ox += STYLE_PIXEL_BLOCK) {
+            uint32_t n = out->width - ox < STYLE_PIXEL_BLOCK ? out->width - ox : STYLE_PIXEL_BLOCK;
+
+            for (uint32_t co = 0; co < layer->out_pad; co += SIMD_LANES) {
+                simd_f acc[STYLE_PIXEL_BLOCK];
+                for (uint32_t p = 0; p < STYLE_PIXEL_BLOCK; p++) acc[p] = simd_set1(0.0f);
+
+                for (uint32_t ky = 0; ky < layer->kernel; ky++) {
+                    uint32_t iy = reflect((int)(oy * layer->stride + ky) - half, in->height);
+                    for (uint32_t kx = 0; kx < layer->kernel; kx++) {
+                        const float *px[STYLE_PIXEL_BLOCK];
+                        for (uint32_t p = 0; p < n; p++) {
+                            px[p] = tensor_at(in, reflect((int)((ox + p) * layer->stride + kx) - half, in->width), iy);
+                        }
+                        size_t row = ((size_t)ky * layer->kernel + kx) * layer->in;
+                        conv_tap(layer, row, co, px, n, acc);
+                    }
+                }
+
+                simd_f scale = simd_load(layer->scale + co);
+                simd_f bias = simd_load(layer->bias + co);
+                for (uint32_t p = 0; p < n; p++) {
+                    simd_f v = simd_madd(acc[p], scale, bias);
+                    if (job->fuse_act) v = activate(v, layer->act);
+                    simd_store(tensor_at(out, ox + p, oy) + co, v);
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    const style_layer_t *layer;
+    style_tensor_t *t;
+    const float *mean;
+    const float *inv_std;
+} norm_job_t;
+
+static void norm_rows(void *ctx, size_t begin, size_t end) {
+    const norm_job_t *job = ctx;
+    const style_layer_t *layer = job->layer;
+    const style_tensor_t *t = job->t;
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        for (uint32_t x = 0; x < t->width; x++) {
+            float *px = tensor_at(t, x, y);
+            for (uint32_t c = 0; c < t->channels; c += SIMD_LANES) {
+                simd_f v = simd_mul(simd_sub(simd_load(px + c), simd_load(job->mean + c)), simd_load(job->inv_std + c));
+                v = simd_madd(v, simd_load(layer->gamma + c), simd_load(layer->beta + c));
+                simd_store(px + c, activate(v, layer->act));
+            }
+        }
+    }
+}
+
+// Normalises each channel over the image, then applies gamma, beta and the
+// activation. The statistics are a cheap serial pass next to the convolution.
+static void instance_norm(const style_layer_t *layer, style_tensor_t *t, task_pool_t *pool) {
+    float mean[STYLE_MAX_CHANNELS] = {0};
+    float inv_std[STYLE_MAX_CHANNELS] = {0};
+    size_t pixels = (size_t)t->width * t->height;
+    const simd_f inv_count = simd_set1(1.0f / (float)pixels);
+
+    for (uint32_t c = 0; c < t->channels; c += SIMD_LANES) {
+        simd_f sum = simd_set1(0.0f);
+        for (size_t i = 0; i < pixels; i++) sum = simd_add(sum, simd_load(t->data + i * t->channels + c));
+        simd_f m = simd_mul(sum, inv_count);
+
+        simd_f var = simd_set1(0.0f);
+        for (size_t i = 0; i < pixels; i++) {
+            simd_f d = simd_sub(simd_load(t->data + i * t->channels + c), m);
+            var = simd_madd(d, d, var);
+        }
+        var = simd_mul(var, inv_count);
+
+        simd_store(mean + c, m);
+        simd_store(inv_std + c, simd_div(simd_set1(1.0f), simd_sqrt(simd_add(var, simd_set1(STYLE_NORM_EPSILON)))));
+    }
+
+    norm_job_t job = {layer, t, mean, inv_std};
+    task_pool_parallel_for(pool, t->height, STYLE_ROWS_PER_TASK, norm_rows, &job);
+}
+
+typedef struct {
+    const style_tensor_t *in;
+    style_tensor_t *out;
+} upsample_job_t;
+
+static void upsample_rows(void *ctx, size_t begin, size_t end) {
+    const upsample_job_t *job = ctx;
+    size_t bytes = sizeof(float) * job->in->channels;
+
+    for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++) {
+        for (uint32_t x = 0; x < job->out->width; x++) {
+            memcpy(tensor_at(job->out, x, y), tensor_at(job->in, x / 2, y / 2), bytes);
+        }
+    }
+}
+
+static void residual_add(style_tensor_t *t, const style_tensor_t *skip) {
+    size_t count = (size_t)t->width * t->height * t->channels;
+    for (size_t i = 0; i < count; i += SIMD_LANES) {
+        simd_store(t->data + i, simd_add(simd_load(t->data + i), simd_load(skip->data + i)));
+    }
+}
+
+// --- Inference ---
+
+static void load_input(style_tensor_t *t, const uint32_t *src, uint32_t stride) {
+    memset(t->data, 0, sizeof(float) * t->width * t->height * t->channels);
+    for (uint32_t y = 0; y < t->height; y++) {
+        for (uint32_t x = 0; x < t->width; x++) {
+            uint32_t texel = src[(size_t)y * stride + x];
+            float *px = tensor_at(t, x, y);
+            px[0] = (float)(texel & 0xFF) / 255.0f;
+            px[1] = (float)((texel >> 8) & 0xFF) / 255.0f;
+            px[2] = (float)((texel >> 16) & 0xFF) / 255.0f;
+        }
+    }
+}
+
+static inline uint32_t to_byte(float v) {
+    if (!(v > 0.0f)) return 0;
+    if (v >= 1.0f) return 255;
+    return (uint32_t)(v * 255.0f + 0.5f);
+}
+
+static void store_output(const style_tensor_t *t, const uint32_t *src, uint32_t *dst, uint32_t stride) {
+    for (uint32_t y = 0; y < t->height; y++) {
+        for (uint32_t x = 0; x < t->width; x++) {
+            const float *px = tensor_at(t, x, y);
+            size_t i = (size_t)y * stride + x;
+            dst[i] = to_byte(px[0]) | to_byte(px[1]) << 8 | to_byte(px[2]) << 16 | (src[i] & 0xFF000000u);
+        }
+    }
+}
+
+// A buffer that is neither the current activations nor a residual input
+static int free_buffer(int current, int residual) {
+    for (int i = 0; i < 3; i++) {
+        if (i != current && i != residual) return i;
+    }
+    return -1;
+}
+
+bool style_net_run(style_net_t *net, task_pool_t *pool, const uint32_t *src, uint32_t *dst, uint32_t width,
+                   uint32_t height, uint32_t stride) {
+    if (!net || !src || !dst || width == 0 || height == 0) return false;
+    if (width % net->alignment || height % net->alignment) return false;
+
+    int current = 0, residual = -1;
+    if (!tensor_reserve(&net->buffers[0], width, height, pad_channels(3))) return false;
+    load_input(&net->buffers[0], src, stride);
+
+    for (size_t i = 0; i < net->num_layers; i++) {
+        const style_layer_t *layer = &net->layers[i];
+        style_tensor_t *in = &net->buffers[current];
+
+        switch (layer->op) {
+            case STYLE_OP_CONV: {
+                int next = free_buffer(current, residual);
+                style_tensor_t *out = &net->buffers[next];
+                uint32_t cx = (in->width + layer->stride - 1) / layer->stride;
+                uint32_t cy = (in->height + layer->stride - 1) / layer->stride;
+                if (!tensor_reserve(out, cx, cy, layer->out_pad)) return false;
+
+                conv_job_t job = {layer, in, out, !layer->norm};
+                task_pool_parallel_for(pool, cy, STYLE_ROWS_PER_TASK, conv_rows, &job);
+                if (layer->norm) instance_norm(layer, out, pool);
+                current = next;
+                break;
+            }
+            case STYLE_OP_UPSAMPLE: {
+                int next = free_buffer(current, residual);
+                style_tensor_t *out = &net->buffers[next];
+                if (!tensor_reserve(out, in->width * 2, in->height * 2, in->channels)) return false;
+
+                upsample_job_t job = {in, out};
+                task_pool_parallel_for(pool, out->height, STYLE_ROWS_PER_TASK * 4, upsample_rows, &job);
+                current = next;
+                break;
+            }
+            case STYLE_OP_RESIDUAL_BEGIN:
+                residual = current;
+                break;
+            case STYLE_OP_RESIDUAL_ADD:
+                residual_add(in, &net->buffers[residual]);
+                residual = -1;
+                break;
+        }
+    }
+
+    const style_tensor_t *result = &net->buffers[current];
+    if (result->width != width || result->height != height) return false;
+    store_output(result, src, dst, stride);
+    return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * src/utils/style-net.h
+ * CPU inference for small feed-forward style transfer networks (no libobs
+ * dependency). Convolutions run on SIMD lanes of output channels, rows split
+ * over a task pool; weights may be stored as fp32, fp16 or int8.
+ */
+
+#pragma once
+
+#include "task-pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Network file (".esn"), little endian:
+//   char     magic[4]  "ESN1"
+//   uint32   num_layers
+//   per layer:
+//     uint8  op        STYLE_OP_*
+//     uint8  act       STYLE_ACT_*, applied after the optional norm
+//     uint8  norm      1 = instance norm (STYLE_OP_CONV only)
+//     uint8  weights   STYLE_WEIGHTS_*
+//     uint16 kernel, stride, in_channels, out_channels
+//     STYLE_OP_CONV only, in this order:
+//       weights   out * kernel * kernel * in values, [ky][kx][in][out]
+//       float32   scale[out]           STYLE_WEIGHTS_INT8 only
+//       float32   bias[out]
+//       float32   gamma[out], beta[out] norm only
+// Input is RGB in 0..1 (3 channels), the output's first three channels are
+// RGB in 0..1. Convolutions pad by reflection and keep ceil(size / stride).
+
+enum style_op {
+    STYLE_OP_CONV = 0,
+    STYLE_OP_UPSAMPLE = 1,      // Nearest neighbour, 2x
+    STYLE_OP_RESIDUAL_BEGIN = 2, // Remembers the current activations
+    STYLE_OP_RESIDUAL_ADD = 3    // Adds them back; blocks don't nest
+};
+
+enum style_act {
+    STYLE_ACT_NONE = 0,
+    STYLE_ACT_RELU = 1,
+    STYLE_ACT_SIGMOID = 2
+};
+
+enum style_weights {
+    STYLE_WEIGHTS_FP32 = 0,
+    STYLE_WEIGHTS_FP16 = 1,
+    STYLE_WEIGHTS_INT8 = 2      // Symmetric, one scale per output channel
+};
+
+typedef struct style_net style_net_t;
+
+// Reads and validates a network file. On failure returns NULL and writes a
+// reason to `error`.
+style_net_t *style_net_load(const char *path, char *error, size_t error_size);
+void style_net_destroy(style_net_t *net);
+
+// Input sizes must be multiples of this for the output to match them
+uint32_t style_net_alignment(const style_net_t *net);
+
+// "fp32", "fp16", "int8" or "mixed"
+const char *style_net_precision(const style_net_t *net);
+
+// Stylises width x height RGBA8 texels (R in the low byte, rows `stride`
+// texels apart) from `src` into `dst`; alpha is copied. Not thread safe per
+// network: scratch buffers live in `net`. Returns false if the sizes don't
+// fit the network or memory runs out.
+bool style_net_run(style_net_t *net, task_pool_t *pool, const uint32_t *src, uint32_t *dst, uint32_t width,
+                   uint32_t height, uint32_t stride);
+
+#ifdef __cplusplus
+}
+#endif
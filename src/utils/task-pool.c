@@ -0,0 +1,186 @@
+/*
+ * src/utils/task-pool.c
+ * Persistent worker threads for data-parallel CPU work (no libobs dependency)
+ */
+
+#include "task-pool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define TASK_POOL_MAX_THREADS 16
+
+struct task_pool {
+    pthread_t threads[TASK_POOL_MAX_THREADS];
+    size_t num_threads;
+
+    pthread_mutex_t submit_mutex;  // One parallel_for at a time
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+
+    // Current job, guarded by mutex
+    task_range_fn fn;
+    void *ctx;
+    size_t count;
+    size_t grain;
+    size_t next;          // First unclaimed item
+    size_t pending;       // Claimed or unclaimed chunks not finished yet
+    unsigned generation;  // Bumped per job so idle workers can tell it's new
+    bool shutdown;
+};
+
+static size_t logical_cores(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+// Claims and runs chunks until the job has none left. Called with mutex held.
+static void run_chunks(task_pool_t *pool) {
+    while (pool->next < pool->count) {
+        size_t begin = pool->next;
+        size_t end = begin + pool->grain;
+        if (end > pool->count) end = pool->count;
+        pool->next = end;
+
+        task_range_fn fn = pool->fn;
+        void *ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->mutex);
+        fn(ctx, begin, end);
+        pthread_mutex_lock(&pool->mutex);
+
+        if (--pool->pending == 0) {
+            pthread_cond_broadcast(&pool->done_cond);
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    task_pool_t *pool = arg;
+    unsigned seen_generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->shutdown) {
+        if (seen_generation == pool->generation) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+            continue;
+        }
+        seen_generation = pool->generation;
+        run_chunks(pool);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+task_pool_t *task_pool_create(size_t num_threads) {
+    if (num_threads == 0) {
+        size_t cores = logical_cores();
+        num_threads = cores > 1 ? cores - 1 : 0;
+    }
+    if (num_threads > TASK_POOL_MAX_THREADS) num_threads = TASK_POOL_MAX_THREADS;
+
+    task_pool_t *pool = calloc(1, sizeof(task_pool_t));
+    if (!pool) return NULL;
+
+    pthread_mutex_init(&pool->submit_mutex, NULL);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    for (size_t i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) break;
+        pool->num_threads++;
+    }
+
+    return pool;
+}
+
+void task_pool_destroy(task_pool_t *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_mutex_destroy(&pool->submit_mutex);
+    free(pool);
+}
+
+void task_pool_parallel_for(task_pool_t *pool, size_t count, size_t grain, task_range_fn fn, void *ctx) {
+    if (!fn || count == 0) return;
+    if (grain == 0) grain = 1;
+
+    if (!pool || pool->num_threads == 0 || count <= grain) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->submit_mutex);
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->grain = grain;
+    pool->next = 0;
+    pool->pending = (count + grain - 1) / grain;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    run_chunks(pool);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+
+    pool->fn = NULL;
+    pool->ctx = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+    pthread_mutex_unlock(&pool->submit_mutex);
+}
+
+size_t task_pool_num_threads(const task_pool_t *pool) {
+    return pool ? pool->num_threads : 0;
+}
+
+// --- Shared pool ---
+
+static pthread_mutex_t shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static task_pool_t *shared_pool = NULL;
+
+task_pool_t *task_pool_shared(void) {
+    pthread_mutex_lock(&shared_mutex);
+    if (!shared_pool) shared_pool = task_pool_create(0);
+    task_pool_t *pool = shared_pool;
+    pthread_mutex_unlock(&shared_mutex);
+    return pool;
+}
+
+void task_pool_shared_release(void) {
+    pthread_mutex_lock(&shared_mutex);
+    task_pool_t *pool = shared_pool;
+    shared_pool = NULL;
+    pthread_mutex_unlock(&shared_mutex);
+
+    task_pool_destroy(pool);
+}
@@ -0,0 +1,36 @@
+/*
+ * src/utils/task-pool.h
+ * Persistent worker threads for data-parallel CPU work (no libobs dependency)
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct task_pool task_pool_t;
+
+// Processes items [begin, end) of a parallel_for range
+typedef void (*task_range_fn)(void *ctx, size_t begin, size_t end);
+
+// num_threads == 0 picks one worker per logical core minus the caller
+task_pool_t *task_pool_create(size_t num_threads);
+void task_pool_destroy(task_pool_t *pool);
+
+// Runs fn over [0, count) in chunks of `grain` items and returns when every
+// chunk is done. The calling thread takes chunks too. Calls from several
+// threads are serialised. A NULL pool runs everything on the caller.
+void task_pool_parallel_for(task_pool_t *pool, size_t count, size_t grain, task_range_fn fn, void *ctx);
+
+size_t task_pool_num_threads(const task_pool_t *pool);
+
+// Process-wide pool, created on first use; release from obs_module_unload
+task_pool_t *task_pool_shared(void);
+void task_pool_shared_release(void);
+
+#ifdef __cplusplus
+}
+#endif
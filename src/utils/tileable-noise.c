@@ -0,0 +1,386 @@
+/*
+ * src/utils/tileable-noise.c
+ * CPU generators for tileable noise textures (no libobs dependency)
+ */
+
+#include "tileable-noise.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILEABLE_NOISE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// --- Lattice hash ---
+// Integer hash (lowbias32 finaliser) instead of the shader's sin() hash:
+// identical on every CPU and cheap to vectorise.
+
+#define HASH_MUL_X 0x8DA6B343u
+#define HASH_MUL_Y 0xD8163841u
+#define HASH_MUL_SEED 0xCB1AB31Fu
+#define HASH_MIX_1 0x7FEB352Du
+#define HASH_MIX_2 0x846CA68Bu
+#define OCTAVE_SEED_STEP 0x9E3779B9u
+
+static inline uint32_t hash_finalize(uint32_t h) {
+    h ^= h >> 16;
+    h *= HASH_MIX_1;
+    h ^= h >> 15;
+    h *= HASH_MIX_2;
+    h ^= h >> 16;
+    return h;
+}
+
+static inline float hash_to_unit(uint32_t h) {
+    return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline float smooth_step01(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static int clamp_octaves(int octaves) {
+    if (octaves < 1) return 1;
+    if (octaves > TILEABLE_NOISE_MAX_OCTAVES) return TILEABLE_NOISE_MAX_OCTAVES;
+    return octaves;
+}
+
+static inline uint16_t unit_to_unorm16(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 1.0f) return 65535;
+    return (uint16_t)(v * 65535.0f + 0.5f);
+}
+
+// Per-octave values shared by every texel of a row
+typedef struct {
+    uint32_t period_x;    // Wrapped lattice width of this octave
+    uint32_t row_hash_0;  // Hash contribution of the lower lattice row (incl. seed)
+    uint32_t row_hash_1;  // Hash contribution of the upper lattice row
+    float fy;             // Smoothed fraction between the two rows
+    float frequency;
+    float amplitude;
+} fbm_octave_row_t;
+
+static float fbm_prepare_row(const tileable_fbm_desc_t *desc, uint32_t y, fbm_octave_row_t *rows) {
+    int octaves = clamp_octaves(desc->octaves);
+    float v = ((float)y + 0.5f) / (float)desc->height * (float)desc->period_y;
+    float amplitude = 1.0f;
+    float max_value = 0.0f;
+
+    for (int k = 0; k < octaves; k++) {
+        fbm_octave_row_t *row = &rows[k];
+        uint32_t period_y = desc->period_y << k;
+        uint32_t seed_hash = (desc->seed + OCTAVE_SEED_STEP * (uint32_t)k) * HASH_MUL_SEED;
+
+        row->frequency = (float)(1u << k);
+        row->period_x = desc->period_x << k;
+        row->amplitude = amplitude;
+
+        float py = v * row->frequency;
+        uint32_t iy = (uint32_t)py;
+        float fy = py - (float)iy;
+        if (iy >= period_y) iy -= period_y;
+        uint32_t iy1 = (iy + 1 == period_y) ? 0 : iy + 1;
+
+        row->row_hash_0 = (iy * HASH_MUL_Y) ^ seed_hash;
+        row->row_hash_1 = (iy1 * HASH_MUL_Y) ^ seed_hash;
+        row->fy = smooth_step01(fy);
+
+        max_value += amplitude;
+        amplitude *= desc->persistence;
+    }
+
+    return max_value > 0.0f ? 1.0f / max_value : 0.0f;
+}
+
+static float fbm_eval_scalar(const tileable_fbm_desc_t *desc, const fbm_octave_row_t *rows, float inv_max, uint32_t x) {
+    int octaves = clamp_octaves(desc->octaves);
+    float u = ((float)x + 0.5f) / (float)desc->width * (float)desc->period_x;
+    float total = 0.0f;
+
+    for (int k = 0; k < octaves; k++) {
+        const fbm_octave_row_t *row = &rows[k];
+        float px = u * row->frequency;
+        uint32_t ix = (uint32_t)px;
+        float fx = smooth_step01(px - (float)ix);
+        if (ix >= row->period_x) ix -= row->period_x;
+        uint32_t ix1 = (ix + 1 == row->period_x) ? 0 : ix + 1;
+
+        uint32_t hx0 = ix * HASH_MUL_X;
+        uint32_t hx1 = ix1 * HASH_MUL_X;
+        float n00 = hash_to_unit(hash_finalize(hx0 ^ row->row_hash_0));
+        float n10 = hash_to_unit(hash_finalize(hx1 ^ row->row_hash_0));
+        float n01 = hash_to_unit(hash_finalize(hx0 ^ row->row_hash_1));
+        float n11 = hash_to_unit(hash_finalize(hx1 ^ row->row_hash_1));
+
+        float bottom = n00 + (n10 - n00) * fx;
+        float top = n01 + (n11 - n01) * fx;
+        total += (bottom + (top - bottom) * row->fy) * row->amplitude;
+    }
+
+    return total * inv_max;
+}
+
+#ifdef TILEABLE_NOISE_SSE2
+// SSE2 has no 32-bit low multiply (_mm_mullo_epi32 is SSE4.1)
+static inline __m128i mullo_epi32_sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i hash_finalize_sse2(__m128i h) {
+    const __m128i mix1 = _mm_set1_epi32((int)HASH_MIX_1);
+    const __m128i mix2 = _mm_set1_epi32((int)HASH_MIX_2);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    h = mullo_epi32_sse2(h, mix1);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = mullo_epi32_sse2(h, mix2);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    return h;
+}
+
+static inline __m128 hash_to_unit_sse2(__m128i h) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+static inline __m128 smooth_step01_sse2(__m128 t) {
+    __m128 s = _mm_sub_ps(_mm_set1_ps(3.0f), _mm_add_ps(t, t));
+    return _mm_mul_ps(_mm_mul_ps(t, t), s);
+}
+
+// Four adjacent texels of one row
+static void fbm_eval_sse2(const tileable_fbm_desc_t *desc, const fbm_octave_row_t *rows, float inv_max, uint32_t x, uint16_t *out) {
+    int octaves = clamp_octaves(desc->octaves);
+    const float scale_u = (float)desc->period_x / (float)desc->width;
+    const __m128i mul_x = _mm_set1_epi32((int)HASH_MUL_X);
+    const __m128i one = _mm_set1_epi32(1);
+
+    __m128 xs = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32((int)x), _mm_set_epi32(3, 2, 1, 0))),
+                           _mm_set1_ps(0.5f));
+    __m128 u = _mm_mul_ps(xs, _mm_set1_ps(scale_u));
+    __m128 total = _mm_setzero_ps();
+
+    for (int k = 0; k < octaves; k++) {
+        const fbm_octave_row_t *row = &rows[k];
+        __m128i period = _mm_set1_epi32((int)row->period_x);
+
+        __m128 px = _mm_mul_ps(u, _mm_set1_ps(row->frequency));
+        __m128i ix = _mm_cvttps_epi32(px);
+        __m128 fx = smooth_step01_sse2(_mm_sub_ps(px, _mm_cvtepi32_ps(ix)));
+
+        // ix -= period where ix >= period; ix1 = (ix + 1) mod period
+        __m128i over = _mm_cmpgt_epi32(ix, _mm_sub_epi32(period, one));
+        ix = _mm_sub_epi32(ix, _mm_and_si128(over, period));
+        __m128i ix1 = _mm_add_epi32(ix, one);
+        ix1 = _mm_andnot_si128(_mm_cmpeq_epi32(ix1, period), ix1);
+
+        __m128i hx0 = mullo_epi32_sse2(ix, mul_x);
+        __m128i hx1 = mullo_epi32_sse2(ix1, mul_x);
+        __m128i ry0 = _mm_set1_epi32((int)row->row_hash_0);
+        __m128i ry1 = _mm_set1_epi32((int)row->row_hash_1);
+
+        __m128 n00 = hash_to_unit_sse2(hash_finalize_sse2(_mm_xor_si128(hx0, ry0)));
+        __m128 n10 = hash_to_unit_sse2(hash_finalize_sse2(_mm_xor_si128(hx1, ry0)));
+        __m128 n01 = hash_to_unit_sse2(hash_finalize_sse2(_mm_xor_si128(hx0, ry1)));
+        __m128 n11 = hash_to_unit_sse2(hash_finalize_sse2(_mm_xor_si128(hx1, ry1)));
+
+        __m128 bottom = _mm_add_ps(n00, _mm_mul_ps(_mm_sub_ps(n10, n00), fx));
+        __m128 top = _mm_add_ps(n01, _mm_mul_ps(_mm_sub_ps(n11, n01), fx));
+        __m128 value = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), _mm_set1_ps(row->fy)));
+        total = _mm_add_ps(total, _mm_mul_ps(value, _mm_set1_ps(row->amplitude)));
+    }
+
+    // Normalise, convert to UNORM16. packs_epi32 saturates signed, so bias
+    // into the signed range and flip the sign bit back afterwards.
+    total = _mm_mul_ps(total, _mm_set1_ps(inv_max * 65535.0f));
+    total = _mm_min_ps(_mm_max_ps(_mm_add_ps(total, _mm_set1_ps(0.5f)), _mm_setzero_ps()), _mm_set1_ps(65535.0f));
+    __m128i q = _mm_sub_epi32(_mm_cvttps_epi32(total), _mm_set1_epi32(32768));
+    q = _mm_xor_si128(_mm_packs_epi32(q, q), _mm_set1_epi16((short)0x8000));
+    _mm_storel_epi64((__m128i *)(void *)out, q);
+}
+#endif
+
+void tileable_fbm_rows(const tileable_fbm_desc_t *desc, uint16_t *out, uint32_t row_begin, uint32_t row_end) {
+    if (!desc || !out || desc->width == 0 || desc->height == 0) return;
+    if (desc->period_x == 0 || desc->period_y == 0) return;
+    if (row_end > desc->height) row_end = desc->height;
+
+    fbm_octave_row_t rows[TILEABLE_NOISE_MAX_OCTAVES];
+
+    for (uint32_t y = row_begin; y < row_end; y++) {
+        uint16_t *dst = out + (size_t)y * desc->width;
+        float inv_max = fbm_prepare_row(desc, y, rows);
+        uint32_t x = 0;
+
+#ifdef TILEABLE_NOISE_SSE2
+        for (; x + 4 <= desc->width; x += 4) {
+            fbm_eval_sse2(desc, rows, inv_max, x, dst + x);
+        }
+#endif
+        for (; x < desc->width; x++) {
+            dst[x] = unit_to_unorm16(fbm_eval_scalar(desc, rows, inv_max, x));
+        }
+    }
+}
+
+void tileable_fbm_bake(const tileable_fbm_desc_t *desc, uint16_t *out) {
+    if (!desc) return;
+    tileable_fbm_rows(desc, out, 0, desc->height);
+}
+
+float tileable_fbm_sample(const tileable_fbm_desc_t *desc, uint32_t x, uint32_t y) {
+    if (!desc || desc->width == 0 || desc->height == 0) return 0.0f;
+    if (desc->period_x == 0 || desc->period_y == 0) return 0.0f;
+
+    fbm_octave_row_t rows[TILEABLE_NOISE_MAX_OCTAVES];
+    float inv_max = fbm_prepare_row(desc, y % desc->height, rows);
+    return fbm_eval_scalar(desc, rows, inv_max, x % desc->width);
+}
+
+// --- Blue noise (void-and-cluster, Ulichney 1993) ---
+
+#define BLUE_NOISE_SIGMA 1.5f
+#define BLUE_NOISE_INITIAL_DENSITY 10  // 1 in N texels set in the initial pattern
+
+typedef struct {
+    uint32_t size_log2;
+    size_t size;
+    size_t count;
+    float *kernel;   // Toroidal gaussian indexed by wrapped (dy, dx)
+    float *energy;
+    uint8_t *bits;
+} blue_noise_ctx_t;
+
+static void blue_noise_splat(blue_noise_ctx_t *ctx, size_t index, float sign) {
+    size_t mask = ctx->size - 1;
+    size_t px = index & mask;
+    size_t py = index >> ctx->size_log2;
+
+    for (size_t y = 0; y < ctx->size; y++) {
+        const float *krow = ctx->kernel + (((y - py) & mask) << ctx->size_log2);
+        float *erow = ctx->energy + (y << ctx->size_log2);
+        for (size_t x = 0; x < ctx->size; x++) {
+            erow[x] += sign * krow[(x - px) & mask];
+        }
+    }
+}
+
+static void blue_noise_set(blue_noise_ctx_t *ctx, size_t index, bool value) {
+    ctx->bits[index] = value ? 1 : 0;
+    blue_noise_splat(ctx, index, value ? 1.0f : -1.0f);
+}
+
+// Tightest cluster: the set texel with the most energy
+static size_t blue_noise_tightest_cluster(const blue_noise_ctx_t *ctx) {
+    size_t best = 0;
+    float best_energy = -INFINITY;
+    for (size_t i = 0; i < ctx->count; i++) {
+        if (ctx->bits[i] && ctx->energy[i] > best_energy) {
+            best_energy = ctx->energy[i];
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Largest void: the unset texel with the least energy
+static size_t blue_noise_largest_void(const blue_noise_ctx_t *ctx) {
+    size_t best = 0;
+    float best_energy = INFINITY;
+    for (size_t i = 0; i < ctx->count; i++) {
+        if (!ctx->bits[i] && ctx->energy[i] < best_energy) {
+            best_energy = ctx->energy[i];
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool blue_noise_bake(uint16_t *out, uint32_t size_log2, uint32_t seed) {
+    // Each step touches every texel, so cost is O(n^2); 128x128 is the practical limit
+    if (!out || size_log2 < 2 || size_log2 > 7) return false;
+
+    blue_noise_ctx_t ctx;
+    ctx.size_log2 = size_log2;
+    ctx.size = (size_t)1 << size_log2;
+    ctx.count = ctx.size * ctx.size;
+    ctx.kernel = malloc(sizeof(float) * ctx.count);
+    ctx.energy = calloc(ctx.count, sizeof(float));
+    ctx.bits = calloc(ctx.count, 1);
+
+    float *initial_energy = malloc(sizeof(float) * ctx.count);
+    uint8_t *initial_bits = malloc(ctx.count);
+    uint32_t *rank = malloc(sizeof(uint32_t) * ctx.count);
+
+    bool ok = ctx.kernel && ctx.energy && ctx.bits && initial_energy && initial_bits && rank;
+    if (ok) {
+        for (size_t dy = 0; dy < ctx.size; dy++) {
+            for (size_t dx = 0; dx < ctx.size; dx++) {
+                float wx = (float)(dx < ctx.size - dx ? dx : ctx.size - dx);
+                float wy = (float)(dy < ctx.size - dy ? dy : ctx.size - dy);
+                ctx.kernel[(dy << size_log2) + dx] = expf(-(wx * wx + wy * wy) / (2.0f * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+            }
+        }
+
+        // Random initial pattern
+        uint32_t state = seed ? seed : 0x2545F491u;
+        size_t ones = ctx.count / BLUE_NOISE_INITIAL_DENSITY;
+        if (ones == 0) ones = 1;
+        for (size_t placed = 0; placed < ones;) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            size_t index = state & (ctx.count - 1);
+            if (!ctx.bits[index]) {
+                blue_noise_set(&ctx, index, true);
+                placed++;
+            }
+        }
+
+        // Move points from clusters to voids until the pattern is stable
+        for (size_t iter = 0; iter < ctx.count; iter++) {
+            size_t cluster = blue_noise_tightest_cluster(&ctx);
+            blue_noise_set(&ctx, cluster, false);
+            size_t hole = blue_noise_largest_void(&ctx);
+            blue_noise_set(&ctx, hole, true);
+            if (hole == cluster) break;
+        }
+
+        memcpy(initial_bits, ctx.bits, ctx.count);
+        memcpy(initial_energy, ctx.energy, sizeof(float) * ctx.count);
+
+        // Phase 1: rank the initial points by removing tightest clusters
+        for (size_t remaining = ones; remaining > 0; remaining--) {
+            size_t cluster = blue_noise_tightest_cluster(&ctx);
+            blue_noise_set(&ctx, cluster, false);
+            rank[cluster] = (uint32_t)(remaining - 1);
+        }
+
+        // Phases 2 and 3: fill the largest voids. The original algorithm
+        // inverts the roles past half density; filling voids throughout
+        // gives an equivalent distribution for a grain threshold map.
+        memcpy(ctx.bits, initial_bits, ctx.count);
+        memcpy(ctx.energy, initial_energy, sizeof(float) * ctx.count);
+        for (size_t filled = ones; filled < ctx.count; filled++) {
+            size_t hole = blue_noise_largest_void(&ctx);
+            blue_noise_set(&ctx, hole, true);
+            rank[hole] = (uint32_t)filled;
+        }
+
+        for (size_t i = 0; i < ctx.count; i++) {
+            out[i] = (uint16_t)(((uint64_t)rank[i] * 65535u) / (ctx.count - 1));
+        }
+    }
+
+    free(ctx.kernel);
+    free(ctx.energy);
+    free(ctx.bits);
+    free(initial_energy);
+    free(initial_bits);
+    free(rank);
+    return ok;
+}
@@ -0,0 +1,49 @@
+/*
+ * src/utils/tileable-noise.h
+ * CPU generators for tileable noise textures (no libobs dependency)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TILEABLE_NOISE_MAX_OCTAVES 12
+
+// Value noise fbm over a [0, period_x) x [0, period_y) lattice domain. The
+// lattice wraps at the period (and at period * 2^k for octave k), so the
+// output tiles seamlessly when sampled with wrap addressing.
+typedef struct {
+    uint32_t width;       // Output texels
+    uint32_t height;
+    uint32_t period_x;    // Lattice cells covered by the texture, >= 1
+    uint32_t period_y;
+    int octaves;          // Clamped to [1, TILEABLE_NOISE_MAX_OCTAVES]
+    float persistence;    // Amplitude falloff per octave
+    uint32_t seed;
+} tileable_fbm_desc_t;
+
+// Fills rows [row_begin, row_end) of `out` (width * height texels, row major)
+// with fbm normalised to [0, 1] and stored as UNORM16. Rows are independent,
+// so callers may split the range across threads.
+void tileable_fbm_rows(const tileable_fbm_desc_t *desc, uint16_t *out, uint32_t row_begin, uint32_t row_end);
+
+// Single-threaded convenience wrapper for the whole texture
+void tileable_fbm_bake(const tileable_fbm_desc_t *desc, uint16_t *out);
+
+// Reference scalar evaluation of one texel, used for the tail of SIMD rows
+float tileable_fbm_sample(const tileable_fbm_desc_t *desc, uint32_t x, uint32_t y);
+
+// Blue noise threshold map of (1 << size_log2)^2 texels via void-and-cluster.
+// Every rank appears exactly once, stored as UNORM16. size_log2 must be in
+// [2, 8]. Returns false on invalid size or allocation failure.
+bool blue_noise_bake(uint16_t *out, uint32_t size_log2, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif